@@ -0,0 +1,108 @@
+#include <cstdio>
+#include "battery_save.hpp"
+
+BatterySave::BatterySave(const std::string &path, size_t size) : path(path), changes(0), ram(nullptr), written(0),
+        saved_changes(0), running(false)
+{
+    snapshots[0].resize(size);
+    snapshots[1].resize(size);
+}
+
+BatterySave::~BatterySave()
+{
+    stop_thread();
+    flush();
+}
+
+bool BatterySave::load(UINT8 *ram) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if(!f) return false;
+    size_t nr_read = fread(ram, 1, snapshots[0].size(), f);
+    fclose(f);
+    if(nr_read != snapshots[0].size()) std::printf("Battery save %s is truncated\n", path.c_str());
+    // as in the file
+    std::copy(ram, ram + snapshots[0].size(), snapshots[written].begin());
+    return true;
+}
+
+void BatterySave::set_ram(const UINT8 *ram) {
+    std::lock_guard<std::mutex> lock(ram_mutex);
+    this->ram = ram;
+}
+
+bool BatterySave::save(UINT32 seen) {
+    std::lock_guard<std::mutex> lock(save_mutex);
+    if(seen == saved_changes) return true;
+    std::vector<UINT8> &snapshot = snapshots[written ^ 1];
+    {
+        std::lock_guard<std::mutex> ram_lock(ram_mutex);
+        if(!ram) return false;
+        std::copy(ram, ram + snapshot.size(), snapshot.begin());
+    }
+    // the game wrote the RAM during the copy
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(changes.load(std::memory_order_relaxed) != seen) return false;
+    if(snapshot != snapshots[written]) {
+        if(!write_file(snapshot)) return false;
+        written ^= 1;
+    }
+    saved_changes = seen;
+    return true;
+}
+
+void BatterySave::thread_loop() {
+    UINT32 seen = changes.load(std::memory_order_acquire);
+    clock::time_point last_change = clock::now();
+    std::unique_lock<std::mutex> lock(thread_mutex);
+    while(running.load()) {
+        // the changes are only seen here, a few times per quiet period
+        UINT32 now_changes = changes.load(std::memory_order_acquire);
+        if(now_changes != seen) {
+            seen = now_changes;
+            last_change = clock::now();
+        } else if(seen != saved_changes && clock::now() - last_change >= std::chrono::milliseconds(BATTERY_QUIET_MS)) {
+            lock.unlock();
+            if(!save(seen)) last_change = clock::now();
+            lock.lock();
+            continue;
+        }
+        wake.wait_for(lock, std::chrono::milliseconds(BATTERY_QUIET_MS / 4));
+    }
+}
+
+void BatterySave::start_thread() {
+    if(running.load()) return;
+    running = true;
+    thread = std::thread(&BatterySave::thread_loop, this);
+}
+
+void BatterySave::stop_thread() {
+    if(!running.load()) return;
+    {
+        std::lock_guard<std::mutex> lock(thread_mutex);
+        running = false;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void BatterySave::flush() {
+    save(changes.load(std::memory_order_acquire));
+}
+
+bool BatterySave::write_file(const std::vector<UINT8> &data) {
+    std::string tmp_path = path + ".tmp";
+    FILE *f = fopen(tmp_path.c_str(), "wb");
+    if(!f) {
+        std::printf("Could not write battery save %s\n", tmp_path.c_str());
+        return false;
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    ok = (fclose(f) == 0) && ok;
+    if(!ok || rename(tmp_path.c_str(), path.c_str())) {
+        std::printf("Could not write battery save %s\n", path.c_str());
+        remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+#ifndef GAYA_BATTERY_SAVE_HPP
+#define GAYA_BATTERY_SAVE_HPP
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include "types.hpp"
+
+// the RAM is written once the game stopped changing it for this long
+#define BATTERY_QUIET_MS    1000
+
+/*
+Keeps the battery-backed PRG RAM of a cartridge in a save file.
+
+The emulation thread only counts the writes to the RAM, before doing them (a single
+atomic store, see get_changes() and ROMDefault::write_prg_ram()), and a background
+thread copies the RAM itself once it has been left alone for BATTERY_QUIET_MS, and
+on exit. A copy during which a write was counted is dropped, and taken again after
+the next quiet period. Two snapshots are
+kept, the one last written and the new one, so that a RAM written back with the
+same content is not saved again.
+Files are written to a temporary file which is then renamed, so that a crash
+never leaves a half-written save.
+*/
+class BatterySave
+{
+public:
+    BatterySave(const std::string &path, size_t size);
+    // flushes what was not written yet
+    ~BatterySave();
+
+    // fills ram with the save file content, returns false if there is none
+    bool                        load(UINT8 *ram);
+    /* The RAM the writer thread copies. Waits for a copy in progress, so it is only
+    called when the RAM moves (nullptr before it is freed) */
+    void                        set_ram(const UINT8 *ram);
+    // from the emulation thread, when the RAM was replaced
+    void                        ram_changed() {changes.store(changes.load(std::memory_order_relaxed) + 1, std::memory_order_release);};
+    // incremented by the emulation thread before each write
+    std::atomic<UINT32>         *get_changes() {return &changes;};
+
+    void                        start_thread();
+    void                        stop_thread();
+    // writes the RAM right away, if it changed since the last write
+    void                        flush();
+
+    const std::string           &get_path() {return path;};
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    std::string                 path;
+    // only written by the emulation thread
+    std::atomic<UINT32>         changes;
+
+    const UINT8                 *ram;
+    std::mutex                  ram_mutex;
+
+    std::vector<UINT8>          snapshots[2];
+    int                         written; // the snapshot in the file
+    UINT32                      saved_changes;
+    std::mutex                  save_mutex;
+
+    std::mutex                  thread_mutex;
+    std::condition_variable     wake;
+    std::thread                 thread;
+    std::atomic<bool>           running;
+
+    void                        thread_loop();
+    // copies the RAM as it is after `seen` changes, and writes it when it differs from the file
+    bool                        save(UINT32 seen);
+    bool                        write_file(const std::vector<UINT8> &data);
+};
+
+#endif
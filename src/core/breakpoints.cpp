@@ -0,0 +1,380 @@
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+#include "breakpoints.hpp"
+#include "cpu_opcodes.hpp"
+#include "mem.hpp"
+#include "ppu_info.hpp"
+#include "exceptions.hpp"
+
+// deepest evaluation stack a condition can need
+#define CONDITION_STACK_SIZE    16
+
+/* ============ CONDITIONS ============ */
+
+enum REG_INDEX {
+    REG_A, REG_X, REG_Y, REG_S, REG_P, REG_PC, REG_ADDR, REG_VALUE
+};
+
+/*
+Recursive descent, one function per level of precedence, each emitting the code of
+its operands and then its operator (so the code is the postfix form)
+*/
+class ConditionParser
+{
+public:
+    ConditionParser(const std::string &t, std::vector<BreakCondition::instr> &c) : text(t), code(c), pos(0), depth(0), max_depth(0) {};
+
+    void parse() {
+        parse_binary(0);
+        skip_spaces();
+        if(pos != text.size()) fail("unexpected characters at the end of the condition");
+        if(max_depth > CONDITION_STACK_SIZE) fail("condition too complex");
+    };
+
+private:
+    typedef BreakCondition::OP OP;
+    const std::string   &text;
+    std::vector<BreakCondition::instr>
+                        &code;
+    size_t              pos;
+    int                 depth, max_depth; // of the evaluation stack
+
+    // binary operators, from the lowest precedence
+    struct binary_op {
+        const char  *token;
+        OP          op;
+    };
+    static const int NR_LEVELS = 9;
+    static const binary_op *level_ops(int level) {
+        static const binary_op ops[NR_LEVELS][5] = {
+            {{"||", OP::LOR}, {nullptr, OP::LOR}},
+            {{"&&", OP::LAND}, {nullptr, OP::LOR}},
+            {{"|", OP::BOR}, {nullptr, OP::LOR}},
+            {{"^", OP::BXOR}, {nullptr, OP::LOR}},
+            {{"&", OP::BAND}, {nullptr, OP::LOR}},
+            {{"==", OP::EQ}, {"!=", OP::NE}, {nullptr, OP::LOR}},
+            {{"<=", OP::LE}, {">=", OP::GE}, {"<", OP::LT}, {">", OP::GT}, {nullptr, OP::LOR}},
+            {{"<<", OP::SHL}, {">>", OP::SHR}, {"+", OP::ADD}, {"-", OP::SUB}, {nullptr, OP::LOR}},
+            {{"*", OP::MUL}, {"/", OP::DIV}, {"%", OP::MOD}, {nullptr, OP::LOR}}
+        };
+        return ops[level];
+    };
+
+    [[noreturn]] void fail(const char *what) {
+        throw IncorrectFileFormat(what);
+    };
+    void skip_spaces() {
+        while(pos < text.size() && std::isspace((unsigned char)text[pos])) pos++;
+    };
+    void emit(OP op, int arg, int stack_change) {
+        code.push_back({op, arg});
+        depth += stack_change;
+        if(depth > max_depth) max_depth = depth;
+    };
+    bool accept(const char *token) {
+        skip_spaces();
+        size_t len = std::strlen(token);
+        if(text.compare(pos, len, token)) return false;
+        // not the start of a longer operator : "|" of "||", "<" of "<=" or "<<"
+        if(len == 1 && pos + 1 < text.size() && std::strchr("|&<>", token[0])) {
+            char next = text[pos + 1];
+            if(next == token[0] || (next == '=' && std::strchr("<>", token[0]))) return false;
+        }
+        pos += len;
+        return true;
+    };
+
+    void parse_binary(int level) {
+        if(level == NR_LEVELS) {
+            parse_unary();
+            return;
+        }
+        parse_binary(level + 1);
+        bool found = true;
+        while(found) {
+            found = false;
+            for(const binary_op *o = level_ops(level); o->token; o++) {
+                if(accept(o->token)) {
+                    parse_binary(level + 1);
+                    emit(o->op, 0, -1);
+                    found = true;
+                    break;
+                }
+            }
+        }
+    };
+
+    void parse_unary() {
+        if(accept("!")) {parse_unary(); emit(OP::NOT, 0, 0);}
+        else if(accept("-")) {parse_unary(); emit(OP::NEG, 0, 0);}
+        else if(accept("~")) {parse_unary(); emit(OP::COMPL, 0, 0);}
+        else parse_primary();
+    };
+
+    void parse_primary() {
+        static const struct {
+            const char  *name;
+            REG_INDEX   reg;
+        } names[] = {
+            {"pc", REG_PC}, {"addr", REG_ADDR}, {"value", REG_VALUE},
+            {"a", REG_A}, {"x", REG_X}, {"y", REG_Y}, {"s", REG_S}, {"p", REG_P}
+        };
+        skip_spaces();
+        if(pos == text.size()) fail("missing value in the condition");
+        if(accept("(")) {
+            parse_binary(0);
+            if(!accept(")")) fail("missing ) in the condition");
+            return;
+        }
+        if(accept("[")) {
+            parse_binary(0);
+            if(!accept("]")) fail("missing ] in the condition");
+            emit(OP::MEM, 0, 0);
+            return;
+        }
+        accept("#"); // as in immediate operands
+        char c = text[pos];
+        if(c == '$' || std::isdigit((unsigned char)c)) {
+            int base = 10;
+            if(c == '$') {
+                base = 16;
+                pos++;
+            } else if(!text.compare(pos, 2, "0x") || !text.compare(pos, 2, "0X")) {
+                base = 16;
+                pos += 2;
+            }
+            const char *start = text.c_str() + pos;
+            char *end;
+            long val = std::strtol(start, &end, base);
+            if(end == start) fail("incorrect number in the condition");
+            pos += end - start;
+            emit(OP::PUSH, (int)val, 1);
+            return;
+        }
+        size_t len = 0;
+        while(pos + len < text.size() && std::isalpha((unsigned char)text[pos + len])) len++;
+        std::string word = text.substr(pos, len);
+        for(char &w : word) w = std::tolower((unsigned char)w);
+        for(auto &n : names) {
+            if(word == n.name) {
+                pos += len;
+                emit(OP::REG, n.reg, 1);
+                return;
+            }
+        }
+        fail("unknown name in the condition (a, x, y, s, p, pc, addr or value)");
+    };
+};
+
+BreakCondition::BreakCondition(const std::string &text) : text(text) {
+    ConditionParser(text, code).parse();
+}
+
+int BreakCondition::evaluate(const break_context &c, const Breakpoints &b) const {
+    int stack[CONDITION_STACK_SIZE];
+    int sp = 0; // next free
+    for(const instr &i : code) {
+        switch (i.op)
+        {
+        case OP::PUSH: stack[sp++] = i.arg; break;
+        case OP::REG: {
+            int regs[] = {c.A, c.X, c.Y, c.S, c.P, c.PC, c.addr, c.value};
+            stack[sp++] = regs[i.arg];
+            break;
+        }
+        case OP::MEM: stack[sp - 1] = b.peek((MEMADDR)stack[sp - 1]); break;
+        case OP::NOT: stack[sp - 1] = !stack[sp - 1]; break;
+        case OP::NEG: stack[sp - 1] = -stack[sp - 1]; break;
+        case OP::COMPL: stack[sp - 1] = ~stack[sp - 1]; break;
+        default: {
+            // binary
+            int r = stack[--sp];
+            int &l = stack[sp - 1];
+            switch (i.op)
+            {
+            case OP::MUL: l *= r; break;
+            case OP::DIV: l = (r)? l / r : 0; break;
+            case OP::MOD: l = (r)? l % r : 0; break;
+            case OP::ADD: l += r; break;
+            case OP::SUB: l -= r; break;
+            case OP::SHL: l <<= (r & 31); break;
+            case OP::SHR: l >>= (r & 31); break;
+            case OP::LT: l = l < r; break;
+            case OP::GT: l = l > r; break;
+            case OP::LE: l = l <= r; break;
+            case OP::GE: l = l >= r; break;
+            case OP::EQ: l = l == r; break;
+            case OP::NE: l = l != r; break;
+            case OP::BAND: l &= r; break;
+            case OP::BXOR: l ^= r; break;
+            case OP::BOR: l |= r; break;
+            case OP::LAND: l = l && r; break;
+            case OP::LOR: l = l || r; break;
+            default: break;
+            }
+        }
+        }
+    }
+    return stack[0];
+}
+
+/* ============ BREAKPOINTS ============ */
+
+Breakpoints::Breakpoints() : next_id(1), cpu_ram(nullptr), rom_mem(nullptr), ppu_mem(nullptr), ppu_state(nullptr),
+        handler(nullptr), handler_ctx(nullptr)
+{
+    update_maps();
+}
+
+UINT8 Breakpoints::peek(MEMADDR a) const {
+    if(a < 0x2000) return (cpu_ram)? cpu_ram[a & (RAM_SIZE - 1)] : 0;
+    if(a >= 0x4020 && rom_mem) return rom_mem->read(a);
+    return 0;
+}
+
+unsigned int Breakpoints::add(const std::string &spec) {
+    static const struct {
+        const char  *name;
+        UINT8       kinds;
+    } kind_names[] = {
+        {"exec", BREAK_EXEC}, {"read", BREAK_READ}, {"write", BREAK_WRITE}, {"rw", BREAK_READ | BREAK_WRITE},
+        {"ppuread", BREAK_PPU_READ}, {"ppuwrite", BREAK_PPU_WRITE}, {"ppurw", BREAK_PPU_READ | BREAK_PPU_WRITE}
+    };
+    breakpoint b;
+    b.hits = 0;
+
+    // kind range [if condition]
+    char kind[16], range[32];
+    int consumed = 0;
+    if(std::sscanf(spec.c_str(), " %15s %31s %n", kind, range, &consumed) != 2)
+        throw IncorrectFileFormat("Breakpoints are : kind address[-last] [if condition]");
+    b.kinds = 0;
+    for(auto &k : kind_names) {
+        if(!std::strcmp(kind, k.name)) b.kinds = k.kinds;
+    }
+    if(!b.kinds) throw IncorrectFileFormat("Unknown kind of breakpoint (exec, read, write, rw, ppuread, ppuwrite, ppurw)");
+
+    const char *r = (range[0] == '$')? range + 1 : range;
+    char *end;
+    unsigned long first = std::strtoul(r, &end, 16), last = first;
+    if(end == r) throw IncorrectFileFormat("Incorrect breakpoint address");
+    if(*end == '-') {
+        r = (end[1] == '$')? end + 2 : end + 1;
+        last = std::strtoul(r, &end, 16);
+        if(end == r) throw IncorrectFileFormat("Incorrect breakpoint address");
+    }
+    unsigned long max = (b.kinds & (BREAK_PPU_READ | BREAK_PPU_WRITE))? 0x3FFF : 0xFFFF;
+    if(*end || first > last || last > max) throw IncorrectFileFormat("Incorrect breakpoint address");
+    b.first = first;
+    b.last = last;
+
+    std::string rest = spec.substr(consumed);
+    if(!rest.empty()) {
+        if(rest.compare(0, 3, "if ")) throw IncorrectFileFormat("Conditions start with \"if\"");
+        b.condition = BreakCondition(rest.substr(3));
+    }
+
+    b.id = next_id++;
+    list.push_back(b);
+    update_maps();
+    return b.id;
+}
+
+bool Breakpoints::remove(unsigned int id) {
+    for(auto it = list.begin(); it != list.end(); it++) {
+        if(it->id == id) {
+            list.erase(it);
+            update_maps();
+            return true;
+        }
+    }
+    return false;
+}
+
+void Breakpoints::print(FILE *f) {
+    static const char *kind_names[] = {"exec", "read", "write", "ppuread", "ppuwrite"};
+    if(list.empty()) std::fprintf(f, "No breakpoints\n");
+    for(const breakpoint &b : list) {
+        std::fprintf(f, "%u :", b.id);
+        for(int k = 0; k < 5; k++) {
+            if(b.kinds & (1 << k)) std::fprintf(f, " %s", kind_names[k]);
+        }
+        if(b.first == b.last) std::fprintf(f, " $%04X", b.first);
+        else std::fprintf(f, " $%04X-$%04X", b.first, b.last);
+        if(!b.condition.get_text().empty()) std::fprintf(f, " if %s", b.condition.get_text().c_str());
+        std::fprintf(f, ", %u hits\n", b.hits);
+    }
+}
+
+void Breakpoints::update_maps() {
+    std::memset(exec_map, 0, sizeof(exec_map));
+    std::memset(read_map, 0, sizeof(read_map));
+    std::memset(write_map, 0, sizeof(write_map));
+    std::memset(ppu_read_map, 0, sizeof(ppu_read_map));
+    std::memset(ppu_write_map, 0, sizeof(ppu_write_map));
+    UINT8 *maps[] = {exec_map, read_map, write_map, ppu_read_map, ppu_write_map};
+    watched_kinds = 0;
+    for(const breakpoint &b : list) {
+        watched_kinds |= b.kinds;
+        for(int k = 0; k < 5; k++) {
+            if(!(b.kinds & (1 << k))) continue;
+            for(unsigned int a = b.first; a <= b.last; a++) maps[k][a >> 3] |= 1 << (a & 7);
+        }
+    }
+}
+
+void Breakpoints::check(UINT8 kind, break_context &c) {
+    MEMADDR a = c.addr;
+    // the handler can add or remove breakpoints (debug cli) : it is called after the loop
+    std::vector<breakpoint> hit;
+    for(breakpoint &b : list) {
+        if(!(b.kinds & kind) || a < b.first || a > b.last || !b.condition.holds(c, *this)) continue;
+        b.hits++;
+        if(handler) hit.push_back(b);
+    }
+    for(const breakpoint &b : hit) handler(handler_ctx, b, kind, c);
+}
+
+void Breakpoints::instruction(UINT8 op, UINT16 operand, break_context &c) {
+    if(marked(exec_map, c.PC)) {
+        c.addr = c.PC;
+        c.value = op;
+        check(BREAK_EXEC, c);
+    }
+    UINT8 access = opcode_data_access(op);
+    UINT8 kinds = ((access & OPCODE_READS)? BREAK_READ | BREAK_PPU_READ : 0) |
+                  ((access & OPCODE_WRITES)? BREAK_WRITE | BREAK_PPU_WRITE : 0);
+    // most of the time, only execution breakpoints
+    if(!(kinds & watched_kinds)) return;
+    const cpu_opcode_info &info = cpu_opcodes[op];
+    MEMADDR a;
+    if(!cpu_ram || !operand_address(info.mode, operand, c.X, c.Y, cpu_ram, a)) return;
+
+    bool ppu = a >= 0x2000 && a < 0x4000 && (a & 0x07) == 7 && ppu_state;
+    // $2007 : the PPU memory at its address register
+    MEMADDR watched_a = ppu? ppu_state->internal_vram & 0x3FFF : a;
+    bool reading = (kinds & BREAK_READ) && marked(ppu? ppu_read_map : read_map, watched_a);
+    bool writing = (kinds & BREAK_WRITE) && marked(ppu? ppu_write_map : write_map, watched_a);
+    if(!reading && !writing) return;
+
+    // the value stored (the registers of STA, STX, STY, SAX), or the one read
+    UINT8 value;
+    if(access == OPCODE_WRITES && (info.flags & (OPCODE_REG_A | OPCODE_REG_X | OPCODE_REG_Y))) {
+        value = 0xFF;
+        if(info.flags & OPCODE_REG_A) value &= c.A;
+        if(info.flags & OPCODE_REG_X) value &= c.X;
+        if(info.flags & OPCODE_REG_Y) value &= c.Y;
+    } else value = peek(a);
+
+    c.addr = watched_a;
+    if(ppu) {
+        c.value = (kinds & BREAK_WRITE)? value : ppu_mem->read_ppu_mem(watched_a);
+        if(reading) check(BREAK_PPU_READ, c);
+        if(writing) check(BREAK_PPU_WRITE, c);
+        return;
+    }
+    c.value = value;
+    if(reading) check(BREAK_READ, c);
+    if(writing) check(BREAK_WRITE, c);
+}
@@ -0,0 +1,137 @@
+#ifndef GAYA_BREAKPOINTS_HPP
+#define GAYA_BREAKPOINTS_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+class ROMMemManager;
+class PPU_mem;
+struct PPU_state;
+
+// what a breakpoint stops on, can be or-ed
+#define BREAK_EXEC              0x01
+#define BREAK_READ              0x02
+#define BREAK_WRITE             0x04
+#define BREAK_PPU_READ          0x08
+#define BREAK_PPU_WRITE         0x10
+
+// values a condition can use, with the instruction about to be executed
+struct break_context {
+    MEMADDR     PC;
+    UINT8       A, X, Y, S, P;
+    MEMADDR     addr;       // of the access (PC for BREAK_EXEC)
+    UINT8       value;      // written by the stores, read otherwise (0 for the I/O registers)
+};
+
+class Breakpoints;
+
+/*
+Condition of a breakpoint, compiled once to a small stack machine. The syntax is
+the one of C expressions, on integers, with :
+    a, x, y, s, p, pc : the registers
+    addr, value : see break_context
+    [expr] : the CPU memory at expr (reading it has no side effect : I/O registers are 0)
+    $C000, 0xC000, 49152 : numbers
+so "a == $10 && [$0300] != 0". Throws IncorrectFileFormat when the text is not one.
+*/
+class BreakCondition
+{
+public:
+    BreakCondition() {};
+    explicit BreakCondition(const std::string &text);
+
+    // true without a condition
+    bool                        holds(const break_context &c, const Breakpoints &b) const {return code.empty() || evaluate(c, b);};
+    const std::string           &get_text() const {return text;};
+
+private:
+    enum class OP : UINT8 {
+        PUSH, REG, MEM,
+        NOT, NEG, COMPL,
+        MUL, DIV, MOD, ADD, SUB, SHL, SHR,
+        LT, GT, LE, GE, EQ, NE,
+        BAND, BXOR, BOR, LAND, LOR
+    };
+    struct instr {
+        OP          op;
+        int         arg;
+    };
+    std::string                 text;
+    std::vector<instr>          code;
+
+    int                         evaluate(const break_context &c, const Breakpoints &b) const;
+    friend class ConditionParser;
+};
+
+struct breakpoint {
+    unsigned int                id;
+    UINT8                       kinds;
+    MEMADDR                     first, last;
+    BreakCondition              condition;
+    UINT32                      hits;
+};
+
+/*
+Execution breakpoints, and watchpoints on the CPU and PPU address spaces. A bitmap
+per kind of access tells which addresses have one, so that only the instructions
+hitting a marked address look at the list (and evaluate the conditions).
+The CPU calls instruction() before executing each instruction while there are
+breakpoints (see cpu6502::execute_cycles_breakpoints, the normal execute_cycles
+doesn't know about them). The data accesses are found from the addressing mode
+of the instruction, so the stack and the dummy reads are not watched. The PPU
+accesses are the ones through $2007.
+On a hit, the handler is called, before the instruction is executed. It may add
+or remove breakpoints.
+*/
+class Breakpoints
+{
+public:
+    Breakpoints();
+
+    // memory for the conditions and the PPU addresses
+    void                        set_memory(const UINT8 *ram, ROMMemManager *rom, PPU_mem *ppu_m, PPU_state *ppu_s) {
+        cpu_ram = ram; rom_mem = rom; ppu_mem = ppu_m; ppu_state = ppu_s;
+    };
+    void                        set_handler(void (*h)(void *ctx, const breakpoint &b, UINT8 kind, const break_context &c), void *ctx) {
+        handler = h;
+        handler_ctx = ctx;
+    };
+
+    /* "exec C000", "write 0300-03FF if value > 9", "ppuwrite 3F00 if value == $0F"...
+    (kinds : exec, read, write, rw, ppuread, ppuwrite, ppurw). Returns the id,
+    throws IncorrectFileFormat */
+    unsigned int                add(const std::string &spec);
+    bool                        remove(unsigned int id);
+    bool                        empty() {return list.empty();};
+    void                        print(FILE *f);
+
+    void                        instruction(UINT8 op, UINT16 operand, break_context &c);
+
+    // without side effects, 0 for the I/O registers
+    UINT8                       peek(MEMADDR a) const;
+
+private:
+    std::vector<breakpoint>     list;
+    unsigned int                next_id;
+    // bit a & 7 of [a >> 3] : there is a breakpoint at a
+    UINT8                       exec_map[0x2000], read_map[0x2000], write_map[0x2000];
+    UINT8                       ppu_read_map[0x800], ppu_write_map[0x800];
+    // BREAK_* of all the breakpoints
+    UINT8                       watched_kinds;
+
+    const UINT8                 *cpu_ram;
+    ROMMemManager               *rom_mem;
+    PPU_mem                     *ppu_mem;
+    PPU_state                   *ppu_state;
+
+    void                        (*handler)(void *ctx, const breakpoint &b, UINT8 kind, const break_context &c);
+    void                        *handler_ctx;
+
+    static bool                 marked(const UINT8 *map, MEMADDR a) {return map[a >> 3] & (1 << (a & 7));};
+    void                        update_maps();
+    void                        check(UINT8 kind, break_context &c);
+};
+
+#endif
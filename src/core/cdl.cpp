@@ -0,0 +1,92 @@
+#include "cdl.hpp"
+#include "cpu_opcodes.hpp"
+#include "ppu_info.hpp"
+
+CodeDataLogger::CodeDataLogger(unsigned int prg_size, unsigned int chr_size) : prg(prg_size, 0), chr(chr_size, 0),
+        rom(nullptr), ppu_state(nullptr), cpu_ram(nullptr), after_indirect_jump(0)
+{
+    background.cdl = this;
+    background.flags = CDL_CHR_RENDERED | CDL_CHR_BACKGROUND;
+    sprites.cdl = this;
+    sprites.flags = CDL_CHR_RENDERED | CDL_CHR_SPRITE;
+}
+
+void CodeDataLogger::attach(ROMMemManager *r, PPU_mem *ppu_m, PPU_state *ppu_s, const UINT8 *ram) {
+    rom = r;
+    ppu_state = ppu_s;
+    cpu_ram = ram;
+    // CHR RAM is not logged
+    if(!chr.empty()) ppu_m->set_pattern_readers(&background, &sprites);
+}
+
+void CodeDataLogger::detach(PPU_mem *ppu_m) {
+    ppu_m->set_rom(ppu_m->rom);
+}
+
+void CodeDataLogger::instruction(MEMADDR pc, UINT8 op, UINT16 operand, UINT8 X, UINT8 Y) {
+    const cpu_opcode_info &info = cpu_opcodes[op];
+    UINT8 len = addr_mode_length(info.mode);
+    UINT8 code = CDL_PRG_CODE | ((after_indirect_jump)? CDL_PRG_INDIRECT_CODE : 0);
+    mark_prg(pc, code | CDL_PRG_OPCODE);
+    for(UINT8 i = 1; i < len; i++) mark_prg(pc + i, code);
+    after_indirect_jump = (info.mode == ADDR_MODE::INDIRECT);
+
+    MEMADDR a;
+    if(!(opcode_data_access(op) & OPCODE_READS) || !operand_address(info.mode, operand, X, Y, cpu_ram, a)) return;
+    if(a >= 0x8000) {
+        bool indirect = (info.mode == ADDR_MODE::X_INDIRECT || info.mode == ADDR_MODE::INDIRECT_Y);
+        mark_prg(a, CDL_PRG_DATA | ((indirect)? CDL_PRG_INDIRECT_DATA : 0));
+    } else if(a >= 0x2000 && a < 0x4000 && (a & 0x07) == 7 && ppu_state) {
+        // $2007, reading the pattern tables
+        MEMADDR ppu_a = ppu_state->internal_vram & 0x3FFF;
+        if(ppu_a < 0x2000) mark_chr(ppu_a, CDL_CHR_READ);
+    }
+}
+
+int CodeDataLogger::load(FILE *f) {
+    std::vector<UINT8> previous(prg.size() + chr.size() + 1);
+    if(fread(previous.data(), 1, previous.size(), f) != prg.size() + chr.size()) return -1;
+    for(size_t i = 0; i < prg.size(); i++) prg[i] |= previous[i];
+    for(size_t i = 0; i < chr.size(); i++) chr[i] |= previous[prg.size() + i];
+    return 0;
+}
+
+void CodeDataLogger::save(FILE *f) {
+    std::vector<UINT8> out(prg.size() + chr.size());
+    for(size_t i = 0; i < prg.size(); i++) out[i] = prg[i] & ~CDL_PRG_OPCODE;
+    for(size_t i = 0; i < chr.size(); i++) out[prg.size() + i] = chr[i] & ~(CDL_CHR_BACKGROUND | CDL_CHR_SPRITE);
+    fwrite(out.data(), 1, out.size(), f);
+}
+
+static double percent(unsigned int n, unsigned int total) {
+    return (total)? 100.0 * n / total : 0.0;
+}
+
+void CodeDataLogger::print_summary(FILE *f) {
+    std::fprintf(f, "PRG ROM bank : code (opcodes), data, unused\n");
+    for(size_t bank = 0; bank * PRG_BANK_SIZE < prg.size(); bank++) {
+        unsigned int code = 0, opcodes = 0, data = 0, unused = 0;
+        for(size_t i = bank * PRG_BANK_SIZE; i < (bank + 1) * PRG_BANK_SIZE && i < prg.size(); i++) {
+            if(prg[i] & CDL_PRG_CODE) code++;
+            if(prg[i] & CDL_PRG_OPCODE) opcodes++;
+            if(prg[i] & CDL_PRG_DATA) data++;
+            if(!(prg[i] & (CDL_PRG_CODE | CDL_PRG_DATA))) unused++;
+        }
+        std::fprintf(f, "  %02X : %5.1f%% (%u), %5.1f%%, %5.1f%%\n", (unsigned int)bank, percent(code, PRG_BANK_SIZE),
+                     opcodes, percent(data, PRG_BANK_SIZE), percent(unused, PRG_BANK_SIZE));
+    }
+    if(chr.empty()) return;
+    // by 4kb, the size of a pattern table
+    std::fprintf(f, "CHR ROM 4kb bank : background, sprites, read by the CPU, unused\n");
+    for(size_t bank = 0; bank * 0x1000 < chr.size(); bank++) {
+        unsigned int bg = 0, sprite = 0, read = 0, unused = 0;
+        for(size_t i = bank * 0x1000; i < (bank + 1) * 0x1000 && i < chr.size(); i++) {
+            if(chr[i] & CDL_CHR_BACKGROUND) bg++;
+            if(chr[i] & CDL_CHR_SPRITE) sprite++;
+            if(chr[i] & CDL_CHR_READ) read++;
+            if(!(chr[i] & (CDL_CHR_RENDERED | CDL_CHR_READ))) unused++;
+        }
+        std::fprintf(f, "  %02X : %5.1f%%, %5.1f%%, %5.1f%%, %5.1f%%\n", (unsigned int)bank, percent(bg, 0x1000),
+                     percent(sprite, 0x1000), percent(read, 0x1000), percent(unused, 0x1000));
+    }
+}
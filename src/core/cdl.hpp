@@ -0,0 +1,90 @@
+#ifndef GAYA_CDL_HPP
+#define GAYA_CDL_HPP
+
+#include <cstdio>
+#include <vector>
+#include "types.hpp"
+#include "mem.hpp"
+
+struct PPU_state;
+
+// flags of the PRG ROM bytes in the .cdl files (FCEUX format)
+#define CDL_PRG_CODE            0x01
+#define CDL_PRG_DATA            0x02
+// bits 2-3 : the 8kb slot the byte was last accessed in ($8000, $A000, $C000, $E000)
+#define CDL_PRG_SLOT_MASK       0x0C
+#define CDL_PRG_INDIRECT_CODE   0x10 // reached by JMP (ind)
+#define CDL_PRG_INDIRECT_DATA   0x20 // read by (zp,X) or (zp),Y
+// ... and of the CHR ROM bytes
+#define CDL_CHR_RENDERED        0x01
+#define CDL_CHR_READ            0x02 // through $2007
+// kept in memory, but not in the files : the readers of .cdl files expect them clear
+#define CDL_PRG_OPCODE          0x80
+#define CDL_CHR_BACKGROUND      0x40
+#define CDL_CHR_SPRITE          0x80
+
+/*
+Code/data logger : one byte of flags per byte of PRG ROM and CHR ROM, or-ed with
+how it was used. The files are the flags of the PRG ROM followed by the ones of
+the CHR ROM, as FCEUX writes them, so its tools (and the disassemblers reading
+them) can be used.
+
+The CPU side is a trace policy of run_cycles (see cpu6502::execute_cycles_cdl) :
+the instruction bytes are code, and the PRG ROM bytes its addressing mode reads are
+data. The CHR side is between the renderer and the mapper (see PPU_mem::read_bg_pt),
+and only while logging. Banks are found with get_prg_bank() and get_chr_bank() of
+the mapper, so the offsets are the ones in the ROM whatever is mapped.
+*/
+class CodeDataLogger
+{
+public:
+    CodeDataLogger(unsigned int prg_size, unsigned int chr_size);
+
+    /* The CHR fetches of the renderer go through the logger until detach(), it must
+    be called again when the memory objects change (save states) */
+    void                        attach(ROMMemManager *rom, PPU_mem *ppu_m, PPU_state *ppu_s, const UINT8 *ram);
+    void                        detach(PPU_mem *ppu_m);
+
+    // before the instruction at pc is executed
+    void                        instruction(MEMADDR pc, UINT8 op, UINT16 operand, UINT8 X, UINT8 Y);
+
+    // ors the flags of a previous run, returns -1 when the file is not for this ROM
+    int                         load(FILE *f);
+    void                        save(FILE *f);
+    // per bank : how many bytes are code, data, or not used yet
+    void                        print_summary(FILE *f);
+
+private:
+    std::vector<UINT8>          prg, chr;
+    ROMMemManager               *rom;
+    PPU_state                   *ppu_state;
+    const UINT8                 *cpu_ram;
+    BOOL                        after_indirect_jump;
+
+    // marks the PRG ROM byte at a, when it is in PRG ROM
+    void                        mark_prg(MEMADDR a, UINT8 flags) {
+        int bank = rom->get_prg_bank(a);
+        if(bank < 0) return;
+        size_t off = (size_t)bank * PRG_BANK_SIZE + (a & (PRG_BANK_SIZE - 1));
+        if(off < prg.size()) prg[off] |= flags | ((a >> 11) & CDL_PRG_SLOT_MASK);
+    };
+    void                        mark_chr(MEMADDR a, UINT8 flags) {
+        int bank = rom->get_chr_bank(a);
+        if(bank < 0) return;
+        size_t off = (size_t)bank * CHR_BANK_SIZE + (a & (CHR_BANK_SIZE - 1));
+        if(off < chr.size()) chr[off] |= flags;
+    };
+
+    // the pattern tables, as the renderer reads them
+    struct ChrLog : public PatternReader {
+        CodeDataLogger  *cdl;
+        UINT8           flags;
+        UINT8           read_pt(MEMADDR a) {
+            cdl->mark_chr(a, flags);
+            return cdl->rom->read_pt(a);
+        };
+    };
+    ChrLog                      background, sprites;
+};
+
+#endif
@@ -1,7 +1,17 @@
 #include <sstream>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include "cpu.hpp"
+#include "mappers/mapper_resolve.hpp"
+#include "cpu_opcodes.hpp"
+#include "trace.hpp"
+#include "profiler.hpp"
+#include "breakpoints.hpp"
+#include "cdl.hpp"
+#ifdef GAYA_CPU_TESTS
+#include "cpu_test_memory.hpp"
+#endif
 
 /* ================ DIFFERENT ADDRESSING MODES ================= */
 
@@ -13,28 +23,36 @@ Page boundary crossed :
 */
 
 // yay I know pretty useless
-MEMADDR  cpu6502::addr_absolute(MEMADDR addr) 
+template<class MEM>
+MEMADDR  cpu6502T<MEM>::addr_absolute(MEMADDR addr) 
 {
     return addr;
 }
 
-cpu6502::addrmem_res  cpu6502::addr_absolute_x(MEMADDR addr) {
+template<class MEM>
+cpu6502::addrmem_res  cpu6502T<MEM>::addr_absolute_x(MEMADDR addr) {
     struct addrmem_res res;
     UINT16 page = addr & 0xFF00;
     UINT16 new_addr = addr + (UINT16) regs.X;
     res.val = new_addr; res.nr_cycles = !(page == (new_addr & 0xFF00));
+    // read in the page of addr first
+    if(res.nr_cycles) dummy_read(page | (new_addr & 0x00FF));
     return res;
 }
 
-cpu6502::addrmem_res  cpu6502::addr_absolute_y(MEMADDR addr) {
+template<class MEM>
+cpu6502::addrmem_res  cpu6502T<MEM>::addr_absolute_y(MEMADDR addr) {
     struct addrmem_res res;
     UINT16 page = addr & 0xFF00;
     UINT16 new_addr = addr + (UINT16) regs.Y;
     res.val = new_addr; res.nr_cycles = !(page == (new_addr & 0xFF00));
+    // read in the page of addr first
+    if(res.nr_cycles) dummy_read(page | (new_addr & 0x00FF));
     return res;
 }
 
-MEMADDR  cpu6502::addr_absolute_indirect(MEMADDR addr) {
+template<class MEM>
+MEMADDR  cpu6502T<MEM>::addr_absolute_indirect(MEMADDR addr) {
     MEMADDR resaddr = read_mem(addr); // we load the low byte at addr
     // then we have to do this to emulate the wrap around done 
     // when the addr is the last of a page
@@ -46,21 +64,27 @@ MEMADDR  cpu6502::addr_absolute_indirect(MEMADDR addr) {
     return resaddr | (((UINT16)high_byte) << 8);
 }
 
-MEMADDR cpu6502::addr_zp(ZPADDR addr) {
+template<class MEM>
+MEMADDR cpu6502T<MEM>::addr_zp(ZPADDR addr) {
     return (UINT16)addr;
 }
 
-MEMADDR cpu6502::addr_zp_x(ZPADDR addr) {
+template<class MEM>
+MEMADDR cpu6502T<MEM>::addr_zp_x(ZPADDR addr) {
     UINT8 new_addr = addr + regs.X; // the fact that it can result in an "overflow" on the byte is intended
+    tick(); // reads addr while adding X
     return (MEMADDR)new_addr;
 }
 
-MEMADDR cpu6502::addr_zp_y(ZPADDR addr) {
+template<class MEM>
+MEMADDR cpu6502T<MEM>::addr_zp_y(ZPADDR addr) {
     UINT8 new_addr = addr + regs.Y; // the fact that it can result in an "overflow" on the byte is intended
+    tick();
     return (MEMADDR)new_addr;
 }
 
-cpu6502::addrmem_res cpu6502::addr_indirect_y(ZPADDR addr){
+template<class MEM>
+cpu6502::addrmem_res cpu6502T<MEM>::addr_indirect_y(ZPADDR addr){
     struct addrmem_res res;
     ZPADDR addr_next = addr+1;
     MEMADDR new_addr = (MEMADDR) read_mem((MEMADDR)addr); // we load the low byte
@@ -68,20 +92,24 @@ cpu6502::addrmem_res cpu6502::addr_indirect_y(ZPADDR addr){
     UINT16 page = new_addr & 0xFF00; 
     MEMADDR final_addr = new_addr + regs.Y;
     res.val = final_addr; res.nr_cycles = !(page == (final_addr & 0xFF00));
+    if(res.nr_cycles) dummy_read(page | (final_addr & 0x00FF));
 
     //std::printf("Y: 0x%02X, offset: 0x%02X, new_addr: 0x%04X, final_addr: 0x%04X, res: 0x%02X, cycles: %d\n", regs.Y, addr, new_addr, final_addr, res.val, res.nr_cycles);
     return res;
 }
 
-MEMADDR cpu6502::addr_x_indirect(ZPADDR addr) {
+template<class MEM>
+MEMADDR cpu6502T<MEM>::addr_x_indirect(ZPADDR addr) {
     ZPADDR new_addr = addr + regs.X;
+    tick();
     ZPADDR new_addr_next = new_addr+1;
     MEMADDR final_addr = (MEMADDR)read_mem(new_addr);
     final_addr |= ((UINT16)read_mem(new_addr_next)) << 8;
     return final_addr;
 }
 
-MEMADDR cpu6502::addr_y_indirect(ZPADDR addr) {
+template<class MEM>
+MEMADDR cpu6502T<MEM>::addr_y_indirect(ZPADDR addr) {
     ZPADDR new_addr = addr + regs.Y;
     ZPADDR new_addr_next = new_addr+1;
     MEMADDR final_addr = (MEMADDR)read_mem(new_addr);
@@ -92,31 +120,29 @@ MEMADDR cpu6502::addr_y_indirect(ZPADDR addr) {
 /* ===================== UTILITIES ========================== */
 
 void cpu6502::setNZflags(UINT8 n) {
+#ifdef GAYA_LAZY_FLAGS
+    nz_result = n;
+#else
     flags.Z = !n;
     flags.N = flagNtable[n];
+#endif
 }
 
 static MEMADDR two_bytes_into_addr(UINT8 low, UINT8 high) {
     return ((MEMADDR) low) | (((MEMADDR) high) << 8);
 }
 
-MEMADDR cpu6502::fetch_addr_from_pc() {
-    UINT8 low = fetch_from_pc();
-    UINT8 high = fetch_from_pc();
-    return two_bytes_into_addr(low, high);
-}
-
 UINT8 flags_to_byte(cpu6502::cpu6502flags f, UINT8 bit4) {
     UINT8 b = 0;
     if(f.C) b |= 0x01;
     if(f.Z) b |= 0x02;
     if(f.I) b |= 0x04;
     if(f.D) b |= 0x08;
-    if(bit4) b |= 0x01;
+    if(bit4) b |= 0x10; // B, only in the copies pushed by PHP and BRK
     b |= 0x20;
     if(f.V) b |= 0x40;
     if(f.N) b |= 0x80;
-    return b; // apparently, we put the 2 useless bits to 1 ?
+    return b;
 }
 
 static cpu6502::cpu6502flags byte_to_flags(UINT8 b) {
@@ -137,8 +163,12 @@ cpu6502::cpu6502savestate cpu6502::get_state() {
     s.cycles = elapsed_cycles;
     s.return_on_ppu = return_on_ppu_op;
     s.skip_next_op = skip_next_op_ppu;
+    s.irq_lines = irq_lines;
+    s.nmi_pending = nmi_pending;
+    s.nmi_deadline = nmi_deadline;
+    s.irq_deadline = irq_deadline;
     s.regs = regs;
-    s.flags = flags;
+    s.flags = get_cpu_flags();
     return s;
 }
 
@@ -146,8 +176,17 @@ void cpu6502::restore_state(cpu6502savestate s) {
     elapsed_cycles = s.cycles;
     return_on_ppu_op = s.return_on_ppu;
     skip_next_op_ppu = s.skip_next_op;
+    irq_lines = s.irq_lines;
+    nmi_pending = s.nmi_pending;
+    nmi_deadline = s.nmi_deadline;
+    irq_deadline = s.irq_deadline;
     regs = s.regs;
-    flags = s.flags;
+    set_flags(s.flags);
+#ifdef GAYA_CYCLE_EXACT
+    sync_rewind = 0;
+#endif
+    invalidate_code_page();
+    update_interrupt_deadline();
 }
 
 /* ================== OPCODES HANDLING ====================== */
@@ -155,118 +194,139 @@ void cpu6502::restore_state(cpu6502savestate s) {
 
 // ---------- FLAG HANDLING
 
-UINT8 cpu6502::CLC() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::CLC() {
     flags.C = 0;
     return 2;
 }
 
-UINT8 cpu6502::CLI() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::CLI() {
     flags.I = 0;
+    if(irq_lines) update_interrupt_deadline();
     return 2;
 }
 
-UINT8 cpu6502::CLD() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::CLD() {
     flags.D = 0; // not used anyway
     return 2;
 }
 
-UINT8 cpu6502::CLV() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::CLV() {
     flags.V = 0;
     return 2;
 }
 
-UINT8 cpu6502::SEC() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::SEC() {
     flags.C = 1;
     return 2;
 }
 
-UINT8 cpu6502::SEI() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::SEI() {
     flags.I = 1;
     return 2;
 }
 
-UINT8 cpu6502::SED() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::SED() {
     flags.D = 1;
     return 2;
 }
 
 // ----------- TRANSFER BETWEEN REGS
 
-UINT8 cpu6502::TAX() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::TAX() {
     regs.X = regs.A;
     setNZflags(regs.X);
     return 2;
 }
 
-UINT8 cpu6502::TXA() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::TXA() {
     regs.A = regs.X;
     setNZflags(regs.A);
     return 2;
 }
 
-UINT8 cpu6502::TAY() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::TAY() {
     regs.Y = regs.A;
     setNZflags(regs.Y);
     return 2;
 }
 
-UINT8 cpu6502::TYA() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::TYA() {
     regs.A = regs.Y;
     setNZflags(regs.A);
     return 2;
 }
 
-UINT8 cpu6502::INX() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::INX() {
     setNZflags(++regs.X);
     return 2;
 }
 
-UINT8 cpu6502::DEX() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::DEX() {
     setNZflags(--regs.X);
     return 2;
 }
 
-UINT8 cpu6502::INY() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::INY() {
     setNZflags(++regs.Y);
     return 2;
 }
 
-UINT8 cpu6502::DEY() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::DEY() {
     setNZflags(--regs.Y);
     return 2;
 }
 
 // ---------------- NOP INSTR
 
-UINT8 cpu6502::NOP() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::NOP() {
     return 2;
 }
 
-UINT8 cpu6502::DOP_i() {
-    fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::DOP_i() {
     return 2;
 }
 
-UINT8 cpu6502::DOP_d() {
-    fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::DOP_d() {
+    dummy_read(operand);
     return 3;
 }
 
-UINT8 cpu6502::NOP_dx() {
-    fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::NOP_dx() {
+    dummy_read(addr_zp_x(operand));
     return 4;
 }
 
-UINT8 cpu6502::TOP_a() {
-    fetch_from_pc();
-    fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::TOP_a() {
+    dummy_read(operand);
     return 4;
 }
 
-UINT8 cpu6502::NOP_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::NOP_ax() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_x(a);
+    dummy_read(res.val);
     return 4 + res.nr_cycles;
 }
 
@@ -275,61 +335,69 @@ UINT8 cpu6502::NOP_ax() {
 // A
 // ----
 
-UINT8 cpu6502::LDA_i() {
-    regs.A = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDA_i() {
+    regs.A = operand;
     setNZflags(regs.A);
     return 2;
 }
 
-UINT8 cpu6502::LDA_d() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDA_d() {
+    ZPADDR zp = operand;
     regs.A = read_mem((MEMADDR) zp); // we don't really need addr_zp...
     setNZflags(regs.A);
     return 3;
 }
 
-UINT8 cpu6502::LDA_dx() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDA_dx() {
+    ZPADDR zp = operand;
     regs.A = read_mem(addr_zp_x(zp));
     setNZflags(regs.A);
     return 4;
 }
 
-UINT8 cpu6502::LDA_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDA_a() {
+    MEMADDR a = operand;
     regs.A = read_mem(a);
     setNZflags(regs.A);
     return 4;
 }
 
-UINT8 cpu6502::LDA_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDA_ax() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_x(a);
     regs.A = read_mem(res.val);
     setNZflags(regs.A);
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::LDA_ay() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDA_ay() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_y(a);
     regs.A = read_mem(res.val);
     setNZflags(regs.A);
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::LDA_xb() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDA_xb() {
+    ZPADDR zp = operand;
     regs.A = read_mem(addr_x_indirect(zp));
     setNZflags(regs.A);
     return 6;
 }
 
-UINT8 cpu6502::LDA_by() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDA_by() {
     struct addrmem_res res;
-    ZPADDR zp = fetch_from_pc();
+    ZPADDR zp = operand;
     res = addr_indirect_y(zp);
     regs.A = read_mem(res.val);
     setNZflags(regs.A);
@@ -339,36 +407,41 @@ UINT8 cpu6502::LDA_by() {
 // X
 // ---
 
-UINT8 cpu6502::LDX_i() {
-    regs.X = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDX_i() {
+    regs.X = operand;
     setNZflags(regs.X);
     return 2;
 }
 
-UINT8 cpu6502::LDX_d() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDX_d() {
+    ZPADDR zp = operand;
     regs.X = read_mem((MEMADDR) zp); // we don't really need addr_zp...
     setNZflags(regs.X);
     return 3;
 }
 
-UINT8 cpu6502::LDX_dy() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDX_dy() {
+    ZPADDR zp = operand;
     regs.X = read_mem(addr_zp_y(zp));
     setNZflags(regs.X);
     return 4;
 }
 
-UINT8 cpu6502::LDX_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDX_a() {
+    MEMADDR a = operand;
     regs.X = read_mem(a);
     setNZflags(regs.X);
     return 4;
 }
 
-UINT8 cpu6502::LDX_ay() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDX_ay() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_y(a);
     regs.X = read_mem(res.val);
     setNZflags(regs.X);
@@ -378,36 +451,41 @@ UINT8 cpu6502::LDX_ay() {
 // Y
 // ---
 
-UINT8 cpu6502::LDY_i() {
-    regs.Y = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDY_i() {
+    regs.Y = operand;
     setNZflags(regs.Y);
     return 2;
 }
 
-UINT8 cpu6502::LDY_d() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDY_d() {
+    ZPADDR zp = operand;
     regs.Y = read_mem((MEMADDR) zp); // we don't really need addr_zp...
     setNZflags(regs.Y);
     return 3;
 }
 
-UINT8 cpu6502::LDY_dx() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDY_dx() {
+    ZPADDR zp = operand;
     regs.Y = read_mem(addr_zp_x(zp));
     setNZflags(regs.Y);
     return 4;
 }
 
-UINT8 cpu6502::LDY_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDY_a() {
+    MEMADDR a = operand;
     regs.Y = read_mem(a);
     setNZflags(regs.Y);
     return 4;
 }
 
-UINT8 cpu6502::LDY_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::LDY_ax() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_x(a);
     regs.Y = read_mem(res.val);
     setNZflags(regs.Y);
@@ -419,53 +497,63 @@ UINT8 cpu6502::LDY_ax() {
 // A
 // ---
 
-UINT8 cpu6502::STA_d() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::STA_d() {
+    ZPADDR zp = operand;
     write_mem((MEMADDR) zp, regs.A);
     return 3;
 }
 
-UINT8 cpu6502::STA_dx() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::STA_dx() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_zp_x(zp);
     //std::printf("STA_dx PC=0x%04X addr=0x%04X A=0x%02X X=0x%02X, C=%d\n", regs.PC, a, regs.A, regs.X, !!(flags.C));
     write_mem(a, regs.A);
     return 4;
 }
 
-UINT8 cpu6502::STA_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::STA_a() {
+    MEMADDR a = operand;
     write_mem(a, regs.A);
     return 4;
 }
 
-UINT8 cpu6502::STA_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::STA_ax() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_x(a);
+    fixed_dummy_read(res);
     write_mem(res.val, regs.A);
     return 5; // no additional cycle, apparently
 }
 
-UINT8 cpu6502::STA_ay() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::STA_ay() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_y(a);
+    fixed_dummy_read(res);
     write_mem(res.val, regs.A);
     return 5; // idem
 }
 
-UINT8 cpu6502::STA_xb() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::STA_xb() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_x_indirect(zp);
     write_mem(a, regs.A);
     return 6;
 }
 
-UINT8 cpu6502::STA_by() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::STA_by() {
     struct addrmem_res res;
-    ZPADDR zp = fetch_from_pc();
+    ZPADDR zp = operand;
     res = addr_indirect_y(zp);
+    fixed_dummy_read(res);
     write_mem(res.val, regs.A);
     return 6; // no additional cycle
 }
@@ -473,21 +561,24 @@ UINT8 cpu6502::STA_by() {
 // X
 // ---
 
-UINT8 cpu6502::STX_d() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::STX_d() {
+    ZPADDR zp = operand;
     write_mem((MEMADDR) zp, regs.X);
     return 3;
 }
 
-UINT8 cpu6502::STX_dy() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::STX_dy() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_zp_y(zp);
     write_mem(a, regs.X);
     return 4;
 }
 
-UINT8 cpu6502::STX_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::STX_a() {
+    MEMADDR a = operand;
     write_mem(a, regs.X);
     return 4;
 }
@@ -495,21 +586,24 @@ UINT8 cpu6502::STX_a() {
 // Y
 // ---
 
-UINT8 cpu6502::STY_d() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::STY_d() {
+    ZPADDR zp = operand;
     write_mem((MEMADDR) zp, regs.Y);
     return 3;
 }
 
-UINT8 cpu6502::STY_dx() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::STY_dx() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_zp_x(zp);
     write_mem(a, regs.Y);
     return 4;
 }
 
-UINT8 cpu6502::STY_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::STY_a() {
+    MEMADDR a = operand;
     write_mem(a, regs.Y);
     return 4;
 }
@@ -519,36 +613,45 @@ UINT8 cpu6502::STY_a() {
 // dec
 // ---
 
-UINT8 cpu6502::DEC_d() {
-    MEMADDR zp = (MEMADDR) fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::DEC_d() {
+    MEMADDR zp = (MEMADDR) operand;
     UINT8 val = read_mem(zp);
+    dummy_write(zp, val);
     write_mem(zp, --val);
     setNZflags(val);
     return 5;
 }
 
-UINT8 cpu6502::DEC_dx() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::DEC_dx() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_zp_x(zp);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, --val);
     setNZflags(val);
     return 6;
 }
 
-UINT8 cpu6502::DEC_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::DEC_a() {
+    MEMADDR a = operand;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, --val);
     setNZflags(val);
     return 6;
 }
 
-UINT8 cpu6502::DEC_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::DEC_ax() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_x(a);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, --val);
     setNZflags(val);
     return 7; // no additional cycle
@@ -557,46 +660,45 @@ UINT8 cpu6502::DEC_ax() {
 // inc
 // ---
 
-UINT8 cpu6502::INC_d() {
-    MEMADDR zp = (MEMADDR) fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::INC_d() {
+    MEMADDR zp = (MEMADDR) operand;
     UINT8 val = read_mem(zp);
+    dummy_write(zp, val);
     write_mem(zp, ++val);
     setNZflags(val);
     return 5;
 }
 
-UINT8 cpu6502::INC_dx() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::INC_dx() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_zp_x(zp);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, ++val);
     setNZflags(val);
     return 6;
 }
 
-UINT8 cpu6502::INC_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::INC_a() {
+    MEMADDR a = operand;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, ++val);
     setNZflags(val);
     return 6;
 }
 
-UINT8 cpu6502::INC_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::INC_ax() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_x(a);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
-    write_mem(res.val, ++val);
-    setNZflags(val);
-    return 7; // no additional cycle
-}
-
-UINT8 cpu6502::INC_ay() {
-    struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
-    res = addr_absolute_y(a);
-    UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, ++val);
     setNZflags(val);
     return 7; // no additional cycle
@@ -607,64 +709,72 @@ UINT8 cpu6502::INC_ay() {
 // AND
 // ---
 
-UINT8 cpu6502::AND_i() {
-    UINT8 op = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::AND_i() {
+    UINT8 op = operand;
     regs.A &= op;
     setNZflags(regs.A);
     return 2;
 }
 
-UINT8 cpu6502::AND_d() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::AND_d() {
+    ZPADDR zp = operand;
     regs.A &= read_mem((MEMADDR) zp);
     setNZflags(regs.A);
     return 3;
 }
 
-UINT8 cpu6502::AND_dx() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::AND_dx() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_zp_x(zp);
     regs.A &= read_mem(a);
     setNZflags(regs.A);
     return 4;
 }
 
-UINT8 cpu6502::AND_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::AND_a() {
+    MEMADDR a = operand;
     regs.A &= read_mem(a);
     setNZflags(regs.A);
     return 4;
 }
 
-UINT8 cpu6502::AND_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::AND_ax() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_x(a);
     regs.A &= read_mem(res.val);
     setNZflags(regs.A);
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::AND_ay() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::AND_ay() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_y(a);
     regs.A &= read_mem(res.val);
     setNZflags(regs.A);
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::AND_xb() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::AND_xb() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_x_indirect(zp);
     regs.A &= read_mem(a);
     setNZflags(regs.A);
     return 6;
 }
 
-UINT8 cpu6502::AND_by() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::AND_by() {
     struct addrmem_res res;
-    ZPADDR zp = fetch_from_pc();
+    ZPADDR zp = operand;
     res = addr_indirect_y(zp);
     regs.A &= read_mem(res.val);
     setNZflags(regs.A);
@@ -674,64 +784,72 @@ UINT8 cpu6502::AND_by() {
 // ORA
 // ---
 
-UINT8 cpu6502::ORA_i() {
-    UINT8 op = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ORA_i() {
+    UINT8 op = operand;
     regs.A |= op;
     setNZflags(regs.A);
     return 2;
 }
 
-UINT8 cpu6502::ORA_d() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ORA_d() {
+    ZPADDR zp = operand;
     regs.A |= read_mem((MEMADDR) zp);
     setNZflags(regs.A);
     return 3;
 }
 
-UINT8 cpu6502::ORA_dx() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ORA_dx() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_zp_x(zp);
     regs.A |= read_mem(a);
     setNZflags(regs.A);
     return 4;
 }
 
-UINT8 cpu6502::ORA_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ORA_a() {
+    MEMADDR a = operand;
     regs.A |= read_mem(a);
     setNZflags(regs.A);
     return 4;
 }
 
-UINT8 cpu6502::ORA_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::ORA_ax() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_x(a);
     regs.A |= read_mem(res.val);
     setNZflags(regs.A);
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::ORA_ay() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::ORA_ay() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_y(a);
     regs.A |= read_mem(res.val);
     setNZflags(regs.A);
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::ORA_xb() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ORA_xb() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_x_indirect(zp);
     regs.A |= read_mem(a);
     setNZflags(regs.A);
     return 6;
 }
 
-UINT8 cpu6502::ORA_by() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::ORA_by() {
     struct addrmem_res res;
-    ZPADDR zp = fetch_from_pc();
+    ZPADDR zp = operand;
     res = addr_indirect_y(zp);
     regs.A |= read_mem(res.val);
     setNZflags(regs.A);
@@ -741,64 +859,72 @@ UINT8 cpu6502::ORA_by() {
 // EOR
 // ---
 
-UINT8 cpu6502::EOR_i() {
-    UINT8 op = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::EOR_i() {
+    UINT8 op = operand;
     regs.A ^= op;
     setNZflags(regs.A);
     return 2;
 }
 
-UINT8 cpu6502::EOR_d() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::EOR_d() {
+    ZPADDR zp = operand;
     regs.A ^= read_mem((MEMADDR) zp);
     setNZflags(regs.A);
     return 3;
 }
 
-UINT8 cpu6502::EOR_dx() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::EOR_dx() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_zp_x(zp);
     regs.A ^= read_mem(a);
     setNZflags(regs.A);
     return 4;
 }
 
-UINT8 cpu6502::EOR_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::EOR_a() {
+    MEMADDR a = operand;
     regs.A ^= read_mem(a);
     setNZflags(regs.A);
     return 4;
 }
 
-UINT8 cpu6502::EOR_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::EOR_ax() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_x(a);
     regs.A ^= read_mem(res.val);
     setNZflags(regs.A);
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::EOR_ay() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::EOR_ay() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_y(a);
     regs.A ^= read_mem(res.val);
     setNZflags(regs.A);
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::EOR_xb() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::EOR_xb() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_x_indirect(zp);
     regs.A ^= read_mem(a);
     setNZflags(regs.A);
     return 6;
 }
 
-UINT8 cpu6502::EOR_by() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::EOR_by() {
     struct addrmem_res res;
-    ZPADDR zp = fetch_from_pc();
+    ZPADDR zp = operand;
     res = addr_indirect_y(zp);
     regs.A ^= read_mem(res.val);
     setNZflags(regs.A);
@@ -807,37 +933,45 @@ UINT8 cpu6502::EOR_by() {
 
 // ----------------------- STACK OPS
 
-UINT8 cpu6502::TXS() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::TXS() {
     regs.S = regs.X;
     return 2;
 }
 
-UINT8 cpu6502::TSX() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::TSX() {
     regs.X = regs.S;
     setNZflags(regs.X);
     return 2;
 }
 
-UINT8 cpu6502::PHA() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::PHA() {
     push_stack(regs.A);
     return 3;
 }
 
-UINT8 cpu6502::PLA() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::PLA() {
+    tick(); // reads the stack before incrementing S
     regs.A = pop_stack();
     setNZflags(regs.A);
     return 4;
 }
 
-UINT8 cpu6502::PHP() {
-    UINT8 flags_b = flags_to_byte(flags, 1);
+template<class MEM>
+UINT8 cpu6502T<MEM>::PHP() {
+    UINT8 flags_b = flags_to_byte(get_cpu_flags(), 1);
     push_stack(flags_b);
     return 3;
 }
 
-UINT8 cpu6502::PLP() {
-    flags = byte_to_flags(pop_stack());
-    flags.I = 1;
+template<class MEM>
+UINT8 cpu6502T<MEM>::PLP() {
+    tick();
+    set_flags(byte_to_flags(pop_stack()));
+    if(irq_lines) update_interrupt_deadline();
     return 4;
 }
 
@@ -846,17 +980,20 @@ UINT8 cpu6502::PLP() {
 // ASL
 // ---
 
-UINT8 cpu6502::ASL() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::ASL() {
     flags.C = regs.A & 0x80;
     regs.A <<= 1;
     setNZflags(regs.A);
     return 2;
 }
 
-UINT8 cpu6502::ASL_d() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ASL_d() {
+    ZPADDR zp = operand;
     MEMADDR a = (MEMADDR) zp;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     flags.C = val & 0x80;
     val <<= 1;
     setNZflags(val);
@@ -864,10 +1001,12 @@ UINT8 cpu6502::ASL_d() {
     return 5;
 }
 
-UINT8 cpu6502::ASL_dx() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ASL_dx() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_zp_x(zp);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     flags.C = val & 0x80;
     val <<= 1;
     setNZflags(val);
@@ -875,9 +1014,11 @@ UINT8 cpu6502::ASL_dx() {
     return 6;
 }
 
-UINT8 cpu6502::ASL_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ASL_a() {
+    MEMADDR a = operand;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     flags.C = val & 0x80;
     val <<= 1;
     setNZflags(val);
@@ -885,11 +1026,14 @@ UINT8 cpu6502::ASL_a() {
     return 6;
 }
 
-UINT8 cpu6502::ASL_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::ASL_ax() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_x(a);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     flags.C = val & 0x80;
     val <<= 1;
     setNZflags(val);
@@ -900,17 +1044,20 @@ UINT8 cpu6502::ASL_ax() {
 // LSR
 // ---
 
-UINT8 cpu6502::LSR() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::LSR() {
     flags.C = regs.A & 0x01;
     regs.A >>= 1;
     setNZflags(regs.A);
     return 2;
 }
 
-UINT8 cpu6502::LSR_d() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LSR_d() {
+    ZPADDR zp = operand;
     MEMADDR a = (MEMADDR) zp;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     flags.C = val & 0x01;
     val >>= 1;
     setNZflags(val);
@@ -918,10 +1065,12 @@ UINT8 cpu6502::LSR_d() {
     return 5;
 }
 
-UINT8 cpu6502::LSR_dx() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LSR_dx() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_zp_x(zp);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     flags.C = val & 0x01;
     val >>= 1;
     setNZflags(val);
@@ -929,9 +1078,11 @@ UINT8 cpu6502::LSR_dx() {
     return 6;
 }
 
-UINT8 cpu6502::LSR_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LSR_a() {
+    MEMADDR a = operand;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     flags.C = val & 0x01;
     val >>= 1;
     setNZflags(val);
@@ -939,11 +1090,14 @@ UINT8 cpu6502::LSR_a() {
     return 6;
 }
 
-UINT8 cpu6502::LSR_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::LSR_ax() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_x(a);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     flags.C = val & 0x01;
     val >>= 1;
     setNZflags(val);
@@ -954,7 +1108,8 @@ UINT8 cpu6502::LSR_ax() {
 // ROR
 // ---
 
-UINT8 cpu6502::ROR() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::ROR() {
     BOOL c = flags.C;
     flags.C = regs.A & 0x01;
     regs.A >>= 1;
@@ -963,10 +1118,12 @@ UINT8 cpu6502::ROR() {
     return 2;
 }
 
-UINT8 cpu6502::ROR_d() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ROR_d() {
+    ZPADDR zp = operand;
     MEMADDR a = (MEMADDR) zp;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     BOOL c = flags.C;
     flags.C = val & 0x01;
     val >>= 1;
@@ -976,10 +1133,12 @@ UINT8 cpu6502::ROR_d() {
     return 5;
 }
 
-UINT8 cpu6502::ROR_dx() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ROR_dx() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_zp_x(zp);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     BOOL c = flags.C;
     flags.C = val & 0x01;
     val >>= 1;
@@ -989,9 +1148,11 @@ UINT8 cpu6502::ROR_dx() {
     return 6;
 }
 
-UINT8 cpu6502::ROR_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ROR_a() {
+    MEMADDR a = operand;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     BOOL c = flags.C;
     flags.C = val & 0x01;
     val >>= 1;
@@ -1001,11 +1162,14 @@ UINT8 cpu6502::ROR_a() {
     return 6;
 }
 
-UINT8 cpu6502::ROR_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::ROR_ax() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_x(a);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     BOOL c = flags.C;
     flags.C = val & 0x01;
     val >>= 1;
@@ -1018,7 +1182,8 @@ UINT8 cpu6502::ROR_ax() {
 // ROL
 // ---
 
-UINT8 cpu6502::ROL() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::ROL() {
     BOOL c = flags.C;
     flags.C = regs.A & 0x80;
     regs.A <<= 1;
@@ -1027,10 +1192,12 @@ UINT8 cpu6502::ROL() {
     return 2;
 }
 
-UINT8 cpu6502::ROL_d() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ROL_d() {
+    ZPADDR zp = operand;
     MEMADDR a = (MEMADDR) zp;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     BOOL c = flags.C;
     flags.C = val & 0x80;
     val <<= 1;
@@ -1040,10 +1207,12 @@ UINT8 cpu6502::ROL_d() {
     return 5;
 }
 
-UINT8 cpu6502::ROL_dx() {
-    ZPADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ROL_dx() {
+    ZPADDR zp = operand;
     MEMADDR a = addr_zp_x(zp);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     BOOL c = flags.C;
     flags.C = val & 0x80;
     val <<= 1;
@@ -1053,9 +1222,11 @@ UINT8 cpu6502::ROL_dx() {
     return 6;
 }
 
-UINT8 cpu6502::ROL_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ROL_a() {
+    MEMADDR a = operand;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     BOOL c = flags.C;
     flags.C = val & 0x80;
     val <<= 1;
@@ -1065,11 +1236,14 @@ UINT8 cpu6502::ROL_a() {
     return 6;
 }
 
-UINT8 cpu6502::ROL_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::ROL_ax() {
     struct addrmem_res res;
-    MEMADDR a = fetch_addr_from_pc();
+    MEMADDR a = operand;
     res = addr_absolute_x(a);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     BOOL c = flags.C;
     flags.C = val & 0x80;
     val <<= 1;
@@ -1081,21 +1255,17 @@ UINT8 cpu6502::ROL_ax() {
 
 // ------------ BIT OP
 
-UINT8 cpu6502::BIT_d() {
-    ZPADDR zp = fetch_from_pc();
-    UINT8 val = read_mem((MEMADDR) zp);
-    flags.Z = !(regs.A & val);
-    flags.N = val & 0x80;
-    flags.V = val & 0x40;
+template<class MEM>
+UINT8 cpu6502T<MEM>::BIT_d() {
+    ZPADDR zp = operand;
+    doBIT(read_mem((MEMADDR) zp));
     return 3;
 }
 
-UINT8 cpu6502::BIT_a() {
-    MEMADDR a = fetch_addr_from_pc();
-    UINT8 val = read_mem(a);
-    flags.Z = !(regs.A & val);
-    flags.N = val & 0x80;
-    flags.V = val & 0x40;
+template<class MEM>
+UINT8 cpu6502T<MEM>::BIT_a() {
+    MEMADDR a = operand;
+    doBIT(read_mem(a));
     return 4;
 }
 
@@ -1123,52 +1293,60 @@ UINT8 cpu6502::doADC(UINT8 n) {
     return res;
 }
 
-UINT8 cpu6502::ADC_i() {
-    regs.A = doADC(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::ADC_i() {
+    regs.A = doADC(operand);
     return 2;
 }
 
-UINT8 cpu6502::ADC_d() {
-    UINT8 val = read_mem((MEMADDR) fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::ADC_d() {
+    UINT8 val = read_mem((MEMADDR) operand);
     regs.A = doADC(val);
     return 3;
 }
 
-UINT8 cpu6502::ADC_dx() {
-    MEMADDR a = addr_zp_x(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::ADC_dx() {
+    MEMADDR a = addr_zp_x(operand);
     regs.A = doADC(read_mem(a));
     return 4;
 }
 
-UINT8 cpu6502::ADC_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ADC_a() {
+    MEMADDR a = operand;
     regs.A = doADC(read_mem(a));
     return 4;
 }
 
-UINT8 cpu6502::ADC_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::ADC_ax() {
     struct addrmem_res res;
-    res = addr_absolute_x(fetch_addr_from_pc());
+    res = addr_absolute_x(operand);
     regs.A = doADC(read_mem(res.val));
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::ADC_ay() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::ADC_ay() {
     struct addrmem_res res;
-    res = addr_absolute_y(fetch_addr_from_pc());
+    res = addr_absolute_y(operand);
     regs.A = doADC(read_mem(res.val));
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::ADC_xb() {
-    MEMADDR a = addr_x_indirect(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::ADC_xb() {
+    MEMADDR a = addr_x_indirect(operand);
     regs.A = doADC(read_mem(a));
     return 6;
 }
 
-UINT8 cpu6502::ADC_by() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::ADC_by() {
     struct addrmem_res res;
-    res = addr_indirect_y(fetch_from_pc());
+    res = addr_indirect_y(operand);
     regs.A = doADC(read_mem(res.val));
     return 5+res.nr_cycles;
 }
@@ -1190,60 +1368,70 @@ UINT8 cpu6502::doSBC(UINT8 n) {
     return res;
 }
 
-UINT8 cpu6502::SBC_i() {
-    regs.A = doSBC(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::SBC_i() {
+    regs.A = doSBC(operand);
     return 2;
 }
 
-UINT8 cpu6502::SBC_d() {
-    UINT8 val = read_mem((MEMADDR) fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::SBC_d() {
+    UINT8 val = read_mem((MEMADDR) operand);
     regs.A = doSBC(val);
     return 3;
 }
 
-UINT8 cpu6502::SBC_dx() {
-    MEMADDR a = addr_zp_x(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::SBC_dx() {
+    MEMADDR a = addr_zp_x(operand);
     regs.A = doSBC(read_mem(a));
     return 4;
 }
 
-UINT8 cpu6502::SBC_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::SBC_a() {
+    MEMADDR a = operand;
     regs.A = doSBC(read_mem(a));
     return 4;
 }
 
-UINT8 cpu6502::SBC_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::SBC_ax() {
     struct addrmem_res res;
-    res = addr_absolute_x(fetch_addr_from_pc());
+    res = addr_absolute_x(operand);
     regs.A = doSBC(read_mem(res.val));
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::SBC_ay() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::SBC_ay() {
     struct addrmem_res res;
-    res = addr_absolute_y(fetch_addr_from_pc());
+    res = addr_absolute_y(operand);
     regs.A = doSBC(read_mem(res.val));
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::SBC_xb() {
-    MEMADDR a = addr_x_indirect(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::SBC_xb() {
+    MEMADDR a = addr_x_indirect(operand);
     regs.A = doSBC(read_mem(a));
     return 6;
 }
 
-UINT8 cpu6502::SBC_by() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::SBC_by() {
     struct addrmem_res res;
-    res = addr_indirect_y(fetch_from_pc());
+    res = addr_indirect_y(operand);
     regs.A = doSBC(read_mem(res.val));
     return 5+res.nr_cycles;
 }
 
 // ----------- SUBROUTINES
 
-UINT8 cpu6502::RTS() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::RTS() {
     //std::printf("RTS : 0x%02X\n", regs.S);
+    tick();
     UINT8 low_pc = pop_stack();
     UINT8 high_pc = pop_stack();
     regs.PC = two_bytes_into_addr(low_pc, high_pc);
@@ -1252,30 +1440,37 @@ UINT8 cpu6502::RTS() {
     return 6;
 }
 
-UINT8 cpu6502::RTI() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::RTI() {
+    tick();
     UINT8 flags_byte = pop_stack();
-    flags = byte_to_flags(flags_byte);
+    set_flags(byte_to_flags(flags_byte));
     UINT8 low_pc = pop_stack();
     UINT8 high_pc = pop_stack();
     regs.PC = two_bytes_into_addr(low_pc, high_pc);
+    if(irq_lines) update_interrupt_deadline();
 
     return 6;
 }
 
-UINT8 cpu6502::JMP_a() {
-    regs.PC = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::JMP_a() {
+    if((UINT16)(regs.PC - operand) <= IDLE_LOOP_MAX_BYTES) watch_idle_loop(operand);
+    regs.PC = operand;
     return 3;
 }
 
-UINT8 cpu6502::JMP_ab() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::JMP_ab() {
     MEMADDR dest = addr_absolute_indirect(
-                    fetch_addr_from_pc());
+                    operand);
     regs.PC = dest;
     return 5;
 }
 
-UINT8 cpu6502::JSR_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::JSR_a() {
+    MEMADDR a = operand;
     regs.PC--;
 
     UINT8 high = (UINT8)(regs.PC >> 8);
@@ -1286,10 +1481,16 @@ UINT8 cpu6502::JSR_a() {
     return 6;
 }
 
-UINT8 cpu6502::BRK() {
-    if(flags.I) return 2;
+template<class MEM>
+UINT8 cpu6502T<MEM>::BRK() {
+    // taken whatever I is
     regs.PC++; // so that PC =  &BRK + 2
-    enter_irq(true);
+    // as enter_irq(true), with the accesses of the instruction
+    push_stack((UINT8)(regs.PC >> 8));
+    push_stack((UINT8)regs.PC);
+    push_stack(flags_to_byte(get_cpu_flags(), 1));
+    regs.PC = read_mem(0xFFFE);
+    regs.PC |= ((MEMADDR) read_mem(0xFFFF)) << 8;
     flags.I = 1;
     return 7;
 }
@@ -1300,61 +1501,77 @@ UINT8 cpu6502::BRK() {
 // ---
 
 void cpu6502::doCMP(UINT8 a, UINT8 b) {
-    UINT8 m = a - b;
     flags.C = (a >= b);
-    flags.N = (m & 0x80);
-    flags.Z = !m;
+    setNZflags(a - b);
 }
 
-UINT8 cpu6502::CMP_i() {
-    UINT8 val = fetch_from_pc();
+void cpu6502::doBIT(UINT8 val) {
+#ifdef GAYA_LAZY_FLAGS
+    nz_result = (regs.A & val) | ((val & 0x80) << 1);
+#else
+    flags.Z = !(regs.A & val);
+    flags.N = val & 0x80;
+#endif
+    flags.V = val & 0x40;
+}
+
+template<class MEM>
+UINT8 cpu6502T<MEM>::CMP_i() {
+    UINT8 val = operand;
     doCMP(regs.A, val);
     return 2;
 }
 
-UINT8 cpu6502::CMP_d() {
-    UINT8 val = read_mem((MEMADDR)fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::CMP_d() {
+    UINT8 val = read_mem((MEMADDR)operand);
     doCMP(regs.A, val);
     return 3;
 }
 
-UINT8 cpu6502::CMP_dx() {
-    UINT8 val = read_mem(addr_zp_x(fetch_from_pc()));
+template<class MEM>
+UINT8 cpu6502T<MEM>::CMP_dx() {
+    UINT8 val = read_mem(addr_zp_x(operand));
     doCMP(regs.A, val);
     return 4;
 }
 
-UINT8 cpu6502::CMP_a() {
-    UINT8 val = read_mem(fetch_addr_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::CMP_a() {
+    UINT8 val = read_mem(operand);
     doCMP(regs.A, val);
     return 4;
 }
 
-UINT8 cpu6502::CMP_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::CMP_ax() {
     struct addrmem_res res;
-    res = addr_absolute_x(fetch_addr_from_pc());
+    res = addr_absolute_x(operand);
     UINT8 val = read_mem(res.val);
     doCMP(regs.A, val);
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::CMP_ay() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::CMP_ay() {
     struct addrmem_res res;
-    res = addr_absolute_y(fetch_addr_from_pc());
+    res = addr_absolute_y(operand);
     UINT8 val = read_mem(res.val);
     doCMP(regs.A, val);
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::CMP_xb() {
-    UINT8 val = read_mem(addr_x_indirect(fetch_from_pc()));
+template<class MEM>
+UINT8 cpu6502T<MEM>::CMP_xb() {
+    UINT8 val = read_mem(addr_x_indirect(operand));
     doCMP(regs.A, val);
     return 6;
 }
 
-UINT8 cpu6502::CMP_by() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::CMP_by() {
     struct addrmem_res res;
-    res = addr_indirect_y(fetch_from_pc());
+    res = addr_indirect_y(operand);
     UINT8 val = read_mem(res.val);
     doCMP(regs.A, val);
     return 5+res.nr_cycles;
@@ -1363,20 +1580,23 @@ UINT8 cpu6502::CMP_by() {
 // CPX
 // ---
 
-UINT8 cpu6502::CPX_i() {
-    UINT8 val = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::CPX_i() {
+    UINT8 val = operand;
     doCMP(regs.X, val);
     return 2;
 }
 
-UINT8 cpu6502::CPX_d() {
-    UINT8 val = read_mem((MEMADDR) fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::CPX_d() {
+    UINT8 val = read_mem((MEMADDR) operand);
     doCMP(regs.X, val);
     return 3;
 }
 
-UINT8 cpu6502::CPX_a() {
-    UINT8 val = read_mem(fetch_addr_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::CPX_a() {
+    UINT8 val = read_mem(operand);
     doCMP(regs.X, val);
     return 4;
 }
@@ -1384,20 +1604,23 @@ UINT8 cpu6502::CPX_a() {
 // CPY
 // ---
 
-UINT8 cpu6502::CPY_i() {
-    UINT8 val = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::CPY_i() {
+    UINT8 val = operand;
     doCMP(regs.Y, val);
     return 2;
 }
 
-UINT8 cpu6502::CPY_d() {
-    UINT8 val = read_mem((MEMADDR) fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::CPY_d() {
+    UINT8 val = read_mem((MEMADDR) operand);
     doCMP(regs.Y, val);
     return 3;
 }
 
-UINT8 cpu6502::CPY_a() {
-    UINT8 val = read_mem(fetch_addr_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::CPY_a() {
+    UINT8 val = read_mem(operand);
     doCMP(regs.Y, val);
     return 4;
 }
@@ -1408,54 +1631,63 @@ UINT8 cpu6502::doBRANCH(INT8 r) {
     // this assumes that PC points after the branch operand
     UINT16 new_pc = regs.PC + (INT16)r;
     UINT8 page_crossed = ((new_pc & 0xFF00) != (regs.PC & 0xFF00));
+    if(r < 0 && r >= -IDLE_LOOP_MAX_BYTES) watch_idle_loop(new_pc);
     regs.PC = new_pc;
     return page_crossed;
 }
 
-UINT8 cpu6502::BPL() {
-    UINT8 r = fetch_from_pc();
-    if(!flags.N) return 3 + doBRANCH(r);
+template<class MEM>
+UINT8 cpu6502T<MEM>::BPL() {
+    UINT8 r = operand;
+    if(!flag_N()) return 3 + doBRANCH(r);
     else return 2;
 }
 
-UINT8 cpu6502::BCC() {
-    UINT8 r = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::BCC() {
+    UINT8 r = operand;
     if(!flags.C) return 3 + doBRANCH(r);
     else return 2;
 }
 
-UINT8 cpu6502::BCS() {
-    UINT8 r = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::BCS() {
+    UINT8 r = operand;
     if(flags.C) return 3 + doBRANCH(r);
     else return 2;
 }
 
-UINT8 cpu6502::BNE() {
-    UINT8 r = fetch_from_pc();
-    if(!flags.Z) return 3 + doBRANCH(r);
+template<class MEM>
+UINT8 cpu6502T<MEM>::BNE() {
+    UINT8 r = operand;
+    if(!flag_Z()) return 3 + doBRANCH(r);
     else return 2;
 }
 
-UINT8 cpu6502::BEQ() {
-    UINT8 r = fetch_from_pc();
-    if(flags.Z) return 3 + doBRANCH(r);
+template<class MEM>
+UINT8 cpu6502T<MEM>::BEQ() {
+    UINT8 r = operand;
+    if(flag_Z()) return 3 + doBRANCH(r);
     else return 2;
 }
 
-UINT8 cpu6502::BMI() {
-    UINT8 r = fetch_from_pc();
-    if(flags.N) return 3 + doBRANCH(r);
+template<class MEM>
+UINT8 cpu6502T<MEM>::BMI() {
+    UINT8 r = operand;
+    if(flag_N()) return 3 + doBRANCH(r);
     else return 2;
 }
 
-UINT8 cpu6502::BVC() {
-    UINT8 r = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::BVC() {
+    UINT8 r = operand;
     if(!flags.V) return 3 + doBRANCH(r);
     else return 2;
 }
 
-UINT8 cpu6502::BVS() {
-    UINT8 r = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::BVS() {
+    UINT8 r = operand;
     if(flags.V) return 3 + doBRANCH(r);
     else return 2;
 }
@@ -1467,7 +1699,8 @@ UINT8 cpu6502::BVS() {
 // KIL
 // ---
 
-UINT8 cpu6502::KIL() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::KIL() {
     throw CPUHalted(regs.PC);
     return 1; // yeah useless
 }
@@ -1483,54 +1716,71 @@ UINT8 cpu6502::doSLO(UINT8 val) {
     return val;
 }
 
-UINT8 cpu6502::SLO_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::SLO_a() {
+    MEMADDR a = operand;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, doSLO(val));
     return 6;
 }
 
-UINT8 cpu6502::SLO_d() {
-    MEMADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::SLO_d() {
+    MEMADDR zp = operand;
     UINT8 val = read_mem(zp);
+    dummy_write(zp, val);
     write_mem(zp, doSLO(val));
     return 5;
 }
 
-UINT8 cpu6502::SLO_dx() {
-    MEMADDR a = addr_zp_x(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::SLO_dx() {
+    MEMADDR a = addr_zp_x(operand);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, doSLO(val));
     return 6;
 }
 
-UINT8 cpu6502::SLO_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::SLO_ax() {
     struct addrmem_res res;
-    res = addr_absolute_x(fetch_addr_from_pc());
+    res = addr_absolute_x(operand);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, doSLO(val));
     return 7;
 }
 
-UINT8 cpu6502::SLO_ay() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::SLO_ay() {
     struct addrmem_res res;
-    res = addr_absolute_y(fetch_addr_from_pc());
+    res = addr_absolute_y(operand);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, doSLO(val));
     return 7;
 }
 
-UINT8 cpu6502::SLO_xb() {
-    MEMADDR a = addr_x_indirect(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::SLO_xb() {
+    MEMADDR a = addr_x_indirect(operand);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, doSLO(val));
     return 8;
 }
 
-UINT8 cpu6502::SLO_by() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::SLO_by() {
     struct addrmem_res res;
-    res = addr_indirect_y(fetch_from_pc());
+    res = addr_indirect_y(operand);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, doSLO(val));
     return 8;
 }
@@ -1546,54 +1796,71 @@ UINT8 cpu6502::doSRE(UINT8 val) {
     return val;
 }
 
-UINT8 cpu6502::SRE_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::SRE_a() {
+    MEMADDR a = operand;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, doSRE(val));
     return 6;
 }
 
-UINT8 cpu6502::SRE_d() {
-    MEMADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::SRE_d() {
+    MEMADDR zp = operand;
     UINT8 val = read_mem(zp);
+    dummy_write(zp, val);
     write_mem(zp, doSRE(val));
     return 5;
 }
 
-UINT8 cpu6502::SRE_dx() {
-    MEMADDR a = addr_zp_x(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::SRE_dx() {
+    MEMADDR a = addr_zp_x(operand);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, doSRE(val));
     return 6;
 }
 
-UINT8 cpu6502::SRE_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::SRE_ax() {
     struct addrmem_res res;
-    res = addr_absolute_x(fetch_addr_from_pc());
+    res = addr_absolute_x(operand);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, doSRE(val));
     return 7;
 }
 
-UINT8 cpu6502::SRE_ay() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::SRE_ay() {
     struct addrmem_res res;
-    res = addr_absolute_y(fetch_addr_from_pc());
+    res = addr_absolute_y(operand);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, doSRE(val));
     return 7;
 }
 
-UINT8 cpu6502::SRE_xb() {
-    MEMADDR a = addr_x_indirect(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::SRE_xb() {
+    MEMADDR a = addr_x_indirect(operand);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, doSRE(val));
     return 8;
 }
 
-UINT8 cpu6502::SRE_by() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::SRE_by() {
     struct addrmem_res res;
-    res = addr_indirect_y(fetch_from_pc());
+    res = addr_indirect_y(operand);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, doSRE(val));
     return 8;
 }
@@ -1611,54 +1878,71 @@ UINT8 cpu6502::doRRA(UINT8 val) {
     return val;
 }
 
-UINT8 cpu6502::RRA_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::RRA_a() {
+    MEMADDR a = operand;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, doRRA(val));
     return 6;
 }
 
-UINT8 cpu6502::RRA_d() {
-    MEMADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::RRA_d() {
+    MEMADDR zp = operand;
     UINT8 val = read_mem(zp);
+    dummy_write(zp, val);
     write_mem(zp, doRRA(val));
     return 5;
 }
 
-UINT8 cpu6502::RRA_dx() {
-    MEMADDR a = addr_zp_x(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::RRA_dx() {
+    MEMADDR a = addr_zp_x(operand);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, doRRA(val));
     return 6;
 }
 
-UINT8 cpu6502::RRA_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::RRA_ax() {
     struct addrmem_res res;
-    res = addr_absolute_x(fetch_addr_from_pc());
+    res = addr_absolute_x(operand);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, doRRA(val));
     return 7;
 }
 
-UINT8 cpu6502::RRA_ay() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::RRA_ay() {
     struct addrmem_res res;
-    res = addr_absolute_y(fetch_addr_from_pc());
+    res = addr_absolute_y(operand);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, doRRA(val));
     return 7;
 }
 
-UINT8 cpu6502::RRA_xb() {
-    MEMADDR a = addr_x_indirect(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::RRA_xb() {
+    MEMADDR a = addr_x_indirect(operand);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, doRRA(val));
     return 8;
 }
 
-UINT8 cpu6502::RRA_by() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::RRA_by() {
     struct addrmem_res res;
-    res = addr_indirect_y(fetch_from_pc());
+    res = addr_indirect_y(operand);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, doRRA(val));
     return 8;
 }   
@@ -1676,54 +1960,71 @@ UINT8 cpu6502::doRLA(UINT8 val) {
     return val;
 }
 
-UINT8 cpu6502::RLA_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::RLA_a() {
+    MEMADDR a = operand;
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, doRLA(val));
     return 6;
 }
 
-UINT8 cpu6502::RLA_d() {
-    MEMADDR zp = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::RLA_d() {
+    MEMADDR zp = operand;
     UINT8 val = read_mem(zp);
+    dummy_write(zp, val);
     write_mem(zp, doRLA(val));
     return 5;
 }
 
-UINT8 cpu6502::RLA_dx() {
-    MEMADDR a = addr_zp_x(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::RLA_dx() {
+    MEMADDR a = addr_zp_x(operand);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, doRLA(val));
     return 6;
 }
 
-UINT8 cpu6502::RLA_ax() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::RLA_ax() {
     struct addrmem_res res;
-    res = addr_absolute_x(fetch_addr_from_pc());
+    res = addr_absolute_x(operand);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, doRLA(val));
     return 7;
 }
 
-UINT8 cpu6502::RLA_ay() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::RLA_ay() {
     struct addrmem_res res;
-    res = addr_absolute_y(fetch_addr_from_pc());
+    res = addr_absolute_y(operand);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, doRLA(val));
     return 7;
 }
 
-UINT8 cpu6502::RLA_xb() {
-    MEMADDR a = addr_x_indirect(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::RLA_xb() {
+    MEMADDR a = addr_x_indirect(operand);
     UINT8 val = read_mem(a);
+    dummy_write(a, val);
     write_mem(a, doRLA(val));
     return 8;
 }
 
-UINT8 cpu6502::RLA_by() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::RLA_by() {
     struct addrmem_res res;
-    res = addr_indirect_y(fetch_from_pc());
+    res = addr_indirect_y(operand);
+    fixed_dummy_read(res);
     UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
     write_mem(res.val, doRLA(val));
     return 8;
 }   
@@ -1734,26 +2035,30 @@ UINT8 cpu6502::RLA_by() {
 // for this one I've read contradictory sources about how it affects flags,
 // so I decided that it wouldn't affect any
 
-UINT8 cpu6502::SAX_d() {
-    MEMADDR a = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::SAX_d() {
+    MEMADDR a = operand;
     write_mem(a, regs.A & regs.X);
     return 3;
 }
 
-UINT8 cpu6502::SAX_dy() {
-    MEMADDR a = addr_zp_y(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::SAX_dy() {
+    MEMADDR a = addr_zp_y(operand);
     write_mem(a, regs.A & regs.X);
     return 4;
 }
 
-UINT8 cpu6502::SAX_a() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::SAX_a() {
+    MEMADDR a = operand;
     write_mem(a, regs.A & regs.X);
     return 4;
 }
 
-UINT8 cpu6502::SAX_xb() {
-    MEMADDR a = addr_x_indirect(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::SAX_xb() {
+    MEMADDR a = addr_x_indirect(operand);
     write_mem(a, regs.A & regs.X);
     return 6;
 }
@@ -1761,212 +2066,270 @@ UINT8 cpu6502::SAX_xb() {
 // LAX
 // ---
 
-UINT8 cpu6502::LAX_i() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::LAX_i() {
     // different from LAXs below
     // ... also contradictory sources for this one
     regs.A |= 0xEE; // some sources tell me to do this, some others don't, plz help
-    regs.A &= fetch_from_pc();
+    regs.A &= operand;
     regs.X = regs.A;
     setNZflags(regs.A);
     return 2;
 }
 
-UINT8 cpu6502::LAX_d() {
-    MEMADDR a = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::LAX_d() {
+    MEMADDR a = operand;
     regs.A = regs.X = read_mem(a);
     setNZflags(regs.A);
     return 3;
 }
 
-UINT8 cpu6502::LAX_dy() {
-    MEMADDR a = addr_zp_y(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::LAX_dy() {
+    MEMADDR a = addr_zp_y(operand);
     regs.A = regs.X = read_mem(a);
     setNZflags(regs.A);
     return 4;
 }
 
-UINT8 cpu6502::LAX_a() {
-    regs.A = regs.X = read_mem(fetch_addr_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::LAX_a() {
+    regs.A = regs.X = read_mem(operand);
     setNZflags(regs.A);
     return 4;
 }
 
-UINT8 cpu6502::LAX_ay() {
-    struct addrmem_res res = addr_absolute_y(fetch_addr_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::LAX_ay() {
+    struct addrmem_res res = addr_absolute_y(operand);
     regs.A = regs.X = read_mem(res.val);
     setNZflags(regs.A);
     return 4+res.nr_cycles;
 }
 
-UINT8 cpu6502::LAX_xb() {
-    MEMADDR a = addr_x_indirect(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::LAX_xb() {
+    MEMADDR a = addr_x_indirect(operand);
     regs.A = regs.X = read_mem(a);
     setNZflags(regs.A);
     return 6;
 }
 
-UINT8 cpu6502::LAX_by() {
-    struct addrmem_res res = addr_indirect_y(fetch_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::LAX_by() {
+    struct addrmem_res res = addr_indirect_y(operand);
     regs.A = regs.X = read_mem(res.val);
     setNZflags(regs.A);
     return 5+res.nr_cycles;
 }
 
-// DCM
+// DCP
 // ---
 
-// not very used, so I didn't really optimize them
-// todo : optimize it a little !
-
-UINT8 cpu6502::DCP_d() {
-    DEC_d();
-    regs.PC--;
-    CMP_d();
-    return 5;
+UINT8 cpu6502::doDCP(UINT8 val) {
+    val--;
+    doCMP(regs.A, val);
+    return val;
 }
 
-UINT8 cpu6502::DCP_dx() {
-    DEC_dx();
-    regs.PC--;
-    CMP_dx();
+template<class MEM>
+UINT8 cpu6502T<MEM>::DCP_a() {
+    MEMADDR a = operand;
+    UINT8 val = read_mem(a);
+    dummy_write(a, val);
+    write_mem(a, doDCP(val));
     return 6;
 }
 
-UINT8 cpu6502::DCP_a() {
-    DEC_a();
-    regs.PC -= 2;
-    CMP_a();
+template<class MEM>
+UINT8 cpu6502T<MEM>::DCP_d() {
+    MEMADDR zp = operand;
+    UINT8 val = read_mem(zp);
+    dummy_write(zp, val);
+    write_mem(zp, doDCP(val));
+    return 5;
+}
+
+template<class MEM>
+UINT8 cpu6502T<MEM>::DCP_dx() {
+    MEMADDR a = addr_zp_x(operand);
+    UINT8 val = read_mem(a);
+    dummy_write(a, val);
+    write_mem(a, doDCP(val));
     return 6;
 }
 
-UINT8 cpu6502::DCP_ax() {
-    DEC_ax();
-    regs.PC -= 2;
-    CMP_ax();
+template<class MEM>
+UINT8 cpu6502T<MEM>::DCP_ax() {
+    struct addrmem_res res;
+    res = addr_absolute_x(operand);
+    fixed_dummy_read(res);
+    UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
+    write_mem(res.val, doDCP(val));
     return 7;
 }
 
-UINT8 cpu6502::DCP_ay() {
-    struct addrmem_res res = addr_absolute_y(fetch_addr_from_pc());
-    write_mem(res.val, read_mem(res.val) - 1);
-    regs.PC-=2;
-    CMP_ay();
+template<class MEM>
+UINT8 cpu6502T<MEM>::DCP_ay() {
+    struct addrmem_res res;
+    res = addr_absolute_y(operand);
+    fixed_dummy_read(res);
+    UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
+    write_mem(res.val, doDCP(val));
     return 7;
 }
 
-UINT8 cpu6502::DCP_xb() {
-    MEMADDR a = addr_x_indirect(fetch_from_pc());
-    write_mem(a, read_mem(a) - 1);
-    regs.PC--;
-    CMP_xb();
+template<class MEM>
+UINT8 cpu6502T<MEM>::DCP_xb() {
+    MEMADDR a = addr_x_indirect(operand);
+    UINT8 val = read_mem(a);
+    dummy_write(a, val);
+    write_mem(a, doDCP(val));
     return 8;
 }
 
-UINT8 cpu6502::DCP_by() {
-    struct addrmem_res res = addr_indirect_y(fetch_from_pc());
-    write_mem(res.val, read_mem(res.val) - 1);
-    regs.PC--;
-    CMP_by();
+template<class MEM>
+UINT8 cpu6502T<MEM>::DCP_by() {
+    struct addrmem_res res;
+    res = addr_indirect_y(operand);
+    fixed_dummy_read(res);
+    UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
+    write_mem(res.val, doDCP(val));
     return 8;
 }
 
 // ISC
 // ---
 
-UINT8 cpu6502::ISC_d() {
-    INC_d();
-    regs.PC--;
-    SBC_d();
-    return 5;
+UINT8 cpu6502::doISC(UINT8 val) {
+    val++;
+    regs.A = doSBC(val);
+    return val;
 }
 
-UINT8 cpu6502::ISC_dx() {
-    INC_dx();
-    regs.PC--;
-    SBC_dx();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ISC_a() {
+    MEMADDR a = operand;
+    UINT8 val = read_mem(a);
+    dummy_write(a, val);
+    write_mem(a, doISC(val));
     return 6;
 }
 
-UINT8 cpu6502::ISC_a() {
-    INC_a();
-    regs.PC-=2;
-    SBC_a();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ISC_d() {
+    MEMADDR zp = operand;
+    UINT8 val = read_mem(zp);
+    dummy_write(zp, val);
+    write_mem(zp, doISC(val));
+    return 5;
+}
+
+template<class MEM>
+UINT8 cpu6502T<MEM>::ISC_dx() {
+    MEMADDR a = addr_zp_x(operand);
+    UINT8 val = read_mem(a);
+    dummy_write(a, val);
+    write_mem(a, doISC(val));
     return 6;
 }
 
-UINT8 cpu6502::ISC_ax() {
-    INC_ax();
-    regs.PC-=2;
-    SBC_ax();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ISC_ax() {
+    struct addrmem_res res;
+    res = addr_absolute_x(operand);
+    fixed_dummy_read(res);
+    UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
+    write_mem(res.val, doISC(val));
     return 7;
 }
 
-UINT8 cpu6502::ISC_ay() {
-    INC_ay();
-    regs.PC-=2;
-    SBC_ax();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ISC_ay() {
+    struct addrmem_res res;
+    res = addr_absolute_y(operand);
+    fixed_dummy_read(res);
+    UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
+    write_mem(res.val, doISC(val));
     return 7;
 }
 
-UINT8 cpu6502::ISC_xb() {
-    MEMADDR a = addr_x_indirect(fetch_from_pc());
-    write_mem(a, read_mem(a) + 1);
-    regs.PC--;
-    SBC_xb();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ISC_xb() {
+    MEMADDR a = addr_x_indirect(operand);
+    UINT8 val = read_mem(a);
+    dummy_write(a, val);
+    write_mem(a, doISC(val));
     return 8;
 }
 
-UINT8 cpu6502::ISC_by() {
-    struct addrmem_res res = addr_indirect_y(fetch_from_pc());
-    write_mem(res.val, read_mem(res.val) + 1);
-    regs.PC--;
-    SBC_by();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ISC_by() {
+    struct addrmem_res res;
+    res = addr_indirect_y(operand);
+    fixed_dummy_read(res);
+    UINT8 val = read_mem(res.val);
+    dummy_write(res.val, val);
+    write_mem(res.val, doISC(val));
     return 8;
 }
 
 // ALR, ARR
 // ---
 
-UINT8 cpu6502::ALR_i() {
-    UINT8 val = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ALR_i() {
+    UINT8 val = operand;
     regs.A &= val;
     LSR();
     return 2;
 }
 
-UINT8 cpu6502::ARR_i() {
-    UINT8 val = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::ARR_i() {
+    UINT8 val = operand;
     regs.A &= val;
-    ROR();
+    regs.A = (regs.A >> 1) | ((flags.C)? 0x80 : 0);
+    setNZflags(regs.A);
+    // C and V come from bits 6 and 5 of the result
+    flags.C = regs.A & 0x40;
+    flags.V = ((regs.A >> 6) ^ (regs.A >> 5)) & 0x01;
     return 2;
 }
 
 // SAX
 // ---
 
-UINT8 cpu6502::AXS_i() {
-    UINT8 a = regs.A;
-    regs.A &= regs.X;
-    SEC();
-    SBC_i();
-    regs.X = regs.A;
-    regs.A = a;
+template<class MEM>
+UINT8 cpu6502T<MEM>::AXS_i() {
+    // a compare (V is not changed), with the result in X
+    UINT8 val = regs.A & regs.X;
+    doCMP(val, operand);
+    regs.X = val - (UINT8)operand;
     return 2;
 }
 
 // ANC
 // ---
 
-UINT8 cpu6502::AAC_i() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::AAC_i() {
     AND_i();
-    flags.C = flags.N;
+    flags.C = flag_N();
     return 2;
 }
 
 // XAA
 // ---
 
-UINT8 cpu6502::XAA_i() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::XAA_i() {
     regs.A = regs.X;
     AND_i();
     return 2;
@@ -1974,18 +2337,22 @@ UINT8 cpu6502::XAA_i() {
 
 // SHY, SHX
 
-UINT8 cpu6502::SHY_ax() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::SHY_ax() {
+    MEMADDR a = operand;
     struct addrmem_res res = addr_absolute_x(a);
     regs.Y &= ((UINT8)(a >> 8)) + 1;
+    fixed_dummy_read(res);
     write_mem(res.val, regs.Y);
     return 5;
 }
 
-UINT8 cpu6502::SHX_ay() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::SHX_ay() {
+    MEMADDR a = operand;
     struct addrmem_res res = addr_absolute_y(a);
     regs.X &= ((UINT8)(a >> 8)) + 1;
+    fixed_dummy_read(res);
     write_mem(res.val, regs.X);
     return 5;
 }
@@ -1993,22 +2360,26 @@ UINT8 cpu6502::SHX_ay() {
 // AHX
 // ---
 
-UINT8 cpu6502::AHX_ay() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::AHX_ay() {
+    MEMADDR a = operand;
     struct addrmem_res res = addr_absolute_y(a);
     UINT8 val = regs.A;
     val &= regs.X;
     val &= ((UINT8)(a >> 8)) + 1;
+    fixed_dummy_read(res);
     write_mem(res.val, val);
     return 5;
 }
 
-UINT8 cpu6502::AHX_by() {
-    ZPADDR a = fetch_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::AHX_by() {
+    ZPADDR a = operand;
     struct addrmem_res res = addr_indirect_y(a);
     UINT8 val = regs.A;
     val &= regs.X;
     val &= a + 1;
+    fixed_dummy_read(res);
     write_mem(res.val, val);
     return 6;
 }
@@ -2016,18 +2387,21 @@ UINT8 cpu6502::AHX_by() {
 // TAS, LAS
 // ---
 
-UINT8 cpu6502::TAS_ay() {
-    MEMADDR a = fetch_addr_from_pc();
+template<class MEM>
+UINT8 cpu6502T<MEM>::TAS_ay() {
+    MEMADDR a = operand;
     struct addrmem_res res = addr_absolute_y(a);
     UINT8 val = regs.A & regs.X;
     regs.S = val;
     val &= ((UINT8)(a>>8)) + 1;
+    fixed_dummy_read(res);
     write_mem(res.val, val);
     return 5;
 }
 
-UINT8 cpu6502::LAS_ay() {
-    struct addrmem_res res = addr_absolute_y(fetch_addr_from_pc());
+template<class MEM>
+UINT8 cpu6502T<MEM>::LAS_ay() {
+    struct addrmem_res res = addr_absolute_y(operand);
     UINT8 val = read_mem(res.val);
     val &= regs.S;
     regs.A = regs.X = regs.S = val;
@@ -2041,18 +2415,19 @@ void cpu6502::enter_irq(bool from_brk) {
     UINT8 high = (UINT8)(regs.PC >> 8);
     push_stack(high);
     push_stack((UINT8)regs.PC);
-    UINT8 flags_b = flags_to_byte(flags, (from_brk)?1:0);
+    UINT8 flags_b = flags_to_byte(get_cpu_flags(), (from_brk)?1:0);
     push_stack(flags_b);
     // starts IRQ
     regs.PC = ((MEMADDR) read_mem(0xFFFF)) << 8;
     regs.PC |= read_mem(0xFFFE);
+    flags.I = 1;
 }
 
 void cpu6502::enter_nmi() {
     UINT8 high = (UINT8)(regs.PC >> 8);
     push_stack(high);
     push_stack((UINT8)regs.PC);
-    UINT8 flags_b = flags_to_byte(flags, 0);
+    UINT8 flags_b = flags_to_byte(get_cpu_flags(), 0);
     push_stack(flags_b);
     // starts NMI
     regs.PC = ((UINT16) read_mem(0xFFFB)) << 8;
@@ -2060,6 +2435,54 @@ void cpu6502::enter_nmi() {
     flags.I = 1;
 }
 
+void cpu6502::raise_nmi(UINT32 at_cycle) {
+    nmi_pending = 1;
+    nmi_deadline = at_cycle;
+    update_interrupt_deadline();
+}
+
+void cpu6502::set_irq_line(UINT8 source) {
+    if(!irq_lines) irq_deadline = elapsed_cycles;
+    irq_lines |= source;
+    update_interrupt_deadline();
+}
+
+void cpu6502::clear_irq_line(UINT8 source) {
+    irq_lines &= ~source;
+    update_interrupt_deadline();
+}
+
+void cpu6502::update_interrupt_deadline() {
+    interrupt_deadline = NO_DEADLINE;
+    if(nmi_pending) interrupt_deadline = nmi_deadline;
+    if(irq_lines && !flags.I && irq_deadline < interrupt_deadline) interrupt_deadline = irq_deadline;
+    // stops the current run early if needed
+    if(interrupt_deadline < run_limit) run_limit = interrupt_deadline;
+}
+
+void cpu6502::take_interrupts() {
+    if(nmi_pending && elapsed_cycles >= nmi_deadline) {
+        nmi_pending = 0;
+        enter_nmi();
+        elapsed_cycles += 7;
+        idle.P = 0; // the handler can change what an idle loop reads
+    } else if(irq_lines && !flags.I && elapsed_cycles >= irq_deadline) {
+        enter_irq(false);
+        elapsed_cycles += 7;
+        idle.P = 0;
+    }
+    update_interrupt_deadline();
+}
+
+void cpu6502::reset_cycles() {
+    // deadlines are relative to the cycles counter
+    nmi_deadline = (nmi_deadline > elapsed_cycles)? nmi_deadline - elapsed_cycles : 0;
+    irq_deadline = (irq_deadline > elapsed_cycles)? irq_deadline - elapsed_cycles : 0;
+    idle.cycles -= elapsed_cycles;
+    elapsed_cycles = 0;
+    update_interrupt_deadline();
+}
+
 void cpu6502::enter_reset() {
     // we don't handle PC and P on stack for now, directly to the routine vector
     regs.PC = ((UINT16) read_mem(0xFFFD)) << 8;
@@ -2068,98 +2491,351 @@ void cpu6502::enter_reset() {
 }
 
 
+/* ================== IDLE LOOPS ================== */
+
+void cpu6502::analyze_idle_loop(MEMADDR head) {
+    idle_rejected[head % IDLE_REJECTED_SIZE] = head;
+    if(head < 0x8000 || (UINT16)(head - code_lo) >= code_len) return;
+
+    UINT32 period = 0;
+    BOOL polls_ppu = 0;
+    MEMADDR pc = head;
+    while((UINT16)(pc - head) < IDLE_LOOP_MAX_BYTES) {
+        UINT16 off = pc - code_lo;
+        if(off >= code_len) return;
+        const cpu_opcode_info &info = cpu_opcodes[code_page[off]];
+        UINT8 len = addr_mode_length(info.mode);
+        if(!info.official || off + len > code_len) return;
+        UINT16 op_operand = (len > 1)? code_page[off + 1] : 0;
+        if(len > 2) op_operand |= code_page[off + 2] << 8;
+        MEMADDR next = pc + len;
+
+        if(info.mode == ADDR_MODE::RELATIVE || (info.mode == ADDR_MODE::ABSOLUTE && info.mnemonic == MNEMONIC::JMP)) {
+            MEMADDR target = (info.mode == ADDR_MODE::RELATIVE)? (MEMADDR)(next + (INT8)op_operand) : op_operand;
+            if(target == head) {
+                // end of the loop, taken
+                period += (info.mode == ADDR_MODE::RELATIVE)? 3 + ((target & 0xFF00) != (next & 0xFF00)) : 3;
+                idle.pc = head;
+                idle.period = period;
+                idle.polls_ppu = polls_ppu;
+                idle.confirmed = 0;
+                idle.P = 0;
+                idle_rejected[head % IDLE_REJECTED_SIZE] = NO_IDLE_LOOP;
+                return;
+            }
+            // a way out, not taken while looping
+            if(info.mode != ADDR_MODE::RELATIVE || target < next) return;
+            period += 2;
+        } else {
+            // only reading memory (or nothing), and changing registers
+            if(!(info.flags & OPCODE_REGS_ONLY)) return;
+            switch (info.mode)
+            {
+            case ADDR_MODE::IMPLIED: case ADDR_MODE::ACCUMULATOR: case ADDR_MODE::IMMEDIATE:
+            case ADDR_MODE::ZERO_PAGE: case ADDR_MODE::ZERO_PAGE_X: case ADDR_MODE::ZERO_PAGE_Y:
+                break;
+            case ADDR_MODE::ABSOLUTE:
+                if(op_operand >= 0x2000 && op_operand < 0x4000 && (op_operand & 0x07) == 2) {
+                    // $2002, only as the first instruction : the PPU is synced there
+                    if(pc != head) return;
+                    polls_ppu = 1;
+                } else if(op_operand >= 0x2000 && op_operand < 0x6000) return;
+                break;
+            default:
+                // indexed absolute and indirect : could read anywhere
+                return;
+            }
+            period += info.cycles;
+        }
+        pc = next;
+    }
+}
 
-/* =============== VON NEUMANN RELATED ============== */
+bool cpu6502::idle_loop_pass() {
+    UINT8 p = flags_to_byte(get_cpu_flags(), 0);
+    idle.confirmed = (elapsed_cycles - idle.cycles == idle.period) && p == idle.P && regs.A == idle.A
+                     && regs.X == idle.X && regs.Y == idle.Y && regs.S == idle.S;
+    idle.cycles = elapsed_cycles;
+    idle.A = regs.A; idle.X = regs.X; idle.Y = regs.Y; idle.S = regs.S; idle.P = p;
+    return idle.confirmed;
+}
 
-UINT8 cpu6502::fetch_from_pc() {
-    return read_mem(regs.PC++);
+template<class MEM>
+void cpu6502T<MEM>::skip_idle_loop() {
+    // $2002 only changes when the PPU runs, which is not during the run out of its syncs (VBlank)
+    if(idle.polls_ppu && (return_on_ppu_op || !mem->MEM::ppu_status_stable())) return;
+    // nothing else can change before the next interrupt, or the end of the run
+    if(run_limit <= elapsed_cycles) return;
+    skip_idle_iterations((run_limit - elapsed_cycles - 1) / idle.period);
 }
 
-UINT8 cpu6502::execute_op(UINT8 op) {
-    UINT8 (cpu6502::*ophandler)() = handlers_ptrs[op];
+
+/* =============== VON NEUMANN RELATED ============== */
+
+template<class MEM>
+UINT8 cpu6502T<MEM>::execute_op(UINT8 op) {
+    // PC is after the opcode
+    operand = 0;
+    if(op_length[op] > 1) operand = fetch_from_pc();
+    if(op_length[op] > 2) operand |= fetch_from_pc() << 8;
+    UINT8 (cpu6502T::*ophandler)() = handlers_ptrs[op];
+#ifdef GAYA_CYCLE_EXACT
+    // the cycles are returned, not counted
+    UINT32 before = elapsed_cycles;
+    UINT8 cycles = (this->*ophandler)();
+    elapsed_cycles = before;
+    return cycles;
+#else
     return (this->*ophandler)(); // execute the correct handler
+#endif
 }
 
 
-UINT8 cpu6502::von_neumann_cycle() {
+template<class MEM>
+UINT8 cpu6502T<MEM>::von_neumann_cycle() {
     UINT8 op = fetch_from_pc(); //increments PC
     return execute_op(op);
 }
 
 
 
-cpu6502::execute_cycles_res cpu6502::execute_cycles(UINT32 nr_cycles) {
-    // some code duplication, sorry it is called lots of times each second so it should be optimized
+template<class MEM>
+bool cpu6502T<MEM>::run_block() {
+    if((UINT16)(regs.PC - code_lo) >= code_len && !map_code_page()) return false;
+    MEMADDR entry = regs.PC;
+    dynarec_block block = dynarec->get_block(code_page, code_lo, code_len, regs.PC);
+    if(!block) return false;
+
+    dynarec_frame f;
+    f.A = regs.A; f.X = regs.X; f.Y = regs.Y; f.S = regs.S;
+    f.C = !!flags.C; f.Z = !!flag_Z(); f.V = !!flags.V; f.N = !!flag_N(); f.D = !!flags.D;
+    f.PC = regs.PC;
+    f.cycles = elapsed_cycles;
+    f.limit = run_limit;
+    f.ram = mem->get_ram_rw();
+    f.mem = mem;
+    f.read = &dynarec_read;
+    block(&f);
+
+    // the first instruction can leave as well, depending on its address
+    if(f.cycles == elapsed_cycles) return false;
+    regs.A = f.A; regs.X = f.X; regs.Y = f.Y; regs.S = f.S;
+    cpu6502flags fl = flags;
+    fl.C = f.C; fl.Z = f.Z; fl.V = f.V; fl.N = f.N; fl.D = f.D;
+    set_flags(fl);
+    regs.PC = f.PC;
+    elapsed_cycles = f.cycles;
+    // the branches ending loops which start with an interpreted read ($2002) are in the block
+    UINT16 back = entry - f.PC;
+    if(back && back <= IDLE_LOOP_MAX_BYTES) watch_idle_loop(f.PC);
+    return true;
+}
+
+template<class MEM>
+template<class TRACE>
+cpu6502::execute_cycles_res cpu6502T<MEM>::run_cycles(UINT32 nr_cycles, TRACE &trace) {
+    // it is called lots of times each second so it should be optimized : NoTrace costs nothing
     execute_cycles_res res = {0, 0};
-    UINT32 nr_returned = 0;
-    UINT32 nr_total = 0;
-
-    while(nr_total <= nr_cycles) {
-
-        MEMADDR pc = regs.PC; // to save it in case we need it
-
-        UINT8 op = fetch_from_pc();
-
-        try
-        {
-            UINT8 (cpu6502::*ophandler)() = handlers_ptrs[op];
-            nr_returned = (this->*ophandler)();
-        }
-        catch(const PpuSync& e)
-        {
-            // got to sync cpu and ppu !
-            skip_next_op_ppu = 1;
-            regs.PC = pc; // we'll have to execute the instruction again
-            res.cycles = nr_total; // before the instruction which triggers sync
-            res.ppu_dirty = 1;
-            return res;
+#ifdef GAYA_CYCLE_EXACT
+    // the instruction stopped by the last PPU sync starts again, from its first cycle
+    elapsed_cycles -= sync_rewind;
+    sync_rewind = 0;
+#endif
+    UINT32 start = elapsed_cycles;
+    UINT32 end = start + nr_cycles;
+
+    while(elapsed_cycles < end) {
+        // not before an instruction interrupted by a PPU sync is executed again
+        if(elapsed_cycles >= interrupt_deadline && !skip_next_op_ppu) {
+            UINT32 before = elapsed_cycles;
+            take_interrupts();
+            if(TRACE::enabled && elapsed_cycles != before) trace.interrupt(*this, elapsed_cycles - before);
         }
-        
-        nr_total += nr_returned;
+
+        // then, nothing to check up to the next deadline (which devices can move earlier)
+        run_limit = (interrupt_deadline < end)? interrupt_deadline : end;
+        do {
+            // traces see every instruction
+            if(!TRACE::enabled) {
+                if(regs.PC == idle.pc && !skip_next_op_ppu && idle_loop_pass()) skip_idle_loop();
+                if(dynarec && !skip_next_op_ppu && regs.PC >= 0x8000 && run_block()) continue;
+            }
+
+            MEMADDR pc = regs.PC; // to save it in case we need it
+
+            UINT8 op = fetch_instruction();
+            trace.instruction(*this, pc, op, start);
+
+#ifdef GAYA_CYCLE_EXACT
+            // the opcode and the operand, then PC is read again by the 1 byte instructions
+            UINT32 op_start = elapsed_cycles;
+            bus_cycles = (op_length[op] > 1)? op_length[op] : 2;
+            elapsed_cycles += bus_cycles;
+#endif
+
+            try
+            {
+                UINT8 (cpu6502T::*ophandler)() = handlers_ptrs[op];
+                UINT8 cycles = (this->*ophandler)();
+#ifdef GAYA_CYCLE_EXACT
+                // the cycles after the last access
+                elapsed_cycles += cycles - bus_cycles;
+                // it was the instruction executed again after a PPU sync, whatever it accessed since
+                skip_next_op_ppu = 0;
+#else
+                elapsed_cycles += cycles;
+#endif
+                trace.executed(*this, pc, op, cycles);
+            }
+            catch(const PpuSync& e)
+            {
+                // got to sync cpu and ppu !
+                skip_next_op_ppu = 1;
+                regs.PC = pc; // we'll have to execute the instruction again
+#ifdef GAYA_CYCLE_EXACT
+                // the PPU runs up to the access
+                sync_rewind = elapsed_cycles - op_start;
+#endif
+                res.cycles = elapsed_cycles - start; // before the instruction which triggers sync
+                res.ppu_dirty = 1;
+                return res;
+            }
+        } while(elapsed_cycles < run_limit);
     }
 
-    res.cycles = nr_total;
+    res.cycles = elapsed_cycles - start;
     res.ppu_dirty = 0;
     return res;
 }
 
-cpu6502::execute_cycles_res cpu6502::execute_cycles_debug(UINT32 nr_cycles, FILE *debug_s, UINT32 cycle_min) {
-    // some code duplication, sorry it is called lots of times each second so it should be optimized
-    execute_cycles_res res = {0, 0};
-    UINT32 nr_total = 0;
-    UINT32 nr_returned = 0;
-    UINT8 op;
-    while(nr_total <= nr_cycles) {
-        if(nr_total >= cycle_min) {
-            std::fprintf(debug_s, "%04X A:%02X X:%02X Y:%02X SP:%02X P: NV--DIZC %d%d--%d%d%d%d \n", regs.PC, regs.A, regs.X, regs.Y, regs.S, 
-                !!flags.N, !!flags.V, !!flags.D, !!flags.I, !!flags.V, !!flags.Z);
-        }
+template<class MEM>
+void cpu6502T<MEM>::TextTrace::instruction(cpu6502T &cpu, MEMADDR pc, UINT8, UINT32 start) {
+    if(cpu.elapsed_cycles - start >= cycle_min) {
+        std::fprintf(debug_s, "%04X A:%02X X:%02X Y:%02X SP:%02X P: NV--DIZC %d%d--%d%d%d%d CYC:%u\n", pc, cpu.regs.A, cpu.regs.X, cpu.regs.Y, cpu.regs.S, 
+            !!cpu.flag_N(), !!cpu.flags.V, !!cpu.flags.D, !!cpu.flags.I, !!cpu.flag_Z(), !!cpu.flags.C, cpu.elapsed_cycles);
+    }
 
-        std::fflush(NULL);
+    std::fflush(debug_s);
+}
 
-        MEMADDR pc = regs.PC; // to save it in case we need it
-        op = fetch_from_pc();
+template<class MEM>
+void cpu6502T<MEM>::RingTrace::instruction(cpu6502T &cpu, MEMADDR pc, UINT8 op, UINT32) {
+    // already recorded before its PPU sync
+    if(cpu.skip_next_op_ppu) return;
+    trace_record r;
+    r.pc = pc;
+    r.opcode = op;
+    r.operand[0] = (UINT8)cpu.operand;
+    r.operand[1] = (UINT8)(cpu.operand >> 8);
+    r.A = cpu.regs.A; r.X = cpu.regs.X; r.Y = cpu.regs.Y; r.S = cpu.regs.S;
+    r.P = flags_to_byte(cpu.get_cpu_flags(), 0);
+    r.frame = (UINT16)writer->get_frame();
+    r.cycles = cpu.elapsed_cycles;
+    writer->push(r);
+}
 
-        try
-        {
-            UINT8 (cpu6502::*ophandler)() = handlers_ptrs[op];
-            nr_returned = (this->*ophandler)();
-        }
-        catch(const PpuSync& e)
-        {
-            // got to sync cpu and ppu !
-            skip_next_op_ppu = 1;
-            regs.PC = pc; // we'll have to execute the instruction again
-            res.cycles = nr_total; // before the instruction which triggers sync
-            res.ppu_dirty = 1;
-            return res;
-        }
-        
-        nr_total += nr_returned;
-    }
-    res.cycles = nr_total;
-    res.ppu_dirty = 0;
-    return res;
+template<class MEM>
+void cpu6502T<MEM>::ProfileTrace::executed(cpu6502T &cpu, MEMADDR pc, UINT8 op, UINT32 cycles) {
+    ROMMemManager *rom = cpu.mem->memROM;
+    // only JSR needs the bank of where it went
+    int new_bank = (op == 0x20)? rom->get_prg_bank(cpu.regs.PC) : -1;
+    profiler->instruction(pc, rom->get_prg_bank(pc), op, cycles, cpu.regs.PC, new_bank, cpu.regs.S);
+}
+
+template<class MEM>
+void cpu6502T<MEM>::ProfileTrace::interrupt(cpu6502T &cpu, UINT32 cycles) {
+    MEMADDR nmi_vector = cpu.mem->MEM::read(0xFFFA) | (cpu.mem->MEM::read(0xFFFB) << 8);
+    profiler->interrupt(cpu.regs.PC, cpu.mem->memROM->get_prg_bank(cpu.regs.PC), cpu.regs.PC == nmi_vector,
+                        cycles, cpu.regs.S);
+}
+
+template<class MEM>
+void cpu6502T<MEM>::BreakTrace::instruction(cpu6502T &cpu, MEMADDR pc, UINT8 op, UINT32) {
+    // already checked before its PPU sync
+    if(cpu.skip_next_op_ppu) return;
+    break_context c;
+    c.PC = pc;
+    c.A = cpu.regs.A; c.X = cpu.regs.X; c.Y = cpu.regs.Y; c.S = cpu.regs.S;
+    c.P = flags_to_byte(cpu.get_cpu_flags(), 0);
+    breakpoints->instruction(op, cpu.operand, c);
+}
+
+template<class MEM>
+void cpu6502T<MEM>::CdlTrace::instruction(cpu6502T &cpu, MEMADDR pc, UINT8 op, UINT32) {
+    if(cpu.skip_next_op_ppu) return;
+    cdl->instruction(pc, op, cpu.operand, cpu.regs.X, cpu.regs.Y);
+}
+
+template<class MEM>
+void cpu6502T<MEM>::MultiTrace::instruction(cpu6502T &cpu, MEMADDR pc, UINT8 op, UINT32 start) {
+    if(brk.breakpoints) brk.instruction(cpu, pc, op, start);
+    if(text.debug_s) text.instruction(cpu, pc, op, start);
+    if(ring.writer) ring.instruction(cpu, pc, op, start);
+    if(cdl.cdl) cdl.instruction(cpu, pc, op, start);
+}
+
+template<class MEM>
+void cpu6502T<MEM>::MultiTrace::executed(cpu6502T &cpu, MEMADDR pc, UINT8 op, UINT32 cycles) {
+    if(profile.profiler) profile.executed(cpu, pc, op, cycles);
+}
+
+template<class MEM>
+void cpu6502T<MEM>::MultiTrace::interrupt(cpu6502T &cpu, UINT32 cycles) {
+    if(profile.profiler) profile.interrupt(cpu, cycles);
+}
+
+template<class MEM>
+cpu6502::execute_cycles_res cpu6502T<MEM>::execute_cycles(UINT32 nr_cycles) {
+    NoTrace trace;
+    return run_cycles(nr_cycles, trace);
+}
+
+template<class MEM>
+cpu6502::execute_cycles_res cpu6502T<MEM>::execute_cycles_debug(UINT32 nr_cycles, FILE *debug_s, UINT32 cycle_min) {
+    TextTrace trace;
+    trace.debug_s = debug_s;
+    trace.cycle_min = cycle_min;
+    return run_cycles(nr_cycles, trace);
+}
+
+template<class MEM>
+cpu6502::execute_cycles_res cpu6502T<MEM>::execute_cycles_traced(UINT32 nr_cycles, TraceWriter *writer) {
+    RingTrace trace;
+    trace.writer = writer;
+    return run_cycles(nr_cycles, trace);
+}
+
+template<class MEM>
+cpu6502::execute_cycles_res cpu6502T<MEM>::execute_cycles_profiled(UINT32 nr_cycles, Profiler *profiler) {
+    ProfileTrace trace;
+    trace.profiler = profiler;
+    return run_cycles(nr_cycles, trace);
+}
+
+template<class MEM>
+cpu6502::execute_cycles_res cpu6502T<MEM>::execute_cycles_breakpoints(UINT32 nr_cycles, Breakpoints *breakpoints) {
+    BreakTrace trace;
+    trace.breakpoints = breakpoints;
+    return run_cycles(nr_cycles, trace);
+}
+
+template<class MEM>
+cpu6502::execute_cycles_res cpu6502T<MEM>::execute_cycles_cdl(UINT32 nr_cycles, CodeDataLogger *cdl) {
+    CdlTrace trace;
+    trace.cdl = cdl;
+    return run_cycles(nr_cycles, trace);
+}
+
+template<class MEM>
+cpu6502::execute_cycles_res cpu6502T<MEM>::execute_cycles_sinks(UINT32 nr_cycles, const trace_sinks &sinks) {
+    MultiTrace trace;
+    trace.brk.breakpoints = sinks.breakpoints;
+    trace.text.debug_s = sinks.debug_s;
+    trace.text.cycle_min = 0;
+    trace.ring.writer = sinks.writer;
+    trace.profile.profiler = sinks.profiler;
+    trace.cdl.cdl = sinks.cdl;
+    return run_cycles(nr_cycles, trace);
 }
 
 /* ========== CONSTRUCTOR, DESTRUCTOR ============ */
@@ -2167,283 +2843,351 @@ cpu6502::execute_cycles_res cpu6502::execute_cycles_debug(UINT32 nr_cycles, FILE
 int cpu6502::init_cpu(MEMADDR pc) {
     // TODO : proper initialization
     regs.A = 0; regs.X = 0; regs.Y = 0; regs.S = 0xFD;
-    flags.C = 0; flags.I = 1; flags.N = 0; flags.V = 0; flags.Z = 0; flags.D = 0;
+    cpu6502flags f;
+    f.C = 0; f.I = 1; f.N = 0; f.V = 0; f.Z = 0; f.D = 0;
+    set_flags(f);
     regs.PC = pc;
+    reset_idle_loop();
     return 0;
 }
 
-cpu6502::cpu6502(CPUMemoryManager *mem_handl) : mem_handl(mem_handl), return_on_ppu_op(0), skip_next_op_ppu(0), elapsed_cycles(0) {
+cpu6502::cpu6502(CPUMemoryManager *mem_handl) : mem_handl(mem_handl), elapsed_cycles(0), code_page(nullptr), code_lo(0), code_len(0),
+        code_decoded(nullptr), return_on_ppu_op(0), skip_next_op_ppu(0), irq_lines(0), nmi_pending(0),
+        nmi_deadline(0), irq_deadline(0), interrupt_deadline(NO_DEADLINE), run_limit(0), dynarec(nullptr) {
 
     for (int i = 0; i < 256; i++)
     {
         flagNtable[i] = !(i < 128);
+        op_length[i] = addr_mode_length(cpu_opcodes[i].mode);
     }
+    for(int i = 0; i < 4; i++) slot_pages[i] = nullptr;
+    reset_idle_loop();
+    idle.cycles = 0;
+#ifdef GAYA_CYCLE_EXACT
+    bus_cycles = 0;
+    sync_rewind = 0;
+#endif
 
     regs.S = 0xFD;
+}
+
+/* ========== DECODED INSTRUCTIONS ============ */
+
+void cpu6502::map_decoded_page() {
+    // $8000-$FFFF is PRG ROM for every mapper
+    if(!code_len || code_lo < 0x8000) {
+        code_decoded = nullptr;
+        return;
+    }
+    UINT8 slot = (code_lo >> 13) & 0x03;
+    if(slot_pages[slot] != code_page) {
+        std::unique_ptr<decoded_op[]> &table = decoded_pages[code_page];
+        if(!table) table.reset(new decoded_op[code_len]()); // zeroed : nothing decoded
+        slot_pages[slot] = code_page;
+        slot_decoded[slot] = table.get();
+    }
+    code_decoded = slot_decoded[slot];
+}
+
+void cpu6502::decode_op(UINT16 off) {
+    UINT8 op = code_page[off];
+    UINT8 len = op_length[op];
+    if(off + len > code_len) return; // ends in the next page, never decoded
+    decoded_op &d = code_decoded[off];
+    d.opcode = op;
+    d.operand = (len > 1)? code_page[off + 1] : 0;
+    if(len > 2) d.operand |= code_page[off + 2] << 8;
+    d.length = len;
+}
+
+void cpu6502::clear_decoded_pages() {
+    decoded_pages.clear();
+    for(int i = 0; i < 4; i++) slot_pages[i] = nullptr;
+    code_decoded = nullptr;
+    invalidate_code_page();
+}
+
+template<class MEM>
+cpu6502T<MEM>::cpu6502T(MEM *mem) : cpu6502(mem), mem(mem) {
 
     // ========== initialization of ophandlers
 
-    handlers_ptrs[0x00] = &cpu6502::BRK;
-    handlers_ptrs[0x01] = &cpu6502::ORA_xb;
-    handlers_ptrs[0x02] = &cpu6502::KIL;
-    handlers_ptrs[0x03] = &cpu6502::SLO_xb;
-    handlers_ptrs[0x04] = &cpu6502::DOP_d;
-    handlers_ptrs[0x05] = &cpu6502::ORA_d;
-    handlers_ptrs[0x06] = &cpu6502::ASL_d;
-    handlers_ptrs[0x07] = &cpu6502::SLO_d;
-    handlers_ptrs[0x08] = &cpu6502::PHP;
-    handlers_ptrs[0x09] = &cpu6502::ORA_i;
-    handlers_ptrs[0x0A] = &cpu6502::ASL;
-    handlers_ptrs[0x0B] = &cpu6502::AAC_i;
-    handlers_ptrs[0x0C] = &cpu6502::TOP_a;
-    handlers_ptrs[0x0D] = &cpu6502::ORA_a;
-    handlers_ptrs[0x0E] = &cpu6502::ASL_a;
-    handlers_ptrs[0x0F] = &cpu6502::SLO_a;
-    handlers_ptrs[0x10] = &cpu6502::BPL;
-    handlers_ptrs[0x11] = &cpu6502::ORA_by;
-    handlers_ptrs[0x12] = &cpu6502::KIL;
-    handlers_ptrs[0x13] = &cpu6502::SLO_by;
-    handlers_ptrs[0x14] = &cpu6502::NOP_dx;
-    handlers_ptrs[0x15] = &cpu6502::ORA_dx;
-    handlers_ptrs[0x16] = &cpu6502::ASL_dx;
-    handlers_ptrs[0x17] = &cpu6502::SLO_dx;
-    handlers_ptrs[0x18] = &cpu6502::CLC;
-    handlers_ptrs[0x19] = &cpu6502::ORA_ay;
-    handlers_ptrs[0x1A] = &cpu6502::NOP;
-    handlers_ptrs[0x1B] = &cpu6502::SLO_ay;
-    handlers_ptrs[0x1C] = &cpu6502::NOP_ax;
-    handlers_ptrs[0x1D] = &cpu6502::ORA_ax;
-    handlers_ptrs[0x1E] = &cpu6502::ASL_ax;
-    handlers_ptrs[0x1F] = &cpu6502::SLO_ax;
-
-    handlers_ptrs[0x20] = &cpu6502::JSR_a;
-    handlers_ptrs[0x21] = &cpu6502::AND_xb;
-    handlers_ptrs[0x22] = &cpu6502::KIL;
-    handlers_ptrs[0x23] = &cpu6502::RLA_xb;
-    handlers_ptrs[0x24] = &cpu6502::BIT_d;
-    handlers_ptrs[0x25] = &cpu6502::AND_d;
-    handlers_ptrs[0x26] = &cpu6502::ROL_d;
-    handlers_ptrs[0x27] = &cpu6502::RLA_d;
-    handlers_ptrs[0x28] = &cpu6502::PLP;
-    handlers_ptrs[0x29] = &cpu6502::AND_i;
-    handlers_ptrs[0x2A] = &cpu6502::ROL;
-    handlers_ptrs[0x2B] = &cpu6502::AAC_i;
-    handlers_ptrs[0x2C] = &cpu6502::BIT_a;
-    handlers_ptrs[0x2D] = &cpu6502::AND_a;
-    handlers_ptrs[0x2E] = &cpu6502::ROL_a;
-    handlers_ptrs[0x2F] = &cpu6502::RLA_a;
-    handlers_ptrs[0x30] = &cpu6502::BMI;
-    handlers_ptrs[0x31] = &cpu6502::AND_by;
-    handlers_ptrs[0x32] = &cpu6502::KIL;
-    handlers_ptrs[0x33] = &cpu6502::RLA_by;
-    handlers_ptrs[0x34] = &cpu6502::NOP_dx;
-    handlers_ptrs[0x35] = &cpu6502::AND_dx;
-    handlers_ptrs[0x36] = &cpu6502::ROL_dx;
-    handlers_ptrs[0x37] = &cpu6502::RLA_dx;
-    handlers_ptrs[0x38] = &cpu6502::SEC;
-    handlers_ptrs[0x39] = &cpu6502::AND_ay;
-    handlers_ptrs[0x3A] = &cpu6502::NOP;
-    handlers_ptrs[0x3B] = &cpu6502::RLA_ay;
-    handlers_ptrs[0x3C] = &cpu6502::NOP_ax;
-    handlers_ptrs[0x3D] = &cpu6502::AND_ax;
-    handlers_ptrs[0x3E] = &cpu6502::ROL_ax;
-    handlers_ptrs[0x3F] = &cpu6502::RLA_ax;
-
-    handlers_ptrs[0x40] = &cpu6502::RTI;
-    handlers_ptrs[0x41] = &cpu6502::EOR_xb;
-    handlers_ptrs[0x42] = &cpu6502::KIL;
-    handlers_ptrs[0x43] = &cpu6502::SRE_xb;
-    handlers_ptrs[0x44] = &cpu6502::DOP_d;
-    handlers_ptrs[0x45] = &cpu6502::EOR_d;
-    handlers_ptrs[0x46] = &cpu6502::LSR_d;
-    handlers_ptrs[0x47] = &cpu6502::SRE_d;
-    handlers_ptrs[0x48] = &cpu6502::PHA;
-    handlers_ptrs[0x49] = &cpu6502::EOR_i;
-    handlers_ptrs[0x4A] = &cpu6502::LSR;
-    handlers_ptrs[0x4B] = &cpu6502::ALR_i;
-    handlers_ptrs[0x4C] = &cpu6502::JMP_a;
-    handlers_ptrs[0x4D] = &cpu6502::EOR_a;
-    handlers_ptrs[0x4E] = &cpu6502::LSR_a;
-    handlers_ptrs[0x4F] = &cpu6502::SRE_a;
-    handlers_ptrs[0x50] = &cpu6502::BVC;
-    handlers_ptrs[0x51] = &cpu6502::EOR_by;
-    handlers_ptrs[0x52] = &cpu6502::KIL;
-    handlers_ptrs[0x53] = &cpu6502::SRE_by;
-    handlers_ptrs[0x54] = &cpu6502::NOP_dx;
-    handlers_ptrs[0x55] = &cpu6502::EOR_dx;
-    handlers_ptrs[0x56] = &cpu6502::LSR_dx;
-    handlers_ptrs[0x57] = &cpu6502::SRE_dx;
-    handlers_ptrs[0x58] = &cpu6502::CLI;
-    handlers_ptrs[0x59] = &cpu6502::EOR_ay;
-    handlers_ptrs[0x5A] = &cpu6502::NOP;
-    handlers_ptrs[0x5B] = &cpu6502::SRE_ay;
-    handlers_ptrs[0x5C] = &cpu6502::NOP_ax;
-    handlers_ptrs[0x5D] = &cpu6502::EOR_ax;
-    handlers_ptrs[0x5E] = &cpu6502::LSR_ax;
-    handlers_ptrs[0x5F] = &cpu6502::SRE_ax;
-
-    handlers_ptrs[0x60] = &cpu6502::RTS;
-    handlers_ptrs[0x61] = &cpu6502::ADC_xb;
-    handlers_ptrs[0x62] = &cpu6502::KIL;
-    handlers_ptrs[0x63] = &cpu6502::RRA_xb;
-    handlers_ptrs[0x64] = &cpu6502::DOP_d;
-    handlers_ptrs[0x65] = &cpu6502::ADC_d;
-    handlers_ptrs[0x66] = &cpu6502::ROR_d;
-    handlers_ptrs[0x67] = &cpu6502::RRA_d;
-    handlers_ptrs[0x68] = &cpu6502::PLA;
-    handlers_ptrs[0x69] = &cpu6502::ADC_i;
-    handlers_ptrs[0x6A] = &cpu6502::ROR;
-    handlers_ptrs[0x6B] = &cpu6502::ARR_i;
-    handlers_ptrs[0x6C] = &cpu6502::JMP_ab;
-    handlers_ptrs[0x6D] = &cpu6502::ADC_a;
-    handlers_ptrs[0x6E] = &cpu6502::ROR_a;
-    handlers_ptrs[0x6F] = &cpu6502::RRA_a;
-    handlers_ptrs[0x70] = &cpu6502::BVS;
-    handlers_ptrs[0x71] = &cpu6502::ADC_by;
-    handlers_ptrs[0x72] = &cpu6502::KIL;
-    handlers_ptrs[0x73] = &cpu6502::RRA_by;
-    handlers_ptrs[0x74] = &cpu6502::NOP_dx;
-    handlers_ptrs[0x75] = &cpu6502::ADC_dx;
-    handlers_ptrs[0x76] = &cpu6502::ROR_dx;
-    handlers_ptrs[0x77] = &cpu6502::RRA_dx;
-    handlers_ptrs[0x78] = &cpu6502::SEI;
-    handlers_ptrs[0x79] = &cpu6502::ADC_ay;
-    handlers_ptrs[0x7A] = &cpu6502::NOP;
-    handlers_ptrs[0x7B] = &cpu6502::RRA_ay;
-    handlers_ptrs[0x7C] = &cpu6502::NOP_ax;
-    handlers_ptrs[0x7D] = &cpu6502::ADC_ax;
-    handlers_ptrs[0x7E] = &cpu6502::ROR_ax;
-    handlers_ptrs[0x7F] = &cpu6502::RRA_ax;
-
-    handlers_ptrs[0x80] = &cpu6502::DOP_i;
-    handlers_ptrs[0x81] = &cpu6502::STA_xb;
-    handlers_ptrs[0x82] = &cpu6502::DOP_i;
-    handlers_ptrs[0x83] = &cpu6502::SAX_xb;
-    handlers_ptrs[0x84] = &cpu6502::STY_d;
-    handlers_ptrs[0x85] = &cpu6502::STA_d;
-    handlers_ptrs[0x86] = &cpu6502::STX_d;
-    handlers_ptrs[0x87] = &cpu6502::SAX_d;
-    handlers_ptrs[0x88] = &cpu6502::DEY;
-    handlers_ptrs[0x89] = &cpu6502::DOP_i;
-    handlers_ptrs[0x8A] = &cpu6502::TXA;
-    handlers_ptrs[0x8B] = &cpu6502::XAA_i;
-    handlers_ptrs[0x8C] = &cpu6502::STY_a;
-    handlers_ptrs[0x8D] = &cpu6502::STA_a;
-    handlers_ptrs[0x8E] = &cpu6502::STX_a;
-    handlers_ptrs[0x8F] = &cpu6502::SAX_a;
-    handlers_ptrs[0x90] = &cpu6502::BCC;
-    handlers_ptrs[0x91] = &cpu6502::STA_by;
-    handlers_ptrs[0x92] = &cpu6502::KIL;
-    handlers_ptrs[0x93] = &cpu6502::AHX_by;
-    handlers_ptrs[0x94] = &cpu6502::STY_dx;
-    handlers_ptrs[0x95] = &cpu6502::STA_dx;
-    handlers_ptrs[0x96] = &cpu6502::STX_dy;
-    handlers_ptrs[0x97] = &cpu6502::SAX_dy;
-    handlers_ptrs[0x98] = &cpu6502::TYA;
-    handlers_ptrs[0x99] = &cpu6502::STA_ay;
-    handlers_ptrs[0x9A] = &cpu6502::TXS;
-    handlers_ptrs[0x9B] = &cpu6502::TAS_ay;
-    handlers_ptrs[0x9C] = &cpu6502::SHY_ax;
-    handlers_ptrs[0x9D] = &cpu6502::STA_ax;
-    handlers_ptrs[0x9E] = &cpu6502::SHX_ay;
-    handlers_ptrs[0x9F] = &cpu6502::AHX_ay;
-
-    handlers_ptrs[0xA0] = &cpu6502::LDY_i;
-    handlers_ptrs[0xA1] = &cpu6502::LDA_xb;
-    handlers_ptrs[0xA2] = &cpu6502::LDX_i;
-    handlers_ptrs[0xA3] = &cpu6502::LAX_xb;
-    handlers_ptrs[0xA4] = &cpu6502::LDY_d;
-    handlers_ptrs[0xA5] = &cpu6502::LDA_d;
-    handlers_ptrs[0xA6] = &cpu6502::LDX_d;
-    handlers_ptrs[0xA7] = &cpu6502::LAX_d;
-    handlers_ptrs[0xA8] = &cpu6502::TAY;
-    handlers_ptrs[0xA9] = &cpu6502::LDA_i;
-    handlers_ptrs[0xAA] = &cpu6502::TAX;
-    handlers_ptrs[0xAB] = &cpu6502::LAX_i;
-    handlers_ptrs[0xAC] = &cpu6502::LDY_a;
-    handlers_ptrs[0xAD] = &cpu6502::LDA_a;
-    handlers_ptrs[0xAE] = &cpu6502::LDX_a;
-    handlers_ptrs[0xAF] = &cpu6502::LAX_a;
-    handlers_ptrs[0xB0] = &cpu6502::BCS;
-    handlers_ptrs[0xB1] = &cpu6502::LDA_by;
-    handlers_ptrs[0xB2] = &cpu6502::KIL;
-    handlers_ptrs[0xB3] = &cpu6502::LAX_by;
-    handlers_ptrs[0xB4] = &cpu6502::LDY_dx;
-    handlers_ptrs[0xB5] = &cpu6502::LDA_dx;
-    handlers_ptrs[0xB6] = &cpu6502::LDX_dy;
-    handlers_ptrs[0xB7] = &cpu6502::LAX_dy;
-    handlers_ptrs[0xB8] = &cpu6502::CLV;
-    handlers_ptrs[0xB9] = &cpu6502::LDA_ay;
-    handlers_ptrs[0xBA] = &cpu6502::TSX;
-    handlers_ptrs[0xBB] = &cpu6502::LAS_ay;
-    handlers_ptrs[0xBC] = &cpu6502::LDY_ax;
-    handlers_ptrs[0xBD] = &cpu6502::LDA_ax;
-    handlers_ptrs[0xBE] = &cpu6502::LDX_ay;
-    handlers_ptrs[0xBF] = &cpu6502::LAX_ay;
-
-    handlers_ptrs[0xC0] = &cpu6502::CPY_i;
-    handlers_ptrs[0xC1] = &cpu6502::CMP_xb;
-    handlers_ptrs[0xC2] = &cpu6502::DOP_i;
-    handlers_ptrs[0xC3] = &cpu6502::DCP_xb;
-    handlers_ptrs[0xC4] = &cpu6502::CPY_d;
-    handlers_ptrs[0xC5] = &cpu6502::CMP_d;
-    handlers_ptrs[0xC6] = &cpu6502::DEC_d;
-    handlers_ptrs[0xC7] = &cpu6502::DCP_d;
-    handlers_ptrs[0xC8] = &cpu6502::INY;
-    handlers_ptrs[0xC9] = &cpu6502::CMP_i;
-    handlers_ptrs[0xCA] = &cpu6502::DEX;
-    handlers_ptrs[0xCB] = &cpu6502::AXS_i;
-    handlers_ptrs[0xCC] = &cpu6502::CPY_a;
-    handlers_ptrs[0xCD] = &cpu6502::CMP_a;
-    handlers_ptrs[0xCE] = &cpu6502::DEC_a;
-    handlers_ptrs[0xCF] = &cpu6502::DCP_a;
-    handlers_ptrs[0xD0] = &cpu6502::BNE;
-    handlers_ptrs[0xD1] = &cpu6502::CMP_by;
-    handlers_ptrs[0xD2] = &cpu6502::KIL;
-    handlers_ptrs[0xD3] = &cpu6502::DCP_by;
-    handlers_ptrs[0xD4] = &cpu6502::NOP_dx;
-    handlers_ptrs[0xD5] = &cpu6502::CMP_dx;
-    handlers_ptrs[0xD6] = &cpu6502::DEC_dx;
-    handlers_ptrs[0xD7] = &cpu6502::DCP_dx;
-    handlers_ptrs[0xD8] = &cpu6502::CLD;
-    handlers_ptrs[0xD9] = &cpu6502::CMP_ay;
-    handlers_ptrs[0xDA] = &cpu6502::NOP;
-    handlers_ptrs[0xDB] = &cpu6502::DCP_ay;
-    handlers_ptrs[0xDC] = &cpu6502::NOP_ax;
-    handlers_ptrs[0xDD] = &cpu6502::CMP_ax;
-    handlers_ptrs[0xDE] = &cpu6502::DEC_ax;
-    handlers_ptrs[0xDF] = &cpu6502::DCP_ax;
-
-    handlers_ptrs[0xE0] = &cpu6502::CPX_i;
-    handlers_ptrs[0xE1] = &cpu6502::SBC_xb;
-    handlers_ptrs[0xE2] = &cpu6502::DOP_i;
-    handlers_ptrs[0xE3] = &cpu6502::ISC_xb;
-    handlers_ptrs[0xE4] = &cpu6502::CPX_d;
-    handlers_ptrs[0xE5] = &cpu6502::SBC_d;
-    handlers_ptrs[0xE6] = &cpu6502::INC_d;
-    handlers_ptrs[0xE7] = &cpu6502::ISC_d;
-    handlers_ptrs[0xE8] = &cpu6502::INX;
-    handlers_ptrs[0xE9] = &cpu6502::SBC_i;
-    handlers_ptrs[0xEA] = &cpu6502::NOP;
-    handlers_ptrs[0xEB] = &cpu6502::SBC_i;
-    handlers_ptrs[0xEC] = &cpu6502::CPX_a;
-    handlers_ptrs[0xED] = &cpu6502::SBC_a;
-    handlers_ptrs[0xEE] = &cpu6502::INC_a;
-    handlers_ptrs[0xEF] = &cpu6502::ISC_a;
-    handlers_ptrs[0xF0] = &cpu6502::BEQ;
-    handlers_ptrs[0xF1] = &cpu6502::SBC_by;
-    handlers_ptrs[0xF2] = &cpu6502::KIL;
-    handlers_ptrs[0xF3] = &cpu6502::ISC_by;
-    handlers_ptrs[0xF4] = &cpu6502::NOP_dx;
-    handlers_ptrs[0xF5] = &cpu6502::SBC_dx;
-    handlers_ptrs[0xF6] = &cpu6502::INC_dx;
-    handlers_ptrs[0xF7] = &cpu6502::ISC_dx;
-    handlers_ptrs[0xF8] = &cpu6502::SED;
-    handlers_ptrs[0xF9] = &cpu6502::SBC_ay;
-    handlers_ptrs[0xFA] = &cpu6502::NOP;
-    handlers_ptrs[0xFB] = &cpu6502::ISC_ay;
-    handlers_ptrs[0xFC] = &cpu6502::NOP_ax;
-    handlers_ptrs[0xFD] = &cpu6502::SBC_ax;
-    handlers_ptrs[0xFE] = &cpu6502::INC_ax;
-    handlers_ptrs[0xFF] = &cpu6502::ISC_ax;
-}
\ No newline at end of file
+    handlers_ptrs[0x00] = &cpu6502T::BRK;
+    handlers_ptrs[0x01] = &cpu6502T::ORA_xb;
+    handlers_ptrs[0x02] = &cpu6502T::KIL;
+    handlers_ptrs[0x03] = &cpu6502T::SLO_xb;
+    handlers_ptrs[0x04] = &cpu6502T::DOP_d;
+    handlers_ptrs[0x05] = &cpu6502T::ORA_d;
+    handlers_ptrs[0x06] = &cpu6502T::ASL_d;
+    handlers_ptrs[0x07] = &cpu6502T::SLO_d;
+    handlers_ptrs[0x08] = &cpu6502T::PHP;
+    handlers_ptrs[0x09] = &cpu6502T::ORA_i;
+    handlers_ptrs[0x0A] = &cpu6502T::ASL;
+    handlers_ptrs[0x0B] = &cpu6502T::AAC_i;
+    handlers_ptrs[0x0C] = &cpu6502T::TOP_a;
+    handlers_ptrs[0x0D] = &cpu6502T::ORA_a;
+    handlers_ptrs[0x0E] = &cpu6502T::ASL_a;
+    handlers_ptrs[0x0F] = &cpu6502T::SLO_a;
+    handlers_ptrs[0x10] = &cpu6502T::BPL;
+    handlers_ptrs[0x11] = &cpu6502T::ORA_by;
+    handlers_ptrs[0x12] = &cpu6502T::KIL;
+    handlers_ptrs[0x13] = &cpu6502T::SLO_by;
+    handlers_ptrs[0x14] = &cpu6502T::NOP_dx;
+    handlers_ptrs[0x15] = &cpu6502T::ORA_dx;
+    handlers_ptrs[0x16] = &cpu6502T::ASL_dx;
+    handlers_ptrs[0x17] = &cpu6502T::SLO_dx;
+    handlers_ptrs[0x18] = &cpu6502T::CLC;
+    handlers_ptrs[0x19] = &cpu6502T::ORA_ay;
+    handlers_ptrs[0x1A] = &cpu6502T::NOP;
+    handlers_ptrs[0x1B] = &cpu6502T::SLO_ay;
+    handlers_ptrs[0x1C] = &cpu6502T::NOP_ax;
+    handlers_ptrs[0x1D] = &cpu6502T::ORA_ax;
+    handlers_ptrs[0x1E] = &cpu6502T::ASL_ax;
+    handlers_ptrs[0x1F] = &cpu6502T::SLO_ax;
+
+    handlers_ptrs[0x20] = &cpu6502T::JSR_a;
+    handlers_ptrs[0x21] = &cpu6502T::AND_xb;
+    handlers_ptrs[0x22] = &cpu6502T::KIL;
+    handlers_ptrs[0x23] = &cpu6502T::RLA_xb;
+    handlers_ptrs[0x24] = &cpu6502T::BIT_d;
+    handlers_ptrs[0x25] = &cpu6502T::AND_d;
+    handlers_ptrs[0x26] = &cpu6502T::ROL_d;
+    handlers_ptrs[0x27] = &cpu6502T::RLA_d;
+    handlers_ptrs[0x28] = &cpu6502T::PLP;
+    handlers_ptrs[0x29] = &cpu6502T::AND_i;
+    handlers_ptrs[0x2A] = &cpu6502T::ROL;
+    handlers_ptrs[0x2B] = &cpu6502T::AAC_i;
+    handlers_ptrs[0x2C] = &cpu6502T::BIT_a;
+    handlers_ptrs[0x2D] = &cpu6502T::AND_a;
+    handlers_ptrs[0x2E] = &cpu6502T::ROL_a;
+    handlers_ptrs[0x2F] = &cpu6502T::RLA_a;
+    handlers_ptrs[0x30] = &cpu6502T::BMI;
+    handlers_ptrs[0x31] = &cpu6502T::AND_by;
+    handlers_ptrs[0x32] = &cpu6502T::KIL;
+    handlers_ptrs[0x33] = &cpu6502T::RLA_by;
+    handlers_ptrs[0x34] = &cpu6502T::NOP_dx;
+    handlers_ptrs[0x35] = &cpu6502T::AND_dx;
+    handlers_ptrs[0x36] = &cpu6502T::ROL_dx;
+    handlers_ptrs[0x37] = &cpu6502T::RLA_dx;
+    handlers_ptrs[0x38] = &cpu6502T::SEC;
+    handlers_ptrs[0x39] = &cpu6502T::AND_ay;
+    handlers_ptrs[0x3A] = &cpu6502T::NOP;
+    handlers_ptrs[0x3B] = &cpu6502T::RLA_ay;
+    handlers_ptrs[0x3C] = &cpu6502T::NOP_ax;
+    handlers_ptrs[0x3D] = &cpu6502T::AND_ax;
+    handlers_ptrs[0x3E] = &cpu6502T::ROL_ax;
+    handlers_ptrs[0x3F] = &cpu6502T::RLA_ax;
+
+    handlers_ptrs[0x40] = &cpu6502T::RTI;
+    handlers_ptrs[0x41] = &cpu6502T::EOR_xb;
+    handlers_ptrs[0x42] = &cpu6502T::KIL;
+    handlers_ptrs[0x43] = &cpu6502T::SRE_xb;
+    handlers_ptrs[0x44] = &cpu6502T::DOP_d;
+    handlers_ptrs[0x45] = &cpu6502T::EOR_d;
+    handlers_ptrs[0x46] = &cpu6502T::LSR_d;
+    handlers_ptrs[0x47] = &cpu6502T::SRE_d;
+    handlers_ptrs[0x48] = &cpu6502T::PHA;
+    handlers_ptrs[0x49] = &cpu6502T::EOR_i;
+    handlers_ptrs[0x4A] = &cpu6502T::LSR;
+    handlers_ptrs[0x4B] = &cpu6502T::ALR_i;
+    handlers_ptrs[0x4C] = &cpu6502T::JMP_a;
+    handlers_ptrs[0x4D] = &cpu6502T::EOR_a;
+    handlers_ptrs[0x4E] = &cpu6502T::LSR_a;
+    handlers_ptrs[0x4F] = &cpu6502T::SRE_a;
+    handlers_ptrs[0x50] = &cpu6502T::BVC;
+    handlers_ptrs[0x51] = &cpu6502T::EOR_by;
+    handlers_ptrs[0x52] = &cpu6502T::KIL;
+    handlers_ptrs[0x53] = &cpu6502T::SRE_by;
+    handlers_ptrs[0x54] = &cpu6502T::NOP_dx;
+    handlers_ptrs[0x55] = &cpu6502T::EOR_dx;
+    handlers_ptrs[0x56] = &cpu6502T::LSR_dx;
+    handlers_ptrs[0x57] = &cpu6502T::SRE_dx;
+    handlers_ptrs[0x58] = &cpu6502T::CLI;
+    handlers_ptrs[0x59] = &cpu6502T::EOR_ay;
+    handlers_ptrs[0x5A] = &cpu6502T::NOP;
+    handlers_ptrs[0x5B] = &cpu6502T::SRE_ay;
+    handlers_ptrs[0x5C] = &cpu6502T::NOP_ax;
+    handlers_ptrs[0x5D] = &cpu6502T::EOR_ax;
+    handlers_ptrs[0x5E] = &cpu6502T::LSR_ax;
+    handlers_ptrs[0x5F] = &cpu6502T::SRE_ax;
+
+    handlers_ptrs[0x60] = &cpu6502T::RTS;
+    handlers_ptrs[0x61] = &cpu6502T::ADC_xb;
+    handlers_ptrs[0x62] = &cpu6502T::KIL;
+    handlers_ptrs[0x63] = &cpu6502T::RRA_xb;
+    handlers_ptrs[0x64] = &cpu6502T::DOP_d;
+    handlers_ptrs[0x65] = &cpu6502T::ADC_d;
+    handlers_ptrs[0x66] = &cpu6502T::ROR_d;
+    handlers_ptrs[0x67] = &cpu6502T::RRA_d;
+    handlers_ptrs[0x68] = &cpu6502T::PLA;
+    handlers_ptrs[0x69] = &cpu6502T::ADC_i;
+    handlers_ptrs[0x6A] = &cpu6502T::ROR;
+    handlers_ptrs[0x6B] = &cpu6502T::ARR_i;
+    handlers_ptrs[0x6C] = &cpu6502T::JMP_ab;
+    handlers_ptrs[0x6D] = &cpu6502T::ADC_a;
+    handlers_ptrs[0x6E] = &cpu6502T::ROR_a;
+    handlers_ptrs[0x6F] = &cpu6502T::RRA_a;
+    handlers_ptrs[0x70] = &cpu6502T::BVS;
+    handlers_ptrs[0x71] = &cpu6502T::ADC_by;
+    handlers_ptrs[0x72] = &cpu6502T::KIL;
+    handlers_ptrs[0x73] = &cpu6502T::RRA_by;
+    handlers_ptrs[0x74] = &cpu6502T::NOP_dx;
+    handlers_ptrs[0x75] = &cpu6502T::ADC_dx;
+    handlers_ptrs[0x76] = &cpu6502T::ROR_dx;
+    handlers_ptrs[0x77] = &cpu6502T::RRA_dx;
+    handlers_ptrs[0x78] = &cpu6502T::SEI;
+    handlers_ptrs[0x79] = &cpu6502T::ADC_ay;
+    handlers_ptrs[0x7A] = &cpu6502T::NOP;
+    handlers_ptrs[0x7B] = &cpu6502T::RRA_ay;
+    handlers_ptrs[0x7C] = &cpu6502T::NOP_ax;
+    handlers_ptrs[0x7D] = &cpu6502T::ADC_ax;
+    handlers_ptrs[0x7E] = &cpu6502T::ROR_ax;
+    handlers_ptrs[0x7F] = &cpu6502T::RRA_ax;
+
+    handlers_ptrs[0x80] = &cpu6502T::DOP_i;
+    handlers_ptrs[0x81] = &cpu6502T::STA_xb;
+    handlers_ptrs[0x82] = &cpu6502T::DOP_i;
+    handlers_ptrs[0x83] = &cpu6502T::SAX_xb;
+    handlers_ptrs[0x84] = &cpu6502T::STY_d;
+    handlers_ptrs[0x85] = &cpu6502T::STA_d;
+    handlers_ptrs[0x86] = &cpu6502T::STX_d;
+    handlers_ptrs[0x87] = &cpu6502T::SAX_d;
+    handlers_ptrs[0x88] = &cpu6502T::DEY;
+    handlers_ptrs[0x89] = &cpu6502T::DOP_i;
+    handlers_ptrs[0x8A] = &cpu6502T::TXA;
+    handlers_ptrs[0x8B] = &cpu6502T::XAA_i;
+    handlers_ptrs[0x8C] = &cpu6502T::STY_a;
+    handlers_ptrs[0x8D] = &cpu6502T::STA_a;
+    handlers_ptrs[0x8E] = &cpu6502T::STX_a;
+    handlers_ptrs[0x8F] = &cpu6502T::SAX_a;
+    handlers_ptrs[0x90] = &cpu6502T::BCC;
+    handlers_ptrs[0x91] = &cpu6502T::STA_by;
+    handlers_ptrs[0x92] = &cpu6502T::KIL;
+    handlers_ptrs[0x93] = &cpu6502T::AHX_by;
+    handlers_ptrs[0x94] = &cpu6502T::STY_dx;
+    handlers_ptrs[0x95] = &cpu6502T::STA_dx;
+    handlers_ptrs[0x96] = &cpu6502T::STX_dy;
+    handlers_ptrs[0x97] = &cpu6502T::SAX_dy;
+    handlers_ptrs[0x98] = &cpu6502T::TYA;
+    handlers_ptrs[0x99] = &cpu6502T::STA_ay;
+    handlers_ptrs[0x9A] = &cpu6502T::TXS;
+    handlers_ptrs[0x9B] = &cpu6502T::TAS_ay;
+    handlers_ptrs[0x9C] = &cpu6502T::SHY_ax;
+    handlers_ptrs[0x9D] = &cpu6502T::STA_ax;
+    handlers_ptrs[0x9E] = &cpu6502T::SHX_ay;
+    handlers_ptrs[0x9F] = &cpu6502T::AHX_ay;
+
+    handlers_ptrs[0xA0] = &cpu6502T::LDY_i;
+    handlers_ptrs[0xA1] = &cpu6502T::LDA_xb;
+    handlers_ptrs[0xA2] = &cpu6502T::LDX_i;
+    handlers_ptrs[0xA3] = &cpu6502T::LAX_xb;
+    handlers_ptrs[0xA4] = &cpu6502T::LDY_d;
+    handlers_ptrs[0xA5] = &cpu6502T::LDA_d;
+    handlers_ptrs[0xA6] = &cpu6502T::LDX_d;
+    handlers_ptrs[0xA7] = &cpu6502T::LAX_d;
+    handlers_ptrs[0xA8] = &cpu6502T::TAY;
+    handlers_ptrs[0xA9] = &cpu6502T::LDA_i;
+    handlers_ptrs[0xAA] = &cpu6502T::TAX;
+    handlers_ptrs[0xAB] = &cpu6502T::LAX_i;
+    handlers_ptrs[0xAC] = &cpu6502T::LDY_a;
+    handlers_ptrs[0xAD] = &cpu6502T::LDA_a;
+    handlers_ptrs[0xAE] = &cpu6502T::LDX_a;
+    handlers_ptrs[0xAF] = &cpu6502T::LAX_a;
+    handlers_ptrs[0xB0] = &cpu6502T::BCS;
+    handlers_ptrs[0xB1] = &cpu6502T::LDA_by;
+    handlers_ptrs[0xB2] = &cpu6502T::KIL;
+    handlers_ptrs[0xB3] = &cpu6502T::LAX_by;
+    handlers_ptrs[0xB4] = &cpu6502T::LDY_dx;
+    handlers_ptrs[0xB5] = &cpu6502T::LDA_dx;
+    handlers_ptrs[0xB6] = &cpu6502T::LDX_dy;
+    handlers_ptrs[0xB7] = &cpu6502T::LAX_dy;
+    handlers_ptrs[0xB8] = &cpu6502T::CLV;
+    handlers_ptrs[0xB9] = &cpu6502T::LDA_ay;
+    handlers_ptrs[0xBA] = &cpu6502T::TSX;
+    handlers_ptrs[0xBB] = &cpu6502T::LAS_ay;
+    handlers_ptrs[0xBC] = &cpu6502T::LDY_ax;
+    handlers_ptrs[0xBD] = &cpu6502T::LDA_ax;
+    handlers_ptrs[0xBE] = &cpu6502T::LDX_ay;
+    handlers_ptrs[0xBF] = &cpu6502T::LAX_ay;
+
+    handlers_ptrs[0xC0] = &cpu6502T::CPY_i;
+    handlers_ptrs[0xC1] = &cpu6502T::CMP_xb;
+    handlers_ptrs[0xC2] = &cpu6502T::DOP_i;
+    handlers_ptrs[0xC3] = &cpu6502T::DCP_xb;
+    handlers_ptrs[0xC4] = &cpu6502T::CPY_d;
+    handlers_ptrs[0xC5] = &cpu6502T::CMP_d;
+    handlers_ptrs[0xC6] = &cpu6502T::DEC_d;
+    handlers_ptrs[0xC7] = &cpu6502T::DCP_d;
+    handlers_ptrs[0xC8] = &cpu6502T::INY;
+    handlers_ptrs[0xC9] = &cpu6502T::CMP_i;
+    handlers_ptrs[0xCA] = &cpu6502T::DEX;
+    handlers_ptrs[0xCB] = &cpu6502T::AXS_i;
+    handlers_ptrs[0xCC] = &cpu6502T::CPY_a;
+    handlers_ptrs[0xCD] = &cpu6502T::CMP_a;
+    handlers_ptrs[0xCE] = &cpu6502T::DEC_a;
+    handlers_ptrs[0xCF] = &cpu6502T::DCP_a;
+    handlers_ptrs[0xD0] = &cpu6502T::BNE;
+    handlers_ptrs[0xD1] = &cpu6502T::CMP_by;
+    handlers_ptrs[0xD2] = &cpu6502T::KIL;
+    handlers_ptrs[0xD3] = &cpu6502T::DCP_by;
+    handlers_ptrs[0xD4] = &cpu6502T::NOP_dx;
+    handlers_ptrs[0xD5] = &cpu6502T::CMP_dx;
+    handlers_ptrs[0xD6] = &cpu6502T::DEC_dx;
+    handlers_ptrs[0xD7] = &cpu6502T::DCP_dx;
+    handlers_ptrs[0xD8] = &cpu6502T::CLD;
+    handlers_ptrs[0xD9] = &cpu6502T::CMP_ay;
+    handlers_ptrs[0xDA] = &cpu6502T::NOP;
+    handlers_ptrs[0xDB] = &cpu6502T::DCP_ay;
+    handlers_ptrs[0xDC] = &cpu6502T::NOP_ax;
+    handlers_ptrs[0xDD] = &cpu6502T::CMP_ax;
+    handlers_ptrs[0xDE] = &cpu6502T::DEC_ax;
+    handlers_ptrs[0xDF] = &cpu6502T::DCP_ax;
+
+    handlers_ptrs[0xE0] = &cpu6502T::CPX_i;
+    handlers_ptrs[0xE1] = &cpu6502T::SBC_xb;
+    handlers_ptrs[0xE2] = &cpu6502T::DOP_i;
+    handlers_ptrs[0xE3] = &cpu6502T::ISC_xb;
+    handlers_ptrs[0xE4] = &cpu6502T::CPX_d;
+    handlers_ptrs[0xE5] = &cpu6502T::SBC_d;
+    handlers_ptrs[0xE6] = &cpu6502T::INC_d;
+    handlers_ptrs[0xE7] = &cpu6502T::ISC_d;
+    handlers_ptrs[0xE8] = &cpu6502T::INX;
+    handlers_ptrs[0xE9] = &cpu6502T::SBC_i;
+    handlers_ptrs[0xEA] = &cpu6502T::NOP;
+    handlers_ptrs[0xEB] = &cpu6502T::SBC_i;
+    handlers_ptrs[0xEC] = &cpu6502T::CPX_a;
+    handlers_ptrs[0xED] = &cpu6502T::SBC_a;
+    handlers_ptrs[0xEE] = &cpu6502T::INC_a;
+    handlers_ptrs[0xEF] = &cpu6502T::ISC_a;
+    handlers_ptrs[0xF0] = &cpu6502T::BEQ;
+    handlers_ptrs[0xF1] = &cpu6502T::SBC_by;
+    handlers_ptrs[0xF2] = &cpu6502T::KIL;
+    handlers_ptrs[0xF3] = &cpu6502T::ISC_by;
+    handlers_ptrs[0xF4] = &cpu6502T::NOP_dx;
+    handlers_ptrs[0xF5] = &cpu6502T::SBC_dx;
+    handlers_ptrs[0xF6] = &cpu6502T::INC_dx;
+    handlers_ptrs[0xF7] = &cpu6502T::ISC_dx;
+    handlers_ptrs[0xF8] = &cpu6502T::SED;
+    handlers_ptrs[0xF9] = &cpu6502T::SBC_ay;
+    handlers_ptrs[0xFA] = &cpu6502T::NOP;
+    handlers_ptrs[0xFB] = &cpu6502T::ISC_ay;
+    handlers_ptrs[0xFC] = &cpu6502T::NOP_ax;
+    handlers_ptrs[0xFD] = &cpu6502T::SBC_ax;
+    handlers_ptrs[0xFE] = &cpu6502T::INC_ax;
+    handlers_ptrs[0xFF] = &cpu6502T::ISC_ax;
+}
+
+/* ========== CORES ============ */
+// the ones core_resolve can create (mappers/mapper_resolve.cpp)
+
+template class cpu6502T<NESMemory>;
+template class cpu6502T<NESMemoryT<ROMDefault>>;
+template class cpu6502T<NESMemoryT<ROMMapper1>>;
+template class cpu6502T<NESMemoryT<ROMMapper2>>;
+template class cpu6502T<NESMemoryT<ROMMapper3>>;
+template class cpu6502T<NESMemoryT<ROMMapper4>>;
+template class cpu6502T<NESMemoryT<ROMMapper7>>;
+#ifdef GAYA_CPU_TESTS
+// and the one of the CPU tests (cpu_test_memory.hpp)
+template class cpu6502T<FullRamMemory>;
+#endif
@@ -8,13 +8,31 @@ author : gthev
 #include <string>
 #include <queue>
 #include <stack>
+#include <memory>
+#include <unordered_map>
 #include "exceptions.hpp"
 #include "types.hpp"
 #include "mem.hpp"
+#include "dynarec.hpp"
+
+class TraceWriter;
+class Profiler;
+class Breakpoints;
+class CodeDataLogger;
 
 /* ==================================== */
 /*       DEFINITION OF THE 6502         */
 
+// sources of the IRQ line, which stays asserted while one of them is
+#define IRQ_SOURCE_MAPPER       0x01
+
+#define NO_DEADLINE             0xFFFFFFFF
+
+// idle loops are at most this long (bytes)
+#define IDLE_LOOP_MAX_BYTES     16
+#define NO_IDLE_LOOP            0xFFFFFFFF
+#define IDLE_REJECTED_SIZE      16
+
 class cpu6502
 {
 public:
@@ -37,14 +55,26 @@ public:
         Normally, those information are present in the P register, but for efficiency (as we don't program in assembly),
         we define them with a byte for each (yay what a waste) 
         A flag is set whenever it's value is != 0
+        With GAYA_LAZY_FLAGS, they are packed in one byte (bool bit-fields : any value
+        != 0 still sets them, and they read as 0 or 1), and the CPU doesn't keep Z and N
+        here but computes them from the last result when needed (see flag_Z())
         */
 
+#ifdef GAYA_LAZY_FLAGS
+        bool        C : 1;
+        bool        D : 1;
+        bool        Z : 1;
+        bool        I : 1;
+        bool        V : 1;
+        bool        N : 1;
+#else
         BOOL        C;
         BOOL        D;
         BOOL        Z;
         BOOL        I;
         BOOL        V;
         BOOL        N;
+#endif
     };
 
     struct cpu6502logentry {
@@ -58,6 +88,9 @@ public:
         cpu6502flags flags;
         UINT32 cycles;
         BOOL return_on_ppu, skip_next_op;
+        UINT8 irq_lines;
+        BOOL nmi_pending;
+        UINT32 nmi_deadline, irq_deadline;
     };
 
     typedef struct {
@@ -65,52 +98,133 @@ public:
         BOOL   ppu_dirty;
     } execute_cycles_res;
 
+    // all the instruction sinks at once, the ones which are null are not used
+    typedef struct {
+        FILE            *debug_s;
+        TraceWriter     *writer;
+        Profiler        *profiler;
+        Breakpoints     *breakpoints;
+        CodeDataLogger  *cdl;
+    } trace_sinks;
+
     cpu6502(){ throw MemNotFound("Trying to create cpu6502 without memory"); };
     cpu6502(CPUMemoryManager *mem_handl);
+    virtual ~cpu6502(){};
     int                         init_cpu(MEMADDR pc);
     int                         reset_cpu();
-    UINT8                       von_neumann_cycle();
-    UINT8                       execute_op(UINT8 op);
-    execute_cycles_res          execute_cycles(UINT32 nr_cycles);
-    execute_cycles_res          execute_cycles_debug(UINT32 nr_cycles, FILE *debug_s, UINT32 cycle_min);
+    virtual UINT8               von_neumann_cycle() = 0;
+    virtual UINT8               execute_op(UINT8 op) = 0;
+    // runs at least nr_cycles (the cycles counter is updated), unless a PPU sync is needed
+    virtual execute_cycles_res  execute_cycles(UINT32 nr_cycles) = 0;
+    virtual execute_cycles_res  execute_cycles_debug(UINT32 nr_cycles, FILE *debug_s, UINT32 cycle_min) = 0;
+    // same as execute_cycles, with a record of each instruction pushed to writer (see trace.hpp)
+    virtual execute_cycles_res  execute_cycles_traced(UINT32 nr_cycles, TraceWriter *writer) = 0;
+    // same as execute_cycles, the cycles of each instruction are counted by profiler (see profiler.hpp)
+    virtual execute_cycles_res  execute_cycles_profiled(UINT32 nr_cycles, Profiler *profiler) = 0;
+    // same as execute_cycles, stopping on the breakpoints (see breakpoints.hpp)
+    virtual execute_cycles_res  execute_cycles_breakpoints(UINT32 nr_cycles, Breakpoints *breakpoints) = 0;
+    // same as execute_cycles, the PRG ROM bytes used are marked in cdl (see cdl.hpp)
+    virtual execute_cycles_res  execute_cycles_cdl(UINT32 nr_cycles, CodeDataLogger *cdl) = 0;
+    // same as execute_cycles, with several of the above (the breakpoints are checked first)
+    virtual execute_cycles_res  execute_cycles_sinks(UINT32 nr_cycles, const trace_sinks &sinks) = 0;
 
     /* get status */
     struct cpu6502regs          get_cpu_regs() const { return regs; };
-    struct cpu6502flags         get_cpu_flags() const { return flags; };
+    struct cpu6502flags         get_cpu_flags() const {
+        cpu6502flags f = flags;
+#ifdef GAYA_LAZY_FLAGS
+        f.Z = flag_Z();
+        f.N = flag_N();
+#endif
+        return f;
+    };
 
-    void                        set_cpu_mem(CPUMemoryManager *cpu_mem){mem_handl = cpu_mem;};
+    virtual void                set_cpu_mem(CPUMemoryManager *cpu_mem){mem_handl = cpu_mem;};
 
     /* ================ INTERRUPTIONS ==================== */
     void                        enter_irq(bool from_brk);
     void                        enter_nmi();
     void                        enter_reset();
 
+    /* Interrupts are not entered by the devices, they set pending lines with the
+    cycle (as returned by get_cycles()) from which they should be taken. The CPU
+    takes them between two instructions, once that cycle is reached */
+    // NMI edge
+    void                        raise_nmi(UINT32 at_cycle);
+    // the IRQ line is taken while it is asserted and I is clear
+    void                        set_irq_line(UINT8 source);
+    void                        clear_irq_line(UINT8 source);
+
     /* ================ CPU HANDLING ===================== */
     UINT8                       read_mem(MEMADDR addr) { return mem_handl->read(addr); };
     void                        write_mem(MEMADDR addr, UINT8 val) { mem_handl->write(addr, val); };
-    void                        reset_cycles(){elapsed_cycles = 0;};
+    void                        reset_cycles();
     void                        wait_cycles(UINT16 nr_cycles){elapsed_cycles+=nr_cycles;};
     UINT32                      get_cycles(){return elapsed_cycles;};
+    UINT32                      get_interrupt_deadline(){return interrupt_deadline;};
     MEMADDR                     get_pc(){return regs.PC;};
 
 
+    /* Instructions are fetched directly from the memory PC is in (PRG bank, RAM)
+    as long as it stays in it. Mappers call this when they switch PRG banks */
+    void                        invalidate_code_page(){code_len = 0; reset_idle_loop();};
+    // the PRG banks the decoded instructions come from were changed (Game Genie)
+    void                        clear_decoded_pages();
+
     void                        set_return_on_ppu(BOOL new_val){return_on_ppu_op = new_val;};
     BOOL                        get_return_on_ppu(){return return_on_ppu_op;};
     BOOL                        get_skip_next_op_ppu(){return skip_next_op_ppu;};
     void                        set_skip_next_op_ppu(BOOL new_val){skip_next_op_ppu = new_val;};    
 
+    // runs translated blocks of the PRG ROM when not nullptr (execute_cycles only)
+    void                        set_dynarec(Dynarec *d){dynarec = d;};
+
+    /* When execute_cycles stopped for a PPU sync at the $2002 read starting an idle loop
+    (see idle_loop), the cycles of one of its iterations, 0 otherwise. Once the PPU is
+    synced, the iterations reading the same value as the last one can be skipped with
+    skip_idle_iterations(), running the PPU up to each of their reads */
+    UINT32                      get_idle_loop_period() {
+        return (skip_next_op_ppu && regs.PC == idle.pc && idle.confirmed && idle.polls_ppu)? idle.period : 0;
+    };
+    void                        skip_idle_iterations(UINT32 n) {
+        elapsed_cycles += n * idle.period;
+        idle.cycles = elapsed_cycles;
+#ifdef GAYA_CYCLE_EXACT
+        idle.cycles -= sync_rewind; // the loop starts before the $2002 read
+#endif
+    };
+
 /* ================= SAVE STATES =================== */
     cpu6502savestate get_state();
     void             restore_state(cpu6502savestate s);
 
-private:
+protected:
     /* information about the cpu state */
     struct cpu6502regs          regs;
     struct cpu6502flags         flags;
 
+    /* Z and N are read through these (branches, PHP, interrupts...), and written by
+    setNZflags() and set_flags() */
+#ifdef GAYA_LAZY_FLAGS
+    // last result setting Z and N : Z if its low byte is 0, N if bit 7 or 8 is set (8 : BIT)
+    UINT16                      nz_result;
+    BOOL                        flag_Z() const {return !(nz_result & 0xFF);};
+    BOOL                        flag_N() const {return (nz_result & 0x180) != 0;};
+    void                        set_flags(cpu6502flags f) {
+        flags = f;
+        nz_result = (f.Z? 0 : 1) | (f.N? 0x100 : 0);
+    };
+#else
+    BOOL                        flag_Z() const {return flags.Z;};
+    BOOL                        flag_N() const {return flags.N;};
+    void                        set_flags(cpu6502flags f) {flags = f;};
+#endif
+
 
     /* memory handlers */
 
+    /* Through virtual calls, only used out of the instructions (interrupts entry,
+    debugger). cpu6502T has the same functions without them */
     CPUMemoryManager            *mem_handl;
     // functions to read/write from stack don't modify regs.S !
     UINT8                       read_stack() { return mem_handl->read_stack(regs.S); };
@@ -126,37 +240,97 @@ private:
         regs.S = (regs.S - 1) & 0xFF;
     }
 
-    // fetches the byte pointed to by PC, and increments PC
-    UINT8                       fetch_from_pc();
-    MEMADDR                     fetch_addr_from_pc();
-
     /* cycles of the cpu since last call of reset cycles */
     UINT32                      elapsed_cycles;
+#ifdef GAYA_CYCLE_EXACT
+    // cycles of the instruction being executed already in elapsed_cycles
+    UINT8                       bus_cycles;
+    // ... when it was stopped by a PPU sync, to count again when it starts again
+    UINT8                       sync_rewind;
+#endif
+
+    // code_page[pc - code_lo] is the byte at pc, for code_lo <= pc < code_lo + code_len
+    const UINT8                 *code_page;
+    MEMADDR                     code_lo;
+    UINT32                      code_len;
+
+    /* PRG ROM instructions are decoded once, the first time they are executed, in a
+    table per bank (per PRG buffer : a bank switch selects another table, and
+    nothing has to be invalidated). RAM and PRG RAM code is decoded each time */
+    struct decoded_op {
+        UINT16      operand;
+        UINT8       opcode;
+        UINT8       length; // 0 : not decoded yet
+    };
+    // table of the code page, nullptr when it is not PRG ROM
+    decoded_op                  *code_decoded;
+    std::unordered_map<const UINT8 *, std::unique_ptr<decoded_op[]>>
+                                decoded_pages;
+    // last table of each 8kb slot, to avoid the map when PC goes from one to the other
+    const UINT8                 *slot_pages[4];
+    decoded_op                  *slot_decoded[4];
+    void                        map_decoded_page();
+    void                        decode_op(UINT16 off);
+    UINT8                       op_length[256];
+
+    // operand of the instruction being executed (fetched with its opcode)
+    UINT16                      operand;
 
     // Should return on a read/write to PPU ? (for synchronization)
     BOOL                        return_on_ppu_op;
     BOOL                        skip_next_op_ppu;
 
+    UINT8                       irq_lines; // IRQ_SOURCE_* bits
+    BOOL                        nmi_pending;
+    UINT32                      nmi_deadline, irq_deadline;
+    // earliest cycle where an interrupt should be taken, NO_DEADLINE if none
+    UINT32                      interrupt_deadline;
+    // the instructions loop runs up to there without looking at interrupts
+    UINT32                      run_limit;
+
+    Dynarec                     *dynarec;
+
+    /* Idle loops are the short loops of PRG ROM which only read RAM, ROM or $2002 and
+    test what they read, as the waits for the NMI or for the sprite 0 hit. When one comes
+    back to its start with the same registers, after exactly the cycles of its
+    instructions, it will run the same way until what it reads changes. RAM only changes
+    through an interrupt, so its iterations are skipped up to the next one (or to the end
+    of the run), and $2002 through the PPU, which the caller runs (get_idle_loop_period).
+    Only whole iterations are skipped, the cycles counter ends where it would have */
+    struct idle_loop {
+        UINT32      pc;         // first instruction, NO_IDLE_LOOP when none
+        UINT32      period;     // cycles of an iteration
+        BOOL        polls_ppu;  // the first instruction reads $2002
+        BOOL        confirmed;  // the last iteration changed nothing
+        UINT32      cycles;     // at the last pass on pc
+        UINT8       A, X, Y, S, P;
+    };
+    idle_loop                   idle;
+    // loops found not to be idle ones, by their low bits (nested loops alternate)
+    UINT32                      idle_rejected[IDLE_REJECTED_SIZE];
+    void                        reset_idle_loop() {
+        idle.pc = NO_IDLE_LOOP;
+        for(int i = 0; i < IDLE_REJECTED_SIZE; i++) idle_rejected[i] = NO_IDLE_LOOP;
+    };
+    // a branch or JMP went back to head, looks at the loop if it is a new one
+    void                        watch_idle_loop(MEMADDR head) {
+        if(head != idle.pc && head != idle_rejected[head % IDLE_REJECTED_SIZE]) analyze_idle_loop(head);
+    };
+    void                        analyze_idle_loop(MEMADDR head);
+    // PC is at the start of the idle loop, true if the last iteration changed nothing
+    bool                        idle_loop_pass();
+
+    void                        update_interrupt_deadline();
+    void                        take_interrupts();
+
 /* ================ OPCODES HANDLING ================= */
-/* First, a few routines to handle opcodes */
+/* First, a few routines to handle opcodes (in cpu6502T for the ones accessing memory) */
 
     struct addrmem_res {
         MEMADDR val;
         UINT8 nr_cycles; // if any additional clicks must be counted (eg in case of page boundary crossed)
     };
 
-    MEMADDR                     addr_absolute           (MEMADDR addr);
-    struct addrmem_res          addr_absolute_x         (MEMADDR addr);
-    struct addrmem_res          addr_absolute_y         (MEMADDR addr);
-    // particular case : an absolute indirect read returns an address, and never results in an additional cycle
-    MEMADDR                     addr_absolute_indirect  (MEMADDR addr); 
-    MEMADDR                     addr_zp                 (ZPADDR addr);
-    MEMADDR                     addr_zp_x               (ZPADDR addr);
-    MEMADDR                     addr_zp_y               (ZPADDR addr);
-    struct addrmem_res          addr_indirect_y         (ZPADDR addr);
-    MEMADDR                     addr_x_indirect         (ZPADDR addr);
-    MEMADDR                     addr_y_indirect         (ZPADDR addr);
-
     // an array containing the value of N flag for all 8bits numbers
     UINT8                flagNtable[256];
     void                 setNZflags(UINT8 n);
@@ -164,11 +338,207 @@ private:
     UINT8                doADC(UINT8 n);
     UINT8                doSBC(UINT8 n);
     void                 doCMP(UINT8 a, UINT8 b);
+    void                 doBIT(UINT8 val);
     UINT8                doBRANCH(INT8 r);
     UINT8                doSLO(UINT8 val);
     UINT8                doSRE(UINT8 val);
     UINT8                doRRA(UINT8 val);
     UINT8                doRLA(UINT8 val);
+    UINT8                doDCP(UINT8 val);
+    UINT8                doISC(UINT8 val);
+};
+
+/*
+Instructions of the 6502, for a given memory map : MEM is the concrete class of the
+CPU memory (NESMemoryT<ROMMapperN> for the NES, see core_resolve), so that fetches,
+operands and stack accesses are direct calls the compiler can inline instead of
+going through CPUMemoryManager and ROMMemManager. NESMemory can be used for any
+memory map, through virtual calls.
+*/
+template<class MEM>
+class cpu6502T final : public cpu6502
+{
+public:
+    cpu6502T(MEM *mem);
+
+    UINT8                       von_neumann_cycle();
+    UINT8                       execute_op(UINT8 op);
+    execute_cycles_res          execute_cycles(UINT32 nr_cycles);
+    execute_cycles_res          execute_cycles_debug(UINT32 nr_cycles, FILE *debug_s, UINT32 cycle_min);
+    execute_cycles_res          execute_cycles_traced(UINT32 nr_cycles, TraceWriter *writer);
+    execute_cycles_res          execute_cycles_profiled(UINT32 nr_cycles, Profiler *profiler);
+    execute_cycles_res          execute_cycles_breakpoints(UINT32 nr_cycles, Breakpoints *breakpoints);
+    execute_cycles_res          execute_cycles_cdl(UINT32 nr_cycles, CodeDataLogger *cdl);
+    execute_cycles_res          execute_cycles_sinks(UINT32 nr_cycles, const trace_sinks &sinks);
+
+    void                        set_cpu_mem(CPUMemoryManager *cpu_mem) {
+        mem_handl = cpu_mem;
+        mem = static_cast<MEM *>(cpu_mem);
+        invalidate_code_page();
+    };
+
+    /* Non virtual versions of the cpu6502 ones. With GAYA_CYCLE_EXACT, the accesses of
+    the instructions are counted as they are done, each one a cycle : during one,
+    get_cycles() is its cycle, so the registers (and the PPU sync, see run_cycles) see
+    exactly when they are accessed. Otherwise the instructions are counted once done,
+    and all their accesses are at their first cycle */
+#ifdef GAYA_CYCLE_EXACT
+    UINT8                       read_mem(MEMADDR addr) { UINT8 val = mem->MEM::read(addr); tick(); return val; };
+    void                        write_mem(MEMADDR addr, UINT8 val) { mem->MEM::write(addr, val); tick(); };
+#else
+    UINT8                       read_mem(MEMADDR addr) { return mem->MEM::read(addr); };
+    void                        write_mem(MEMADDR addr, UINT8 val) { mem->MEM::write(addr, val); };
+#endif
+
+private:
+    MEM                         *mem;
+
+#ifdef GAYA_CYCLE_EXACT
+    UINT8                       read_stack() { UINT8 val = mem->MEM::read_stack(regs.S); tick(); return val; };
+    void                        write_stack(UINT8 val) { mem->MEM::write_stack(regs.S, val); tick(); };
+    // a cycle of the instruction being executed
+    void                        tick() { elapsed_cycles++; bus_cycles++; };
+#else
+    UINT8                       read_stack() { return mem->MEM::read_stack(regs.S); };
+    void                        write_stack(UINT8 val) { mem->MEM::write_stack(regs.S, val); };
+    void                        tick() {};
+#endif
+    /* The 6502 reads or writes on each cycle. Where it is PC, the stack or the zero page,
+    there is nothing to emulate and it is only a tick(), but the indexed modes read
+    before the high byte of the address is fixed, and the read-modify-write instructions
+    write back what they read before the result : those can reach registers, and are
+    done (only in GAYA_CYCLE_EXACT) */
+#ifdef GAYA_CYCLE_EXACT
+    void                        dummy_read(MEMADDR addr) {read_mem(addr);};
+    void                        dummy_write(MEMADDR addr, UINT8 val) {write_mem(addr, val);};
+#else
+    void                        dummy_read(MEMADDR) {};
+    void                        dummy_write(MEMADDR, UINT8) {};
+#endif
+    // the stores and read-modify-writes read there even when the page was right
+    void                        fixed_dummy_read(const addrmem_res &res) {if(!res.nr_cycles) dummy_read(res.val);};
+
+    UINT8                       pop_stack() {
+        regs.S = (regs.S + 1) & 0xFF;
+        return read_stack();
+    };
+
+    void                        push_stack(UINT8 val) {
+        write_stack(val);
+        regs.S = (regs.S - 1) & 0xFF;
+    }
+
+    // fetches the byte pointed to by PC, and increments PC
+    UINT8                       fetch_from_pc() {
+        UINT16 off = regs.PC - code_lo;
+        if(off >= code_len) {
+            // left the page, or banks were switched
+            if(!map_code_page()) return mem->MEM::read(regs.PC++);
+            off = regs.PC - code_lo;
+        }
+        regs.PC++;
+        return code_page[off];
+    };
+    // returns false when PC is not in RAM or ROM (code_len is 0 then)
+    bool                        map_code_page() {
+        code_page = mem->MEM::get_code_page(regs.PC, code_lo, code_len);
+        map_decoded_page();
+        return code_len != 0;
+    };
+    // returns the opcode at PC, sets operand, and PC after the instruction
+    UINT8                       fetch_instruction() {
+        UINT16 off = regs.PC - code_lo;
+        if(off < code_len && code_decoded) {
+            decoded_op &d = code_decoded[off];
+            if(!d.length) decode_op(off);
+            if(d.length) {
+                operand = d.operand;
+                regs.PC += d.length;
+                return d.opcode;
+            }
+        }
+        // the instruction can be in two pages
+        UINT8 op = fetch_from_pc();
+        operand = 0;
+        if(op_length[op] > 1) operand = fetch_from_pc();
+        if(op_length[op] > 2) operand |= fetch_from_pc() << 8;
+        return op;
+    };
+
+    /* Trace policies of run_cycles, called with each instruction before it is executed
+    (its operand is fetched), after it is (with its cycles), and after an interrupt was
+    entered. The instructions are all interpreted when tracing, and the idle loops are
+    not skipped */
+    struct NoTrace {
+        static const bool       enabled = false;
+        void                    instruction(cpu6502T &, MEMADDR, UINT8, UINT32) {};
+        void                    executed(cpu6502T &, MEMADDR, UINT8, UINT32) {};
+        void                    interrupt(cpu6502T &, UINT32) {};
+    };
+    // text, on debug_s (execute_cycles_debug)
+    struct TextTrace : NoTrace {
+        static const bool       enabled = true;
+        FILE                    *debug_s;
+        UINT32                  cycle_min;
+        void                    instruction(cpu6502T &cpu, MEMADDR pc, UINT8 op, UINT32 start);
+    };
+    // binary records, to a TraceWriter
+    struct RingTrace : NoTrace {
+        static const bool       enabled = true;
+        TraceWriter             *writer;
+        void                    instruction(cpu6502T &cpu, MEMADDR pc, UINT8 op, UINT32 start);
+    };
+    // cycles per instruction, bank and routine, to a Profiler
+    struct ProfileTrace : NoTrace {
+        static const bool       enabled = true;
+        Profiler                *profiler;
+        void                    executed(cpu6502T &cpu, MEMADDR pc, UINT8 op, UINT32 cycles);
+        void                    interrupt(cpu6502T &cpu, UINT32 cycles);
+    };
+    // checks the breakpoints before each instruction
+    struct BreakTrace : NoTrace {
+        static const bool       enabled = true;
+        Breakpoints             *breakpoints;
+        void                    instruction(cpu6502T &cpu, MEMADDR pc, UINT8 op, UINT32 start);
+    };
+    // code/data logger
+    struct CdlTrace : NoTrace {
+        static const bool       enabled = true;
+        CodeDataLogger          *cdl;
+        void                    instruction(cpu6502T &cpu, MEMADDR pc, UINT8 op, UINT32 start);
+    };
+    // forwards to the policies above which have a sink
+    struct MultiTrace : NoTrace {
+        static const bool       enabled = true;
+        BreakTrace              brk;
+        TextTrace               text;
+        RingTrace               ring;
+        ProfileTrace            profile;
+        CdlTrace                cdl;
+        void                    instruction(cpu6502T &cpu, MEMADDR pc, UINT8 op, UINT32 start);
+        void                    executed(cpu6502T &cpu, MEMADDR pc, UINT8 op, UINT32 cycles);
+        void                    interrupt(cpu6502T &cpu, UINT32 cycles);
+    };
+    template<class TRACE>
+    execute_cycles_res          run_cycles(UINT32 nr_cycles, TRACE &trace);
+
+    // runs the translated block at PC, false when there is none (or it did nothing)
+    bool                        run_block();
+    // at the start of an idle loop which changed nothing
+    void                        skip_idle_loop();
+    static UINT8                dynarec_read(void *m, MEMADDR a) {return static_cast<MEM *>(m)->MEM::read(a);};
+
+    MEMADDR                     addr_absolute           (MEMADDR addr);
+    struct addrmem_res          addr_absolute_x         (MEMADDR addr);
+    struct addrmem_res          addr_absolute_y         (MEMADDR addr);
+    // particular case : an absolute indirect read returns an address, and never results in an additional cycle
+    MEMADDR                     addr_absolute_indirect  (MEMADDR addr); 
+    MEMADDR                     addr_zp                 (ZPADDR addr);
+    MEMADDR                     addr_zp_x               (ZPADDR addr);
+    MEMADDR                     addr_zp_y               (ZPADDR addr);
+    struct addrmem_res          addr_indirect_y         (ZPADDR addr);
+    MEMADDR                     addr_x_indirect         (ZPADDR addr);
+    MEMADDR                     addr_y_indirect         (ZPADDR addr);
 
 /*
 -------------- List of handlers
@@ -414,11 +784,11 @@ and they return the number of cycles the instruction took. This list also includ
     UINT8 SBC_ax();
     UINT8 INC_ax();
     UINT8 ISC_ax();
-    UINT8 INC_ay();
 
-    UINT8 (cpu6502::*handlers_ptrs[256])();
+    UINT8 (cpu6502T::*handlers_ptrs[256])();
 };
 
-UINT8 flags_to_byte(struct cpu6502flags f);
+// P as pushed on the stack, bit4 : B
+UINT8 flags_to_byte(cpu6502::cpu6502flags f, UINT8 bit4);
 
 #endif
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <boost/algorithm/string.hpp>
 #include <vector>
 #include "cpu.hpp"
+#include "cpu_test_memory.hpp"
 
 #define INSTR_START   0x00C0
 
@@ -12,16 +13,15 @@
 -> s : step
 -> r : read memory, 'r 1234' to read $1234
 
-compile with
-g++ -o cputest cpu_debug.cpp cpu.cpp ppu_mem.cpp mem.cpp -lSDL2 -g
+compile with (the CPU cores need the mappers, so most of the core is linked)
+g++ -g -DGAYA_CPU_TESTS -o cputest cpu_debug.cpp nes_loaders/ines.cpp nes_loaders/rom_image.cpp nes_loaders/rom_db.cpp emulation_manager.cpp emulation_debug_cli.cpp ppu_render/ppu_render.cpp ppu_render/draw_tile.cpp ppu_render/frame_presenter.cpp cpu.cpp cpu_opcodes.cpp dynarec.cpp mem.cpp game_genie.cpp ram_search.cpp ppu_mem.cpp input_devices/device.cpp input_devices/nesjoypad.cpp input_devices/input_movie.cpp sdl_utils.cpp latency_probe.cpp battery_save.cpp trace.cpp profiler.cpp breakpoints.cpp cdl.cpp mappers/mapper_resolve.cpp mappers/mapper1.cpp mappers/mapper2.cpp mappers/mapper3.cpp mappers/mapper4.cpp mappers/mapper7.cpp -lSDL2 -pthread
 */
 
-void print_cpu_state(cpu6502 const& cpu, FullRamMemory *mem) {
-    cpu6502flags f = cpu.get_cpu_flags();
-    cpu6502regs  r = cpu.get_cpu_regs();
-    cpu6502interrupts intps = cpu.get_cpu_intps();
+void print_cpu_state(cpu6502 const& cpu, FullRamMemory *mem, bool halted) {
+    cpu6502::cpu6502flags f = cpu.get_cpu_flags();
+    cpu6502::cpu6502regs  r = cpu.get_cpu_regs();
 
-    UINT8 flags = flags_to_byte(f);
+    UINT8 flags = flags_to_byte(f, 0);
     UINT8 next_op = mem->read(r.PC);
     std::bitset<8> fb(flags);
 
@@ -31,9 +31,7 @@ void print_cpu_state(cpu6502 const& cpu, FullRamMemory *mem) {
     std::printf("Y  : $%02X\n", r.Y);
     std::printf("S  : $%02X\n", r.S);
     std::cout << "NV---IZC" << std::endl;
-    if(intps.CPUhalt) std::cout << "*** CPU HALTED ***\n";
-    if(intps.NMIPending) std::cout << "* NMI PENDING *\n";
-    if(intps.IRQPending) std::cout << "* IRQ PENDING *\n";
+    if(halted) std::cout << "*** CPU HALTED ***\n";
     std::cout << fb << std::endl;
 }
 
@@ -50,7 +48,8 @@ int main(int argc, char *argv[]) {
 
     bool cont = true;
     FullRamMemory *mem = new FullRamMemory();
-    cpu6502 cpu = cpu6502(mem);
+    cpu6502T<FullRamMemory> cpu(mem);
+    bool halted = false;
     std::cout << s << std::endl;
 
     do {
@@ -86,7 +85,7 @@ int main(int argc, char *argv[]) {
     cont = true;
     while(cont) {
         std::cout << "===================\n";
-        print_cpu_state(cpu, mem);
+        print_cpu_state(cpu, mem, halted);
         std::cout << ">>> ";
         std::getline(std::cin, input);
 
@@ -98,10 +97,17 @@ int main(int argc, char *argv[]) {
         // ------------- step
 
         if(input == "" || command == "s") {
-            if(!cpu.get_cpu_intps().CPUhalt) {
-                UINT8 nr_cycles = cpu.von_neumann_cycle();
-                std::printf("%d cycles\n", 
-                    (unsigned int)nr_cycles);
+            if(!halted) {
+                try
+                {
+                    UINT8 nr_cycles = cpu.von_neumann_cycle();
+                    std::printf("%d cycles\n", 
+                        (unsigned int)nr_cycles);
+                }
+                catch(const CPUHalted& e)
+                {
+                    halted = true;
+                }
             }
 
         // -------------- read memory
@@ -0,0 +1,640 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <random>
+#include <set>
+#include <vector>
+#include "cpu.hpp"
+#include "cpu_test_memory.hpp"
+
+/*
+Differential fuzzer of the CPU : random instructions are run from random states by
+cpu6502T<FullRamMemory> and by a reference 6502 written here (with its own opcode
+tables, nothing is shared with cpu.cpp), and their registers, flags, writes and
+cycles are compared after each instruction. A difference is reduced to the
+instruction alone, from a state where the registers and the memory it reads are
+simplified as long as the difference stays, and printed (the first one of each
+opcode).
+
+    ./cpu_fuzz [-n cases] [-l instructions per case] [-s seed]
+
+Each case is a random state (registers and the 64kb of memory) with a sequence of
+random instructions at PC, run until the end of the sequence or an opcode which is
+not tested. The exit status is 1 when a difference was found.
+Not tested : KIL, and the unstable opcodes (XAA, LAX #imm, AHX, SHX, SHY, TAS).
+Interrupts are only BRK. The 2A03 has no decimal mode, D only changes P.
+Writes are compared in their order, without the dummy ones of the read-modify-write
+instructions. With GAYA_CYCLE_EXACT, the reference does the dummy accesses too, and
+all the reads and writes are compared with their cycle (but the instruction fetches,
+and the reads whose value is not used on PC, the stack and the zero page, which
+cpu6502T only counts).
+
+Compile with (add -DGAYA_LAZY_FLAGS or -DGAYA_CYCLE_EXACT to test these versions)
+g++ -O2 -DGAYA_CPU_TESTS -o cpu_fuzz cpu_fuzz.cpp nes_loaders/ines.cpp nes_loaders/rom_image.cpp nes_loaders/rom_db.cpp emulation_manager.cpp emulation_debug_cli.cpp ppu_render/ppu_render.cpp ppu_render/draw_tile.cpp ppu_render/frame_presenter.cpp cpu.cpp cpu_opcodes.cpp dynarec.cpp mem.cpp game_genie.cpp ram_search.cpp ppu_mem.cpp input_devices/device.cpp input_devices/nesjoypad.cpp input_devices/input_movie.cpp sdl_utils.cpp latency_probe.cpp battery_save.cpp trace.cpp profiler.cpp breakpoints.cpp cdl.cpp mappers/mapper_resolve.cpp mappers/mapper1.cpp mappers/mapper2.cpp mappers/mapper3.cpp mappers/mapper4.cpp mappers/mapper7.cpp -lSDL2 -pthread
+*/
+
+// ==================== REFERENCE
+
+#define FLAG_C      0x01
+#define FLAG_Z      0x02
+#define FLAG_I      0x04
+#define FLAG_D      0x08
+#define FLAG_B      0x10
+#define FLAG_U      0x20
+#define FLAG_V      0x40
+#define FLAG_N      0x80
+
+enum ref_mode {IMP, ACC, IMM, ZP, ZPX, ZPY, ABS, ABX, ABY, IND, IZX, IZY, REL};
+static const char *ref_mode_names[] = {"imp", "acc", "imm", "zp", "zpx", "zpy", "abs", "abx", "aby", "ind", "izx", "izy", "rel"};
+
+// the opcode matrix of the NMOS 6502, name and addressing mode of $00-$FF
+static const char *ref_matrix[16] = {
+    "BRK imp ORA izx KIL imp SLO izx NOP zp  ORA zp  ASL zp  SLO zp  PHP imp ORA imm ASL acc ANC imm NOP abs ORA abs ASL abs SLO abs",
+    "BPL rel ORA izy KIL imp SLO izy NOP zpx ORA zpx ASL zpx SLO zpx CLC imp ORA aby NOP imp SLO aby NOP abx ORA abx ASL abx SLO abx",
+    "JSR abs AND izx KIL imp RLA izx BIT zp  AND zp  ROL zp  RLA zp  PLP imp AND imm ROL acc ANC imm BIT abs AND abs ROL abs RLA abs",
+    "BMI rel AND izy KIL imp RLA izy NOP zpx AND zpx ROL zpx RLA zpx SEC imp AND aby NOP imp RLA aby NOP abx AND abx ROL abx RLA abx",
+    "RTI imp EOR izx KIL imp SRE izx NOP zp  EOR zp  LSR zp  SRE zp  PHA imp EOR imm LSR acc ALR imm JMP abs EOR abs LSR abs SRE abs",
+    "BVC rel EOR izy KIL imp SRE izy NOP zpx EOR zpx LSR zpx SRE zpx CLI imp EOR aby NOP imp SRE aby NOP abx EOR abx LSR abx SRE abx",
+    "RTS imp ADC izx KIL imp RRA izx NOP zp  ADC zp  ROR zp  RRA zp  PLA imp ADC imm ROR acc ARR imm JMP ind ADC abs ROR abs RRA abs",
+    "BVS rel ADC izy KIL imp RRA izy NOP zpx ADC zpx ROR zpx RRA zpx SEI imp ADC aby NOP imp RRA aby NOP abx ADC abx ROR abx RRA abx",
+    "NOP imm STA izx NOP imm SAX izx STY zp  STA zp  STX zp  SAX zp  DEY imp NOP imm TXA imp XAA imm STY abs STA abs STX abs SAX abs",
+    "BCC rel STA izy KIL imp AHX izy STY zpx STA zpx STX zpy SAX zpy TYA imp STA aby TXS imp TAS aby SHY abx STA abx SHX aby AHX aby",
+    "LDY imm LDA izx LDX imm LAX izx LDY zp  LDA zp  LDX zp  LAX zp  TAY imp LDA imm TAX imp LXA imm LDY abs LDA abs LDX abs LAX abs",
+    "BCS rel LDA izy KIL imp LAX izy LDY zpx LDA zpx LDX zpy LAX zpy CLV imp LDA aby TSX imp LAS aby LDY abx LDA abx LDX aby LAX aby",
+    "CPY imm CMP izx NOP imm DCP izx CPY zp  CMP zp  DEC zp  DCP zp  INY imp CMP imm DEX imp AXS imm CPY abs CMP abs DEC abs DCP abs",
+    "BNE rel CMP izy KIL imp DCP izy NOP zpx CMP zpx DEC zpx DCP zpx CLD imp CMP aby NOP imp DCP aby NOP abx CMP abx DEC abx DCP abx",
+    "CPX imm SBC izx NOP imm ISC izx CPX zp  SBC zp  INC zp  ISC zp  INX imp SBC imm NOP imp SBC imm CPX abs SBC abs INC abs ISC abs",
+    "BEQ rel SBC izy KIL imp ISC izy NOP zpx SBC zpx INC zpx ISC zpx SED imp SBC aby NOP imp ISC aby NOP abx SBC abx INC abx ISC abx",
+};
+
+// cycles, without the page crossings and the branches taken
+static const UINT8 ref_cycles[256] = {
+    7, 6, 0, 8, 3, 3, 5, 5, 3, 2, 2, 2, 4, 4, 6, 6,
+    2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,
+    6, 6, 0, 8, 3, 3, 5, 5, 4, 2, 2, 2, 4, 4, 6, 6,
+    2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,
+    6, 6, 0, 8, 3, 3, 5, 5, 3, 2, 2, 2, 3, 4, 6, 6,
+    2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,
+    6, 6, 0, 8, 3, 3, 5, 5, 4, 2, 2, 2, 5, 4, 6, 6,
+    2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,
+    2, 6, 2, 6, 3, 3, 3, 3, 2, 2, 2, 2, 4, 4, 4, 4,
+    2, 6, 0, 6, 4, 4, 4, 4, 2, 5, 2, 5, 5, 5, 5, 5,
+    2, 6, 2, 6, 3, 3, 3, 3, 2, 2, 2, 2, 4, 4, 4, 4,
+    2, 5, 0, 5, 4, 4, 4, 4, 2, 4, 2, 4, 4, 4, 4, 4,
+    2, 6, 2, 8, 3, 3, 5, 5, 2, 2, 2, 2, 4, 4, 6, 6,
+    2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,
+    2, 6, 2, 8, 3, 3, 5, 5, 2, 2, 2, 2, 4, 4, 6, 6,
+    2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,
+};
+
+struct ref_opcode {
+    char        name[4];
+    ref_mode    mode;
+    UINT8       cycles;
+    bool        page_cycle; // +1 when the indexed address is in another page
+    bool        tested;
+};
+static ref_opcode ref_ops[256];
+
+static void init_ref_ops() {
+    // the reads (the stores and read-modify-write ones always take the extra cycle)
+    static const char *page_cycle[] = {"ORA", "AND", "EOR", "ADC", "SBC", "CMP", "LDA", "LDX", "LDY", "LAX", "LAS", "NOP"};
+    static const char *untested[] = {"KIL", "XAA", "LXA", "AHX", "SHX", "SHY", "TAS"};
+    for(int row = 0; row < 16; row++) {
+        const char *p = ref_matrix[row];
+        for(int col = 0; col < 16; col++) {
+            ref_opcode &o = ref_ops[row * 16 + col];
+            char mode[4];
+            int n;
+            std::sscanf(p, "%3s %3s%n", o.name, mode, &n);
+            p += n;
+            for(int m = 0; m <= REL; m++) if(!std::strcmp(mode, ref_mode_names[m])) o.mode = (ref_mode)m;
+            o.cycles = ref_cycles[row * 16 + col];
+            o.page_cycle = false;
+            if(o.mode == ABX || o.mode == ABY || o.mode == IZY) {
+                for(const char *name : page_cycle) if(!std::strcmp(o.name, name)) o.page_cycle = true;
+            }
+            o.tested = true;
+            for(const char *name : untested) if(!std::strcmp(o.name, name)) o.tested = false;
+        }
+    }
+}
+
+static int ref_length(ref_mode mode) {
+    switch (mode)
+    {
+    case IMP: case ACC: return 1;
+    case ABS: case ABX: case ABY: case IND: return 3;
+    default: return 2;
+    }
+}
+
+struct ref_regs {
+    UINT16      PC;
+    UINT8       A, X, Y, S;
+    UINT8       P; // U always set, B never
+};
+
+typedef FullRamMemory::access access;
+typedef std::vector<access> access_list;
+
+// what an instruction did
+struct outcome {
+    ref_regs    r;
+    unsigned int cycles;
+    access_list accesses; // the compared ones, cycles from the start of the instruction
+};
+
+// the writes, or all the accesses but the fetches through read() (at cycle 0)
+static void compared_accesses(const access_list &all, UINT32 start, access_list &out) {
+    out.clear();
+    for(access a : all) {
+        a.cycle -= start;
+#ifdef GAYA_CYCLE_EXACT
+        if(a.cycle) out.push_back(a);
+#else
+        a.cycle = 0;
+        if(a.write) out.push_back(a);
+#endif
+    }
+}
+
+#define NAME(a, b, c) ((a) << 16 | (b) << 8 | (c))
+
+class Reference6502
+{
+public:
+    ref_regs                    r;
+    UINT8                       mem[ADDR_SPACE_SIZE];
+    access_list                 accesses;
+    std::vector<MEMADDR>        reads;
+
+    void                        load(const ref_regs &regs, const UINT8 *m) {
+        r = regs;
+        std::memcpy(mem, m, ADDR_SPACE_SIZE);
+    };
+    // runs the instruction at PC, returns its cycles
+    unsigned int                step();
+    void                        step(outcome &out) {
+        accesses.clear();
+        reads.clear();
+        out.cycles = step();
+        out.r = r;
+        compared_accesses(accesses, 0, out.accesses);
+    };
+
+private:
+    // one access per cycle
+    unsigned int                clock;
+    UINT8                       rd(MEMADDR a) {
+        reads.push_back(a);
+        accesses.push_back({clock++, a, mem[a], 0});
+        return mem[a];
+    };
+    void                        wr(MEMADDR a, UINT8 v) {accesses.push_back({clock++, a, v, 1}); mem[a] = v;};
+    // the instruction bytes
+    UINT8                       fetch(MEMADDR a) {reads.push_back(a); clock++; return mem[a];};
+    // the reads of PC, the stack or the zero page whose value is not used
+    void                        idle() {clock++;};
+#ifdef GAYA_CYCLE_EXACT
+    void                        dummy_rd(MEMADDR a) {rd(a);};
+    void                        dummy_wr(MEMADDR a, UINT8 v) {wr(a, v);};
+#else
+    void                        dummy_rd(MEMADDR) {};
+    void                        dummy_wr(MEMADDR, UINT8) {};
+#endif
+    void                        push(UINT8 v) {wr(0x0100 | r.S, v); r.S--;};
+    UINT8                       pull() {r.S++; return rd(0x0100 | r.S);};
+    void                        set(UINT8 flag, bool on) {r.P = (on)? r.P | flag : r.P & ~flag;};
+    void                        nz(UINT8 v) {set(FLAG_Z, !v); set(FLAG_N, v & 0x80);};
+    void                        adc(UINT8 v) {
+        unsigned int sum = r.A + v + (r.P & FLAG_C);
+        set(FLAG_V, ~(r.A ^ v) & (r.A ^ sum) & 0x80);
+        set(FLAG_C, sum > 0xFF);
+        r.A = sum;
+        nz(r.A);
+    };
+    void                        cmp(UINT8 reg, UINT8 v) {set(FLAG_C, reg >= v); nz(reg - v);};
+};
+
+unsigned int Reference6502::step() {
+    clock = 0;
+    UINT8 op = fetch(r.PC);
+    const ref_opcode &o = ref_ops[op];
+    UINT8 lo = 0, hi = 0;
+    int len = ref_length(o.mode);
+    if(len > 1) lo = fetch(r.PC + 1);
+    if(len > 2) hi = fetch(r.PC + 2);
+    // the 1 byte instructions read the next one
+    if(len == 1) idle();
+    r.PC += len;
+    unsigned int cycles = o.cycles;
+
+    // effective address
+    MEMADDR ea = 0, base = 0;
+    switch (o.mode)
+    {
+    case ZP:  ea = lo; break;
+    // (zp) is read while X or Y is added
+    case ZPX: idle(); ea = (UINT8)(lo + r.X); break;
+    case ZPY: idle(); ea = (UINT8)(lo + r.Y); break;
+    case ABS: ea = lo | hi << 8; break;
+    case ABX: base = lo | hi << 8; ea = base + r.X; break;
+    case ABY: base = lo | hi << 8; ea = base + r.Y; break;
+    case IND:
+        base = lo | hi << 8;
+        // the high byte is read in the same page
+        ea = rd(base);
+        ea |= rd((base & 0xFF00) | ((base + 1) & 0x00FF)) << 8;
+        break;
+    // (the low byte first, the order of the reads is compared with GAYA_CYCLE_EXACT)
+    case IZX: idle(); ea = rd((UINT8)(lo + r.X)); ea |= rd((UINT8)(lo + r.X + 1)) << 8; break;
+    case IZY: base = rd(lo); base |= rd((UINT8)(lo + 1)) << 8; ea = base + r.Y; break;
+    case REL: ea = r.PC + (INT8)lo; break;
+    default: break;
+    }
+    if(o.mode == ABX || o.mode == ABY || o.mode == IZY) {
+        bool crossed = (ea ^ base) & 0xFF00;
+        if(o.page_cycle && crossed) cycles++;
+        // read before the high byte is fixed, always by the stores and read-modify-writes
+        if(!o.page_cycle || crossed) dummy_rd((base & 0xFF00) | (ea & 0x00FF));
+    }
+
+    // the value of the reads
+    UINT8 v = (o.mode == IMM)? lo : (o.mode == IMP || o.mode == ACC || o.mode == REL)? r.A : 0;
+    bool branch = false, taken = false;
+    switch (NAME(o.name[0], o.name[1], o.name[2]))
+    {
+    case NAME('L','D','A'): r.A = (o.mode == IMM)? v : rd(ea); nz(r.A); break;
+    case NAME('L','D','X'): r.X = (o.mode == IMM)? v : rd(ea); nz(r.X); break;
+    case NAME('L','D','Y'): r.Y = (o.mode == IMM)? v : rd(ea); nz(r.Y); break;
+    case NAME('L','A','X'): r.A = r.X = rd(ea); nz(r.A); break;
+    case NAME('L','A','S'): r.A = r.X = r.S = rd(ea) & r.S; nz(r.A); break;
+    case NAME('S','T','A'): wr(ea, r.A); break;
+    case NAME('S','T','X'): wr(ea, r.X); break;
+    case NAME('S','T','Y'): wr(ea, r.Y); break;
+    case NAME('S','A','X'): wr(ea, r.A & r.X); break;
+    case NAME('O','R','A'): r.A |= (o.mode == IMM)? v : rd(ea); nz(r.A); break;
+    case NAME('A','N','D'): r.A &= (o.mode == IMM)? v : rd(ea); nz(r.A); break;
+    case NAME('E','O','R'): r.A ^= (o.mode == IMM)? v : rd(ea); nz(r.A); break;
+    case NAME('A','D','C'): adc((o.mode == IMM)? v : rd(ea)); break;
+    case NAME('S','B','C'): adc(~((o.mode == IMM)? v : rd(ea))); break;
+    case NAME('C','M','P'): cmp(r.A, (o.mode == IMM)? v : rd(ea)); break;
+    case NAME('C','P','X'): cmp(r.X, (o.mode == IMM)? v : rd(ea)); break;
+    case NAME('C','P','Y'): cmp(r.Y, (o.mode == IMM)? v : rd(ea)); break;
+    case NAME('B','I','T'):
+        v = rd(ea);
+        set(FLAG_Z, !(r.A & v));
+        set(FLAG_N, v & 0x80);
+        set(FLAG_V, v & 0x40);
+        break;
+
+    // read-modify-write
+    case NAME('A','S','L'): case NAME('L','S','R'): case NAME('R','O','L'): case NAME('R','O','R'):
+    case NAME('S','L','O'): case NAME('S','R','E'): case NAME('R','L','A'): case NAME('R','R','A'): {
+        int name = NAME(o.name[0], o.name[1], o.name[2]);
+        bool left = (name == NAME('A','S','L') || name == NAME('R','O','L') || name == NAME('S','L','O') || name == NAME('R','L','A'));
+        bool rotate = (o.name[0] == 'R');
+        UINT8 carry_in = (rotate && (r.P & FLAG_C))? 1 : 0;
+        if(o.mode != ACC) {
+            v = rd(ea);
+            dummy_wr(ea, v);
+        }
+        if(left) {
+            set(FLAG_C, v & 0x80);
+            v = (v << 1) | carry_in;
+        } else {
+            set(FLAG_C, v & 0x01);
+            v = (v >> 1) | (carry_in << 7);
+        }
+        if(o.mode == ACC) r.A = v;
+        else wr(ea, v);
+        switch (name)
+        {
+        case NAME('S','L','O'): r.A |= v; nz(r.A); break;
+        case NAME('R','L','A'): r.A &= v; nz(r.A); break;
+        case NAME('S','R','E'): r.A ^= v; nz(r.A); break;
+        case NAME('R','R','A'): adc(v); break;
+        default: nz(v); break;
+        }
+        break;
+    }
+    case NAME('I','N','C'): v = rd(ea); dummy_wr(ea, v); wr(ea, ++v); nz(v); break;
+    case NAME('D','E','C'): v = rd(ea); dummy_wr(ea, v); wr(ea, --v); nz(v); break;
+    case NAME('D','C','P'): v = rd(ea); dummy_wr(ea, v); wr(ea, --v); cmp(r.A, v); break;
+    case NAME('I','S','C'): v = rd(ea); dummy_wr(ea, v); wr(ea, ++v); adc(~v); break;
+
+    // with an immediate operand
+    case NAME('A','N','C'): r.A &= v; nz(r.A); set(FLAG_C, r.A & 0x80); break;
+    case NAME('A','L','R'): r.A &= v; set(FLAG_C, r.A & 0x01); r.A >>= 1; nz(r.A); break;
+    case NAME('A','R','R'):
+        r.A &= v;
+        r.A = (r.A >> 1) | ((r.P & FLAG_C)? 0x80 : 0);
+        nz(r.A);
+        set(FLAG_C, r.A & 0x40);
+        set(FLAG_V, ((r.A >> 6) ^ (r.A >> 5)) & 0x01);
+        break;
+    case NAME('A','X','S'): {
+        UINT8 t = r.A & r.X;
+        set(FLAG_C, t >= v);
+        r.X = t - v;
+        nz(r.X);
+        break;
+    }
+    case NAME('N','O','P'): if(o.mode != IMP && o.mode != IMM) rd(ea); break;
+
+    case NAME('I','N','X'): nz(++r.X); break;
+    case NAME('I','N','Y'): nz(++r.Y); break;
+    case NAME('D','E','X'): nz(--r.X); break;
+    case NAME('D','E','Y'): nz(--r.Y); break;
+    case NAME('T','A','X'): nz(r.X = r.A); break;
+    case NAME('T','A','Y'): nz(r.Y = r.A); break;
+    case NAME('T','X','A'): nz(r.A = r.X); break;
+    case NAME('T','Y','A'): nz(r.A = r.Y); break;
+    case NAME('T','S','X'): nz(r.X = r.S); break;
+    case NAME('T','X','S'): r.S = r.X; break;
+    case NAME('C','L','C'): set(FLAG_C, false); break;
+    case NAME('S','E','C'): set(FLAG_C, true); break;
+    case NAME('C','L','I'): set(FLAG_I, false); break;
+    case NAME('S','E','I'): set(FLAG_I, true); break;
+    case NAME('C','L','V'): set(FLAG_V, false); break;
+    case NAME('C','L','D'): set(FLAG_D, false); break;
+    case NAME('S','E','D'): set(FLAG_D, true); break;
+
+    // stack
+    case NAME('P','H','A'): push(r.A); break;
+    case NAME('P','H','P'): push(r.P | FLAG_B | FLAG_U); break;
+    // the pulls read the stack once before incrementing S
+    case NAME('P','L','A'): idle(); r.A = pull(); nz(r.A); break;
+    case NAME('P','L','P'): idle(); r.P = (pull() & ~FLAG_B) | FLAG_U; break;
+
+    // jumps
+    case NAME('J','M','P'): r.PC = ea; break;
+    case NAME('J','S','R'):
+        // pushes the address of its last byte
+        push((r.PC - 1) >> 8);
+        push((r.PC - 1) & 0xFF);
+        idle(); // (the stack read, before the pushes : hi is fetched after them)
+        r.PC = ea;
+        break;
+    case NAME('R','T','S'): idle(); r.PC = pull(); r.PC |= pull() << 8; idle(); r.PC++; break;
+    case NAME('R','T','I'):
+        idle();
+        r.P = (pull() & ~FLAG_B) | FLAG_U;
+        r.PC = pull();
+        r.PC |= pull() << 8;
+        break;
+    case NAME('B','R','K'):
+        // skips the byte after it
+        r.PC++;
+        push(r.PC >> 8);
+        push(r.PC & 0xFF);
+        push(r.P | FLAG_B | FLAG_U);
+        set(FLAG_I, true);
+        r.PC = rd(0xFFFE);
+        r.PC |= rd(0xFFFF) << 8;
+        break;
+
+    case NAME('B','P','L'): branch = true; taken = !(r.P & FLAG_N); break;
+    case NAME('B','M','I'): branch = true; taken = r.P & FLAG_N; break;
+    case NAME('B','V','C'): branch = true; taken = !(r.P & FLAG_V); break;
+    case NAME('B','V','S'): branch = true; taken = r.P & FLAG_V; break;
+    case NAME('B','C','C'): branch = true; taken = !(r.P & FLAG_C); break;
+    case NAME('B','C','S'): branch = true; taken = r.P & FLAG_C; break;
+    case NAME('B','N','E'): branch = true; taken = !(r.P & FLAG_Z); break;
+    case NAME('B','E','Q'): branch = true; taken = r.P & FLAG_Z; break;
+    default:
+        std::printf("Reference : opcode $%02X (%s) is not emulated\n", op, o.name);
+        std::exit(2);
+    }
+    if(branch && taken) {
+        cycles += ((ea ^ r.PC) & 0xFF00)? 2 : 1;
+        clock += ((ea ^ r.PC) & 0xFF00)? 2 : 1;
+        r.PC = ea;
+    }
+#ifdef GAYA_CYCLE_EXACT
+    if(clock != cycles) {
+        std::printf("Reference : opcode $%02X (%s) takes %u cycles, and does %u accesses\n", op, o.name, cycles, clock);
+        std::exit(2);
+    }
+#endif
+    return cycles;
+}
+
+// ==================== CPU UNDER TEST
+
+class CpuUnderTest
+{
+public:
+    CpuUnderTest() : cpu(&mem) {
+        mem.accesses = &accesses;
+        mem.cpu = &cpu;
+        cpu.init_cpu(0);
+    };
+
+    void                        load(const ref_regs &r, const UINT8 *m) {
+        std::memcpy(mem.get_ram_rw(), m, ADDR_SPACE_SIZE);
+        set_regs(r);
+    };
+    // one instruction
+    void                        step(outcome &out) {
+        accesses.clear();
+        UINT32 start = cpu.get_cycles();
+        out.cycles = cpu.execute_cycles(1).cycles;
+        out.r = get_regs();
+        compared_accesses(accesses, start, out.accesses);
+    };
+
+    void                        set_regs(const ref_regs &r) {
+        cpu6502::cpu6502savestate s = cpu.get_state();
+        s.regs.PC = r.PC; s.regs.A = r.A; s.regs.X = r.X; s.regs.Y = r.Y; s.regs.S = r.S;
+        s.flags.C = r.P & FLAG_C;
+        s.flags.Z = r.P & FLAG_Z;
+        s.flags.I = r.P & FLAG_I;
+        s.flags.D = r.P & FLAG_D;
+        s.flags.V = r.P & FLAG_V;
+        s.flags.N = r.P & FLAG_N;
+        s.cycles = 0;
+        s.return_on_ppu = 0; s.skip_next_op = 0;
+        s.irq_lines = 0; s.nmi_pending = 0;
+        cpu.restore_state(s);
+    };
+    ref_regs                    get_regs() {
+        cpu6502::cpu6502regs regs = cpu.get_cpu_regs();
+        ref_regs r = {regs.PC, regs.A, regs.X, regs.Y, regs.S, flags_to_byte(cpu.get_cpu_flags(), 0)};
+        return r;
+    };
+
+private:
+    FullRamMemory               mem;
+    cpu6502T<FullRamMemory>     cpu;
+    access_list                 accesses;
+};
+
+// ==================== FUZZER
+
+static Reference6502 ref;
+static CpuUnderTest *tested;
+
+static bool same(const outcome &a, const outcome &b) {
+    return a.r.PC == b.r.PC && a.r.A == b.r.A && a.r.X == b.r.X && a.r.Y == b.r.Y && a.r.S == b.r.S
+           && a.r.P == b.r.P && a.cycles == b.cycles && a.accesses == b.accesses;
+}
+
+/* Runs the instruction at r.PC from r and m on both, true when they differ.
+reads : the addresses the reference read */
+static bool differs(const ref_regs &r, const UINT8 *m, outcome &cpu_out, outcome &ref_out, std::vector<MEMADDR> *reads) {
+    tested->load(r, m);
+    tested->step(cpu_out);
+    ref.load(r, m);
+    ref.step(ref_out);
+    if(reads) *reads = ref.reads;
+    return !same(cpu_out, ref_out);
+}
+
+// the memory of the simplified states is 0 except at the bytes read
+static void minimize(ref_regs &r, std::vector<UINT8> &m) {
+    outcome cpu_out, ref_out;
+    std::vector<MEMADDR> reads;
+    differs(r, m.data(), cpu_out, ref_out, &reads);
+    std::vector<UINT8> sparse(ADDR_SPACE_SIZE, 0);
+    for(MEMADDR a : reads) sparse[a] = m[a];
+    if(differs(r, sparse.data(), cpu_out, ref_out, nullptr)) m = sparse;
+
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        // registers to 0, flags cleared
+        UINT8 *fields[] = {&r.A, &r.X, &r.Y};
+        for(UINT8 *f : fields) {
+            if(!*f) continue;
+            UINT8 old = *f;
+            *f = 0;
+            if(differs(r, m.data(), cpu_out, ref_out, nullptr)) changed = true;
+            else *f = old;
+        }
+        for(UINT8 flag : {FLAG_C, FLAG_Z, FLAG_I, FLAG_D, FLAG_V, FLAG_N}) {
+            if(!(r.P & flag)) continue;
+            r.P &= ~flag;
+            if(differs(r, m.data(), cpu_out, ref_out, nullptr)) changed = true;
+            else r.P |= flag;
+        }
+        if(r.S != 0xFD) {
+            UINT8 old = r.S;
+            r.S = 0xFD;
+            if(differs(r, m.data(), cpu_out, ref_out, nullptr)) changed = true;
+            else r.S = old;
+        }
+        // the bytes read, but the opcode
+        differs(r, m.data(), cpu_out, ref_out, &reads);
+        for(MEMADDR a : reads) {
+            if(a == r.PC || !m[a]) continue;
+            UINT8 old = m[a];
+            m[a] = 0;
+            if(differs(r, m.data(), cpu_out, ref_out, nullptr)) changed = true;
+            else m[a] = old;
+        }
+    }
+}
+
+static void print_instruction(const ref_regs &r, const std::vector<UINT8> &m) {
+    const ref_opcode &o = ref_ops[m[r.PC]];
+    int len = ref_length(o.mode);
+    std::printf("  %04X ", r.PC);
+    for(int i = 0; i < 3; i++) {
+        if(i < len) std::printf(" %02X", m[(MEMADDR)(r.PC + i)]);
+        else std::printf("   ");
+    }
+    std::printf("  %s %s\n", o.name, ref_mode_names[o.mode]);
+}
+
+static void print_outcome(const char *who, const outcome &o) {
+    std::printf("  %-9s : PC:%04X A:%02X X:%02X Y:%02X P:%02X SP:%02X CYC:%u", who, o.r.PC, o.r.A, o.r.X, o.r.Y, o.r.P, o.r.S, o.cycles);
+#ifdef GAYA_CYCLE_EXACT
+    if(!o.accesses.empty()) std::printf(" accesses:");
+    for(auto &a : o.accesses) std::printf(" %u:%s$%04X=%02X", a.cycle, (a.write)? "W" : "R", a.addr, a.val);
+#else
+    if(!o.accesses.empty()) std::printf(" writes:");
+    for(auto &a : o.accesses) std::printf(" $%04X=%02X", a.addr, a.val);
+#endif
+    std::printf("\n");
+}
+
+static void report(unsigned int case_nr, unsigned int step, ref_regs r, std::vector<UINT8> m) {
+    minimize(r, m);
+    outcome cpu_out, ref_out;
+    std::vector<MEMADDR> reads;
+    differs(r, m.data(), cpu_out, ref_out, &reads);
+
+    std::printf("Difference in case %u, instruction %u, reduced to :\n", case_nr, step);
+    print_instruction(r, m);
+    std::printf("  from      : A:%02X X:%02X Y:%02X P:%02X SP:%02X\n", r.A, r.X, r.Y, r.P, r.S);
+    std::printf("  reading   :");
+    std::set<MEMADDR> seen;
+    for(MEMADDR a : reads) if(seen.insert(a).second) std::printf(" $%04X=%02X", a, m[a]);
+    std::printf("\n");
+    print_outcome("cpu6502", cpu_out);
+    print_outcome("reference", ref_out);
+    std::printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int nr_cases = 20000, length = 32;
+    unsigned int seed = 1;
+    int option;
+    while((option = getopt(argc, argv, "n:l:s:h")) != -1) {
+        switch (option)
+        {
+        case 'n': nr_cases = std::strtoul(optarg, nullptr, 10); break;
+        case 'l': length = std::strtoul(optarg, nullptr, 10); break;
+        case 's': seed = std::strtoul(optarg, nullptr, 10); break;
+        default:
+            std::printf("usage : %s [-n cases] [-l instructions per case] [-s seed]\n", argv[0]);
+            return 2;
+        }
+    }
+    init_ref_ops();
+    std::vector<UINT8> tested_ops;
+    for(int op = 0; op < 256; op++) if(ref_ops[op].tested) tested_ops.push_back(op);
+    tested = new CpuUnderTest();
+
+    std::mt19937 rng(seed);
+    std::vector<UINT8> m(ADDR_SPACE_SIZE);
+    // opcodes already reported
+    std::set<UINT8> reported;
+    unsigned long long nr_instructions = 0;
+    for(unsigned int c = 0; c < nr_cases; c++) {
+        for(unsigned int i = 0; i < ADDR_SPACE_SIZE; i += 4) {
+            UINT32 bytes = rng();
+            std::memcpy(&m[i], &bytes, 4);
+        }
+        ref_regs r = {(UINT16)rng(), (UINT8)rng(), (UINT8)rng(), (UINT8)rng(), (UINT8)rng(), 0};
+        r.P = ((UINT8)rng() & ~FLAG_B) | FLAG_U;
+        // the instructions, one after the other
+        MEMADDR a = r.PC;
+        for(unsigned int i = 0; i < length; i++) {
+            UINT8 op = tested_ops[rng() % tested_ops.size()];
+            m[a++] = op;
+            for(int j = 1; j < ref_length(ref_ops[op].mode); j++) m[a++] = rng();
+        }
+
+        tested->load(r, m.data());
+        ref.load(r, m.data());
+        for(unsigned int i = 0; i < length && ref_ops[ref.mem[ref.r.PC]].tested; i++) {
+            outcome cpu_out, ref_out;
+            nr_instructions++;
+            tested->step(cpu_out);
+            ref.step(ref_out);
+            if(same(cpu_out, ref_out)) continue;
+            // the state before the instruction, from the start again
+            ref.load(r, m.data());
+            for(unsigned int j = 0; j < i; j++) ref.step();
+            std::vector<UINT8> before(ref.mem, ref.mem + ADDR_SPACE_SIZE);
+            if(reported.insert(before[ref.r.PC]).second) report(c, i, ref.r, before);
+            break;
+        }
+    }
+    std::printf("%u cases, %llu instructions, %u opcodes with differences\n", nr_cases, nr_instructions, (unsigned int)reported.size());
+    return (reported.empty())? 0 : 1;
+}
@@ -0,0 +1,327 @@
+#include <cstring>
+#include "cpu_opcodes.hpp"
+
+const cpu_opcode_info cpu_opcodes[256] = {
+    /* 00 */ {"BRK", ADDR_MODE::IMPLIED, 7, 0, 1, MNEMONIC::BRK, 0},
+    /* 01 */ {"ORA", ADDR_MODE::X_INDIRECT, 6, 0, 1, MNEMONIC::ORA, OPCODE_REGS_ONLY},
+    /* 02 */ {"KIL", ADDR_MODE::IMPLIED, 1, 0, 0, MNEMONIC::KIL, 0},
+    /* 03 */ {"SLO", ADDR_MODE::X_INDIRECT, 8, 0, 0, MNEMONIC::SLO, 0},
+    /* 04 */ {"NOP", ADDR_MODE::ZERO_PAGE, 3, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 05 */ {"ORA", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::ORA, OPCODE_REGS_ONLY},
+    /* 06 */ {"ASL", ADDR_MODE::ZERO_PAGE, 5, 0, 1, MNEMONIC::ASL, 0},
+    /* 07 */ {"SLO", ADDR_MODE::ZERO_PAGE, 5, 0, 0, MNEMONIC::SLO, 0},
+    /* 08 */ {"PHP", ADDR_MODE::IMPLIED, 3, 0, 1, MNEMONIC::PHP, 0},
+    /* 09 */ {"ORA", ADDR_MODE::IMMEDIATE, 2, 0, 1, MNEMONIC::ORA, OPCODE_REGS_ONLY},
+    /* 0A */ {"ASL", ADDR_MODE::ACCUMULATOR, 2, 0, 1, MNEMONIC::ASL, OPCODE_REGS_ONLY},
+    /* 0B */ {"ANC", ADDR_MODE::IMMEDIATE, 2, 0, 0, MNEMONIC::ANC, OPCODE_REGS_ONLY},
+    /* 0C */ {"NOP", ADDR_MODE::ABSOLUTE, 4, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 0D */ {"ORA", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::ORA, OPCODE_REGS_ONLY},
+    /* 0E */ {"ASL", ADDR_MODE::ABSOLUTE, 6, 0, 1, MNEMONIC::ASL, 0},
+    /* 0F */ {"SLO", ADDR_MODE::ABSOLUTE, 6, 0, 0, MNEMONIC::SLO, 0},
+    /* 10 */ {"BPL", ADDR_MODE::RELATIVE, 2, 0, 1, MNEMONIC::BPL, 0},
+    /* 11 */ {"ORA", ADDR_MODE::INDIRECT_Y, 5, 1, 1, MNEMONIC::ORA, OPCODE_REGS_ONLY},
+    /* 12 */ {"KIL", ADDR_MODE::IMPLIED, 1, 0, 0, MNEMONIC::KIL, 0},
+    /* 13 */ {"SLO", ADDR_MODE::INDIRECT_Y, 8, 0, 0, MNEMONIC::SLO, 0},
+    /* 14 */ {"NOP", ADDR_MODE::ZERO_PAGE_X, 4, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 15 */ {"ORA", ADDR_MODE::ZERO_PAGE_X, 4, 0, 1, MNEMONIC::ORA, OPCODE_REGS_ONLY},
+    /* 16 */ {"ASL", ADDR_MODE::ZERO_PAGE_X, 6, 0, 1, MNEMONIC::ASL, 0},
+    /* 17 */ {"SLO", ADDR_MODE::ZERO_PAGE_X, 6, 0, 0, MNEMONIC::SLO, 0},
+    /* 18 */ {"CLC", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::CLC, OPCODE_REGS_ONLY},
+    /* 19 */ {"ORA", ADDR_MODE::ABSOLUTE_Y, 4, 1, 1, MNEMONIC::ORA, OPCODE_REGS_ONLY},
+    /* 1A */ {"NOP", ADDR_MODE::IMPLIED, 2, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 1B */ {"SLO", ADDR_MODE::ABSOLUTE_Y, 7, 0, 0, MNEMONIC::SLO, 0},
+    /* 1C */ {"NOP", ADDR_MODE::ABSOLUTE_X, 4, 1, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 1D */ {"ORA", ADDR_MODE::ABSOLUTE_X, 4, 1, 1, MNEMONIC::ORA, OPCODE_REGS_ONLY},
+    /* 1E */ {"ASL", ADDR_MODE::ABSOLUTE_X, 7, 0, 1, MNEMONIC::ASL, 0},
+    /* 1F */ {"SLO", ADDR_MODE::ABSOLUTE_X, 7, 0, 0, MNEMONIC::SLO, 0},
+    /* 20 */ {"JSR", ADDR_MODE::ABSOLUTE, 6, 0, 1, MNEMONIC::JSR, 0},
+    /* 21 */ {"AND", ADDR_MODE::X_INDIRECT, 6, 0, 1, MNEMONIC::AND, OPCODE_REGS_ONLY},
+    /* 22 */ {"KIL", ADDR_MODE::IMPLIED, 1, 0, 0, MNEMONIC::KIL, 0},
+    /* 23 */ {"RLA", ADDR_MODE::X_INDIRECT, 8, 0, 0, MNEMONIC::RLA, 0},
+    /* 24 */ {"BIT", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::BIT, OPCODE_REGS_ONLY},
+    /* 25 */ {"AND", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::AND, OPCODE_REGS_ONLY},
+    /* 26 */ {"ROL", ADDR_MODE::ZERO_PAGE, 5, 0, 1, MNEMONIC::ROL, 0},
+    /* 27 */ {"RLA", ADDR_MODE::ZERO_PAGE, 5, 0, 0, MNEMONIC::RLA, 0},
+    /* 28 */ {"PLP", ADDR_MODE::IMPLIED, 4, 0, 1, MNEMONIC::PLP, 0},
+    /* 29 */ {"AND", ADDR_MODE::IMMEDIATE, 2, 0, 1, MNEMONIC::AND, OPCODE_REGS_ONLY},
+    /* 2A */ {"ROL", ADDR_MODE::ACCUMULATOR, 2, 0, 1, MNEMONIC::ROL, OPCODE_REGS_ONLY},
+    /* 2B */ {"ANC", ADDR_MODE::IMMEDIATE, 2, 0, 0, MNEMONIC::ANC, OPCODE_REGS_ONLY},
+    /* 2C */ {"BIT", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::BIT, OPCODE_REGS_ONLY},
+    /* 2D */ {"AND", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::AND, OPCODE_REGS_ONLY},
+    /* 2E */ {"ROL", ADDR_MODE::ABSOLUTE, 6, 0, 1, MNEMONIC::ROL, 0},
+    /* 2F */ {"RLA", ADDR_MODE::ABSOLUTE, 6, 0, 0, MNEMONIC::RLA, 0},
+    /* 30 */ {"BMI", ADDR_MODE::RELATIVE, 2, 0, 1, MNEMONIC::BMI, 0},
+    /* 31 */ {"AND", ADDR_MODE::INDIRECT_Y, 5, 1, 1, MNEMONIC::AND, OPCODE_REGS_ONLY},
+    /* 32 */ {"KIL", ADDR_MODE::IMPLIED, 1, 0, 0, MNEMONIC::KIL, 0},
+    /* 33 */ {"RLA", ADDR_MODE::INDIRECT_Y, 8, 0, 0, MNEMONIC::RLA, 0},
+    /* 34 */ {"NOP", ADDR_MODE::ZERO_PAGE_X, 4, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 35 */ {"AND", ADDR_MODE::ZERO_PAGE_X, 4, 0, 1, MNEMONIC::AND, OPCODE_REGS_ONLY},
+    /* 36 */ {"ROL", ADDR_MODE::ZERO_PAGE_X, 6, 0, 1, MNEMONIC::ROL, 0},
+    /* 37 */ {"RLA", ADDR_MODE::ZERO_PAGE_X, 6, 0, 0, MNEMONIC::RLA, 0},
+    /* 38 */ {"SEC", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::SEC, OPCODE_REGS_ONLY},
+    /* 39 */ {"AND", ADDR_MODE::ABSOLUTE_Y, 4, 1, 1, MNEMONIC::AND, OPCODE_REGS_ONLY},
+    /* 3A */ {"NOP", ADDR_MODE::IMPLIED, 2, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 3B */ {"RLA", ADDR_MODE::ABSOLUTE_Y, 7, 0, 0, MNEMONIC::RLA, 0},
+    /* 3C */ {"NOP", ADDR_MODE::ABSOLUTE_X, 4, 1, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 3D */ {"AND", ADDR_MODE::ABSOLUTE_X, 4, 1, 1, MNEMONIC::AND, OPCODE_REGS_ONLY},
+    /* 3E */ {"ROL", ADDR_MODE::ABSOLUTE_X, 7, 0, 1, MNEMONIC::ROL, 0},
+    /* 3F */ {"RLA", ADDR_MODE::ABSOLUTE_X, 7, 0, 0, MNEMONIC::RLA, 0},
+    /* 40 */ {"RTI", ADDR_MODE::IMPLIED, 6, 0, 1, MNEMONIC::RTI, 0},
+    /* 41 */ {"EOR", ADDR_MODE::X_INDIRECT, 6, 0, 1, MNEMONIC::EOR, OPCODE_REGS_ONLY},
+    /* 42 */ {"KIL", ADDR_MODE::IMPLIED, 1, 0, 0, MNEMONIC::KIL, 0},
+    /* 43 */ {"SRE", ADDR_MODE::X_INDIRECT, 8, 0, 0, MNEMONIC::SRE, 0},
+    /* 44 */ {"NOP", ADDR_MODE::ZERO_PAGE, 3, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 45 */ {"EOR", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::EOR, OPCODE_REGS_ONLY},
+    /* 46 */ {"LSR", ADDR_MODE::ZERO_PAGE, 5, 0, 1, MNEMONIC::LSR, 0},
+    /* 47 */ {"SRE", ADDR_MODE::ZERO_PAGE, 5, 0, 0, MNEMONIC::SRE, 0},
+    /* 48 */ {"PHA", ADDR_MODE::IMPLIED, 3, 0, 1, MNEMONIC::PHA, 0},
+    /* 49 */ {"EOR", ADDR_MODE::IMMEDIATE, 2, 0, 1, MNEMONIC::EOR, OPCODE_REGS_ONLY},
+    /* 4A */ {"LSR", ADDR_MODE::ACCUMULATOR, 2, 0, 1, MNEMONIC::LSR, OPCODE_REGS_ONLY},
+    /* 4B */ {"ALR", ADDR_MODE::IMMEDIATE, 2, 0, 0, MNEMONIC::ALR, OPCODE_REGS_ONLY},
+    /* 4C */ {"JMP", ADDR_MODE::ABSOLUTE, 3, 0, 1, MNEMONIC::JMP, 0},
+    /* 4D */ {"EOR", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::EOR, OPCODE_REGS_ONLY},
+    /* 4E */ {"LSR", ADDR_MODE::ABSOLUTE, 6, 0, 1, MNEMONIC::LSR, 0},
+    /* 4F */ {"SRE", ADDR_MODE::ABSOLUTE, 6, 0, 0, MNEMONIC::SRE, 0},
+    /* 50 */ {"BVC", ADDR_MODE::RELATIVE, 2, 0, 1, MNEMONIC::BVC, 0},
+    /* 51 */ {"EOR", ADDR_MODE::INDIRECT_Y, 5, 1, 1, MNEMONIC::EOR, OPCODE_REGS_ONLY},
+    /* 52 */ {"KIL", ADDR_MODE::IMPLIED, 1, 0, 0, MNEMONIC::KIL, 0},
+    /* 53 */ {"SRE", ADDR_MODE::INDIRECT_Y, 8, 0, 0, MNEMONIC::SRE, 0},
+    /* 54 */ {"NOP", ADDR_MODE::ZERO_PAGE_X, 4, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 55 */ {"EOR", ADDR_MODE::ZERO_PAGE_X, 4, 0, 1, MNEMONIC::EOR, OPCODE_REGS_ONLY},
+    /* 56 */ {"LSR", ADDR_MODE::ZERO_PAGE_X, 6, 0, 1, MNEMONIC::LSR, 0},
+    /* 57 */ {"SRE", ADDR_MODE::ZERO_PAGE_X, 6, 0, 0, MNEMONIC::SRE, 0},
+    /* 58 */ {"CLI", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::CLI, 0},
+    /* 59 */ {"EOR", ADDR_MODE::ABSOLUTE_Y, 4, 1, 1, MNEMONIC::EOR, OPCODE_REGS_ONLY},
+    /* 5A */ {"NOP", ADDR_MODE::IMPLIED, 2, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 5B */ {"SRE", ADDR_MODE::ABSOLUTE_Y, 7, 0, 0, MNEMONIC::SRE, 0},
+    /* 5C */ {"NOP", ADDR_MODE::ABSOLUTE_X, 4, 1, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 5D */ {"EOR", ADDR_MODE::ABSOLUTE_X, 4, 1, 1, MNEMONIC::EOR, OPCODE_REGS_ONLY},
+    /* 5E */ {"LSR", ADDR_MODE::ABSOLUTE_X, 7, 0, 1, MNEMONIC::LSR, 0},
+    /* 5F */ {"SRE", ADDR_MODE::ABSOLUTE_X, 7, 0, 0, MNEMONIC::SRE, 0},
+    /* 60 */ {"RTS", ADDR_MODE::IMPLIED, 6, 0, 1, MNEMONIC::RTS, 0},
+    /* 61 */ {"ADC", ADDR_MODE::X_INDIRECT, 6, 0, 1, MNEMONIC::ADC, OPCODE_REGS_ONLY},
+    /* 62 */ {"KIL", ADDR_MODE::IMPLIED, 1, 0, 0, MNEMONIC::KIL, 0},
+    /* 63 */ {"RRA", ADDR_MODE::X_INDIRECT, 8, 0, 0, MNEMONIC::RRA, 0},
+    /* 64 */ {"NOP", ADDR_MODE::ZERO_PAGE, 3, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 65 */ {"ADC", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::ADC, OPCODE_REGS_ONLY},
+    /* 66 */ {"ROR", ADDR_MODE::ZERO_PAGE, 5, 0, 1, MNEMONIC::ROR, 0},
+    /* 67 */ {"RRA", ADDR_MODE::ZERO_PAGE, 5, 0, 0, MNEMONIC::RRA, 0},
+    /* 68 */ {"PLA", ADDR_MODE::IMPLIED, 4, 0, 1, MNEMONIC::PLA, 0},
+    /* 69 */ {"ADC", ADDR_MODE::IMMEDIATE, 2, 0, 1, MNEMONIC::ADC, OPCODE_REGS_ONLY},
+    /* 6A */ {"ROR", ADDR_MODE::ACCUMULATOR, 2, 0, 1, MNEMONIC::ROR, OPCODE_REGS_ONLY},
+    /* 6B */ {"ARR", ADDR_MODE::IMMEDIATE, 2, 0, 0, MNEMONIC::ARR, OPCODE_REGS_ONLY},
+    /* 6C */ {"JMP", ADDR_MODE::INDIRECT, 5, 0, 1, MNEMONIC::JMP, 0},
+    /* 6D */ {"ADC", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::ADC, OPCODE_REGS_ONLY},
+    /* 6E */ {"ROR", ADDR_MODE::ABSOLUTE, 6, 0, 1, MNEMONIC::ROR, 0},
+    /* 6F */ {"RRA", ADDR_MODE::ABSOLUTE, 6, 0, 0, MNEMONIC::RRA, 0},
+    /* 70 */ {"BVS", ADDR_MODE::RELATIVE, 2, 0, 1, MNEMONIC::BVS, 0},
+    /* 71 */ {"ADC", ADDR_MODE::INDIRECT_Y, 5, 1, 1, MNEMONIC::ADC, OPCODE_REGS_ONLY},
+    /* 72 */ {"KIL", ADDR_MODE::IMPLIED, 1, 0, 0, MNEMONIC::KIL, 0},
+    /* 73 */ {"RRA", ADDR_MODE::INDIRECT_Y, 8, 0, 0, MNEMONIC::RRA, 0},
+    /* 74 */ {"NOP", ADDR_MODE::ZERO_PAGE_X, 4, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 75 */ {"ADC", ADDR_MODE::ZERO_PAGE_X, 4, 0, 1, MNEMONIC::ADC, OPCODE_REGS_ONLY},
+    /* 76 */ {"ROR", ADDR_MODE::ZERO_PAGE_X, 6, 0, 1, MNEMONIC::ROR, 0},
+    /* 77 */ {"RRA", ADDR_MODE::ZERO_PAGE_X, 6, 0, 0, MNEMONIC::RRA, 0},
+    /* 78 */ {"SEI", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::SEI, 0},
+    /* 79 */ {"ADC", ADDR_MODE::ABSOLUTE_Y, 4, 1, 1, MNEMONIC::ADC, OPCODE_REGS_ONLY},
+    /* 7A */ {"NOP", ADDR_MODE::IMPLIED, 2, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 7B */ {"RRA", ADDR_MODE::ABSOLUTE_Y, 7, 0, 0, MNEMONIC::RRA, 0},
+    /* 7C */ {"NOP", ADDR_MODE::ABSOLUTE_X, 4, 1, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 7D */ {"ADC", ADDR_MODE::ABSOLUTE_X, 4, 1, 1, MNEMONIC::ADC, OPCODE_REGS_ONLY},
+    /* 7E */ {"ROR", ADDR_MODE::ABSOLUTE_X, 7, 0, 1, MNEMONIC::ROR, 0},
+    /* 7F */ {"RRA", ADDR_MODE::ABSOLUTE_X, 7, 0, 0, MNEMONIC::RRA, 0},
+    /* 80 */ {"NOP", ADDR_MODE::IMMEDIATE, 2, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 81 */ {"STA", ADDR_MODE::X_INDIRECT, 6, 0, 1, MNEMONIC::STA, OPCODE_REG_A},
+    /* 82 */ {"NOP", ADDR_MODE::IMMEDIATE, 2, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 83 */ {"SAX", ADDR_MODE::X_INDIRECT, 6, 0, 0, MNEMONIC::SAX, OPCODE_REG_A | OPCODE_REG_X},
+    /* 84 */ {"STY", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::STY, OPCODE_REG_Y},
+    /* 85 */ {"STA", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::STA, OPCODE_REG_A},
+    /* 86 */ {"STX", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::STX, OPCODE_REG_X},
+    /* 87 */ {"SAX", ADDR_MODE::ZERO_PAGE, 3, 0, 0, MNEMONIC::SAX, OPCODE_REG_A | OPCODE_REG_X},
+    /* 88 */ {"DEY", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::DEY, OPCODE_REGS_ONLY | OPCODE_REG_Y},
+    /* 89 */ {"NOP", ADDR_MODE::IMMEDIATE, 2, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* 8A */ {"TXA", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::TXA, OPCODE_REGS_ONLY},
+    /* 8B */ {"XAA", ADDR_MODE::IMMEDIATE, 2, 0, 0, MNEMONIC::XAA, OPCODE_REGS_ONLY},
+    /* 8C */ {"STY", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::STY, OPCODE_REG_Y},
+    /* 8D */ {"STA", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::STA, OPCODE_REG_A},
+    /* 8E */ {"STX", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::STX, OPCODE_REG_X},
+    /* 8F */ {"SAX", ADDR_MODE::ABSOLUTE, 4, 0, 0, MNEMONIC::SAX, OPCODE_REG_A | OPCODE_REG_X},
+    /* 90 */ {"BCC", ADDR_MODE::RELATIVE, 2, 0, 1, MNEMONIC::BCC, 0},
+    /* 91 */ {"STA", ADDR_MODE::INDIRECT_Y, 6, 0, 1, MNEMONIC::STA, OPCODE_REG_A},
+    /* 92 */ {"KIL", ADDR_MODE::IMPLIED, 1, 0, 0, MNEMONIC::KIL, 0},
+    /* 93 */ {"AHX", ADDR_MODE::INDIRECT_Y, 6, 0, 0, MNEMONIC::AHX, 0},
+    /* 94 */ {"STY", ADDR_MODE::ZERO_PAGE_X, 4, 0, 1, MNEMONIC::STY, OPCODE_REG_Y},
+    /* 95 */ {"STA", ADDR_MODE::ZERO_PAGE_X, 4, 0, 1, MNEMONIC::STA, OPCODE_REG_A},
+    /* 96 */ {"STX", ADDR_MODE::ZERO_PAGE_Y, 4, 0, 1, MNEMONIC::STX, OPCODE_REG_X},
+    /* 97 */ {"SAX", ADDR_MODE::ZERO_PAGE_Y, 4, 0, 0, MNEMONIC::SAX, OPCODE_REG_A | OPCODE_REG_X},
+    /* 98 */ {"TYA", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::TYA, OPCODE_REGS_ONLY},
+    /* 99 */ {"STA", ADDR_MODE::ABSOLUTE_Y, 5, 0, 1, MNEMONIC::STA, OPCODE_REG_A},
+    /* 9A */ {"TXS", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::TXS, 0},
+    /* 9B */ {"TAS", ADDR_MODE::ABSOLUTE_Y, 5, 0, 0, MNEMONIC::TAS, 0},
+    /* 9C */ {"SHY", ADDR_MODE::ABSOLUTE_X, 5, 0, 0, MNEMONIC::SHY, 0},
+    /* 9D */ {"STA", ADDR_MODE::ABSOLUTE_X, 5, 0, 1, MNEMONIC::STA, OPCODE_REG_A},
+    /* 9E */ {"SHX", ADDR_MODE::ABSOLUTE_Y, 5, 0, 0, MNEMONIC::SHX, 0},
+    /* 9F */ {"AHX", ADDR_MODE::ABSOLUTE_Y, 5, 0, 0, MNEMONIC::AHX, 0},
+    /* A0 */ {"LDY", ADDR_MODE::IMMEDIATE, 2, 0, 1, MNEMONIC::LDY, OPCODE_REGS_ONLY | OPCODE_REG_Y},
+    /* A1 */ {"LDA", ADDR_MODE::X_INDIRECT, 6, 0, 1, MNEMONIC::LDA, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* A2 */ {"LDX", ADDR_MODE::IMMEDIATE, 2, 0, 1, MNEMONIC::LDX, OPCODE_REGS_ONLY | OPCODE_REG_X},
+    /* A3 */ {"LAX", ADDR_MODE::X_INDIRECT, 6, 0, 0, MNEMONIC::LAX, OPCODE_REGS_ONLY},
+    /* A4 */ {"LDY", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::LDY, OPCODE_REGS_ONLY | OPCODE_REG_Y},
+    /* A5 */ {"LDA", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::LDA, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* A6 */ {"LDX", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::LDX, OPCODE_REGS_ONLY | OPCODE_REG_X},
+    /* A7 */ {"LAX", ADDR_MODE::ZERO_PAGE, 3, 0, 0, MNEMONIC::LAX, OPCODE_REGS_ONLY},
+    /* A8 */ {"TAY", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::TAY, OPCODE_REGS_ONLY},
+    /* A9 */ {"LDA", ADDR_MODE::IMMEDIATE, 2, 0, 1, MNEMONIC::LDA, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* AA */ {"TAX", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::TAX, OPCODE_REGS_ONLY},
+    /* AB */ {"LAX", ADDR_MODE::IMMEDIATE, 2, 0, 0, MNEMONIC::LAX, OPCODE_REGS_ONLY},
+    /* AC */ {"LDY", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::LDY, OPCODE_REGS_ONLY | OPCODE_REG_Y},
+    /* AD */ {"LDA", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::LDA, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* AE */ {"LDX", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::LDX, OPCODE_REGS_ONLY | OPCODE_REG_X},
+    /* AF */ {"LAX", ADDR_MODE::ABSOLUTE, 4, 0, 0, MNEMONIC::LAX, OPCODE_REGS_ONLY},
+    /* B0 */ {"BCS", ADDR_MODE::RELATIVE, 2, 0, 1, MNEMONIC::BCS, 0},
+    /* B1 */ {"LDA", ADDR_MODE::INDIRECT_Y, 5, 1, 1, MNEMONIC::LDA, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* B2 */ {"KIL", ADDR_MODE::IMPLIED, 1, 0, 0, MNEMONIC::KIL, 0},
+    /* B3 */ {"LAX", ADDR_MODE::INDIRECT_Y, 5, 1, 0, MNEMONIC::LAX, OPCODE_REGS_ONLY},
+    /* B4 */ {"LDY", ADDR_MODE::ZERO_PAGE_X, 4, 0, 1, MNEMONIC::LDY, OPCODE_REGS_ONLY | OPCODE_REG_Y},
+    /* B5 */ {"LDA", ADDR_MODE::ZERO_PAGE_X, 4, 0, 1, MNEMONIC::LDA, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* B6 */ {"LDX", ADDR_MODE::ZERO_PAGE_Y, 4, 0, 1, MNEMONIC::LDX, OPCODE_REGS_ONLY | OPCODE_REG_X},
+    /* B7 */ {"LAX", ADDR_MODE::ZERO_PAGE_Y, 4, 0, 0, MNEMONIC::LAX, OPCODE_REGS_ONLY},
+    /* B8 */ {"CLV", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::CLV, OPCODE_REGS_ONLY},
+    /* B9 */ {"LDA", ADDR_MODE::ABSOLUTE_Y, 4, 1, 1, MNEMONIC::LDA, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* BA */ {"TSX", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::TSX, OPCODE_REGS_ONLY},
+    /* BB */ {"LAS", ADDR_MODE::ABSOLUTE_Y, 4, 1, 0, MNEMONIC::LAS, 0},
+    /* BC */ {"LDY", ADDR_MODE::ABSOLUTE_X, 4, 1, 1, MNEMONIC::LDY, OPCODE_REGS_ONLY | OPCODE_REG_Y},
+    /* BD */ {"LDA", ADDR_MODE::ABSOLUTE_X, 4, 1, 1, MNEMONIC::LDA, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* BE */ {"LDX", ADDR_MODE::ABSOLUTE_Y, 4, 1, 1, MNEMONIC::LDX, OPCODE_REGS_ONLY | OPCODE_REG_X},
+    /* BF */ {"LAX", ADDR_MODE::ABSOLUTE_Y, 4, 1, 0, MNEMONIC::LAX, OPCODE_REGS_ONLY},
+    /* C0 */ {"CPY", ADDR_MODE::IMMEDIATE, 2, 0, 1, MNEMONIC::CPY, OPCODE_REGS_ONLY | OPCODE_REG_Y},
+    /* C1 */ {"CMP", ADDR_MODE::X_INDIRECT, 6, 0, 1, MNEMONIC::CMP, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* C2 */ {"NOP", ADDR_MODE::IMMEDIATE, 2, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* C3 */ {"DCP", ADDR_MODE::X_INDIRECT, 8, 0, 0, MNEMONIC::DCP, 0},
+    /* C4 */ {"CPY", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::CPY, OPCODE_REGS_ONLY | OPCODE_REG_Y},
+    /* C5 */ {"CMP", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::CMP, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* C6 */ {"DEC", ADDR_MODE::ZERO_PAGE, 5, 0, 1, MNEMONIC::DEC, 0},
+    /* C7 */ {"DCP", ADDR_MODE::ZERO_PAGE, 5, 0, 0, MNEMONIC::DCP, 0},
+    /* C8 */ {"INY", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::INY, OPCODE_REGS_ONLY | OPCODE_REG_Y},
+    /* C9 */ {"CMP", ADDR_MODE::IMMEDIATE, 2, 0, 1, MNEMONIC::CMP, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* CA */ {"DEX", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::DEX, OPCODE_REGS_ONLY | OPCODE_REG_X},
+    /* CB */ {"AXS", ADDR_MODE::IMMEDIATE, 2, 0, 0, MNEMONIC::AXS, OPCODE_REGS_ONLY},
+    /* CC */ {"CPY", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::CPY, OPCODE_REGS_ONLY | OPCODE_REG_Y},
+    /* CD */ {"CMP", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::CMP, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* CE */ {"DEC", ADDR_MODE::ABSOLUTE, 6, 0, 1, MNEMONIC::DEC, 0},
+    /* CF */ {"DCP", ADDR_MODE::ABSOLUTE, 6, 0, 0, MNEMONIC::DCP, 0},
+    /* D0 */ {"BNE", ADDR_MODE::RELATIVE, 2, 0, 1, MNEMONIC::BNE, 0},
+    /* D1 */ {"CMP", ADDR_MODE::INDIRECT_Y, 5, 1, 1, MNEMONIC::CMP, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* D2 */ {"KIL", ADDR_MODE::IMPLIED, 1, 0, 0, MNEMONIC::KIL, 0},
+    /* D3 */ {"DCP", ADDR_MODE::INDIRECT_Y, 8, 0, 0, MNEMONIC::DCP, 0},
+    /* D4 */ {"NOP", ADDR_MODE::ZERO_PAGE_X, 4, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* D5 */ {"CMP", ADDR_MODE::ZERO_PAGE_X, 4, 0, 1, MNEMONIC::CMP, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* D6 */ {"DEC", ADDR_MODE::ZERO_PAGE_X, 6, 0, 1, MNEMONIC::DEC, 0},
+    /* D7 */ {"DCP", ADDR_MODE::ZERO_PAGE_X, 6, 0, 0, MNEMONIC::DCP, 0},
+    /* D8 */ {"CLD", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::CLD, 0},
+    /* D9 */ {"CMP", ADDR_MODE::ABSOLUTE_Y, 4, 1, 1, MNEMONIC::CMP, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* DA */ {"NOP", ADDR_MODE::IMPLIED, 2, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* DB */ {"DCP", ADDR_MODE::ABSOLUTE_Y, 7, 0, 0, MNEMONIC::DCP, 0},
+    /* DC */ {"NOP", ADDR_MODE::ABSOLUTE_X, 4, 1, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* DD */ {"CMP", ADDR_MODE::ABSOLUTE_X, 4, 1, 1, MNEMONIC::CMP, OPCODE_REGS_ONLY | OPCODE_REG_A},
+    /* DE */ {"DEC", ADDR_MODE::ABSOLUTE_X, 7, 0, 1, MNEMONIC::DEC, 0},
+    /* DF */ {"DCP", ADDR_MODE::ABSOLUTE_X, 7, 0, 0, MNEMONIC::DCP, 0},
+    /* E0 */ {"CPX", ADDR_MODE::IMMEDIATE, 2, 0, 1, MNEMONIC::CPX, OPCODE_REGS_ONLY | OPCODE_REG_X},
+    /* E1 */ {"SBC", ADDR_MODE::X_INDIRECT, 6, 0, 1, MNEMONIC::SBC, OPCODE_REGS_ONLY},
+    /* E2 */ {"NOP", ADDR_MODE::IMMEDIATE, 2, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* E3 */ {"ISB", ADDR_MODE::X_INDIRECT, 8, 0, 0, MNEMONIC::ISB, 0},
+    /* E4 */ {"CPX", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::CPX, OPCODE_REGS_ONLY | OPCODE_REG_X},
+    /* E5 */ {"SBC", ADDR_MODE::ZERO_PAGE, 3, 0, 1, MNEMONIC::SBC, OPCODE_REGS_ONLY},
+    /* E6 */ {"INC", ADDR_MODE::ZERO_PAGE, 5, 0, 1, MNEMONIC::INC, 0},
+    /* E7 */ {"ISB", ADDR_MODE::ZERO_PAGE, 5, 0, 0, MNEMONIC::ISB, 0},
+    /* E8 */ {"INX", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::INX, OPCODE_REGS_ONLY | OPCODE_REG_X},
+    /* E9 */ {"SBC", ADDR_MODE::IMMEDIATE, 2, 0, 1, MNEMONIC::SBC, OPCODE_REGS_ONLY},
+    /* EA */ {"NOP", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* EB */ {"SBC", ADDR_MODE::IMMEDIATE, 2, 0, 0, MNEMONIC::SBC, OPCODE_REGS_ONLY},
+    /* EC */ {"CPX", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::CPX, OPCODE_REGS_ONLY | OPCODE_REG_X},
+    /* ED */ {"SBC", ADDR_MODE::ABSOLUTE, 4, 0, 1, MNEMONIC::SBC, OPCODE_REGS_ONLY},
+    /* EE */ {"INC", ADDR_MODE::ABSOLUTE, 6, 0, 1, MNEMONIC::INC, 0},
+    /* EF */ {"ISB", ADDR_MODE::ABSOLUTE, 6, 0, 0, MNEMONIC::ISB, 0},
+    /* F0 */ {"BEQ", ADDR_MODE::RELATIVE, 2, 0, 1, MNEMONIC::BEQ, 0},
+    /* F1 */ {"SBC", ADDR_MODE::INDIRECT_Y, 5, 1, 1, MNEMONIC::SBC, OPCODE_REGS_ONLY},
+    /* F2 */ {"KIL", ADDR_MODE::IMPLIED, 1, 0, 0, MNEMONIC::KIL, 0},
+    /* F3 */ {"ISB", ADDR_MODE::INDIRECT_Y, 8, 0, 0, MNEMONIC::ISB, 0},
+    /* F4 */ {"NOP", ADDR_MODE::ZERO_PAGE_X, 4, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* F5 */ {"SBC", ADDR_MODE::ZERO_PAGE_X, 4, 0, 1, MNEMONIC::SBC, OPCODE_REGS_ONLY},
+    /* F6 */ {"INC", ADDR_MODE::ZERO_PAGE_X, 6, 0, 1, MNEMONIC::INC, 0},
+    /* F7 */ {"ISB", ADDR_MODE::ZERO_PAGE_X, 6, 0, 0, MNEMONIC::ISB, 0},
+    /* F8 */ {"SED", ADDR_MODE::IMPLIED, 2, 0, 1, MNEMONIC::SED, 0},
+    /* F9 */ {"SBC", ADDR_MODE::ABSOLUTE_Y, 4, 1, 1, MNEMONIC::SBC, OPCODE_REGS_ONLY},
+    /* FA */ {"NOP", ADDR_MODE::IMPLIED, 2, 0, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* FB */ {"ISB", ADDR_MODE::ABSOLUTE_Y, 7, 0, 0, MNEMONIC::ISB, 0},
+    /* FC */ {"NOP", ADDR_MODE::ABSOLUTE_X, 4, 1, 0, MNEMONIC::NOP, OPCODE_REGS_ONLY},
+    /* FD */ {"SBC", ADDR_MODE::ABSOLUTE_X, 4, 1, 1, MNEMONIC::SBC, OPCODE_REGS_ONLY},
+    /* FE */ {"INC", ADDR_MODE::ABSOLUTE_X, 7, 0, 1, MNEMONIC::INC, 0},
+    /* FF */ {"ISB", ADDR_MODE::ABSOLUTE_X, 7, 0, 0, MNEMONIC::ISB, 0},
+};
+
+UINT8 addr_mode_length(ADDR_MODE mode) {
+    switch (mode)
+    {
+    case ADDR_MODE::IMPLIED:
+    case ADDR_MODE::ACCUMULATOR:
+        return 1;
+    case ADDR_MODE::ABSOLUTE:
+    case ADDR_MODE::ABSOLUTE_X:
+    case ADDR_MODE::ABSOLUTE_Y:
+    case ADDR_MODE::INDIRECT:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+namespace {
+// from the names
+struct opcode_accesses {
+    UINT8   access[256];
+
+    opcode_accesses() {
+        static const char *reads[] = {"LDA", "LDX", "LDY", "LAX", "LAS", "CMP", "CPX", "CPY", "BIT", "AND", "ORA", "EOR",
+                                      "ADC", "SBC"};
+        static const char *writes[] = {"STA", "STX", "STY", "SAX", "AHX", "SHX", "SHY", "TAS"};
+        static const char *rmw[] = {"ASL", "LSR", "ROL", "ROR", "INC", "DEC", "SLO", "RLA", "SRE", "RRA", "DCP", "ISB"};
+        for(int op = 0; op < 256; op++) {
+            const cpu_opcode_info &info = cpu_opcodes[op];
+            access[op] = 0;
+            if(info.mode == ADDR_MODE::IMPLIED || info.mode == ADDR_MODE::ACCUMULATOR || info.mode == ADDR_MODE::IMMEDIATE
+               || info.mode == ADDR_MODE::RELATIVE || info.mode == ADDR_MODE::INDIRECT) continue;
+            for(const char *n : reads) if(!std::strcmp(info.name, n)) access[op] = OPCODE_READS;
+            for(const char *n : writes) if(!std::strcmp(info.name, n)) access[op] = OPCODE_WRITES;
+            for(const char *n : rmw) if(!std::strcmp(info.name, n)) access[op] = OPCODE_READS | OPCODE_WRITES;
+        }
+    };
+};
+}
+
+UINT8 opcode_data_access(UINT8 op) {
+    static const opcode_accesses table;
+    return table.access[op];
+}
+
+bool operand_address(ADDR_MODE mode, UINT16 operand, UINT8 X, UINT8 Y, const UINT8 *zero_page, MEMADDR &addr) {
+    switch (mode)
+    {
+    case ADDR_MODE::ZERO_PAGE:   addr = operand & 0xFF; return true;
+    case ADDR_MODE::ZERO_PAGE_X: addr = (operand + X) & 0xFF; return true;
+    case ADDR_MODE::ZERO_PAGE_Y: addr = (operand + Y) & 0xFF; return true;
+    case ADDR_MODE::ABSOLUTE:    addr = operand; return true;
+    case ADDR_MODE::ABSOLUTE_X:  addr = operand + X; return true;
+    case ADDR_MODE::ABSOLUTE_Y:  addr = operand + Y; return true;
+    case ADDR_MODE::X_INDIRECT: {
+        UINT8 ptr = operand + X;
+        addr = zero_page[ptr] | (zero_page[(UINT8)(ptr + 1)] << 8);
+        return true;
+    }
+    case ADDR_MODE::INDIRECT_Y:
+        addr = (zero_page[operand & 0xFF] | (zero_page[(UINT8)(operand + 1)] << 8)) + Y;
+        return true;
+    default:
+        return false;
+    }
+}
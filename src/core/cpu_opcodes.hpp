@@ -0,0 +1,56 @@
+#ifndef GAYA_CPU_OPCODES_HPP
+#define GAYA_CPU_OPCODES_HPP
+
+#include "types.hpp"
+
+enum class ADDR_MODE : UINT8 {
+    IMPLIED, ACCUMULATOR, IMMEDIATE, ZERO_PAGE, ZERO_PAGE_X, ZERO_PAGE_Y, ABSOLUTE,
+    ABSOLUTE_X, ABSOLUTE_Y, INDIRECT, X_INDIRECT, INDIRECT_Y, RELATIVE
+};
+
+enum class MNEMONIC : UINT8 {
+    ADC, AHX, ALR, ANC, AND, ARR, ASL, AXS, BCC, BCS, BEQ, BIT, BMI, BNE, BPL, BRK,
+    BVC, BVS, CLC, CLD, CLI, CLV, CMP, CPX, CPY, DCP, DEC, DEX, DEY, EOR, INC, INX,
+    INY, ISB, JMP, JSR, KIL, LAS, LAX, LDA, LDX, LDY, LSR, NOP, ORA, PHA, PHP, PLA,
+    PLP, RLA, ROL, ROR, RRA, RTI, RTS, SAX, SBC, SEC, SED, SEI, SHX, SHY, SLO, SRE,
+    STA, STX, STY, TAS, TAX, TAY, TSX, TXA, TXS, TYA, XAA
+};
+
+// reads the memory or nothing, and only changes A, X, Y and C, Z, V, N (no stack, no jump)
+#define OPCODE_REGS_ONLY        0x01
+/* the register loaded, stored, compared or counted (A & X for SAX). Not set for the
+ones which always work on A (ORA, ADC...) and the transfers */
+#define OPCODE_REG_A            0x02
+#define OPCODE_REG_X            0x04
+#define OPCODE_REG_Y            0x08
+
+/*
+What the CPU tools (dynarec, traces...) need to know about an opcode without running
+its handler. Cycles are the ones the handlers of cpu.cpp return : for branches it is
+the not taken case (taken : 3, +1 when crossing a page).
+*/
+struct cpu_opcode_info {
+    const char  *name;
+    ADDR_MODE   mode;
+    UINT8       cycles;
+    BOOL        page_cycle; // +1 when the indexed address is in another page
+    BOOL        official;
+    MNEMONIC    mnemonic;
+    UINT8       flags; // OPCODE_REGS_ONLY, OPCODE_REG_*
+};
+
+extern const cpu_opcode_info cpu_opcodes[256];
+
+// bytes of the instruction, opcode included
+UINT8 addr_mode_length(ADDR_MODE mode);
+
+#define OPCODE_READS            0x01
+#define OPCODE_WRITES           0x02
+/* How the instruction accesses the memory at its operand address (read-modify-write
+ones do both). The stack, the dummy reads and the JMP pointers are not counted */
+UINT8 opcode_data_access(UINT8 op);
+/* The address the instruction accesses, as the handlers compute it, zero_page is
+read for the pointers of the indirect modes. false when the mode has none */
+bool operand_address(ADDR_MODE mode, UINT16 operand, UINT8 X, UINT8 Y, const UINT8 *zero_page, MEMADDR &addr);
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef GAYA_CPU_TEST_MEMORY_HPP
+#define GAYA_CPU_TEST_MEMORY_HPP
+
+#include <vector>
+#include "cpu.hpp"
+
+#ifndef GAYA_CPU_TESTS
+#error "the CPU tests are compiled with -DGAYA_CPU_TESTS"
+#endif
+
+/*
+64kb of RAM and nothing else, to run the CPU alone (cpu_debug.cpp, cpu_fuzz.cpp).
+The reads and writes are appended to accesses when it is not nullptr, with the
+cycle of the CPU (cpu). Instructions are fetched directly from $0000-$7FFF, and
+through read(), so both ways are used.
+Only for the CPU tests : cpu.cpp instantiates cpu6502T<FullRamMemory> when
+GAYA_CPU_TESTS is defined, which the programs including this have to be compiled with
+*/
+class FullRamMemory final : public CPUMemoryManager
+{
+public:
+    FullRamMemory() : accesses(nullptr) {
+        memROM = nullptr;
+        ppu_mem = nullptr;
+        cpu = nullptr;
+        for(int i=0; i<ADDR_SPACE_SIZE; i++) mem[i] = 0;
+    };
+    struct access {
+        UINT32      cycle; // get_cycles() of the CPU during the access
+        MEMADDR     addr;
+        UINT8       val;
+        BOOL        write;
+        bool        operator==(const access &o) const {
+            return cycle == o.cycle && addr == o.addr && val == o.val && write == o.write;
+        };
+    };
+    std::vector<access>         *accesses;
+
+    UINT8                       read(MEMADDR a) {
+        if(accesses) log_access(a, mem[a], 0);
+        return mem[a];
+    };
+    void                        write(MEMADDR a, UINT8 val) {
+        mem[a] = val;
+        if(accesses) log_access(a, val, 1);
+    };
+    UINT8                       read_stack(ZPADDR offset) {return read(STACK_PAGE_START+(MEMADDR)offset);};
+    void                        write_stack(ZPADDR offset, UINT8 val) {write(STACK_PAGE_START+(MEMADDR)offset, val);};
+    const UINT8                 *get_ram() {return mem;};
+    UINT8                       *get_ram_rw() {return mem;};
+    // no PPU
+    BOOL                        ppu_status_stable() {return 1;};
+    const UINT8                 *get_code_page(MEMADDR a, MEMADDR &lo, UINT32 &len) {
+        lo = 0;
+        len = (a < 0x8000)? 0x8000 : 0;
+        return mem;
+    };
+
+    CPUMemoryManager            *save_state() {return new FullRamMemory(*this);};
+
+private:
+    UINT8                       mem[ADDR_SPACE_SIZE];
+    void                        log_access(MEMADDR a, UINT8 val, BOOL write) {
+        accesses->push_back({(cpu)? cpu->get_cycles() : 0, a, val, write});
+    };
+};
+
+#endif
@@ -0,0 +1,616 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "dynarec.hpp"
+#include "cpu_opcodes.hpp"
+
+#if defined(__x86_64__)
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define DYNAREC_MAX_INSTRUCTIONS    64
+// an instruction is at most ~160 bytes of host code
+#define DYNAREC_MAX_BLOCK_SIZE      (DYNAREC_MAX_INSTRUCTIONS * 192 + 64)
+
+#define FIELD(f)                    ((UINT8)offsetof(dynarec_frame, f))
+static_assert(offsetof(dynarec_frame, read) < 0x80, "frame fields are addressed with 8 bits offsets");
+
+// x86 condition codes, the opposite one is cc ^ 1
+enum {
+    CC_O = 0x0, CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_S = 0x8
+};
+
+// registers in ModRM
+enum {
+    EAX = 0, ECX = 1, EDX = 2
+};
+
+/*
+The few x86-64 instructions the blocks are made of. While a block runs :
+rbx : the frame, r12 : the RAM, r13d : cycles, r14d : limit
+eax, ecx, edx : scratch, eax holds addresses and ecx operands
+*/
+class X64Emitter
+{
+public:
+    UINT8               *p;
+
+    X64Emitter(UINT8 *start) : p(start) {};
+
+    void b(std::initializer_list<UINT8> l) {for(UINT8 v : l) *p++ = v;};
+    void d32(UINT32 v) {std::memcpy(p, &v, 4); p += 4;};
+    void rel32(const UINT8 *target) {d32((UINT32)(target - (p + 4)));};
+
+    // movzx r32, byte [rbx + field]
+    void load_field(UINT8 reg, UINT8 field) {b({0x0F, 0xB6, (UINT8)(0x43 | reg << 3), field});};
+    // mov byte [rbx + field], r8
+    void store_field(UINT8 field, UINT8 reg) {b({0x88, (UINT8)(0x43 | reg << 3), field});};
+    void set_field(UINT8 field, UINT8 val) {b({0xC6, 0x43, field, val});};
+    void setcc_field(UINT8 cc, UINT8 field) {b({0x0F, (UINT8)(0x90 | cc), 0x43, field});};
+    void cmp_field(UINT8 field, UINT8 val) {b({0x80, 0x7B, field, val});};
+    void inc_field(UINT8 field) {b({0xFE, 0x43, field});};
+    void dec_field(UINT8 field) {b({0xFE, 0x4B, field});};
+
+    // movzx r32, byte [r12 + rax]
+    void load_ram(UINT8 reg) {b({0x41, 0x0F, 0xB6, (UINT8)(0x04 | reg << 3), 0x04});};
+    // mov byte [r12 + rax], r8
+    void store_ram(UINT8 reg) {b({0x41, 0x88, (UINT8)(0x04 | reg << 3), 0x04});};
+    // movzx r32, byte [r12 + addr]
+    void load_ram_at(UINT8 reg, UINT32 addr) {b({0x41, 0x0F, 0xB6, (UINT8)(0x84 | reg << 3), 0x24}); d32(addr);};
+    // [r12 + rax + 0x100], rax being S
+    void load_stack(UINT8 reg) {b({0x41, 0x0F, 0xB6, (UINT8)(0x84 | reg << 3), 0x04}); d32(0x100);};
+    void store_stack(UINT8 reg) {b({0x41, 0x88, (UINT8)(0x84 | reg << 3), 0x04}); d32(0x100);};
+    void store_stack_imm(UINT8 val) {b({0x41, 0xC6, 0x84, 0x04}); d32(0x100); b({val});};
+
+    void mov_imm(UINT8 reg, UINT32 val) {b({(UINT8)(0xB8 | reg)}); d32(val);};
+    void add_eax(UINT32 val) {b({0x05}); d32(val);};
+    void and_eax(UINT32 val) {b({0x25}); d32(val);};
+    void cmp_eax(UINT32 val) {b({0x3D}); d32(val);};
+    void test_cl() {b({0x84, 0xC9});};
+
+    void add_cycles(UINT8 n) {b({0x41, 0x83, 0xC5, n});};
+    // neg reg ; adc r13d, 0 : one more cycle when reg != 0
+    void add_cycle_if(UINT8 reg) {b({0xF7, (UINT8)(0xD8 | reg), 0x41, 0x83, 0xD5, 0x00});};
+    void cmp_cycles_limit() {b({0x45, 0x39, 0xF5});};
+
+    void jmp(const UINT8 *target) {b({0xE9}); rel32(target);};
+    void jcc(UINT8 cc, const UINT8 *target) {b({0x0F, (UINT8)(0x80 | cc)}); rel32(target);};
+    // forward jumps inside an instruction, bind() them once the target is emitted
+    UINT8 *jcc8(UINT8 cc) {b({(UINT8)(0x70 | cc), 0}); return p - 1;};
+    UINT8 *jmp8() {b({0xEB, 0}); return p - 1;};
+    void bind(UINT8 *rel8) {*rel8 = (UINT8)(p - (rel8 + 1));};
+};
+
+class BlockTranslator
+{
+public:
+    X64Emitter          e;
+
+    BlockTranslator(UINT8 *start, const UINT8 *epilogue, const UINT8 *page, MEMADDR page_lo, UINT32 page_len) :
+        e(start), epilogue(epilogue), page(page), page_lo(page_lo), page_len(page_len) {};
+
+    // returns the number of translated instructions
+    unsigned int        translate(MEMADDR pc);
+
+private:
+    const UINT8         *epilogue;
+    const UINT8         *page;
+    MEMADDR             page_lo;
+    UINT32              page_len;
+    // instructions of the block and their code, for the branches back into it
+    std::vector<std::pair<MEMADDR, UINT8 *>>
+                        done;
+
+    bool in_page(MEMADDR pc, UINT8 len) {return (UINT32)(MEMADDR)(pc - page_lo) + len <= page_len;};
+    UINT8 *find(MEMADDR pc) {
+        for(auto &d : done) if(d.first == pc) return d.second;
+        return nullptr;
+    };
+
+    void exit_to(MEMADDR pc) {
+        e.b({0x66, 0xC7, 0x43, FIELD(PC), (UINT8)pc, (UINT8)(pc >> 8)});
+        e.jmp(epilogue);
+    };
+    void exit_if(UINT8 cc, MEMADDR pc) {
+        UINT8 *skip = e.jcc8(cc ^ 1);
+        exit_to(pc);
+        e.bind(skip);
+    };
+    void flags_nz() {
+        e.setcc_field(CC_E, FIELD(Z));
+        e.setcc_field(CC_S, FIELD(N));
+    };
+    // mem->read(eax), in ecx
+    void call_read() {
+        e.b({0x48, 0x8B, 0x7B, FIELD(mem), 0x89, 0xC6, 0xFF, 0x53, FIELD(read), 0x0F, 0xB6, 0xC8});
+    };
+
+    void indirect_x_address(UINT8 zp);
+    bool read_operand(const cpu_opcode_info &info, UINT16 operand, MEMADDR pc);
+    bool ram_address(const cpu_opcode_info &info, UINT16 operand, MEMADDR pc);
+    void rmw_op(const cpu_opcode_info &info);
+    // false when the instruction is left to the interpreter, nothing is emitted then
+    bool instruction(const cpu_opcode_info &info, UINT16 operand, MEMADDR pc, MEMADDR &next, bool &dynamic_exit);
+};
+
+// eax = the address at zp + X
+void BlockTranslator::indirect_x_address(UINT8 zp) {
+    e.load_field(ECX, FIELD(X));
+    e.b({0x80, 0xC1, zp});                          // add cl, zp
+    e.b({0x41, 0x0F, 0xB6, 0x04, 0x0C});            // movzx eax, byte [r12 + rcx]
+    e.b({0xFE, 0xC1});                              // inc cl
+    e.b({0x41, 0x0F, 0xB6, 0x14, 0x0C});            // movzx edx, byte [r12 + rcx]
+    e.b({0xC1, 0xE2, 0x08, 0x09, 0xD0});            // shl edx, 8 ; or eax, edx
+}
+
+// operand in ecx
+bool BlockTranslator::read_operand(const cpu_opcode_info &info, UINT16 operand, MEMADDR pc) {
+    UINT8 index = (info.mode == ADDR_MODE::ABSOLUTE_Y || info.mode == ADDR_MODE::ZERO_PAGE_Y)? FIELD(Y) : FIELD(X);
+    switch (info.mode)
+    {
+    case ADDR_MODE::IMMEDIATE:
+        e.mov_imm(ECX, operand);
+        return true;
+
+    case ADDR_MODE::ZERO_PAGE:
+        e.load_ram_at(ECX, operand);
+        return true;
+
+    case ADDR_MODE::ZERO_PAGE_X:
+    case ADDR_MODE::ZERO_PAGE_Y:
+        e.load_field(EAX, index);
+        e.b({0x04, (UINT8)operand});                // add al, zp
+        e.load_ram(ECX);
+        return true;
+
+    case ADDR_MODE::ABSOLUTE:
+        if(operand < 0x2000) {
+            e.load_ram_at(ECX, operand & 0x07FF);
+        } else if(operand >= 0x6000) {
+            e.mov_imm(EAX, operand);
+            call_read();
+        } else return false;
+        return true;
+
+    case ADDR_MODE::ABSOLUTE_X:
+    case ADDR_MODE::ABSOLUTE_Y: {
+        bool ram = (operand + 0xFF < 0x2000);
+        if(!ram && !(operand >= 0x6000 && operand + 0xFF <= 0xFFFF)) return false;
+        e.load_field(EAX, index);
+        e.add_eax(operand);
+        if(info.page_cycle) {
+            e.b({0x89, 0xC1, 0x81, 0xF1}); e.d32(operand); // mov ecx, eax ; xor ecx, operand
+            e.b({0xC1, 0xE9, 0x08});                // shr ecx, 8
+            e.add_cycle_if(ECX);
+        }
+        if(ram) {
+            e.and_eax(0x07FF);
+            e.load_ram(ECX);
+        } else call_read();
+        return true;
+    }
+
+    case ADDR_MODE::INDIRECT_Y:
+    case ADDR_MODE::X_INDIRECT: {
+        bool page_cycle = (info.mode == ADDR_MODE::INDIRECT_Y) && info.page_cycle;
+        if(info.mode == ADDR_MODE::INDIRECT_Y) {
+            e.load_ram_at(EAX, operand);
+            e.load_ram_at(EDX, (operand + 1) & 0xFF);
+            e.b({0xC1, 0xE2, 0x08, 0x09, 0xC2});    // shl edx, 8 ; or edx, eax
+            e.load_field(EAX, FIELD(Y));
+            e.b({0x01, 0xD0, 0x0F, 0xB7, 0xC0});    // add eax, edx ; movzx eax, ax
+            e.b({0x31, 0xC2, 0xC1, 0xEA, 0x08});    // xor edx, eax ; shr edx, 8
+        } else indirect_x_address(operand);
+
+        // only known now : RAM, PRG, or back to the interpreter
+        e.cmp_eax(0x2000);
+        UINT8 *not_ram = e.jcc8(CC_AE);
+        if(page_cycle) e.add_cycle_if(EDX);
+        e.and_eax(0x07FF);
+        e.load_ram(ECX);
+        UINT8 *done = e.jmp8();
+        e.bind(not_ram);
+        e.cmp_eax(0x6000);
+        exit_if(CC_B, pc);
+        if(page_cycle) e.add_cycle_if(EDX);
+        call_read();
+        e.bind(done);
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+// RAM index of the operand in rax, for writes
+bool BlockTranslator::ram_address(const cpu_opcode_info &info, UINT16 operand, MEMADDR pc) {
+    switch (info.mode)
+    {
+    case ADDR_MODE::ZERO_PAGE:
+        e.mov_imm(EAX, operand);
+        return true;
+
+    case ADDR_MODE::ZERO_PAGE_X:
+    case ADDR_MODE::ZERO_PAGE_Y:
+        e.load_field(EAX, (info.mode == ADDR_MODE::ZERO_PAGE_Y)? FIELD(Y) : FIELD(X));
+        e.b({0x04, (UINT8)operand});
+        return true;
+
+    case ADDR_MODE::ABSOLUTE:
+        if(operand >= 0x2000) return false;
+        e.mov_imm(EAX, operand & 0x07FF);
+        return true;
+
+    case ADDR_MODE::ABSOLUTE_X:
+    case ADDR_MODE::ABSOLUTE_Y:
+        if(operand + 0xFF >= 0x2000) return false;
+        e.load_field(EAX, (info.mode == ADDR_MODE::ABSOLUTE_Y)? FIELD(Y) : FIELD(X));
+        e.add_eax(operand);
+        e.and_eax(0x07FF);
+        return true;
+
+    case ADDR_MODE::INDIRECT_Y:
+    case ADDR_MODE::X_INDIRECT:
+        if(info.mode == ADDR_MODE::INDIRECT_Y) {
+            e.load_ram_at(EAX, operand);
+            e.load_ram_at(EDX, (operand + 1) & 0xFF);
+            e.b({0xC1, 0xE2, 0x08, 0x09, 0xD0});    // shl edx, 8 ; or eax, edx
+            e.load_field(EDX, FIELD(Y));
+            e.b({0x01, 0xD0, 0x0F, 0xB7, 0xC0});    // add eax, edx ; movzx eax, ax
+        } else indirect_x_address(operand);
+        e.cmp_eax(0x2000);
+        exit_if(CC_AE, pc);
+        e.and_eax(0x07FF);
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+// shifts, rotations, INC and DEC of cl
+void BlockTranslator::rmw_op(const cpu_opcode_info &info) {
+    switch (info.mnemonic)
+    {
+    case MNEMONIC::INC:
+    case MNEMONIC::DEC:
+        e.b({0xFE, (UINT8)((info.mnemonic == MNEMONIC::INC)? 0xC1 : 0xC9)});
+        break;
+    case MNEMONIC::ROL:
+    case MNEMONIC::ROR:
+        e.cmp_field(FIELD(C), 1);
+        e.b({0xF5, 0xD0, (UINT8)((info.mnemonic == MNEMONIC::ROL)? 0xD1 : 0xD9)}); // cmc ; rcl/rcr cl, 1
+        e.setcc_field(CC_B, FIELD(C));
+        e.test_cl();                                // rcl and rcr leave Z and S
+        break;
+    default:
+        e.b({0xD0, (UINT8)((info.mnemonic == MNEMONIC::ASL)? 0xE1 : 0xE9)}); // shl/shr cl, 1
+        e.setcc_field(CC_B, FIELD(C));
+        break;
+    }
+    flags_nz();
+}
+
+bool BlockTranslator::instruction(const cpu_opcode_info &info, UINT16 operand, MEMADDR pc, MEMADDR &next, bool &dynamic_exit) {
+    next = pc + addr_mode_length(info.mode);
+    dynamic_exit = false;
+    if(!info.official) return false;
+
+    UINT8 reg = (info.flags & OPCODE_REG_X)? FIELD(X) : (info.flags & OPCODE_REG_Y)? FIELD(Y) : FIELD(A);
+
+    switch (info.mnemonic)
+    {
+    case MNEMONIC::LDA: case MNEMONIC::LDX: case MNEMONIC::LDY:
+        if(!read_operand(info, operand, pc)) return false;
+        e.store_field(reg, ECX);
+        e.test_cl();
+        flags_nz();
+        break;
+
+    case MNEMONIC::STA: case MNEMONIC::STX: case MNEMONIC::STY:
+        if(!ram_address(info, operand, pc)) return false;
+        e.load_field(EDX, reg);
+        e.store_ram(EDX);
+        break;
+
+    case MNEMONIC::ORA: case MNEMONIC::AND: case MNEMONIC::EOR:
+        if(!read_operand(info, operand, pc)) return false;
+        e.load_field(EDX, FIELD(A));
+        e.b({(UINT8)((info.mnemonic == MNEMONIC::ORA)? 0x08 : (info.mnemonic == MNEMONIC::AND)? 0x20 : 0x30), 0xCA}); // op dl, cl
+        flags_nz();
+        e.store_field(FIELD(A), EDX);
+        break;
+
+    case MNEMONIC::ADC: case MNEMONIC::SBC:
+        // same carry and overflow as the 6502, with C inverted for sbb
+        if(!read_operand(info, operand, pc)) return false;
+        e.load_field(EDX, FIELD(A));
+        e.cmp_field(FIELD(C), 1);
+        if(info.mnemonic == MNEMONIC::ADC) e.b({0xF5, 0x10, 0xCA}); // cmc ; adc dl, cl
+        else e.b({0x18, 0xCA});                     // sbb dl, cl
+        e.setcc_field((info.mnemonic == MNEMONIC::ADC)? CC_B : CC_AE, FIELD(C));
+        e.setcc_field(CC_O, FIELD(V));
+        flags_nz();
+        e.store_field(FIELD(A), EDX);
+        break;
+
+    case MNEMONIC::CMP: case MNEMONIC::CPX: case MNEMONIC::CPY:
+        if(!read_operand(info, operand, pc)) return false;
+        e.load_field(EDX, reg);
+        e.b({0x38, 0xCA});                          // cmp dl, cl
+        e.setcc_field(CC_AE, FIELD(C));
+        flags_nz();
+        break;
+
+    case MNEMONIC::BIT:
+        if(!read_operand(info, operand, pc)) return false;
+        e.load_field(EDX, FIELD(A));
+        e.b({0x84, 0xCA});                          // test dl, cl
+        e.setcc_field(CC_E, FIELD(Z));
+        e.b({0xF6, 0xC1, 0x80});
+        e.setcc_field(CC_NE, FIELD(N));
+        e.b({0xF6, 0xC1, 0x40});
+        e.setcc_field(CC_NE, FIELD(V));
+        break;
+
+    case MNEMONIC::ASL: case MNEMONIC::LSR: case MNEMONIC::ROL: case MNEMONIC::ROR:
+    case MNEMONIC::INC: case MNEMONIC::DEC:
+        if(info.mode == ADDR_MODE::ACCUMULATOR) {
+            e.load_field(ECX, FIELD(A));
+            rmw_op(info);
+            e.store_field(FIELD(A), ECX);
+        } else {
+            if(!ram_address(info, operand, pc)) return false;
+            e.load_ram(ECX);
+            rmw_op(info);
+            e.store_ram(ECX);
+        }
+        break;
+
+    case MNEMONIC::INX: case MNEMONIC::INY: case MNEMONIC::DEX: case MNEMONIC::DEY:
+        e.load_field(ECX, reg);
+        e.b({0xFE, (UINT8)((info.mnemonic == MNEMONIC::INX || info.mnemonic == MNEMONIC::INY)? 0xC1 : 0xC9)});
+        flags_nz();
+        e.store_field(reg, ECX);
+        break;
+
+    case MNEMONIC::TAX: case MNEMONIC::TAY: case MNEMONIC::TXA: case MNEMONIC::TYA:
+    case MNEMONIC::TSX: case MNEMONIC::TXS: {
+        UINT8 from, to;
+        switch (info.mnemonic)
+        {
+        case MNEMONIC::TAX: from = FIELD(A); to = FIELD(X); break;
+        case MNEMONIC::TAY: from = FIELD(A); to = FIELD(Y); break;
+        case MNEMONIC::TXA: from = FIELD(X); to = FIELD(A); break;
+        case MNEMONIC::TYA: from = FIELD(Y); to = FIELD(A); break;
+        case MNEMONIC::TSX: from = FIELD(S); to = FIELD(X); break;
+        default:            from = FIELD(X); to = FIELD(S); break; // TXS
+        }
+        e.load_field(ECX, from);
+        e.store_field(to, ECX);
+        if(info.mnemonic != MNEMONIC::TXS) {
+            e.test_cl();
+            flags_nz();
+        }
+        break;
+    }
+
+    case MNEMONIC::CLC: case MNEMONIC::SEC:
+        e.set_field(FIELD(C), info.mnemonic == MNEMONIC::SEC);
+        break;
+    case MNEMONIC::CLD: case MNEMONIC::SED:
+        e.set_field(FIELD(D), info.mnemonic == MNEMONIC::SED);
+        break;
+    case MNEMONIC::CLV:
+        e.set_field(FIELD(V), 0);
+        break;
+    case MNEMONIC::NOP:
+        break;
+
+    case MNEMONIC::PHA:
+        e.load_field(ECX, FIELD(A));
+        e.load_field(EAX, FIELD(S));
+        e.store_stack(ECX);
+        e.dec_field(FIELD(S));
+        break;
+
+    case MNEMONIC::PLA:
+        e.inc_field(FIELD(S));
+        e.load_field(EAX, FIELD(S));
+        e.load_stack(ECX);
+        e.store_field(FIELD(A), ECX);
+        e.test_cl();
+        flags_nz();
+        break;
+
+    case MNEMONIC::JSR: {
+        MEMADDR ret = pc + 2;
+        e.load_field(EAX, FIELD(S));
+        e.store_stack_imm(ret >> 8);
+        e.dec_field(FIELD(S));
+        e.load_field(EAX, FIELD(S));
+        e.store_stack_imm(ret & 0xFF);
+        e.dec_field(FIELD(S));
+        next = operand;
+        break;
+    }
+
+    case MNEMONIC::JMP:
+        if(info.mode != ADDR_MODE::ABSOLUTE) return false;
+        next = operand;
+        break;
+
+    case MNEMONIC::RTS:
+        e.inc_field(FIELD(S));
+        e.load_field(EAX, FIELD(S));
+        e.load_stack(ECX);
+        e.inc_field(FIELD(S));
+        e.load_field(EAX, FIELD(S));
+        e.load_stack(EDX);
+        e.b({0xC1, 0xE2, 0x08, 0x09, 0xD1, 0xFF, 0xC1}); // shl edx, 8 ; or ecx, edx ; inc ecx
+        e.b({0x66, 0x89, 0x4B, FIELD(PC)});         // mov [PC], cx
+        dynamic_exit = true;
+        break;
+
+    case MNEMONIC::BPL: case MNEMONIC::BMI: case MNEMONIC::BVC: case MNEMONIC::BVS:
+    case MNEMONIC::BCC: case MNEMONIC::BCS: case MNEMONIC::BNE: case MNEMONIC::BEQ: {
+        UINT8 flag;
+        switch (info.mnemonic)
+        {
+        case MNEMONIC::BPL: case MNEMONIC::BMI: flag = FIELD(N); break;
+        case MNEMONIC::BVC: case MNEMONIC::BVS: flag = FIELD(V); break;
+        case MNEMONIC::BCC: case MNEMONIC::BCS: flag = FIELD(C); break;
+        default:                                flag = FIELD(Z); break; // BNE, BEQ
+        }
+        // BPL, BVC, BCC, BNE are taken when the flag is clear
+        bool on_clear = (info.mnemonic == MNEMONIC::BPL || info.mnemonic == MNEMONIC::BVC ||
+                         info.mnemonic == MNEMONIC::BCC || info.mnemonic == MNEMONIC::BNE);
+        MEMADDR target = next + (INT8)operand;
+        e.cmp_field(flag, 0);
+        UINT8 *not_taken = e.jcc8(on_clear? CC_NE : CC_E);
+        e.add_cycles(3 + ((target & 0xFF00) != (next & 0xFF00)));
+        UINT8 *back = find(target);
+        if(back) {
+            e.cmp_cycles_limit();
+            e.jcc(CC_B, back);
+        }
+        exit_to(target);
+        e.bind(not_taken);
+        break;
+    }
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+unsigned int BlockTranslator::translate(MEMADDR pc) {
+    // push rbx, r12, r13, r14 ; sub rsp, 8 (calls need a 16 bytes aligned stack)
+    e.b({0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x48, 0x83, 0xEC, 0x08});
+    e.b({0x48, 0x89, 0xFB});                        // mov rbx, rdi
+    e.b({0x4C, 0x8B, 0x63, FIELD(ram)});            // mov r12, [rbx + ram]
+    e.b({0x44, 0x8B, 0x6B, FIELD(cycles)});         // mov r13d, [rbx + cycles]
+    e.b({0x44, 0x8B, 0x73, FIELD(limit)});          // mov r14d, [rbx + limit]
+
+    while(true) {
+        if(done.size() == DYNAREC_MAX_INSTRUCTIONS || !in_page(pc, 1)) break;
+        const UINT8 *bytes = page + (MEMADDR)(pc - page_lo);
+        const cpu_opcode_info &info = cpu_opcodes[bytes[0]];
+        UINT8 len = addr_mode_length(info.mode);
+        if(!in_page(pc, len)) break;
+        UINT16 operand = (len == 1)? 0 : (len == 2)? bytes[1] : (bytes[1] | (bytes[2] << 8));
+
+        UINT8 *start = e.p;
+        done.push_back({pc, start});
+        MEMADDR next;
+        bool dynamic_exit;
+        if(!instruction(info, operand, pc, next, dynamic_exit)) {
+            e.p = start;
+            done.pop_back();
+            break;
+        }
+
+        e.add_cycles(info.cycles);
+        if(dynamic_exit) {
+            e.jmp(epilogue);
+            return done.size();
+        }
+        e.cmp_cycles_limit();
+        UINT8 *back = find(next);
+        if(back) {
+            // loops stay in the block until the limit
+            e.jcc(CC_B, back);
+            exit_to(next);
+            return done.size();
+        }
+        UINT8 *skip = e.jcc8(CC_B);
+        exit_to(next);
+        e.bind(skip);
+        pc = next;
+    }
+    exit_to(pc);
+    return done.size();
+}
+
+Dynarec::Dynarec() : code_used(0), epilogue(nullptr) {
+    // never writable and executable at once : see protect()
+    void *m = mmap(nullptr, DYNAREC_CODE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    code = (m == MAP_FAILED)? nullptr : (UINT8 *)m;
+    flush();
+}
+
+Dynarec::~Dynarec() {
+    if(code) munmap(code, DYNAREC_CODE_SIZE);
+}
+
+bool Dynarec::protect(size_t from, size_t to, bool exec) {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    from &= ~(page_size - 1);
+    to = std::min((to + page_size - 1) & ~(page_size - 1), (size_t)DYNAREC_CODE_SIZE);
+    if(!mprotect(code + from, to - from, PROT_READ | (exec? PROT_EXEC : PROT_WRITE))) return true;
+    // back to the interpreter
+    blocks.clear();
+    std::memset(cache, 0, sizeof(cache));
+    munmap(code, DYNAREC_CODE_SIZE);
+    code = nullptr;
+    return false;
+}
+
+void Dynarec::flush() {
+    blocks.clear();
+    std::memset(cache, 0, sizeof(cache));
+    if(!code || !protect(0, DYNAREC_CODE_SIZE, false)) return;
+
+    // all the blocks return through the same code
+    X64Emitter e(code);
+    epilogue = code;
+    e.b({0x44, 0x89, 0x6B, FIELD(cycles)});         // mov [rbx + cycles], r13d
+    e.b({0x48, 0x83, 0xC4, 0x08, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3});
+    code_used = 64;
+    protect(0, code_used, true);
+}
+
+dynarec_block Dynarec::translate(const UINT8 *page, MEMADDR page_lo, UINT32 page_len, MEMADDR pc) {
+    if(!code) return nullptr;
+    if(code_used + DYNAREC_MAX_BLOCK_SIZE > DYNAREC_CODE_SIZE) flush();
+    // the pages of the block, the first one can have the end of the previous block
+    size_t from = code_used, to = code_used + DYNAREC_MAX_BLOCK_SIZE;
+    if(!code || !protect(from, to, false)) return nullptr;
+
+    BlockTranslator t(code + code_used, epilogue, page, page_lo, page_len);
+    bool translated = t.translate(pc);
+    if(!protect(from, to, true) || !translated) return nullptr;
+    dynarec_block block = reinterpret_cast<dynarec_block>(code + code_used);
+    code_used = ((t.e.p - code) + 15) & ~(size_t)15;
+    return block;
+}
+
+#else
+
+Dynarec::Dynarec() : code(nullptr), code_used(0), epilogue(nullptr) {
+    flush();
+}
+
+Dynarec::~Dynarec() {}
+
+void Dynarec::flush() {
+    blocks.clear();
+    std::memset(cache, 0, sizeof(cache));
+}
+
+dynarec_block Dynarec::translate(const UINT8 *page, MEMADDR page_lo, UINT32 page_len, MEMADDR pc) {
+    return nullptr;
+}
+
+#endif
+
+dynarec_block Dynarec::lookup(UINT64 key, const UINT8 *page, MEMADDR page_lo, UINT32 page_len, MEMADDR pc) {
+    auto it = blocks.find(key);
+    if(it != blocks.end()) return it->second;
+    dynarec_block block = translate(page, page_lo, page_len, pc);
+    blocks[key] = block;
+    return block;
+}
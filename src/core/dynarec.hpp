@@ -0,0 +1,95 @@
+#ifndef GAYA_DYNAREC_HPP
+#define GAYA_DYNAREC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include "types.hpp"
+
+#define DYNAREC_CODE_SIZE       (4 << 20)
+#define DYNAREC_CACHE_SIZE      4096
+
+/*
+State of the CPU while a translated block runs, the block gets a pointer to it.
+Flags are 0 or 1. The CPU copies its registers in before the call, and back after.
+*/
+struct dynarec_frame {
+    UINT8       A, X, Y, S;
+    UINT8       C, Z, V, N, D;
+    UINT16      PC;         // where the interpreter goes on
+    UINT32      cycles;
+    UINT32      limit;      // blocks stop once cycles >= limit, as the interpreter loop
+    UINT8       *ram;
+    // $6000-$FFFF reads (PRG RAM and ROM, no side effects)
+    void        *mem;
+    UINT8       (*read)(void *mem, MEMADDR a);
+};
+
+typedef void (*dynarec_block)(dynarec_frame *f);
+
+/*
+Translates the hot parts of the PRG ROM into x86-64 code : a block starts at an
+instruction and follows the code (through JMP, JSR and the not taken branches) until
+an instruction the translator leaves to the interpreter, or one which can jump anywhere.
+Backward branches to an instruction of the block stay in the block.
+Cycles are counted after each instruction like the interpreter does, so a block
+stops exactly where the interpreter would have.
+
+Only RAM, PRG RAM and PRG ROM are accessed : the instructions touching the PPU,
+APU or mapper registers, and all the ones changing I or reading P (PHP, PLP, RTI,
+BRK, CLI, SEI), are left to the interpreter. A block exits just before one of them,
+so those are always interpreted, even when the address is only known at runtime.
+
+Blocks are keyed by the host address of their first byte and its PC : after a
+bank switch, the same PC is another block. RAM code is never translated, so writes
+don't invalidate anything. The patched banks of Game Genie codes are other buffers,
+so blocks are only flushed when the codes change (the buffers are then freed).
+
+The code cache is never writable and executable at once : the pages a block is
+emitted to are writable during translate() only.
+*/
+class Dynarec
+{
+public:
+    Dynarec();
+    ~Dynarec();
+
+    /* false when no executable memory could be allocated (or its protection changed),
+    or not on a x86-64 host */
+    bool                        is_available() {return code != nullptr;};
+
+    /* Block for PC, in the code page mapped at page_lo (see cpu6502::code_page), nullptr
+    when its first instruction is interpreted */
+    dynarec_block               get_block(const UINT8 *page, MEMADDR page_lo, UINT32 page_len, MEMADDR pc) {
+        UINT64 key = (UINT64)(uintptr_t)(page + (MEMADDR)(pc - page_lo)) ^ ((UINT64)pc << 48);
+        cache_entry &e = cache[(key ^ (key >> 12)) & (DYNAREC_CACHE_SIZE - 1)];
+        if(e.key == key) return e.block;
+        dynarec_block block = lookup(key, page, page_lo, page_len, pc); // can flush the cache
+        e.key = key;
+        e.block = block;
+        return block;
+    };
+    void                        flush();
+    size_t                      get_nr_blocks() {return blocks.size();};
+
+private:
+    struct cache_entry {
+        UINT64          key;
+        dynarec_block   block;
+    };
+
+    UINT8                       *code;
+    size_t                      code_used;
+    UINT8                       *epilogue;
+    std::unordered_map<UINT64, dynarec_block>
+                                blocks;
+    cache_entry                 cache[DYNAREC_CACHE_SIZE];
+
+    dynarec_block               lookup(UINT64 key, const UINT8 *page, MEMADDR page_lo, UINT32 page_len, MEMADDR pc);
+    dynarec_block               translate(const UINT8 *page, MEMADDR page_lo, UINT32 page_len, MEMADDR pc);
+    /* The pages of [from, to) in the code, writable or executable. On a failure, the
+    code is freed and everything goes back to the interpreter */
+    bool                        protect(size_t from, size_t to, bool exec);
+};
+
+#endif
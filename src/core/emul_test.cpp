@@ -2,12 +2,14 @@
 #include <iostream>
 #include <fstream>
 #include <getopt.h>
+#include <thread>
+#include <atomic>
 #include "emulation_manager.hpp"
 #include "sdl_utils.hpp"
 
 /*
 compile with
-g++ -o emul_test emul_test.cpp nes_loaders/ines.cpp emulation_manager.cpp emulation_debug_cli.cpp ppu_render/ppu_render.cpp ppu_render/draw_tile.cpp cpu.cpp mem.cpp ppu_mem.cpp input_devices/device.cpp input_devices/nesjoypad.cpp sdl_utils.cpp -lSDL2
+g++ -o emul_test emul_test.cpp nes_loaders/ines.cpp nes_loaders/rom_image.cpp nes_loaders/rom_db.cpp emulation_manager.cpp emulation_debug_cli.cpp ppu_render/ppu_render.cpp ppu_render/draw_tile.cpp ppu_render/frame_presenter.cpp cpu.cpp cpu_opcodes.cpp dynarec.cpp mem.cpp game_genie.cpp ram_search.cpp ppu_mem.cpp input_devices/device.cpp input_devices/nesjoypad.cpp input_devices/input_movie.cpp sdl_utils.cpp latency_probe.cpp battery_save.cpp trace.cpp profiler.cpp breakpoints.cpp cdl.cpp -lSDL2
 */
 
 const int block_size = 4;
@@ -15,8 +17,17 @@ const int width_screen = block_size*256;
 const int height_screen = block_size*240;
 
 typedef struct {
-    char *rom_path = NULL, *game_genie = NULL;
+    char *rom_path = NULL, *latency_output = NULL;
+    std::vector<char *> game_genie;
+    std::vector<char *> breakpoints;
+    char *movie_record = NULL, *movie_play = NULL, *hash_log = NULL, *instruction_trace = NULL;
+    char *profile_output = NULL, *cdl_file = NULL;
+    char *battery_dir = NULL;
+    unsigned int nr_frames = 0, trace_frame = 0;
+    bool headless = false;
     bool cli_debug = false;
+    bool low_latency = false;
+    bool dynarec = false;
     bool help = false;
     bool should_stop = false;
 } cli_args_result;
@@ -24,7 +35,7 @@ typedef struct {
 cli_args_result parse_args(int argc, char *argv[]) {
     cli_args_result res;
     int option;
-    while((option = getopt(argc, argv, ":g:dh")) != -1) {
+    while((option = getopt(argc, argv, ":g:dlL:r:p:Hn:S:T:t:P:B:C:b:jh")) != -1) {
         switch (option)
         {
         case 'h':
@@ -36,8 +47,64 @@ cli_args_result parse_args(int argc, char *argv[]) {
             res.cli_debug = true;
             break;
 
+        case 'l':
+            res.low_latency = true;
+            break;
+
+        case 'L':
+            res.latency_output = optarg;
+            break;
+
+        case 'r':
+            res.movie_record = optarg;
+            break;
+
+        case 'p':
+            res.movie_play = optarg;
+            break;
+
+        case 'H':
+            res.headless = true;
+            break;
+
+        case 'n':
+            res.nr_frames = strtoul(optarg, NULL, 10);
+            break;
+
+        case 'S':
+            res.hash_log = optarg;
+            break;
+
+        case 'T':
+            res.trace_frame = strtoul(optarg, NULL, 10);
+            break;
+
+        case 't':
+            res.instruction_trace = optarg;
+            break;
+
+        case 'P':
+            res.profile_output = optarg;
+            break;
+
+        case 'B':
+            res.breakpoints.push_back(optarg);
+            break;
+
+        case 'C':
+            res.cdl_file = optarg;
+            break;
+
         case 'g':
-            res.game_genie = optarg;
+            res.game_genie.push_back(optarg);
+            break;
+
+        case 'b':
+            res.battery_dir = optarg;
+            break;
+
+        case 'j':
+            res.dynarec = true;
             break;
 
         case ':':
@@ -70,52 +137,103 @@ void show_cli_help() {
     std::printf("GayaNES CLI HELP\n");
     std::printf("Gaspard Thévenon\n\n");
     std::printf("Usage : ./emul_core [OPTIONS] rom_path\n");
-    std::printf("\nOptions:\n\t-g CODE : use a game-genie code\n");
-    std::printf("\t-d : enable debug cli when exiting the game\n");
+    std::printf("\nOptions:\n\t-g CODE : use a game-genie code (6 or 8 letters, can be repeated)\n");
+    std::printf("\t-d : enable debug cli when exiting the game, or at the end of a headless run\n");
+    std::printf("\t-l : low latency input (the joypads are updated as soon as a key is pressed)\n");
+    std::printf("\t-L FILE : measure input latency, histograms are written to FILE at exit\n");
+    std::printf("\t-r FILE : record the controllers input to the movie FILE\n");
+    std::printf("\t-p FILE : play the controllers input from the movie FILE\n");
+    std::printf("\t-H : headless, without window nor frame pacing (stops at the end of the movie)\n");
+    std::printf("\t-n N : stop after N frames\n");
+    std::printf("\t-S FILE : log hashes of the state at the end of each frame to FILE\n");
+    std::printf("\t-T N : trace the instructions executed during frame N on stdout\n");
+    std::printf("\t-t FILE : binary trace of all the instructions to FILE (see trace_dump)\n");
+    std::printf("\t-B SPEC : breakpoint, \"exec C000\" or \"write 0300-03FF if value > 9\" (see the break command of the debug cli)\n");
+    std::printf("\t-C FILE : code/data log (FCEUX .cdl) of the run to FILE, added to the one already in FILE\n");
+    std::printf("\t-P FILE : profile the game, report in FILE and stacks for flamegraph.pl in FILE.folded\n");
+    std::printf("\t-b DIR : directory of the battery saves (default : current directory)\n");
+    std::printf("\t-j : translate the game code to host code (dynarec, x86-64 only)\n");
     std::printf("\t-h : shows this message\n\n");
 }
 
 void show_options(cli_args_result res) {
     std::printf("--- CLI arguments :\n");
     std::printf("ROM path : %s\n", res.rom_path);
-    std::printf("Game Genie : %s\n", (res.game_genie)? res.game_genie : "[NO]");
+    std::printf("Game Genie :");
+    if(res.game_genie.empty()) std::printf(" [NO]");
+    for(auto code : res.game_genie) std::printf(" %s", code);
+    std::printf("\n");
     std::printf("Debug CLI : %d\n", res.cli_debug);
+    std::printf("Low latency input : %d\n", res.low_latency);
+    std::printf("Latency histograms : %s\n", (res.latency_output)? res.latency_output : "[NO]");
+    std::printf("Movie recording : %s\n", (res.movie_record)? res.movie_record : "[NO]");
+    std::printf("Movie playback : %s\n", (res.movie_play)? res.movie_play : "[NO]");
+    std::printf("Headless : %d\n", res.headless);
+    std::printf("Frames : %u\n", res.nr_frames);
+    std::printf("State hashes log : %s\n", (res.hash_log)? res.hash_log : "[NO]");
+    std::printf("Traced frame : %u\n", res.trace_frame);
+    std::printf("Instruction trace : %s\n", (res.instruction_trace)? res.instruction_trace : "[NO]");
+    std::printf("Profile : %s\n", (res.profile_output)? res.profile_output : "[NO]");
+    std::printf("Breakpoints : %u\n", (unsigned int)res.breakpoints.size());
+    std::printf("Code/data log : %s\n", (res.cdl_file)? res.cdl_file : "[NO]");
+    std::printf("Battery saves directory : %s\n", (res.battery_dir)? res.battery_dir : ".");
+    std::printf("Dynarec : %d\n", res.dynarec);
 }
 
-void check_keys(EmulationManager *em) {
-    SDL_Event ev;
-    SDL_Keycode k;
-    while(SDL_PollEvent(&ev))
-        switch (ev.type)
-        {
-        case SDL_KEYDOWN:
-            k = ev.key.keysym.sym;
-            switch (k)
-            {
-            case SDLK_s:
-                em->save_state();
-                break;
-
-            case SDLK_r:
-                em->restore_state();
-                break;
-            
-            default:
-                em->push_sdl_event(ev);
-                break;
+enum class emulation_status {
+    RUNNING, EXITED, HALTED, FINISHED
+};
+
+bool run_finished(EmulationManager *em, cli_args_result &args) {
+    if(args.nr_frames && em->get_frame_count() >= args.nr_frames) return true;
+    // headless runs stop with the movie, otherwise the player takes over
+    return args.headless && em->is_movie_over();
+}
+
+/* Windowed runs : the emulation runs on its own thread, while this one, which
+owns the window and the renderer, waits for the SDL events and presents the
+frames. In low latency mode, the joypads snapshot is updated as soon as a key
+is pressed rather than once per frame */
+emulation_status run_threaded_emulation(EmulationManager *em, cli_args_result &args) {
+    std::atomic<emulation_status> status(emulation_status::RUNNING);
+
+    std::thread emulation_thread([em, &status, &args]() {
+        try {
+            while(status.load() == emulation_status::RUNNING) {
+                em->one_emulation_loop();
+                if(run_finished(em, args)) status = emulation_status::FINISHED;
             }
-            break;
-        
-        default:
-            em->push_sdl_event(ev);
-            break;
         }
+        catch(const ExitedGame& e) {
+            status = emulation_status::EXITED;
+        }
+        catch(const CPUHalted& e) {
+            status = emulation_status::HALTED;
+        }
+    });
+
+    SDL_Event ev;
+    UINT32 present_event = em->get_present_event();
+    while(status.load() == emulation_status::RUNNING) {
+        // without event for a while, in case a wake up was lost
+        if(!SDL_WaitEventTimeout(&ev, 10)) em->present_frame();
+        else if(ev.type == present_event) em->present_frame();
+        else em->push_sdl_event(ev);
+    }
+
+    emulation_thread.join();
+    // the events pushed after the one which stopped it would be seen by the debug drawings
+    em->discard_sdl_events();
+    // this thread goes on alone
+    em->stop_deferred_presentation();
+    return status.load();
 }
 
 int main(int argc, char *argv[]) {
     sdl_context sdl_ctx;
-    SDL_Window *window;
+    SDL_Window *window = nullptr;
     SDL_Renderer *renderer;
+    FILE *fmovie = NULL, *fhash_log = NULL, *ftrace = NULL;
     
     cli_args_result args = parse_args(argc, argv);
     if(args.help) {
@@ -125,18 +243,18 @@ int main(int argc, char *argv[]) {
 
     show_options(args);
 
-    if(init_window_renderer("Test gayaNES", &window, &renderer, width_screen, height_screen) < 0) {
-        std::printf("Initialization of SDL window failed: %s\n", SDL_GetError());
-        return 1;
-    }
-
-    sdl_ctx.block_size = block_size;
-    sdl_ctx.renderer = renderer;
-    sdl_ctx.format = SDL_AllocFormat(SDL_GetWindowPixelFormat(window));
+    if(!args.headless) {
+        if(init_window_renderer("Test gayaNES", &window, &renderer, width_screen, height_screen) < 0) {
+            std::printf("Initialization of SDL window failed: %s\n", SDL_GetError());
+            return 1;
+        }
 
-    std::string game_genie_code("");
+        sdl_ctx.block_size = block_size;
+        sdl_ctx.renderer = renderer;
+        sdl_ctx.format = SDL_AllocFormat(SDL_GetWindowPixelFormat(window));
+    }
 
-    EmulationManager *emul_manager = new EmulationManager(&sdl_ctx);
+    EmulationManager *emul_manager = new EmulationManager(args.headless ? nullptr : &sdl_ctx);
     FILE *fnes = fopen(args.rom_path, "r");
     if(!fnes) {
         std::printf("Error while opening nes file.\n");
@@ -144,20 +262,26 @@ int main(int argc, char *argv[]) {
     }
     emul_manager->open_nes(fnes);
 
+    if(args.battery_dir) emul_manager->set_battery_directory(args.battery_dir);
     emul_manager->init_rom();
 
+    for(auto code : args.game_genie) {
+        try {
+            emul_manager->add_game_genie(std::string(code));
+        } catch(const IncorrectFileFormat &e) {
+            std::printf("%s : %s. Skipping it\n", code, e.what());
+        }
+    }
+
     emul_manager->init_devices();
+    if(args.latency_output) emul_manager->enable_latency_probe();
 
     std::printf("File opening : OK\n");
     std::fflush(NULL);
 
+    emul_manager->set_dynarec(args.dynarec);
     emul_manager->init_cpu(0xC000);
 
-    if(args.game_genie) {
-        game_genie_code = std::string(args.game_genie);
-        emul_manager->set_game_genie(game_genie_code);
-    }
-
     std::printf("CPU initialization : OK\n");
     std::fflush(NULL);
 
@@ -166,34 +290,145 @@ int main(int argc, char *argv[]) {
     std::printf("Emulation initialization : OK\n");
     std::fflush(NULL);
 
+    if(args.instruction_trace) {
+        // from the reset
+        ftrace = fopen(args.instruction_trace, "wb");
+        if(!ftrace) {
+            std::printf("Error while opening instruction trace.\n");
+            return 1;
+        }
+        emul_manager->start_instruction_trace(ftrace);
+    }
+    if(args.profile_output) emul_manager->start_profiling();
+    if(args.cdl_file) {
+        // logs of previous runs are kept
+        FILE *fcdl = fopen(args.cdl_file, "rb");
+        if(emul_manager->start_cdl(fcdl) < 0) std::printf("%s is not a code/data log of this game, it will be replaced\n", args.cdl_file);
+        if(fcdl) fclose(fcdl);
+    }
+    for(auto spec : args.breakpoints) {
+        try {
+            emul_manager->add_breakpoint(std::string(spec));
+        } catch(const IncorrectFileFormat &e) {
+            std::printf("%s : %s. Skipping it\n", spec, e.what());
+        }
+    }
+
     emul_manager->reset_emulation_loop();
+
+    if(args.movie_play) {
+        fmovie = fopen(args.movie_play, "rb");
+        if(!fmovie || emul_manager->start_movie_playback(fmovie) < 0) {
+            std::printf("Error while opening movie file.\n");
+            return 1;
+        }
+        fclose(fmovie);
+    }
+    else if(args.movie_record) {
+        fmovie = fopen(args.movie_record, "wb");
+        if(!fmovie) {
+            std::printf("Error while opening movie file.\n");
+            return 1;
+        }
+        emul_manager->start_movie_recording(fmovie);
+    }
+
+    if(args.hash_log) {
+        fhash_log = fopen(args.hash_log, "w");
+        if(!fhash_log) {
+            std::printf("Error while opening state hashes log.\n");
+            return 1;
+        }
+        emul_manager->set_hash_log(fhash_log);
+    }
+    if(args.trace_frame) emul_manager->set_trace_frame(args.trace_frame);
+
+    if(args.headless) emul_manager->set_frame_pacing(false);
+    else emul_manager->start_deferred_presentation();
     
         // main emulation loop
 
         //std::printf("loop : %d\n", nr_loops);
         //std::fflush(NULL);
-    do {
+    emulation_status status = emulation_status::RUNNING;
+    if(!args.headless) {
+        emul_manager->set_low_latency_input(args.low_latency);
+        status = run_threaded_emulation(emul_manager, args);
+    }
+    else do {
         try
         {
-            check_keys(emul_manager);
             emul_manager->one_emulation_loop();
+            if(run_finished(emul_manager, args)) status = emulation_status::FINISHED;
         }
         catch(const ExitedGame& e)
         {
-            // this is done to avoid endless "Window has stopped responding"
-            SDL_SetHint(SDL_HINT_VIDEO_X11_NET_WM_PING, "0");
-            emul_manager->draw_visual_debug_information();
-            if(args.cli_debug) emul_manager->enter_debug_cli();
-            
-            break;
+            status = emulation_status::EXITED;
         }
         catch(const CPUHalted& e)
         {
-            std::printf("CPU Halted after %d cycles\n", emul_manager->get_cpu_cycles());
-            break;
+            status = emulation_status::HALTED;
         }
-    } while(true);
+    } while(status == emulation_status::RUNNING);
+
+    if(args.movie_record) {
+        emul_manager->stop_movie();
+        fclose(fmovie);
+    }
+    if(fhash_log) {
+        emul_manager->set_hash_log(nullptr);
+        fclose(fhash_log);
+    }
+    if(ftrace) {
+        emul_manager->stop_instruction_trace();
+        fclose(ftrace);
+    }
+    if(args.profile_output) {
+        std::string folded_path = std::string(args.profile_output) + ".folded";
+        FILE *freport = fopen(args.profile_output, "w");
+        FILE *ffolded = fopen(folded_path.c_str(), "w");
+        if(!freport || !ffolded) std::printf("Error while opening the profile files.\n");
+        emul_manager->stop_profiling(freport, ffolded);
+        if(freport) fclose(freport);
+        if(ffolded) fclose(ffolded);
+    }
 
+    if(status == emulation_status::FINISHED) {
+        std::printf("Frame %u : RAM hash %016llx, frame hash %016llx\n", emul_manager->get_frame_count(),
+                    (unsigned long long)emul_manager->hash_ram(), (unsigned long long)emul_manager->hash_frame());
+        if(args.cli_debug) emul_manager->enter_debug_cli();
+    }
+    else if(status == emulation_status::EXITED && !args.headless) {
+        // this is done to avoid endless "Window has stopped responding"
+        SDL_SetHint(SDL_HINT_VIDEO_X11_NET_WM_PING, "0");
+        emul_manager->draw_visual_debug_information();
+        if(args.cli_debug) emul_manager->enter_debug_cli();
+    }
+    else if(status == emulation_status::HALTED) {
+        std::printf("CPU Halted after %d cycles\n", emul_manager->get_cpu_cycles());
+    }
+
+    // after the debug cli, which can show it (or stop it)
+    if(args.cdl_file && emul_manager->is_cdl_running()) {
+        FILE *fcdl = fopen(args.cdl_file, "wb");
+        if(!fcdl) std::printf("Error while opening the code/data log.\n");
+        emul_manager->stop_cdl(fcdl);
+        if(fcdl) fclose(fcdl);
+    }
+
+    if(args.latency_output) {
+        FILE *flatency = fopen(args.latency_output, "w");
+        if(flatency) {
+            emul_manager->export_latency_histograms(flatency);
+            fclose(flatency);
+        }
+        else std::printf("Could not open %s to write latency histograms\n", args.latency_output);
+    }
+
+    if(args.headless) {
+        delete emul_manager;
+        return 0;
+    }
     
     SDL_pause();
 
@@ -1,5 +1,6 @@
 #include <string>
 #include "emulation_manager.hpp"
+#include "exceptions.hpp"
 
 #define CHECK_BOUNDS(val, min_, max_, val_name)                         \
 if(val < min_ || val > max_) {                                          \
@@ -33,6 +34,15 @@ void print_oam_entry(struct OAMentry &sprite) {
     if(sprite.attr & 0x80) printf("Flip vertically\n");
 }
 
+static const struct {
+    const char      *name;
+    RAM_SEARCH_OP   op;
+} ram_search_ops[] = {
+    {"eq", RAM_SEARCH_OP::EQUAL}, {"ne", RAM_SEARCH_OP::NOT_EQUAL},
+    {"lt", RAM_SEARCH_OP::LESS}, {"gt", RAM_SEARCH_OP::GREATER},
+    {"le", RAM_SEARCH_OP::LESS_EQUAL}, {"ge", RAM_SEARCH_OP::GREATER_EQUAL}
+};
+
 void EmulationManager::enter_debug_cli() {
     bool continuer = true;
     string user_input = "";
@@ -43,10 +53,12 @@ void EmulationManager::enter_debug_cli() {
     printf("=-=-=-=-=-=-=-=-=-=-=-=-=\n");
     printf("   EMULATION MANAGER\n");
     printf("       DEBUG CLI\n");
+    if(at_breakpoint) printf("(q goes on with the emulation)\n");
 
     while(continuer) {
         cout << "\n>>> ";
-        getline(cin, user_input);
+        // end of the input (scripted runs) : same as q
+        if(!getline(cin, user_input)) break;
         cout << endl;
         tokens = tokenise(user_input);
 
@@ -185,6 +197,10 @@ void EmulationManager::enter_debug_cli() {
         }
 
         else if(!command.compare("cpustep")) {
+            if(at_breakpoint) {
+                printf("Stopped at a breakpoint, quit to go on with the emulation\n");
+                continue;
+            }
             if(tokens.size() > 2) {
                  printf("Bad usage : cpustep [nr_steps]?\n");
                 continue;
@@ -196,6 +212,137 @@ void EmulationManager::enter_debug_cli() {
             }
         }
 
+        // emulate frames, with the usual inputs (keyboard or movie)
+        else if(!command.compare("run")) {
+            if(at_breakpoint) {
+                printf("Stopped at a breakpoint, quit to go on with the emulation\n");
+                continue;
+            }
+            if(tokens.size() > 2) {
+                printf("Bad usage : run [nr_frames]?\n");
+                continue;
+            }
+            arg1 = (tokens.size() > 1)? stoi(tokens[1]) : 1;
+            CHECK_BOUNDS(arg1, 0, 1000000, "nr_frames");
+            try {
+                for(int i=0; i<arg1; i++) one_emulation_loop();
+            }
+            catch(const ExitedGame& e) {}
+            catch(const CPUHalted& e) {
+                printf("CPU Halted\n");
+            }
+            printf("Frame %u\n", frame_count);
+        }
+
+        // RAM search : rsnew, then rs after each change in the game, until few candidates remain
+        else if(!command.compare("rsnew")) {
+            ram_search.reset(new RamSearch(cpu_mem->get_ram(), rom_mem->get_prg_ram()));
+            printf("%u candidates\n", ram_search->get_nr_candidates());
+        }
+
+        else if(!command.compare("rs")) {
+            if(tokens.size() < 2 || tokens.size() > 3 || !ram_search) {
+                printf("Bad usage (after rsnew) : rs [eq | ne | lt | gt | le | ge] [value]?\n");
+                printf("                          rs [inc | dec] [delta]?\n");
+                printf("Without value, bytes are compared to the previous rs\n");
+                continue;
+            }
+            bool against_previous = (tokens.size() == 2);
+            arg1 = (tokens.size() == 3)? stoi(tokens[2], 0, 0) : 0;
+            CHECK_BOUNDS(arg1, 0, 0xFF, "value");
+            RAM_SEARCH_OP op;
+            bool found = false;
+            if(!tokens[1].compare("inc") || !tokens[1].compare("dec")) {
+                // by any amount, or exactly delta (wrapping around)
+                bool inc = !tokens[1].compare("inc");
+                if(tokens.size() == 2) op = (inc)? RAM_SEARCH_OP::GREATER : RAM_SEARCH_OP::LESS;
+                else {
+                    op = RAM_SEARCH_OP::EQUAL;
+                    if(!inc) arg1 = (0x100 - arg1) & 0xFF;
+                }
+                against_previous = true;
+                found = true;
+            }
+            for(auto &o : ram_search_ops) {
+                if(!tokens[1].compare(o.name)) {
+                    op = o.op;
+                    found = true;
+                }
+            }
+            if(!found) {
+                printf("Unknown comparison %s\n", tokens[1].c_str());
+                continue;
+            }
+            printf("%u candidates\n", ram_search->filter(op, against_previous, arg1));
+            ram_search->print_candidates(stdout, 16);
+        }
+
+        else if(!command.compare("rslist")) {
+            if(!ram_search) {
+                printf("No RAM search, start one with rsnew\n");
+                continue;
+            }
+            ram_search->print_candidates(stdout, (tokens.size() > 1)? stoi(tokens[1]) : 256);
+        }
+
+        // breakpoints : break exec C000, break write 0300-03FF if value > 9...
+        else if(!command.compare("break")) {
+            if(tokens.size() < 3) {
+                printf("Bad usage : break [exec | read | write | rw | ppuread | ppuwrite | ppurw] addr[-last](hex) [if condition]?\n");
+                printf("Conditions are C expressions of a, x, y, s, p, pc, addr, value and [addr] (CPU memory)\n");
+                continue;
+            }
+            try {
+                unsigned int id = add_breakpoint(user_input.substr(user_input.find(' ') + 1));
+                printf("Breakpoint %u\n", id);
+            } catch(const IncorrectFileFormat &e) {
+                printf("%s\n", e.what());
+            }
+        }
+
+        else if(!command.compare("breaks")) {
+            if(breakpoints) breakpoints->print(stdout);
+            else printf("No breakpoints\n");
+        }
+
+        else if(!command.compare("delete")) {
+            if(tokens.size() != 2) {
+                printf("Bad usage : delete breakpoint_nr\n");
+                continue;
+            }
+            if(!breakpoints || !breakpoints->remove(stoi(tokens[1]))) printf("No breakpoint %s\n", tokens[1].c_str());
+        }
+
+        // code/data log : cdlstart, then cdl for how much of the ROM was used so far
+        else if(!command.compare("cdlstart")) {
+            if(cdl) printf("Already logging\n");
+            else start_cdl(nullptr);
+        }
+
+        else if(!command.compare("cdl")) {
+            if(cdl) cdl->print_summary(stdout);
+            else printf("No code/data log, start one with cdlstart\n");
+        }
+
+        else if(!command.compare("cdlstop")) {
+            // the running instructions log into it
+            if(at_breakpoint) {
+                printf("Stopped at a breakpoint, quit to go on with the emulation\n");
+                continue;
+            }
+            if(tokens.size() > 2) {
+                printf("Bad usage : cdlstop [file.cdl]?\n");
+                continue;
+            }
+            FILE *f = nullptr;
+            if(tokens.size() == 2 && !(f = fopen(tokens[1].c_str(), "wb"))) {
+                printf("Could not open %s\n", tokens[1].c_str());
+                continue;
+            }
+            stop_cdl(f);
+            if(f) fclose(f);
+        }
+
         else if(!command.compare("ppurender")) {
             ppu_render->render();
             ppu_render->draw_debug_tiles_grid(1);
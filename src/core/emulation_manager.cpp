@@ -2,17 +2,26 @@
 #include <chrono>
 #include <thread>
 #include <future>
+#include <cmath>
 #include "exceptions.hpp"
 #include "emulation_manager.hpp"
-
-EmulationManager::EmulationManager(sdl_context *ctx) : sdl_ctx(ctx), cpu(nullptr), cpu_mem(nullptr), ppu_mem(nullptr), ppu_state(nullptr), 
-                                                        ppu_render(nullptr), rom_mem(nullptr), devices(nullptr), loop_duration(0.026)
+#include "hash.hpp"
+#include "nes_loaders/rom_db.hpp"
+
+EmulationManager::EmulationManager(sdl_context *ctx) : cpu(nullptr), rom_mem(nullptr), cpu_mem(nullptr), sdl_ctx(ctx), ppu_mem(nullptr),
+                                                        ppu_state(nullptr), ppu_render(nullptr), devices(nullptr),
+                                                        debug_output(stdout), frame_count(0), frame_pacing(true), movie_mode(MOVIE_MODE::NONE),
+                                                        movie_output(nullptr), movie_frame(0), movie_over(false),
+                                                        hash_log(nullptr), trace_frame(0), tracing(false),
+                                                        at_breakpoint(false), battery_dir("."), loop_duration(0.026)
 {
     current_save_state.cpu_mem = nullptr; current_save_state.ppu_mem = nullptr; current_save_state.ppu_state = nullptr; current_save_state.rom_mem = nullptr;
 }
 
 EmulationManager::~EmulationManager()
 {
+    // last battery save write
+    battery_save.reset();
     // probably destroy things ?
     delete cpu;
     delete cpu_mem;
@@ -55,46 +64,118 @@ int EmulationManager::open_nes(FILE *fnes) {
         std::printf("Memory allocation error on constructing game data: %s\n", e.what()); return -1;
     }
 
+    rom_crc = rom_crc32(nes_data);
+    rom_sha.clear();
+    const struct rom_db_entry *known = rom_db_lookup(rom_crc);
+    if(known) {
+        std::printf("Known game : %s (crc32 %08X)\n", known->name, rom_crc);
+        if(rom_db_correct_header(nes_data, known)) nes_header = nes_data.header;
+    } else {
+        std::printf("Unknown game (crc32 %08X)\n", rom_crc);
+    }
+
     return 0;
 }
 
+const std::string &EmulationManager::get_rom_sha1() {
+    if(rom_sha.empty()) rom_sha = rom_sha1(nes_data);
+    return rom_sha;
+}
+
 int EmulationManager::init_devices() {
     if(devices) delete devices.get();
     devices = std::make_shared<DevicesManager>();
     devices->set_automatic_poll_empty(true);
     keys_manager = std::make_shared<SDL_Events_Manager>(devices);
     devices->keyboards_manager = keys_manager;
+    return 0;
 }
 
 int EmulationManager::init_rom() {
+    // the last write of the previous game reads its RAM
+    battery_save.reset();
     if(rom_mem) delete rom_mem;
     rom_mem = mapper_resolve(&nes_header, &nes_data);
     if(!rom_mem) {
         throw MemAllocFailed("Rom memory initialization failed\n");
     }
+
+    if(nes_header.BB_PRG_RAM) {
+        battery_save.reset(new BatterySave(battery_dir + "/" + get_rom_sha1() + ".sav", PRG_RAM_SIZE));
+        if(battery_save->load(rom_mem->get_prg_ram())) std::printf("Battery save loaded from %s\n", battery_save->get_path().c_str());
+        battery_save->set_ram(rom_mem->get_prg_ram());
+        rom_mem->set_prg_ram_changes(battery_save->get_changes());
+        battery_save->start_thread();
+    }
+    update_cheats();
     return 0;
 }
 
+void EmulationManager::update_cheats() {
+    cheats.reset();
+    if(!game_genie_codes.empty()) {
+        cheats = std::make_shared<CheatPatches>(game_genie_codes, nes_data.PRG_ROM_data,
+                                                nes_data.PRG_ROM_size / PRG_BANK_SIZE);
+    }
+    if(rom_mem) rom_mem->set_cheats(cheats);
+    // instructions of the previous patched banks
+    if(cpu) cpu->clear_decoded_pages();
+    if(dynarec) dynarec->flush();
+}
+
+void EmulationManager::add_game_genie(const std::string &genie_code) {
+    GameGenieCode code = game_genie_decode(genie_code);
+    if(code.has_compare) {
+        std::printf("Game Genie : addr : 0x%04X data : 0x%02X compare : 0x%02X\n", code.addr, code.data, code.compare);
+    } else {
+        std::printf("Game Genie : addr : 0x%04X data : 0x%02X\n", code.addr, code.data);
+    }
+    game_genie_codes.push_back(code);
+    update_cheats();
+}
+
+void EmulationManager::clear_game_genie() {
+    game_genie_codes.clear();
+    update_cheats();
+}
+
 int EmulationManager::init_cpu(MEMADDR init_pc) {
     if(cpu_mem) delete cpu_mem;
-    cpu_mem = new NESMemory(rom_mem);
     if(cpu) delete cpu;
-    cpu     = new cpu6502(cpu_mem);
+    // devirtualized CPU and memory map for the mapper
+    cpu     = core_resolve(&nes_header, rom_mem, &cpu_mem);
     cpu->init_cpu(init_pc);
     cpu_mem->cpu = cpu;
     cpu_mem->devices = devices;
+    rom_mem->set_cpu(cpu);
+    cpu->set_dynarec(dynarec.get());
 
     return 0;
 }
 
+void EmulationManager::set_dynarec(bool val) {
+    if(val && !dynarec) {
+        dynarec.reset(new Dynarec());
+        if(!dynarec->is_available()) {
+            std::printf("Dynarec not available on this system, the CPU is interpreted\n");
+            dynarec.reset();
+        }
+    } else if(!val) {
+        dynarec.reset();
+    }
+    if(cpu) cpu->set_dynarec(dynarec.get());
+}
+
 int EmulationManager::init_ppu() {
     if(ppu_state) delete ppu_state;
     ppu_state = new PPU_state;
     if(ppu_mem) delete ppu_mem;
     ppu_mem = new PPU_mem(ppu_state);
-    ppu_mem->rom = rom_mem;
+    ppu_mem->set_rom(rom_mem);
     if(ppu_render) delete ppu_render;
-    ppu_render = new PPU_Render(sdl_ctx, ppu_mem, ppu_state, cpu);
+    if(!presenter) presenter.reset(new FramePresenter(sdl_ctx));
+    presenter->set_latency_probe(latency_probe.get());
+    ppu_render = new PPU_Render(sdl_ctx, ppu_mem, ppu_state, cpu, presenter.get());
 
     cpu_mem->ppu_mem = ppu_mem;
 
@@ -115,6 +196,7 @@ int EmulationManager::init_ppu() {
 
     ppu_mem->set_screen_miroring((screen_miroring)(nes_header.SCREEN_MIRRORING));
     // TODO : if(nes_header->FOUR_SCREENS) ppu_mem->set_screen_miroring(MIRORING_FOUR);
+    rom_mem->set_ppu_mem(ppu_mem);
     ppu_mem->cpu = cpu;
 
     ppu_render->set_debug_mode(PPU_DEBUG_MODE::NONE);
@@ -124,8 +206,26 @@ int EmulationManager::init_ppu() {
 }
 
 BOOL EmulationManager::execute_cpu_cycles(UINT32 nr_cycles) {
-    cpu6502::execute_cycles_res res = cpu->execute_cycles(nr_cycles);
-    cpu->wait_cycles(res.cycles);
+    bool breaking = breakpoints && !breakpoints->empty();
+    // the memory objects change with the save states
+    if(breaking) breakpoints->set_memory(cpu_mem->get_ram(), rom_mem, ppu_mem, ppu_state);
+    int nr_sinks = breaking + tracing + !!trace_writer + !!profiler + !!cdl;
+    if(nr_sinks > 1) {
+        cpu6502::trace_sinks sinks;
+        sinks.debug_s = (tracing)? debug_output : nullptr;
+        sinks.writer = trace_writer.get();
+        sinks.profiler = profiler.get();
+        sinks.breakpoints = (breaking)? breakpoints.get() : nullptr;
+        sinks.cdl = cdl.get();
+        return cpu->execute_cycles_sinks(nr_cycles, sinks).ppu_dirty;
+    }
+    // a single one is cheaper with its own policy
+    cpu6502::execute_cycles_res res = (breaking)? cpu->execute_cycles_breakpoints(nr_cycles, breakpoints.get())
+                                    : (tracing)? cpu->execute_cycles_debug(nr_cycles, debug_output, 0)
+                                    : (trace_writer)? cpu->execute_cycles_traced(nr_cycles, trace_writer.get())
+                                    : (profiler)? cpu->execute_cycles_profiled(nr_cycles, profiler.get())
+                                    : (cdl)? cpu->execute_cycles_cdl(nr_cycles, cdl.get())
+                                    : cpu->execute_cycles(nr_cycles);
     return res.ppu_dirty;
 }
 
@@ -172,9 +272,15 @@ NES Execution Functions
 */
 
 void EmulationManager::BeginFrame() {
+    frame_count++;
+    if(latency_probe) latency_probe->begin_frame(frame_count);
+    if(movie_mode != MOVIE_MODE::NONE) movie_begin_frame();
+    tracing = trace_frame && frame_count == trace_frame;
+    if(trace_writer) trace_writer->set_frame(frame_count);
+    if(tracing) std::fprintf(debug_output, "==== Trace of frame %u\n", frame_count);
     cpu->reset_cycles();
     cpu->set_return_on_ppu(1);
-    ppu_render->ppu_begin_frame();
+    ppu_render->ppu_begin_frame(frame_count);
     frame_start_time = std::chrono::high_resolution_clock::now();
 }
 
@@ -183,24 +289,47 @@ void EmulationManager::BeginVBlank() {
 }
 
 void EmulationManager::EndFrame() {
+    if(hash_log) log_state_hash();
+    if(ram_search) ram_search->snapshot(cpu_mem->get_ram(), rom_mem->get_prg_ram());
+    tracing = false;
+    if(!frame_pacing) return;
     // real time synchronization
     double sec_elapsed = (std::chrono::high_resolution_clock::now() - frame_start_time).count() / 1e9;
     double to_wait = loop_duration - sec_elapsed;
     if(to_wait > 0.002) preciseSleep(to_wait);
 }
 
+void EmulationManager::handle_sp_actions() {
+    EMU_SP_ACTIONS action;
+    while(keys_manager->pop_sp_action(&action)) {
+        switch(action) {
+        case EMU_SP_ACTIONS::SAVE_STATE:
+            save_state();
+            break;
+        case EMU_SP_ACTIONS::RESTORE_STATE:
+            restore_state();
+            break;
+        default:
+            break;
+        }
+    }
+}
+
 int EmulationManager::one_emulation_loop() {
     BOOL should_sync_ppu;
 
     keys_manager->sdl_handle_poll();
+    handle_sp_actions();
 
     BeginFrame();
 
     // rendering part !
+    if(rom_mem->watches_ppu_a12()) execute_rendering_by_scanlines();
     while(cpu->get_cycles() < 27508) {
-        should_sync_ppu = execute_cpu_cycles(27508); // try to execute all cpu cycles (will probably end before)
+        should_sync_ppu = execute_cpu_cycles(27508 - cpu->get_cycles()); // try to execute all cpu cycles (will probably end before)
         if(should_sync_ppu) {
             ppu_render->ppu_execute_up_to(cpu->get_cycles() * 3);
+            skip_ppu_polling(27508);
         }
     }
 
@@ -209,9 +338,189 @@ int EmulationManager::one_emulation_loop() {
     BeginVBlank();
 
     // only execute cpu, no pressure for cpu/ppu sync
-    execute_cpu_cycles(2272);
+    execute_cpu_cycles(27508 + 2272 - cpu->get_cycles());
 
     EndFrame();
+    return 0;
+}
+
+void EmulationManager::execute_rendering_by_scanlines() {
+    // A12 rises at tick 260 or 324 of each line (see PPU_Render::a12_fetch_point), and the
+    // frame starts with the pre render line
+    static const UINT32 a12_ticks[2] = {261, 325};
+    for(UINT32 line = 0; line < 242; line++) {
+        for(int point = 0; point < 2; point++) {
+            UINT32 target = (line * 341 + a12_ticks[point] + 2) / 3;
+            if(target > 27508) return;
+            while(cpu->get_cycles() < target) {
+                execute_cpu_cycles(target - cpu->get_cycles());
+                ppu_render->ppu_execute_up_to(cpu->get_cycles() * 3);
+                skip_ppu_polling(target);
+            }
+        }
+    }
+}
+
+void EmulationManager::skip_ppu_polling(UINT32 end) {
+    UINT32 period = cpu->get_idle_loop_period();
+    if(!period || tracing || trace_writer || profiler || (breakpoints && !breakpoints->empty())) return;
+    // the interrupts the PPU raises are taken after the read, as without skipping
+    UINT8 status = ppu_mem->get_last_status();
+    while(ppu_mem->peek_PPUSTATUS() == status && !(status & 0x80)) {
+        UINT32 next = cpu->get_cycles() + period;
+        if(next >= end || next >= cpu->get_interrupt_deadline()) return;
+        cpu->skip_idle_iterations(1);
+        ppu_render->ppu_execute_up_to(next * 3);
+    }
+}
+
+/* ============ MOVIES ============== */
+
+void EmulationManager::start_movie_recording(FILE *f) {
+    stop_movie();
+    movie.reset(new InputMovie(devices->get_nr_devices()));
+    movie_output = f;
+    movie_mode = MOVIE_MODE::RECORDING;
+    movie_frame = 0;
+    movie_over = false;
+    devices->set_frame_latched_input(true);
+}
+
+int EmulationManager::start_movie_playback(FILE *f) {
+    stop_movie();
+    try {
+        movie.reset(InputMovie::load(f));
+    }
+    catch(const FileReadingError& e) {
+        std::printf("Reading error on loading input movie: %s\n", e.what()); return -1;
+    }
+    catch(const IncorrectFileFormat& e) {
+        std::printf("FileFormat error on loading input movie: %s\n", e.what()); return -1;
+    }
+    movie_mode = MOVIE_MODE::PLAYBACK;
+    movie_frame = 0;
+    movie_over = false;
+    devices->set_frame_latched_input(true);
+    return 0;
+}
+
+void EmulationManager::stop_movie() {
+    if(movie_mode == MOVIE_MODE::RECORDING && movie_output) {
+        movie->save(movie_output);
+        std::printf("Input movie saved : %u frames\n", movie->get_nr_frames());
+    }
+    movie_mode = MOVIE_MODE::NONE;
+    movie_output = nullptr;
+    movie.reset();
+    devices->set_frame_latched_input(false);
+}
+
+void EmulationManager::movie_begin_frame() {
+    UINT8 buttons[INPUT_MOVIE_MAX_DEVICES] = {0};
+    UINT8 nr_devices = movie->get_nr_devices();
+
+    if(movie_mode == MOVIE_MODE::RECORDING) {
+        devices->latch_frame_input();
+        for(UINT8 d = 0; d < nr_devices; d++) buttons[d] = devices->get_device_buttons(d);
+        movie->record_frame(buttons);
+    }
+    else {
+        // the host input is ignored
+        devices->discard_pending_keys();
+        movie->get_frame(movie_frame, buttons);
+        for(UINT8 d = 0; d < nr_devices; d++) devices->set_device_buttons(d, buttons[d]);
+    }
+    movie_frame++;
+    // the last frame of the movie is being emulated
+    if(movie_mode == MOVIE_MODE::PLAYBACK && movie_frame >= movie->get_nr_frames()) movie_over = true;
+}
+
+/* ============ HASHES ============== */
+
+UINT64 EmulationManager::hash_ram() {
+    return hash64(cpu_mem->get_ram(), RAM_SIZE);
+}
+
+UINT64 EmulationManager::hash_frame() {
+    return hash64(presenter->get_last_published(), FRAME_WIDTH*FRAME_HEIGHT*sizeof(UINT32));
+}
+
+UINT64 EmulationManager::hash_cpu() {
+    cpu6502::cpu6502regs r = cpu->get_cpu_regs();
+    cpu6502::cpu6502flags f = cpu->get_cpu_flags();
+    // flags are only considered set or not
+    UINT8 state[7] = {(UINT8)r.PC, (UINT8)(r.PC >> 8), r.A, r.X, r.Y, r.S,
+                      (UINT8)((f.C? 0x01 : 0) | (f.Z? 0x02 : 0) | (f.I? 0x04 : 0) | (f.D? 0x08 : 0) |
+                              (f.V? 0x40 : 0) | (f.N? 0x80 : 0))};
+    return hash64(state, sizeof(state));
+}
+
+UINT64 EmulationManager::hash_oam() {
+    return hash64(ppu_mem->get_oam_entry(0), 64*sizeof(struct OAMentry));
+}
+
+UINT64 EmulationManager::hash_nametables() {
+    return hash64(ppu_mem->get_nt(), 4*sizeof(PPU_NT));
+}
+
+void EmulationManager::log_state_hash() {
+    UINT64 h[5] = {hash_cpu(), hash_ram(), hash_oam(), hash_nametables(), hash_frame()};
+    std::fprintf(hash_log, "%u %016llx cpu=%016llx ram=%016llx oam=%016llx nt=%016llx fb=%016llx\n", frame_count,
+        (unsigned long long)hash64(h, sizeof(h)), (unsigned long long)h[0], (unsigned long long)h[1],
+        (unsigned long long)h[2], (unsigned long long)h[3], (unsigned long long)h[4]);
+}
+
+/* ============ LATENCY ============== */
+
+void EmulationManager::enable_latency_probe() {
+    if(!latency_probe) latency_probe.reset(new LatencyProbe);
+    devices->set_latency_probe(latency_probe.get());
+    if(presenter) presenter->set_latency_probe(latency_probe.get());
+}
+
+void EmulationManager::export_latency_histograms(FILE *f) {
+    if(latency_probe) latency_probe->export_histograms(f);
+}
+
+unsigned int EmulationManager::add_breakpoint(const std::string &spec) {
+    if(!breakpoints) {
+        breakpoints.reset(new Breakpoints());
+        breakpoints->set_handler(on_breakpoint, this);
+    }
+    return breakpoints->add(spec);
+}
+
+void EmulationManager::on_breakpoint(void *ctx, const breakpoint &b, UINT8 kind, const break_context &c) {
+    static const char *kind_names[] = {"execution", "read", "write", "PPU read", "PPU write"};
+    EmulationManager *em = static_cast<EmulationManager *>(ctx);
+    int k = 0;
+    while(!(kind & (1 << k))) k++;
+    std::printf("Breakpoint %u, frame %u, PC $%04X : %s", b.id, em->frame_count, c.PC, kind_names[k]);
+    if(kind != BREAK_EXEC) std::printf(" of $%04X, value $%02X", c.addr, c.value);
+    std::printf("\n");
+    em->at_breakpoint = true;
+    em->enter_debug_cli();
+    em->at_breakpoint = false;
+}
+
+int EmulationManager::start_cdl(FILE *f) {
+    cdl.reset(new CodeDataLogger(nes_data.PRG_ROM_size, nes_data.CHR_ROM_size));
+    cdl->attach(rom_mem, ppu_mem, ppu_state, cpu_mem->get_ram());
+    return (f)? cdl->load(f) : 0;
+}
+
+void EmulationManager::stop_cdl(FILE *f) {
+    if(!cdl) return;
+    if(f) cdl->save(f);
+    cdl->detach(ppu_mem);
+    cdl.reset();
+}
+
+void EmulationManager::stop_profiling(FILE *report, FILE *folded) {
+    if(!profiler) return;
+    if(report) profiler->write_report(report, 50);
+    if(folded) profiler->write_folded(folded);
+    profiler.reset();
 }
 
 /* ============ SAVE STATE ============== */
@@ -239,6 +548,7 @@ void EmulationManager::save_state() {
 
 void EmulationManager::restore_state() {
     std::printf("Restoring state...");
+    if(battery_save) battery_save->set_ram(nullptr);
     delete rom_mem;
 
     // we copy rom mem from the save state
@@ -247,6 +557,15 @@ void EmulationManager::restore_state() {
     delete cpu_mem;
     cpu_mem = current_save_state.cpu_mem->save_state();
     cpu_mem->memROM = rom_mem;
+    rom_mem->set_cpu(cpu);
+    // the state may have been saved with other codes
+    rom_mem->set_cheats(cheats);
+    // the battery RAM comes back with the state
+    rom_mem->set_prg_ram_changes(battery_save? battery_save->get_changes() : nullptr);
+    if(battery_save) {
+        battery_save->set_ram(rom_mem->get_prg_ram());
+        battery_save->ram_changed();
+    }
     cpu->restore_state(current_save_state.cpu);
 
     cpu->set_cpu_mem(cpu_mem);
@@ -261,13 +580,15 @@ void EmulationManager::restore_state() {
     ppu_mem = new PPU_mem(*(current_save_state.ppu_mem));
 
     ppu_mem->ppu_state = ppu_state;
-    ppu_mem->rom = rom_mem;
+    ppu_mem->set_rom(rom_mem);
+    rom_mem->set_ppu_mem(ppu_mem);
     cpu_mem->ppu_mem = ppu_mem;
     
     delete ppu_render;
-    ppu_render = new PPU_Render(sdl_ctx, ppu_mem, ppu_state, cpu);
+    ppu_render = new PPU_Render(sdl_ctx, ppu_mem, ppu_state, cpu, presenter.get());
     ppu_render->ppu_render_restore_state(current_save_state.ppu_render);
     ppu_mem->cpu = cpu;
+    if(cdl) cdl->attach(rom_mem, ppu_mem, ppu_state, cpu_mem->get_ram());
     std::printf("OK\n");
 }
 
@@ -280,6 +601,8 @@ int EmulationManager::draw_visual_debug_information() {
     std::printf("*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*\n");
     std::printf("DEBUG INFORMATION EMULATION MANAGER\n");
     std::printf("*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*\n");
+    // debug drawings are done directly on the renderer
+    stop_deferred_presentation();
     ppu_render->set_debug_mode(PPU_DEBUG_MODE::SPRITE);
     one_emulation_loop();
     ppu_render->draw_debug_tiles_grid(1);
@@ -287,11 +610,13 @@ int EmulationManager::draw_visual_debug_information() {
     SDL_Window *palettes_window = open_palette_window(ppu_mem->BACKGROUND_palette, ppu_mem->SPRITE_palette, 50);
     ppu_mem->print_debug();
     std::printf("*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*\n");
+    return 0;
 }
 
 int EmulationManager::dump_cpu_history(FILE *s) {
     fprintf(s, "-------------------\n------ STACK DUMP -------\n");
     cpu_mem->dump_stack(s);
+    return 0;
 }
 
 
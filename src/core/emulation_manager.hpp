@@ -8,6 +8,15 @@
 #include "ppu_info.hpp"
 #include "ppu_render/ppu_render.hpp"
 #include "mappers/mapper_resolve.hpp"
+#include "latency_probe.hpp"
+#include "input_devices/input_movie.hpp"
+#include "battery_save.hpp"
+#include "ram_search.hpp"
+#include "dynarec.hpp"
+#include "trace.hpp"
+#include "profiler.hpp"
+#include "breakpoints.hpp"
+#include "cdl.hpp"
 
 
 class EmulationManager
@@ -28,6 +37,8 @@ private:
 
     struct nes_header           nes_header;
     struct nes_data             nes_data;
+    UINT32                      rom_crc;
+    std::string                 rom_sha; // computed when first asked
 
     cpu6502                     *cpu;
     ROMMemManager               *rom_mem;
@@ -36,6 +47,8 @@ private:
     PPU_mem                     *ppu_mem;
     PPU_state                   *ppu_state;
     PPU_Render                  *ppu_render;
+    std::unique_ptr<FramePresenter>
+                                presenter;
 
     std::shared_ptr<DevicesManager>
                                 devices;
@@ -44,12 +57,71 @@ private:
 
     FILE                        *debug_output;
 
+    UINT32                      frame_count;
+    bool                        frame_pacing;
+
+    enum class MOVIE_MODE {
+        NONE, RECORDING, PLAYBACK
+    };
+    MOVIE_MODE                  movie_mode;
+    std::unique_ptr<InputMovie> movie;
+    FILE                        *movie_output;
+    UINT32                      movie_frame;
+    bool                        movie_over;
+
+    void movie_begin_frame();
+
+    // per frame hashes of the state, and instruction trace of one frame
+    FILE                        *hash_log;
+    UINT32                      trace_frame;
+    bool                        tracing;
+    // binary trace of all the instructions
+    std::unique_ptr<TraceWriter>
+                                trace_writer;
+    // cycles counted per instruction, bank and routine
+    std::unique_ptr<Profiler>   profiler;
+
+    /* Checked by the CPU only while there are some. A hit enters the debug CLI, in
+    the middle of the frame, and quitting it goes on with the emulation */
+    std::unique_ptr<Breakpoints>
+                                breakpoints;
+    bool                        at_breakpoint;
+
+    // marks the PRG and CHR ROM bytes the game uses while it runs
+    std::unique_ptr<CodeDataLogger>
+                                cdl;
+    static void on_breakpoint(void *ctx, const breakpoint &b, UINT8 kind, const break_context &c);
+
+    void log_state_hash();
+
+    std::unique_ptr<LatencyProbe>
+                                latency_probe;
+
+    // PRG RAM of cartridges with a battery, saved as <rom sha1>.sav in battery_dir
+    std::unique_ptr<BatterySave>
+                                battery_save;
+    std::string                 battery_dir;
+
+    // Game Genie codes, compiled again against the PRG ROM when the list changes
+    std::vector<GameGenieCode>  game_genie_codes;
+    std::shared_ptr<CheatPatches>
+                                cheats;
+
+    void update_cheats();
+
+    // running RAM search of the debug CLI, snapshotted at each end of frame
+    std::unique_ptr<RamSearch>  ram_search;
+
+    std::unique_ptr<Dynarec>    dynarec;
+
     double                      loop_duration;
 
     std::chrono::_V2::
         system_clock::
         time_point              frame_start_time;
 
+    void handle_sp_actions();
+
 public:
 
     EmulationManager(sdl_context *ctx);
@@ -59,14 +131,25 @@ public:
 
     int open_nes(FILE *fnes);
     int init_devices(); // TODO : ways to customize it
+    // loads the battery save too, when the cartridge has one
     int init_rom();
+    void set_battery_directory(const char *dir) {battery_dir = dir;};
     int init_cpu(MEMADDR init_pc = 0);
+    // PRG ROM code translated to host code (x86-64), see dynarec.hpp. Traced frames are still interpreted
+    void set_dynarec(bool val);
     // should be called once init_cpu() is done
     int init_ppu();
     /*
     Returns whether ppu should be put up to date
     */
     BOOL execute_cpu_cycles(UINT32 nr_cycles);
+    /* Rendering part of the frame for mappers with scanline IRQs : the CPU is stopped
+    after each point where the PPU can clock the mapper, and the PPU is caught up */
+    void execute_rendering_by_scanlines();
+    /* After a PPU sync, when the CPU waits in a loop polling $2002 (see
+    cpu6502::get_idle_loop_period) : runs the PPU up to the read of each iteration,
+    and skips the ones which read the same value, before end */
+    void skip_ppu_polling(UINT32 end);
     int reset_emulation_loop();
     int draw_visual_debug_information();
     void set_ppu_render_debug_mode(PPU_DEBUG_MODE m) {ppu_render->set_debug_mode(m);};
@@ -74,10 +157,64 @@ public:
 
     void set_debug_output(FILE *foutput){debug_output = foutput;};
 
-    void set_game_genie(std::string &genie_code) {cpu_mem->set_game_genie(genie_code);};
-    void unset_game_genie() {cpu_mem->unset_game_genie();};
+    /* Should be called once init_rom() is done. Can throw:
+    - IncorrectFileFormat (invalid code) */
+    void add_game_genie(const std::string &genie_code);
+    void clear_game_genie();
     
     UINT32 get_cpu_cycles(){return cpu->get_cycles();};
+    // identification of the game (see rom_db.hpp), to key save files and per-game data
+    UINT32 get_rom_crc32(){return rom_crc;};
+    const std::string &get_rom_sha1();
+    UINT32 get_frame_count(){return frame_count;};
+
+    // should be called once init_devices() is done
+    void enable_latency_probe();
+    /* Frames are then uploaded and presented by the main thread, which owns the
+    renderer, while the emulation runs on another one and never waits for vsync.
+    The main thread calls present_frame() on the SDL events of type get_present_event().
+    Should be called once init_ppu() is done */
+    void start_deferred_presentation() {presenter->start_deferred();};
+    void stop_deferred_presentation() {presenter->stop_deferred();};
+    bool present_frame() {return presenter->present_deferred();};
+    UINT32 get_present_event() {return FramePresenter::get_wake_event();};
+    // without pacing, frames are emulated as fast as possible (headless runs)
+    void set_frame_pacing(bool val) {frame_pacing = val;};
+
+    /* Input movies : the controllers state is recorded, or replayed, once per frame.
+    Both should be started after reset_emulation_loop() to be replayed identically */
+    void start_movie_recording(FILE *f); // the movie is written to f by stop_movie()
+    int  start_movie_playback(FILE *f);
+    void stop_movie();
+    bool is_movie_over() {return movie_over;};
+
+    // hashes of the current state, to compare runs
+    UINT64 hash_ram();
+    UINT64 hash_frame();
+    UINT64 hash_cpu();
+    UINT64 hash_oam();
+    UINT64 hash_nametables();
+
+    /* Logs a line with the hashes of the state at the end of each frame, see hash_diff.cpp
+    to compare two logs */
+    void set_hash_log(FILE *f) {hash_log = f;};
+    // instructions of the given frame will be traced to the debug output
+    void set_trace_frame(UINT32 frame) {trace_frame = frame;};
+    /* Binary trace of all the instructions from now on to f (see trace.hpp and
+    trace_dump.cpp), until stop_instruction_trace(). f is not closed */
+    void start_instruction_trace(FILE *f) {trace_writer.reset(new TraceWriter(f));};
+    void stop_instruction_trace() {trace_writer.reset();};
+    /* Profile of the game from now on (see profiler.hpp). Stopping writes the report
+    and the folded stacks, when not NULL */
+    void start_profiling() {profiler.reset(new Profiler());};
+    void stop_profiling(FILE *report, FILE *folded);
+    /* Code/data log (see cdl.hpp), from now on. The flags of a previous log of the
+    game can be loaded from f (not closed), returns -1 when they don't fit the ROM */
+    int  start_cdl(FILE *f);
+    // writes the .cdl file to f (when not NULL), and stops logging
+    void stop_cdl(FILE *f);
+    bool is_cdl_running() {return cdl != nullptr;};
+    void export_latency_histograms(FILE *f);
 
 
     /* Functions most users will use are below */
@@ -88,11 +225,17 @@ public:
 
     int one_emulation_loop();
     void push_sdl_event(SDL_Event ev) {keys_manager->push_event(ev);};
+    void discard_sdl_events() {keys_manager->discard_pending_events();};
+    /* In low latency mode, joypads are sampled from a snapshot kept up to date by
+    push_sdl_event() when the game strobes $4016, instead of once per frame */
+    void set_low_latency_input(bool val) {devices->set_low_latency_input(val);};
 
     void save_state();
     void restore_state();
 
     void enter_debug_cli();
+    // see Breakpoints::add, throws IncorrectFileFormat
+    unsigned int add_breakpoint(const std::string &spec);
 
 
     // void debug_donkey_kong();
@@ -0,0 +1,78 @@
+#include <cstring>
+#include <cctype>
+#include "game_genie.hpp"
+#include "exceptions.hpp"
+
+#define GG_BANK_SIZE 0x2000
+#define GG_NR_SLOTS  4
+
+static const char game_genie_letters[16] = {'A', 'P', 'Z', 'L', 'G', 'I', 'T', 'Y', 'E', 'O', 'X', 'U', 'K', 'S', 'V', 'N'};
+
+static UINT8 game_genie_decode_tok(char c) {
+    c = toupper(c);
+    for(int i=0; i<16; i++) {
+        if(game_genie_letters[i] == c) return i;
+    }
+    throw IncorrectFileFormat("Incorrect Game Genie character");
+}
+
+GameGenieCode game_genie_decode(const std::string &code) {
+    if(code.size() != 6 && code.size() != 8) {
+        throw IncorrectFileFormat("Game Genie codes have 6 or 8 letters");
+    }
+    UINT8 n[8];
+    for(size_t i=0; i<code.size(); i++) n[i] = game_genie_decode_tok(code[i]);
+
+    GameGenieCode res;
+    res.addr = 0x8000 | ((n[3] & 7) << 12)
+                      | ((n[5] & 7) << 8) | ((n[4] & 8) << 8)
+                      | ((n[2] & 7) << 4) | ((n[1] & 8) << 4)
+                      | (n[4] & 7)        | (n[3] & 8);
+    res.data = ((n[1] & 7) << 4) | ((n[0] & 8) << 4) | (n[0] & 7);
+
+    if(code.size() == 6) {
+        res.data |= (n[5] & 8);
+        res.has_compare = 0;
+        res.compare = 0;
+    } else {
+        res.data |= (n[7] & 8);
+        res.has_compare = 1;
+        res.compare = ((n[7] & 7) << 4) | ((n[6] & 8) << 4) | (n[6] & 7) | (n[5] & 8);
+    }
+    return res;
+}
+
+CheatPatches::CheatPatches(const std::vector<GameGenieCode> &codes, const UINT8 *prg_data, unsigned int nr_prg_banks) :
+    nr_banks(nr_prg_banks), nr_patched(0), banks(GG_NR_SLOTS*nr_prg_banks, nullptr)
+{
+    // first pass to find the banks, so that the copies are allocated once
+    std::vector<int> copy_index(banks.size(), -1);
+    for(unsigned int slot=0; slot<GG_NR_SLOTS; slot++) {
+        for(unsigned int bank=0; bank<nr_banks; bank++) {
+            const UINT8 *rom = prg_data + bank*GG_BANK_SIZE;
+            for(auto &c : codes) {
+                if(((c.addr >> 13) & 3) != slot) continue;
+                if(c.has_compare && rom[c.addr & 0x1FFF] != c.compare) continue;
+                copy_index[slot*nr_banks + bank] = nr_patched++;
+                break;
+            }
+        }
+    }
+
+    data.resize((size_t)nr_patched * GG_BANK_SIZE);
+    for(unsigned int slot=0; slot<GG_NR_SLOTS; slot++) {
+        for(unsigned int bank=0; bank<nr_banks; bank++) {
+            int idx = copy_index[slot*nr_banks + bank];
+            if(idx < 0) continue;
+            UINT8 *copy = &data[(size_t)idx * GG_BANK_SIZE];
+            const UINT8 *rom = prg_data + bank*GG_BANK_SIZE;
+            std::memcpy(copy, rom, GG_BANK_SIZE);
+            for(auto &c : codes) {
+                if(((c.addr >> 13) & 3) != slot) continue;
+                if(c.has_compare && rom[c.addr & 0x1FFF] != c.compare) continue;
+                copy[c.addr & 0x1FFF] = c.data;
+            }
+            banks[slot*nr_banks + bank] = copy;
+        }
+    }
+}
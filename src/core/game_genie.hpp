@@ -0,0 +1,42 @@
+#ifndef GAYA_GAME_GENIE_HPP
+#define GAYA_GAME_GENIE_HPP
+
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+struct GameGenieCode {
+    MEMADDR     addr;           // $8000-$FFFF
+    UINT8       data;
+    BOOL        has_compare;    // 8 letters codes
+    UINT8       compare;        // the byte is only replaced when the ROM has this value
+};
+
+/* Can throw:
+- IncorrectFileFormat (wrong length or letter) */
+GameGenieCode game_genie_decode(const std::string &code);
+
+/*
+Game Genie codes compiled against the PRG ROM : a patched copy of every 8kb bank
+which a code applies to, for each slot it can be mapped in (a code patches a CPU
+address, and compare values depend on the bank under it). The mappers point
+their slots to these copies instead of the ROM when banks are mapped, so reads
+never check for cheats.
+*/
+class CheatPatches
+{
+public:
+    CheatPatches(const std::vector<GameGenieCode> &codes, const UINT8 *prg_data, unsigned int nr_prg_banks);
+
+    // patched copy of bank as seen in slot ($8000 + slot*8kb), or nullptr
+    UINT8                       *get_bank(UINT8 slot, unsigned int bank) {return banks[slot*nr_banks + bank];};
+    unsigned int                get_nr_patched_banks() {return nr_patched;};
+
+private:
+    unsigned int                nr_banks;
+    unsigned int                nr_patched;
+    std::vector<UINT8>          data;
+    std::vector<UINT8 *>        banks;
+};
+
+#endif
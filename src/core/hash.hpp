@@ -0,0 +1,55 @@
+#ifndef GAYA_HASH_HPP
+#define GAYA_HASH_HPP
+
+#include <cstring>
+#include <cstddef>
+#include "types.hpp"
+
+/*
+Fast non-cryptographic 64-bit hash, to compare emulation states between runs.
+Data is consumed 8 bytes at a time, with one multiply-rotate-multiply round each.
+Can be chained by giving the previous hash as seed.
+*/
+
+#define HASH64_PRIME1 0x9E3779B185EBCA87ULL
+#define HASH64_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define HASH64_PRIME3 0x165667B19E3779F9ULL
+
+static inline UINT64 hash64_rotl(UINT64 x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline UINT64 hash64_round(UINT64 h, UINT64 w) {
+    w *= HASH64_PRIME2;
+    w = hash64_rotl(w, 31);
+    w *= HASH64_PRIME1;
+    h ^= w;
+    return hash64_rotl(h, 27) * HASH64_PRIME1 + HASH64_PRIME3;
+}
+
+static inline UINT64 hash64(const void *data, size_t len, UINT64 seed = 0) {
+    const UINT8 *p = (const UINT8*) data;
+    UINT64 h = seed + HASH64_PRIME3 + len;
+    UINT64 w;
+
+    while(len >= 8) {
+        std::memcpy(&w, p, 8);
+        h = hash64_round(h, w);
+        p += 8; len -= 8;
+    }
+    if(len) {
+        w = 0;
+        std::memcpy(&w, p, len);
+        h = hash64_round(h, w);
+    }
+
+    // final avalanche
+    h ^= h >> 33;
+    h *= HASH64_PRIME2;
+    h ^= h >> 29;
+    h *= HASH64_PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+Compares two state hashes logs written by emul_core -S, and reports the
+first frame where emulation diverged, with the parts of the state which differ.
+
+    ./hash_diff a.log b.log
+
+Both runs should be fed the same input, for instance by playing the same movie
+headless (emul_core -H -p movie.gmv -S a.log rom.nes).
+Once the frame is known, both runs can be traced on this frame with -T, and the
+traces compared with:
+
+    ./hash_diff -t trace_a.txt trace_b.txt
+
+which reports the first instruction where they differ.
+
+Compile with `g++ -o hash_diff hash_diff.cpp`
+*/
+
+#define NR_PARTS 5
+
+struct hash_entry {
+    unsigned int frame;
+    unsigned long long hash;
+    unsigned long long parts[NR_PARTS];
+};
+
+static const char *parts_names[NR_PARTS] = {"cpu", "ram", "oam", "nt", "fb"};
+
+static bool read_hash_log(const char *path, std::vector<hash_entry> &entries) {
+    FILE *f = fopen(path, "r");
+    if(!f) {
+        std::printf("Could not open %s\n", path);
+        return false;
+    }
+    hash_entry e;
+    while(fscanf(f, "%u %llx cpu=%llx ram=%llx oam=%llx nt=%llx fb=%llx", &e.frame, &e.hash, &e.parts[0],
+                 &e.parts[1], &e.parts[2], &e.parts[3], &e.parts[4]) == 7) {
+        entries.push_back(e);
+    }
+    fclose(f);
+    return true;
+}
+
+static int compare_hash_logs(const char *path_a, const char *path_b) {
+    std::vector<hash_entry> a, b;
+    if(!read_hash_log(path_a, a) || !read_hash_log(path_b, b)) return 2;
+
+    size_t n = (a.size() < b.size())? a.size() : b.size();
+    for(size_t i = 0; i < n; i++) {
+        if(a[i].frame != b[i].frame) {
+            std::printf("Logs are not aligned : line %zu is frame %u in %s and %u in %s\n", i+1,
+                        a[i].frame, path_a, b[i].frame, path_b);
+            return 1;
+        }
+        if(a[i].hash != b[i].hash) {
+            std::printf("First divergent frame : %u\n", a[i].frame);
+            std::printf("Differing parts :");
+            for(int p = 0; p < NR_PARTS; p++) {
+                if(a[i].parts[p] != b[i].parts[p]) std::printf(" %s", parts_names[p]);
+            }
+            std::printf("\nTrace this frame in both runs with -T %u, then compare the traces with -t\n", a[i].frame);
+            return 1;
+        }
+    }
+
+    if(a.size() != b.size()) {
+        std::printf("Identical over %zu frames, but %s has %zu frames and %s has %zu\n", n,
+                    path_a, a.size(), path_b, b.size());
+        return 1;
+    }
+    std::printf("Identical over %zu frames\n", n);
+    return 0;
+}
+
+static bool read_line(FILE *f, std::string &line) {
+    char buf[256];
+    line.clear();
+    while(fgets(buf, sizeof(buf), f)) {
+        line += buf;
+        if(!line.empty() && line.back() == '\n') return true;
+    }
+    return !line.empty();
+}
+
+static int compare_traces(const char *path_a, const char *path_b) {
+    FILE *fa = fopen(path_a, "r"), *fb = fopen(path_b, "r");
+    if(!fa || !fb) {
+        std::printf("Could not open traces\n");
+        return 2;
+    }
+    std::string la, lb, prev;
+    bool in_trace = false;
+    unsigned long line = 0;
+    int res = 0;
+
+    // lines before the trace header are the usual emul_core output
+    while(true) {
+        bool ra = read_line(fa, la), rb = read_line(fb, lb);
+        line++;
+        if(!ra && !rb) break;
+        if(!in_trace) {
+            in_trace = (la.compare(0, 19, "==== Trace of frame") == 0);
+            if(in_trace && lb != la) {
+                std::printf("Traces start at different lines (line %lu), use the same options for both runs\n", line);
+                res = 1;
+                break;
+            }
+            continue;
+        }
+        if(la != lb) {
+            std::printf("First divergent instruction, line %lu\n", line);
+            std::printf("previous : %s", prev.c_str());
+            std::printf("%s : %s", path_a, ra ? la.c_str() : "[end of trace]\n");
+            std::printf("%s : %s", path_b, rb ? lb.c_str() : "[end of trace]\n");
+            res = 1;
+            break;
+        }
+        prev = la;
+    }
+    if(!res) std::printf("Traces are identical\n");
+    fclose(fa);
+    fclose(fb);
+    return res;
+}
+
+int main(int argc, char *argv[]) {
+    if(argc == 4 && !strcmp(argv[1], "-t")) return compare_traces(argv[2], argv[3]);
+    if(argc == 3) return compare_hash_logs(argv[1], argv[2]);
+
+    std::printf("Usage : %s a.log b.log\n", argv[0]);
+    std::printf("        %s -t trace_a.txt trace_b.txt\n", argv[0]);
+    return 2;
+}
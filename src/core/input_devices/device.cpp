@@ -28,10 +28,29 @@ UINT8 ButtonsDevice::get_current() {
     return current_button;
 }
 
+UINT8 ButtonsDevice::get_buttons_mask() {
+    UINT8 mask = 0;
+    for(UINT8 b = 0; b < nr_buttons && b < 8; b++) {
+        if(buttons_active[b]) mask |= 1 << b;
+    }
+    return mask;
+}
+
+void ButtonsDevice::set_buttons_mask(UINT8 mask) {
+    for(UINT8 b = 0; b < nr_buttons && b < 8; b++) {
+        buttons_active[b] = (mask >> b) & 1;
+    }
+}
+
 DevicesManager::DevicesManager() {
     // By default, one NESJoypad ?
     nr_devices = 1;
     automatic_poll_empty = true;
+    low_latency_input = false;
+    buttons_snapshot = 0;
+    latency_probe = nullptr;
+    frame_latched_input = false;
+    for(int d = 0; d < 4; d++) last_read_buttons[d] = 0;
     devices.push_back(new NESJoypad);
     // with default keys ?
     resolve_key[SDLK_w] = {0, 0}; // means first device, first button
@@ -56,6 +75,7 @@ DevicesManager::~DevicesManager() {
 }
 
 void DevicesManager::write_4016(UINT8 val) {
+    UINT8 old_strobe = strobe;
     strobe = val & 0x01;
     //std::printf("%p\n", this);
 
@@ -64,27 +84,43 @@ void DevicesManager::write_4016(UINT8 val) {
         it++) 
         (*it)->set_current(0);
     
-    if(strobe && automatic_poll_empty) {
+    if(frame_latched_input) {
+        // buttons were set at the beginning of the frame
+    }
+    else if(low_latency_input) {
+        // the shift registers are reloaded as long as the strobe is high, and
+        // latched when it goes low : this is the latest time we can sample
+        if(strobe || old_strobe) sample_buttons_snapshot();
+    }
+    else if(strobe && automatic_poll_empty) {
         update_pending_keys();
     }
 }
 
-UINT8 DevicesManager::read_4016() {
+UINT8 DevicesManager::read_device(UINT8 d) {
     UINT8 res = 0;
-    if(nr_devices > 0) {
-        res = devices[0]->check_status();
-        if(!strobe) devices[0]->set_current(devices[0]->get_current()+1); // incr current button
+    if(nr_devices > d) {
+        UINT8 current = devices[d]->get_current();
+        res = devices[d]->check_status();
+        if(!strobe) devices[d]->set_current(current+1); // incr current button
+
+        if(latency_probe && current < 8 && d < 4) {
+            UINT8 mask = 1 << current;
+            if(((last_read_buttons[d] & mask) != 0) != (res != 0)) {
+                last_read_buttons[d] ^= mask;
+                latency_probe->bit_read(d, current, res != 0);
+            }
+        }
     }
     return res;
 }
 
+UINT8 DevicesManager::read_4016() {
+    return read_device(0);
+}
+
 UINT8 DevicesManager::read_4017() {
-    UINT8 res = 0;
-    if(nr_devices > 1) {
-        res = devices[1]->check_status();
-        if(!strobe) devices[1]->set_current(devices[1]->get_current()+1); // incr current button
-    }
-    return res;
+    return read_device(1);
 }
 
 bool DevicesManager::pop_event(SDL_Event *ev) {
@@ -99,10 +135,34 @@ void DevicesManager::push_pending_key(SDL_Event ev) {
 }
 
 void DevicesManager::update_pending_keys() {
+    if(!strobe) return;
+    apply_pending_keys();
+}
+
+void DevicesManager::discard_pending_keys() {
+    SDL_Event ev;
+    while(pop_event(&ev));
+}
+
+void DevicesManager::latch_frame_input() {
+    if(low_latency_input) sample_buttons_snapshot();
+    else apply_pending_keys();
+}
+
+UINT8 DevicesManager::get_device_buttons(UINT8 d) {
+    if(d >= nr_devices) return 0;
+    return devices[d]->get_buttons_mask();
+}
+
+void DevicesManager::set_device_buttons(UINT8 d, UINT8 mask) {
+    if(d >= nr_devices) return;
+    devices[d]->set_buttons_mask(mask);
+}
+
+void DevicesManager::apply_pending_keys() {
     std::pair<UINT8, UINT8> p;
     SDL_Keycode k;
     SDL_Event ev;
-    if(!strobe) return;
 
     while(pop_event(&ev)) {
 
@@ -128,24 +188,82 @@ void DevicesManager::update_pending_keys() {
     }
 }
 
+void DevicesManager::update_buttons_snapshot(const SDL_Event &ev) {
+    if(ev.type != SDL_KEYDOWN && ev.type != SDL_KEYUP) return;
+    auto it = resolve_key.find(ev.key.keysym.sym);
+    if(it == resolve_key.end()) return;
+
+    button_id p = it->second;
+    if(p.first >= 4 || p.second >= 8) return;
+    UINT32 mask = 1u << (8*p.first + p.second);
+
+    if(ev.type == SDL_KEYDOWN)
+        buttons_snapshot.fetch_or(mask, std::memory_order_release);
+    else
+        buttons_snapshot.fetch_and(~mask, std::memory_order_release);
+}
+
+void DevicesManager::probe_key_event(const SDL_Event &ev) {
+    if(!latency_probe) return;
+    if(ev.type != SDL_KEYDOWN && ev.type != SDL_KEYUP) return;
+    auto it = resolve_key.find(ev.key.keysym.sym);
+    if(it == resolve_key.end()) return;
+    latency_probe->key_event(it->second.first, it->second.second, ev.type == SDL_KEYDOWN);
+}
+
+void DevicesManager::sample_buttons_snapshot() {
+    UINT32 snapshot = buttons_snapshot.load(std::memory_order_acquire);
+    for(UINT8 d = 0; d < nr_devices && d < 4; d++) {
+        for(UINT8 b = 0; b < 8; b++) {
+            devices[d]->set_buttons(b, (snapshot >> (8*d + b)) & 1);
+        }
+    }
+}
+
 SDL_Events_Manager::SDL_Events_Manager(std::shared_ptr<DevicesManager> devices_manager) : devices_manager(devices_manager)
 {
     sp_actions_keys[SDLK_ESCAPE] = EMU_SP_ACTIONS::QUIT;
+    sp_actions_keys[SDLK_s] = EMU_SP_ACTIONS::SAVE_STATE;
+    sp_actions_keys[SDLK_r] = EMU_SP_ACTIONS::RESTORE_STATE;
 }
 
 SDL_Events_Manager::~SDL_Events_Manager() {}
 
 void SDL_Events_Manager::push_event(SDL_Event ev) {
+    devices_manager->probe_key_event(ev);
+    // the snapshot is updated right away, without waiting for the emulation thread.
+    // Only quitting and the special actions still go through the queue then
+    if(devices_manager->get_low_latency_input()) {
+        devices_manager->update_buttons_snapshot(ev);
+        bool queued = ev.type == SDL_QUIT ||
+            ((ev.type == SDL_KEYDOWN || ev.type == SDL_KEYUP) && sp_actions_keys.count(ev.key.keysym.sym));
+        if(!queued) return;
+    }
+
+    std::lock_guard<std::mutex> lock(pending_events_mutex);
     pending_events.push(ev);
 }
 
+void SDL_Events_Manager::discard_pending_events() {
+    SDL_Event ev;
+    while(pop_event(&ev));
+}
+
 bool SDL_Events_Manager::pop_event(SDL_Event *ev) {
+    std::lock_guard<std::mutex> lock(pending_events_mutex);
     if(pending_events.empty()) return false;
     *ev = pending_events.front();
     pending_events.pop();
     return true;
 }
 
+bool SDL_Events_Manager::pop_sp_action(EMU_SP_ACTIONS *a) {
+    if(pending_sp_actions.empty()) return false;
+    *a = pending_sp_actions.front();
+    pending_sp_actions.pop();
+    return true;
+}
+
 void SDL_Events_Manager::sdl_handle_poll() {
     SDL_Event ev;
     SDL_Keycode k;
@@ -159,7 +277,16 @@ void SDL_Events_Manager::sdl_handle_poll() {
             k = ev.key.keysym.sym;
             if(sp_actions_keys.count(k)) {
 
-            } else {
+                switch(sp_actions_keys[k]) {
+                    case EMU_SP_ACTIONS::SAVE_STATE:
+                    case EMU_SP_ACTIONS::RESTORE_STATE:
+                        pending_sp_actions.push(sp_actions_keys[k]);
+                        break;
+                    default:
+                        break;
+                }
+
+            } else if(!devices_manager->get_low_latency_input()) {
                 devices_manager->push_pending_key(ev);
             }
             break;
@@ -172,9 +299,11 @@ void SDL_Events_Manager::sdl_handle_poll() {
                     case EMU_SP_ACTIONS::QUIT:
                         throw ExitedGame();
                         break;
+                    default:
+                        break;
                 }
 
-            } else {
+            } else if(!devices_manager->get_low_latency_input()) {
                 devices_manager->push_pending_key(ev);
             }
             break;
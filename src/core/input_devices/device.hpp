@@ -8,7 +8,10 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <mutex>
+#include <atomic>
 #include <SDL2/SDL.h>
+#include "../latency_probe.hpp"
 
 typedef std::pair<UINT8,UINT8> button_id;
 
@@ -26,6 +29,9 @@ public:
     virtual void        set_current(UINT8 current);
     virtual UINT8       check_status();
     virtual UINT8       get_current();
+    // bit n is button n
+    UINT8               get_buttons_mask();
+    void                set_buttons_mask(UINT8 mask);
 };
 
 #include "nesjoypad.hpp"
@@ -45,7 +51,26 @@ private:
 
     std::queue<SDL_Event>               pending_keys;
 
+    /* Low latency input : instead of going through the pending keys queue,
+    the buttons are kept in a snapshot (8 bits per device) that the event
+    thread updates, and that is sampled when the game writes the strobe */
+    bool                                low_latency_input;
+    std::atomic<UINT32>                 buttons_snapshot;
+
+    /* When input is frame latched (movies), the strobe doesn't read the host
+    input anymore : the buttons only change with latch_frame_input() or
+    set_device_buttons(), at the beginning of frames */
+    bool                                frame_latched_input;
+
+    /* Used to find the first read of a button after it changed, when
+    measuring input latency */
+    LatencyProbe                        *latency_probe;
+    UINT8                               last_read_buttons[4];
+
     bool                                pop_event(SDL_Event *ev);
+    void                                sample_buttons_snapshot();
+    void                                apply_pending_keys();
+    UINT8                               read_device(UINT8 d);
 
 public:
     DevicesManager();
@@ -55,6 +80,8 @@ public:
  
     void                               set_key_association(SDL_KeyCode k, button_id val){resolve_key[k] = val;};
     void                               set_automatic_poll_empty(bool val) {automatic_poll_empty = val;};
+    void                               set_low_latency_input(bool val) {low_latency_input = val;};
+    bool                               get_low_latency_input() {return low_latency_input;};
     void                               write_4016(UINT8 val);
     UINT8                              read_4016();
     //also them I suppose
@@ -63,10 +90,22 @@ public:
 
     void                               update_pending_keys();
     void                               push_pending_key(SDL_Event ev);
+    void                               discard_pending_keys();
+
+    UINT8                              get_nr_devices() {return nr_devices;};
+    void                               set_frame_latched_input(bool val) {frame_latched_input = val;};
+    // apply the host input (pending keys or snapshot) to the devices right now
+    void                               latch_frame_input();
+    UINT8                              get_device_buttons(UINT8 d);
+    void                               set_device_buttons(UINT8 d, UINT8 mask);
+    // can be called from another thread than the emulation one
+    void                               update_buttons_snapshot(const SDL_Event &ev);
+    void                               set_latency_probe(LatencyProbe *probe) {latency_probe = probe;};
+    void                               probe_key_event(const SDL_Event &ev);
 };
 
 enum class EMU_SP_ACTIONS {
-    QUIT, NR_ACTIONS
+    QUIT, SAVE_STATE, RESTORE_STATE, NR_ACTIONS
 };
 
 class SDL_Events_Manager
@@ -78,9 +117,16 @@ public:
 
     void                                        sdl_handle_poll();
     void                                        push_event(SDL_Event ev);
+    void                                        discard_pending_events();
+    /* Actions (save state, ...) which were requested during the last
+    sdl_handle_poll(), to be handled by the emulation manager */
+    bool                                        pop_sp_action(EMU_SP_ACTIONS *a);
 
 private:
     std::map<SDL_Keycode, EMU_SP_ACTIONS>       sp_actions_keys;
+    std::queue<EMU_SP_ACTIONS>                  pending_sp_actions;
+    // events may be pushed by the event thread while the emulation one pops them
+    std::mutex                                  pending_events_mutex;
     std::queue<SDL_Event>                       pending_events;
     std::shared_ptr<DevicesManager>             devices_manager;
     bool                                        pop_event(SDL_Event *ev);
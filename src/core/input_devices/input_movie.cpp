@@ -0,0 +1,55 @@
+#include <cstring>
+#include "input_movie.hpp"
+#include "../exceptions.hpp"
+
+static const UINT8 movie_magic[4] = {'G', 'M', 'V', 0x1A};
+
+InputMovie::InputMovie(UINT8 nr_devices) : nr_devices(nr_devices)
+{
+    if(!nr_devices || nr_devices > INPUT_MOVIE_MAX_DEVICES) {
+        throw IncorrectFileFormat("Incorrect number of devices for input movie");
+    }
+}
+
+InputMovie::~InputMovie() {}
+
+InputMovie *InputMovie::load(FILE *f) {
+    UINT8 header[12];
+    if(fread(header, 1, 12, f) != 12) {
+        throw FileReadingError("Could not read input movie header");
+    }
+    if(std::memcmp(header, movie_magic, 4)) {
+        throw IncorrectFileFormat("Not an input movie");
+    }
+    if(header[4] != INPUT_MOVIE_VERSION) {
+        throw IncorrectFileFormat("Unsupported input movie version");
+    }
+
+    UINT32 nr_frames = header[8] | (header[9] << 8) | (header[10] << 16) | ((UINT32)header[11] << 24);
+    InputMovie *movie = new InputMovie(header[5]);
+    movie->frames.resize((size_t)nr_frames * movie->nr_devices);
+    if(fread(movie->frames.data(), 1, movie->frames.size(), f) != movie->frames.size()) {
+        delete movie;
+        throw FileReadingError("Input movie is truncated");
+    }
+    return movie;
+}
+
+void InputMovie::save(FILE *f) {
+    UINT32 nr_frames = get_nr_frames();
+    UINT8 header[12] = {movie_magic[0], movie_magic[1], movie_magic[2], movie_magic[3],
+                        INPUT_MOVIE_VERSION, nr_devices, 0, 0,
+                        (UINT8)nr_frames, (UINT8)(nr_frames >> 8), (UINT8)(nr_frames >> 16), (UINT8)(nr_frames >> 24)};
+    fwrite(header, 1, 12, f);
+    fwrite(frames.data(), 1, frames.size(), f);
+}
+
+void InputMovie::record_frame(const UINT8 *buttons) {
+    frames.insert(frames.end(), buttons, buttons + nr_devices);
+}
+
+bool InputMovie::get_frame(UINT32 frame, UINT8 *buttons) {
+    if(frame >= get_nr_frames()) return false;
+    std::memcpy(buttons, &frames[(size_t)frame * nr_devices], nr_devices);
+    return true;
+}
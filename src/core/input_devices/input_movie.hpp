@@ -0,0 +1,47 @@
+#ifndef GAYA_INPUT_MOVIE_HPP
+#define GAYA_INPUT_MOVIE_HPP
+
+#include <cstdio>
+#include <vector>
+#include "../types.hpp"
+
+/*
+Controllers state for each frame, as seen by the game through $4016/$4017.
+
+File format (little endian) :
+    4 bytes  : magic "GMV\x1A"
+    1 byte   : version
+    1 byte   : number of devices
+    2 bytes  : reserved
+    4 bytes  : number of frames
+    then, for each frame, one byte per device (bit n = button n, as in NESJoypad)
+*/
+
+#define INPUT_MOVIE_VERSION     1
+#define INPUT_MOVIE_MAX_DEVICES 4
+
+class InputMovie
+{
+public:
+    InputMovie(UINT8 nr_devices);
+    ~InputMovie();
+
+    /* Can throw:
+    - FileReadingError
+    - IncorrectFileFormat */
+    static InputMovie           *load(FILE *f);
+    void                        save(FILE *f);
+
+    void                        record_frame(const UINT8 *buttons);
+    // returns false when the movie is over
+    bool                        get_frame(UINT32 frame, UINT8 *buttons);
+
+    UINT8                       get_nr_devices() {return nr_devices;};
+    UINT32                      get_nr_frames() {return frames.size() / nr_devices;};
+
+private:
+    UINT8                       nr_devices;
+    std::vector<UINT8>          frames;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include "latency_probe.hpp"
+
+LatencyProbe::LatencyProbe() : current_frame(0)
+{
+    for(int d = 0; d < 4; d++)
+        for(int b = 0; b < 8; b++) {
+            events[d][b].valid = false;
+            events[d][b].value = 0;
+        }
+}
+
+LatencyProbe::~LatencyProbe() {}
+
+UINT32 LatencyProbe::to_us(clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+void LatencyProbe::key_event(UINT8 device, UINT8 button, UINT8 value) {
+    if(device >= 4 || button >= 8) return;
+    std::lock_guard<std::mutex> guard(lock);
+    pending_event &ev = events[device][button];
+    // key repeats don't change anything for the game
+    if(ev.value == value) return;
+    ev.value = value;
+    ev.time = clock::now();
+    ev.valid = true;
+}
+
+void LatencyProbe::bit_read(UINT8 device, UINT8 button, UINT8 value) {
+    if(device >= 4 || button >= 8) return;
+    clock::time_point now = clock::now();
+    std::lock_guard<std::mutex> guard(lock);
+    pending_event &ev = events[device][button];
+    if(!ev.valid || ev.value != value) return;
+    ev.valid = false;
+
+    samples[EVENT_TO_READ].push_back(to_us(now - ev.time));
+    waiting_present.push_back({ev.time, now, current_frame.load()});
+}
+
+void LatencyProbe::frame_presented(UINT32 frame) {
+    clock::time_point now = clock::now();
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = waiting_present.begin();
+    while(it != waiting_present.end()) {
+        // the frame which was being emulated during the read may already be drawn
+        // partly, so the first one to show the result is the next one
+        if(it->frame < frame) {
+            samples[READ_TO_PRESENT].push_back(to_us(now - it->read_time));
+            samples[EVENT_TO_PRESENT].push_back(to_us(now - it->event_time));
+            it = waiting_present.erase(it);
+        }
+        else it++;
+    }
+}
+
+void LatencyProbe::export_histograms(FILE *f) {
+    static const char *stage_names[NR_STAGES] = {"event_to_read", "read_to_present", "event_to_present"};
+    std::lock_guard<std::mutex> guard(lock);
+
+    std::fprintf(f, "# gayaNES input latency, in microseconds\n");
+    for(int s = 0; s < NR_STAGES; s++) {
+        std::vector<UINT32> sorted(samples[s]);
+        std::sort(sorted.begin(), sorted.end());
+        size_t n = sorted.size();
+
+        std::fprintf(f, "\nstage %s : %zu samples\n", stage_names[s], n);
+        if(!n) continue;
+
+        double mean = 0;
+        for(UINT32 v : sorted) mean += v;
+        mean /= n;
+        std::fprintf(f, "mean %.1f min %u p50 %u p90 %u p99 %u max %u\n", mean, sorted[0],
+            sorted[n/2], sorted[(n*9)/10], sorted[(n*99)/100], sorted[n-1]);
+
+        // power of two buckets
+        UINT32 buckets[33] = {0};
+        for(UINT32 v : sorted) {
+            int b = 0;
+            while(b < 32 && (1u << b) <= v) b++;
+            buckets[b]++;
+        }
+        for(int b = 0; b < 33; b++) {
+            if(!buckets[b]) continue;
+            std::fprintf(f, "[%10u, %10u) %u\n", b ? (1u << (b-1)) : 0, b < 32 ? (1u << b) : 0xFFFFFFFF, buckets[b]);
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef GAYA_LATENCY_PROBE_HPP
+#define GAYA_LATENCY_PROBE_HPP
+
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdio>
+#include "types.hpp"
+
+/*
+Measures the input-to-photon latency, in three stages :
+    - from the SDL key event to the first read of the changed bit by the game ($4016/$4017)
+    - from this read to the SDL_RenderPresent of the first frame emulated after it
+    - the total of both
+Key events can be reported from another thread than the emulation one.
+*/
+class LatencyProbe
+{
+public:
+    enum stage {
+        EVENT_TO_READ, READ_TO_PRESENT, EVENT_TO_PRESENT, NR_STAGES
+    };
+
+    LatencyProbe();
+    ~LatencyProbe();
+
+    void                        key_event(UINT8 device, UINT8 button, UINT8 value);
+    // the game read the given button, and saw a different value from its previous read
+    void                        bit_read(UINT8 device, UINT8 button, UINT8 value);
+    void                        begin_frame(UINT32 frame) {current_frame.store(frame);};
+    UINT32                      get_current_frame() {return current_frame.load();};
+    void                        frame_presented(UINT32 frame);
+
+    void                        export_histograms(FILE *f);
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    struct pending_event {
+        clock::time_point       time;
+        UINT8                   value;
+        bool                    valid;
+    };
+
+    struct pending_sample {
+        clock::time_point       event_time, read_time;
+        UINT32                  frame;
+    };
+
+    std::mutex                  lock;
+    std::atomic<UINT32>         current_frame;
+    pending_event               events[4][8];
+    std::vector<pending_sample> waiting_present;
+    // samples in microseconds
+    std::vector<UINT32>         samples[NR_STAGES];
+
+    static UINT32               to_us(clock::duration d);
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "mapper_resolve.hpp"
+#include "../ppu_info.hpp"
+
+ROMMapper1::ROMMapper1(struct nes_data *nesdata) {
+    init_banks(nesdata);
+    shift = 0x10;
+    control = 0x0C; // last bank fixed at $C000 on power up
+    chr_reg[0] = 0; chr_reg[1] = 0;
+    prg_reg = 0;
+    update_banks();
+}
+
+ROMMemManager *ROMMapper1::save_state() {
+    ROMMapper1 *cloned = new ROMMapper1(*this);
+    cloned->remap_banks();
+    return cloned;
+}
+
+void ROMMapper1::update_banks() {
+    static const UINT8 miroring_modes[4] = {MIRORING_SINGLE, MIRORING_SINGLE_UPPER, MIRORING_VERTICAL, MIRORING_HORIZONTAL};
+    set_miroring(miroring_modes[control & 0x03]);
+
+    switch ((control >> 2) & 0x03)
+    {
+    case 0:
+    case 1:
+        // 32kb mode, low bit ignored
+        map_prg_32k((prg_reg & 0x0F) >> 1);
+        break;
+    case 2:
+        // first bank fixed at $8000
+        map_prg_16k(0, 0);
+        map_prg_16k(1, prg_reg & 0x0F);
+        break;
+    case 3:
+        // last bank fixed at $C000
+        map_prg_16k(0, prg_reg & 0x0F);
+        map_prg_16k(1, NR_PRG_BANKS / 2 - 1);
+        break;
+    }
+
+    if(control & 0x10) {
+        // two 4kb banks
+        map_chr_4k(0, chr_reg[0]);
+        map_chr_4k(1, chr_reg[1]);
+    } else {
+        map_chr_8k(chr_reg[0] >> 1);
+    }
+}
+
+void ROMMapper1::write(MEMADDR a, UINT8 val) {
+    if(a < 0x8000) {
+        if(a >= 0x6000) write_prg_ram(a, val);
+        return;
+    }
+
+    if(val & 0x80) {
+        shift = 0x10;
+        control |= 0x0C;
+        update_banks();
+        return;
+    }
+
+    // serial port, LSB first : the register is written on the 5th write, when the
+    // initial 1 gets out of the shift register
+    BOOL full = shift & 0x01;
+    shift = (shift >> 1) | ((val & 0x01) << 4);
+    if(!full) return;
+
+    switch ((a >> 13) & 0x03)
+    {
+    case 0:
+        control = shift;
+        break;
+    case 1:
+        chr_reg[0] = shift;
+        break;
+    case 2:
+        chr_reg[1] = shift;
+        break;
+    case 3:
+        prg_reg = shift; // bit 4 : PRG RAM disable, ignored
+        break;
+    }
+    shift = 0x10;
+    update_banks();
+}
@@ -0,0 +1,25 @@
+#include "mapper_resolve.hpp"
+
+ROMMapper3::ROMMapper3(struct nes_data *nesdata) {
+    if(nesdata->CHR_ROM_size == 0) {
+        throw IncorrectFileFormat("Mapper 3 without CHR_ROM");
+    }
+    // PRG is the same as mapper 0
+    init_banks(nesdata);
+}
+
+ROMMemManager *ROMMapper3::save_state() {
+    ROMMapper3 *cloned = new ROMMapper3(*this);
+    cloned->remap_banks();
+    return cloned;
+}
+
+void ROMMapper3::write(MEMADDR a, UINT8 val) {
+    if(a < 0x8000) {
+        if(a >= 0x6000) write_prg_ram(a, val);
+        return;
+    }
+
+    // 2 bits on the original boards, some later games use more
+    map_chr_8k(val);
+}
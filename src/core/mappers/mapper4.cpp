@@ -0,0 +1,94 @@
+#include "mapper_resolve.hpp"
+#include "../cpu.hpp"
+#include "../ppu_info.hpp"
+
+ROMMapper4::ROMMapper4(struct nes_data *nesdata) {
+    init_banks(nesdata);
+    bank_select = 0;
+    for(int i=0; i<8; i++) bank_regs[i] = 0;
+    // usual power up values, games set them anyway
+    bank_regs[0] = 0; bank_regs[1] = 2;
+    bank_regs[2] = 4; bank_regs[3] = 5; bank_regs[4] = 6; bank_regs[5] = 7;
+    bank_regs[6] = 0; bank_regs[7] = 1;
+    irq_latch = 0;
+    irq_counter = 0;
+    irq_reload = 0;
+    irq_enabled = 0;
+    four_screens = nesdata->header.FOUR_SCREENS;
+    update_banks();
+}
+
+ROMMemManager *ROMMapper4::save_state() {
+    ROMMapper4 *cloned = new ROMMapper4(*this);
+    cloned->remap_banks();
+    return cloned;
+}
+
+void ROMMapper4::update_banks() {
+    // PRG : R6 and R7 are switchable, $E000 is fixed to the last bank, and the second to last
+    // one is at $C000 or $8000 (swapped with R6) depending on bit 6
+    UINT8 prg_swap = (bank_select & 0x40)? 2 : 0;
+    map_prg_8k(prg_swap, bank_regs[6]);
+    map_prg_8k(1, bank_regs[7]);
+    map_prg_8k(2 - prg_swap, NR_PRG_BANKS - 2);
+    map_prg_8k(3, NR_PRG_BANKS - 1);
+
+    // CHR : R0 and R1 are 2kb banks, R2-R5 1kb ones, halves swapped with bit 7
+    UINT8 chr_swap = (bank_select & 0x80)? 4 : 0;
+    map_chr_1k(0 ^ chr_swap, bank_regs[0] & 0xFE);
+    map_chr_1k(1 ^ chr_swap, bank_regs[0] | 0x01);
+    map_chr_1k(2 ^ chr_swap, bank_regs[1] & 0xFE);
+    map_chr_1k(3 ^ chr_swap, bank_regs[1] | 0x01);
+    for(UINT8 r=2; r<6; r++) map_chr_1k((r + 2) ^ chr_swap, bank_regs[r]);
+}
+
+void ROMMapper4::write(MEMADDR a, UINT8 val) {
+    if(a < 0x8000) {
+        if(a >= 0x6000) write_prg_ram(a, val);
+        return;
+    }
+
+    // registers are selected by the range and the parity of the address
+    switch ((a & 0x6000) | (a & 0x01))
+    {
+    case 0x0000:
+        bank_select = val;
+        update_banks();
+        break;
+    case 0x0001:
+        bank_regs[bank_select & 0x07] = val;
+        update_banks();
+        break;
+    case 0x2000:
+        if(!four_screens) set_miroring((val & 0x01)? MIRORING_HORIZONTAL : MIRORING_VERTICAL);
+        break;
+    case 0x2001:
+        // PRG RAM protect
+        break;
+    case 0x4000:
+        irq_latch = val;
+        break;
+    case 0x4001:
+        irq_counter = 0;
+        irq_reload = 1;
+        break;
+    case 0x6000:
+        // also acknowledges a pending IRQ
+        irq_enabled = 0;
+        if(cpu) cpu->clear_irq_line(IRQ_SOURCE_MAPPER);
+        break;
+    case 0x6001:
+        irq_enabled = 1;
+        break;
+    }
+}
+
+void ROMMapper4::ppu_a12_rise() {
+    if(!irq_counter || irq_reload) {
+        irq_counter = irq_latch;
+        irq_reload = 0;
+    } else {
+        irq_counter--;
+    }
+    if(!irq_counter && irq_enabled && cpu) cpu->set_irq_line(IRQ_SOURCE_MAPPER);
+}
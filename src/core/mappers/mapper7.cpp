@@ -0,0 +1,29 @@
+#include "mapper_resolve.hpp"
+#include "../ppu_info.hpp"
+
+ROMMapper7::ROMMapper7(struct nes_data *nesdata) {
+    if(nesdata->CHR_ROM_size / 8192 > 1) {
+        std::printf("Mapper 7 used with %d CHR_ROM 8kb chunks.\n", nesdata->CHR_ROM_size / 8192);
+        throw IncorrectFileFormat("Mapper 7 with > 1x8kb of CHR_ROM");
+    }
+    init_banks(nesdata);
+    map_prg_32k(0);
+    set_miroring(MIRORING_SINGLE);
+}
+
+ROMMemManager *ROMMapper7::save_state() {
+    ROMMapper7 *cloned = new ROMMapper7(*this);
+    cloned->remap_banks();
+    return cloned;
+}
+
+void ROMMapper7::write(MEMADDR a, UINT8 val) {
+    if(a < 0x8000) {
+        if(a >= 0x6000) write_prg_ram(a, val);
+        return;
+    }
+
+    map_prg_32k(val & 0x07);
+    // bit 4 selects the nametable used for the whole screen
+    set_miroring((val & 0x10)? MIRORING_SINGLE_UPPER : MIRORING_SINGLE);
+}
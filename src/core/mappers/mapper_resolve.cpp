@@ -1,5 +1,6 @@
 #include <iostream>
 #include "mapper_resolve.hpp"
+#include "../cpu.hpp"
 
 ROMMemManager *mapper_resolve(struct nes_header *nesh, struct nes_data *nesd) {
     std::printf("Resolving mapper %d\n", nesh->MAPPER_NB);
@@ -8,12 +9,54 @@ ROMMemManager *mapper_resolve(struct nes_header *nesh, struct nes_data *nesd) {
     case 0x00:
         /* Default */
         return new ROMDefault(nesd);
+    case 0x01:
+        /* MMC1 */
+        return new ROMMapper1(nesd);
     case 0x02:
         /* UNROM */
         return new ROMMapper2(nesd);
+    case 0x03:
+        /* CNROM */
+        return new ROMMapper3(nesd);
+    case 0x04:
+        /* MMC3 */
+        return new ROMMapper4(nesd);
+    case 0x07:
+        /* AxROM */
+        return new ROMMapper7(nesd);
     
     default:
         std::printf("Mapper not recognized\n");
         return nullptr;
     }
-}
\ No newline at end of file
+}
+
+template<class ROM>
+static cpu6502 *make_core(ROMMemManager *rom, CPUMemoryManager **cpu_mem) {
+    NESMemoryT<ROM> *mem = new NESMemoryT<ROM>(static_cast<ROM *>(rom));
+    *cpu_mem = mem;
+    return new cpu6502T<NESMemoryT<ROM>>(mem);
+}
+
+cpu6502 *core_resolve(struct nes_header *nesh, ROMMemManager *rom, CPUMemoryManager **cpu_mem) {
+    switch (nesh->MAPPER_NB)
+    {
+    case 0x00:
+        return make_core<ROMDefault>(rom, cpu_mem);
+    case 0x01:
+        return make_core<ROMMapper1>(rom, cpu_mem);
+    case 0x02:
+        return make_core<ROMMapper2>(rom, cpu_mem);
+    case 0x03:
+        return make_core<ROMMapper3>(rom, cpu_mem);
+    case 0x04:
+        return make_core<ROMMapper4>(rom, cpu_mem);
+    case 0x07:
+        return make_core<ROMMapper7>(rom, cpu_mem);
+
+    default:
+        NESMemory *mem = new NESMemory(rom);
+        *cpu_mem = mem;
+        return new cpu6502T<NESMemory>(mem);
+    }
+}
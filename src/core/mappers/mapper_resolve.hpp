@@ -10,6 +10,29 @@ Mappers List
 =============
 */
 
+/*
+Mapper 1, or MMC1 (SxROM)
+Registers are written one bit at a time through a 5 bits shift register
+*/
+
+class ROMMapper1 : public ROMDefault
+{
+protected:
+    UINT8               shift;
+    UINT8               control;
+    UINT8               chr_reg[2];
+    UINT8               prg_reg;
+
+    void                update_banks();
+public:
+    ROMMapper1(){};
+    ROMMapper1(struct nes_data *nesdata);
+    virtual ~ROMMapper1(){};
+    virtual void        write(MEMADDR a, UINT8 val);
+    virtual ROMMemManager
+                        *save_state();
+};
+
 /*
 Mapper 2, or UNROM
 */
@@ -21,7 +44,65 @@ public:
     ROMMapper2(struct nes_data *nesdata);
     virtual ~ROMMapper2(){};
     virtual void        write(MEMADDR a, UINT8 val);
-    virtual void        write_pt(MEMADDR a, UINT8 val);
+    virtual ROMMemManager
+                        *save_state();
+};
+
+/*
+Mapper 3, or CNROM : 8kb CHR banks
+*/
+
+class ROMMapper3 : public ROMDefault
+{
+public:
+    ROMMapper3(){};
+    ROMMapper3(struct nes_data *nesdata);
+    virtual ~ROMMapper3(){};
+    virtual void        write(MEMADDR a, UINT8 val);
+    virtual ROMMemManager
+                        *save_state();
+};
+
+/*
+Mapper 4, or MMC3 (TxROM)
+8kb PRG banks, 1kb and 2kb CHR banks, and a scanline counter clocked by the PPU A12
+rises, raising an IRQ when it gets to 0
+*/
+
+class ROMMapper4 : public ROMDefault
+{
+protected:
+    UINT8               bank_select;
+    UINT8               bank_regs[8]; // R0-R7
+    UINT8               irq_latch;
+    UINT8               irq_counter;
+    BOOL                irq_reload;
+    BOOL                irq_enabled;
+    BOOL                four_screens;
+
+    void                update_banks();
+public:
+    ROMMapper4(){};
+    ROMMapper4(struct nes_data *nesdata);
+    virtual ~ROMMapper4(){};
+    virtual void        write(MEMADDR a, UINT8 val);
+    virtual BOOL        watches_ppu_a12() {return 1;};
+    virtual void        ppu_a12_rise();
+    virtual ROMMemManager
+                        *save_state();
+};
+
+/*
+Mapper 7, or AxROM : 32kb PRG banks and single screen miroring
+*/
+
+class ROMMapper7 : public ROMDefault
+{
+public:
+    ROMMapper7(){};
+    ROMMapper7(struct nes_data *nesdata);
+    virtual ~ROMMapper7(){};
+    virtual void        write(MEMADDR a, UINT8 val);
     virtual ROMMemManager
                         *save_state();
 };
@@ -32,4 +113,11 @@ Mapper resolution
 
 ROMMemManager *mapper_resolve(struct nes_header *nesh, struct nes_data *nesd);
 
+/*
+CPU and CPU memory specialized for the mapper class of rom, which should come from
+mapper_resolve with the same header. The memory is returned in cpu_mem.
+Unknown mappers get the generic core, through virtual calls
+*/
+cpu6502 *core_resolve(struct nes_header *nesh, ROMMemManager *rom, CPUMemoryManager **cpu_mem);
+
 #endif
\ No newline at end of file
@@ -7,55 +7,6 @@
 
 // ========== NES MEMORY
 
-static char game_genie_codes_raw[16] = {'A', 'P', 'Z', 'L', 'G', 'I', 'T', 'Y', 'E', 'O', 'X', 'U', 'K', 'S', 'V', 'N'};
-static UINT8 game_genie_decode_tok(char c) {
-    for(int i=0; i<16; i++) {
-        if(game_genie_codes_raw[i] == c) return i;
-    }
-    throw AddressFault("Incorrect Game Genie character");
-}
-
-void NESMemory::set_game_genie(std::string &genie_code) {
-    // upper case
-    for (auto & c: genie_code) c = toupper(c);
-
-    if(genie_code.size() == 6) {
-        UINT16 decoded[6] = {0, 0, 0, 0, 0, 0};
-        try
-        {
-            for(int i=0; i<6; i++) {
-                decoded[i] = (UINT16)game_genie_decode_tok(genie_code[i]);
-            }
-        }
-        catch(const AddressFault& e)
-        {
-            std::printf("Incorrect Game Genie character. Skipping it\n");
-            return;
-        }
-        MEMADDR addr = 0x8000 +
-                          ((decoded[3] & 7) << 12)
-                        | ((decoded[5] & 7) << 8) | ((decoded[4] & 8) << 8)
-                        | ((decoded[2] & 7) << 4) | ((decoded[1] & 8) << 4)
-                        | ((decoded[4] & 7))      | ((decoded[3] & 8));
-
-        UINT8 data = ((decoded[1] & 7) << 4) | ((decoded[0] & 8) << 4)
-                       | ((decoded[0] & 7))   | (decoded[5] << 8);
-
-        game_genie.addr = addr;
-        game_genie.data = data;
-        std::printf("Game Genie : addr : 0x%04X data : 0x%02X\n", addr, data);
-        game_genie_active = 1;
-    }
-    else if(genie_code.size() == 8) {
-        throw NotImplemented("8-bits Game Genie Code");
-        game_genie_active = 1;
-    }
-}
-
-void NESMemory::unset_game_genie() {
-    game_genie_active = 0;
-}
-
 void NESMemory::check_ppu_sync() {
     if(cpu->get_return_on_ppu()) {
             
@@ -63,11 +14,19 @@ void NESMemory::check_ppu_sync() {
             // ok we got to sync cpu and ppu !
             throw PpuSync();
         } else {
+#ifndef GAYA_CYCLE_EXACT
+            // (with GAYA_CYCLE_EXACT, once the instruction is done : the sync is at its first access)
             cpu->set_skip_next_op_ppu(0);
+#endif
         }
     }
 }
 
+BOOL NESMemory::ppu_status_stable() {
+    UINT8 status = ppu_mem->peek_PPUSTATUS();
+    return status == ppu_mem->get_last_status() && !(status & 0x80);
+}
+
 CPUMemoryManager *NESMemory::save_state() {
     NESMemory *cloned = new NESMemory(memROM);
     // we copy the reference to the device object ?
@@ -82,26 +41,9 @@ CPUMemoryManager *NESMemory::save_state() {
     return cloned;
 }
 
-UINT8 NESMemory::read(MEMADDR a) {
-    // TODO : check if faster bitwise or with <
-
-    if(game_genie_active && a == game_genie.addr) {
-        return game_genie.data;
-    }
-
-    if(!(a & 0xF800)) {
-        //if(a == 0x06FC) std::printf("Reading 0x06FC from 0x%04X : 0x%02X\n", cpu->get_pc(), memRAM[a]);
-        return memRAM[a]; // main ram
-    }
-    else if(a < 0x1000)
-        return memRAM[a & 0x07FF]; // first mirror
-    else if(a < 0x1800)
-        return memRAM[a & 0x07FF];
-    else if(!(a & 0xE000))
-        return memRAM[a & 0x07FF];
-    
-    // then, PPU regs
-    else if(a < 0x2008)
+UINT8 NESMemory::read_io(MEMADDR a) {
+    // PPU regs
+    if(a < 0x2008)
     {
         
         check_ppu_sync();
@@ -134,7 +76,7 @@ UINT8 NESMemory::read(MEMADDR a) {
 
     else if(!(a & 0xC000)) {
         UINT8 nr_reg = (a - 0x2000) % 8;
-        return read(0x2000+((MEMADDR)nr_reg));
+        return read_io(0x2000+((MEMADDR)nr_reg));
     }
 
     else if(a < 0x4020) {
@@ -155,30 +97,15 @@ UINT8 NESMemory::read(MEMADDR a) {
             break;
         }
     }
-
-    else {
-        return memROM->read(a);
-    }
+    // other APU registers, not emulated yet
+    return 0x00;
 }
 
 // =========
 
-void NESMemory::write(MEMADDR a, UINT8 val) {
-    if(!(a & 0xF800)) {
-        memRAM[a] = val; // main ram
-    }
-    else if(a < 0x1000) {
-        memRAM[a & 0x07FF] = val; // first mirror
-    }
-    else if(a < 0x1800) {
-        memRAM[a & 0x07FF] = val; // second mirror
-    }
-    else if(!(a & 0xE000)) {
-        memRAM[a & 0x07FF] = val; // third mirror
-    }
-    
-    // then, PPU regs
-    else if(a < 0x2008)
+void NESMemory::write_io(MEMADDR a, UINT8 val) {
+    // PPU regs
+    if(a < 0x2008)
     {
 
         check_ppu_sync();
@@ -216,7 +143,7 @@ void NESMemory::write(MEMADDR a, UINT8 val) {
 
     else if(!(a & 0xC000)) {
         UINT8 nr_reg = (a - 0x2000) % 8;
-        write(0x2000+((MEMADDR)nr_reg), val); return;
+        write_io(0x2000+((MEMADDR)nr_reg), val); return;
     }
 
     else if(a < 0x4020) {
@@ -241,93 +168,128 @@ void NESMemory::write(MEMADDR a, UINT8 val) {
             break;
         }
     }
+}
+
+// ************* ROM MANAGER
 
-    else {
-        memROM->write(a, val);
+void ROMDefault::init_banks(struct nes_data *nesdata) {
+    PRG_ROM_SIZE = nesdata->PRG_ROM_size;
+    PRG_ROM_DATA = nesdata->PRG_ROM_data;
+    NR_PRG_BANKS = PRG_ROM_SIZE / PRG_BANK_SIZE;
+    if(!NR_PRG_BANKS) {
+        throw IncorrectFileFormat("No PRG ROM");
     }
+
+    // no CHR ROM : the cartridge has 8kb of CHR RAM instead
+    chr_writable = (nesdata->CHR_ROM_size == 0);
+    if(chr_writable) {
+        for(int i=0; i<0x2000; i++) chr_ram[i] = 0;
+        CHR_SIZE = 0x2000;
+        CHR_DATA = chr_ram;
+    } else {
+        CHR_SIZE = nesdata->CHR_ROM_size;
+        CHR_DATA = nesdata->CHR_ROM_data;
+    }
+    NR_CHR_BANKS = CHR_SIZE / CHR_BANK_SIZE;
+
+    for(int i=0; i<PRG_RAM_SIZE; i++) prg_ram[i] = 0;
+    prg_ram_changes = nullptr;
+
+    ppu_mem = nullptr;
+    cpu = nullptr;
+    controls_miroring = 0;
+    miroring = 0;
+
+    // NROM layout, the mappers change it afterwards : first 16kb at $8000, last at $C000
+    map_prg_16k(0, 0);
+    map_prg_16k(1, NR_PRG_BANKS / 2 - 1);
+    map_chr_8k(0);
 }
 
-UINT8 NESMemory::read_stack(ZPADDR offset) {
-    //std::printf("Reading stack @0x%02X\n", offset);
-    return memRAM[STACK_PAGE_START+(MEMADDR)offset];
+void ROMDefault::map_prg_8k(UINT8 slot, unsigned int bank) {
+    bank %= NR_PRG_BANKS;
+    prg_bank_index[slot] = bank;
+    UINT8 *patched = (cheats)? cheats->get_bank(slot, bank) : nullptr;
+    prg_banks[slot] = (patched)? patched : PRG_ROM_DATA + bank * PRG_BANK_SIZE;
+    // the CPU may be fetching from the previous bank
+    if(cpu) cpu->invalidate_code_page();
 }
-void NESMemory::write_stack(ZPADDR offset, UINT8 val) {
-    //std::printf("Writing %02X stack @0x%02X\n", val, offset);
-    memRAM[STACK_PAGE_START+(MEMADDR)offset] = val;
+
+void ROMDefault::map_prg_16k(UINT8 slot, unsigned int bank) {
+    map_prg_8k(slot << 1, bank << 1);
+    map_prg_8k((slot << 1) + 1, (bank << 1) + 1);
 }
 
-// ************* ROM MANAGER
+void ROMDefault::map_prg_32k(unsigned int bank) {
+    for(UINT8 slot=0; slot<NR_PRG_SLOTS; slot++) map_prg_8k(slot, (bank << 2) + slot);
+}
 
-ROMDefault::ROMDefault(struct nes_data *nesdata) {
-    PRG_ROM_SIZE = nesdata->PRG_ROM_size;
-    PRG_ROM_DATA = nesdata->PRG_ROM_data;
+void ROMDefault::map_chr_1k(UINT8 slot, unsigned int bank) {
+    bank %= NR_CHR_BANKS;
+    chr_bank_index[slot] = bank;
+    chr_banks[slot] = CHR_DATA + bank * CHR_BANK_SIZE;
+}
 
-    PRG_ROM_RESOLUTION[0] = 0;
+void ROMDefault::map_chr_4k(UINT8 slot, unsigned int bank) {
+    for(UINT8 i=0; i<4; i++) map_chr_1k((slot << 2) + i, (bank << 2) + i);
+}
 
-    if(nesdata->header.nb_PRG_ROM == 1) {
-        PRG_ROM_RESOLUTION[1] = 0;
-    } else if (nesdata->header.nb_PRG_ROM == 2) {
-        PRG_ROM_RESOLUTION[1] = 0x4000;
-    }
+void ROMDefault::map_chr_8k(unsigned int bank) {
+    for(UINT8 slot=0; slot<NR_CHR_SLOTS; slot++) map_chr_1k(slot, (bank << 3) + slot);
+}
 
-    // TODO : handle it
-    // SRAM_SIZE = nesdata->header.BB_PRG_RAM;
+void ROMDefault::remap_banks() {
+    // a copied CHR RAM must not be shared with the original
+    if(chr_writable) CHR_DATA = chr_ram;
+    for(UINT8 slot=0; slot<NR_PRG_SLOTS; slot++) map_prg_8k(slot, prg_bank_index[slot]);
+    for(UINT8 slot=0; slot<NR_CHR_SLOTS; slot++) map_chr_1k(slot, chr_bank_index[slot]);
+}
 
-    // by default, we copy what we can into pattern table
-    if(nesdata->CHR_ROM_size / 8192 != 1) {
-        std::printf("Mapper 0 used with %d CHR_ROM 8kb chunks.\n", nesdata->CHR_ROM_size / 8192);
-        throw IncorrectFileFormat("Mapper 0 with != 1x8kb of CHR_ROM");
-    }
+void ROMDefault::set_cheats(std::shared_ptr<CheatPatches> patches) {
+    cheats = patches;
+    for(UINT8 slot=0; slot<NR_PRG_SLOTS; slot++) map_prg_8k(slot, prg_bank_index[slot]);
+}
 
-    for(int nr_table = 0; nr_table<2; nr_table++) {
-        for(int i=0; i<4096; i++) {
-            pt[nr_table][i] = nesdata->CHR_ROM_data[i + (nr_table << 12)];
-        }
+void ROMDefault::set_miroring(UINT8 scrmir) {
+    controls_miroring = 1;
+    miroring = scrmir;
+    if(ppu_mem) ppu_mem->set_screen_miroring((screen_miroring)scrmir);
+}
+
+void ROMDefault::set_ppu_mem(PPU_mem *ppu_m) {
+    ppu_mem = ppu_m;
+    // overrides the header miroring
+    if(ppu_mem && controls_miroring) ppu_mem->set_screen_miroring((screen_miroring)miroring);
+}
+
+ROMDefault::ROMDefault(struct nes_data *nesdata) {
+    if(nesdata->CHR_ROM_size / 8192 > 1) {
+        std::printf("Mapper 0 used with %d CHR_ROM 8kb chunks.\n", nesdata->CHR_ROM_size / 8192);
+        throw IncorrectFileFormat("Mapper 0 with > 1x8kb of CHR_ROM");
     }
+    init_banks(nesdata);
 }
 
 ROMMemManager *ROMDefault::save_state() {
-    ROMDefault *cloned = new ROMDefault();
-    cloned->PRG_ROM_SIZE = PRG_ROM_SIZE;
-    cloned->PRG_ROM_DATA = PRG_ROM_DATA;
-    cloned->PRG_ROM_RESOLUTION[0] = PRG_ROM_RESOLUTION[0];
-    cloned->PRG_ROM_RESOLUTION[1] = PRG_ROM_RESOLUTION[1];
-    // now the pt
-    for(int ptable=0; ptable<2; ptable++) {
-        for(int i=0; i<4096; i++) {
-            cloned->pt[ptable][i] = pt[ptable][i];
-        }
-    }
+    ROMDefault *cloned = new ROMDefault(*this);
+    cloned->remap_banks();
     return cloned;
 }
 
 ROMDefault::~ROMDefault() {}
 
 void ROMDefault::write(MEMADDR a, UINT8 val) {
-    // default : no behaviour in case of write !
-    return;
-}
-
-UINT8 ROMDefault::read(MEMADDR a) {
-    
-    if(a < 0x8000) return 0x00; // TODO : change it in case of SRAM
-
-    // 2nd highest bit of a : number of 16kb chunk of rom
-    // after putting down the highest bit, we select the second one (>>14), which gives 0 or 1, and we read the ROM using the rest of the address (a & 0x3FFF)
-
-    a &= 0x7FFF;
-    
-    return PRG_ROM_DATA[PRG_ROM_RESOLUTION[a >> 14]+(a & 0x3FFF)];
+    // default : no behaviour in case of write to the ROM !
+    if(a >= 0x6000 && a < 0x8000) write_prg_ram(a, val);
 }
 
 UINT8 ROMDefault::read_pt(MEMADDR a) {
-    int nr_table = !!(a & 0x1000);
-    return pt[nr_table][a & 0x0FFF];
+    return chr_banks[(a >> 10) & 0x07][a & 0x03FF];
 }
 
 void ROMDefault::write_pt(MEMADDR a, UINT8 val) {
-    // mapper 0, no !
-    return;
+    // only CHR RAM can be written
+    if(chr_writable) chr_banks[(a >> 10) & 0x07][a & 0x03FF] = val;
 }
 
 
@@ -335,4 +297,4 @@ void CPUMemoryManager::dump_stack(FILE *s) {
     for(UINT16 i=0; i<0x100; i++) {
         fprintf(s, "0x%02X : %02X\n", i, read_stack(i));
     }
-}
\ No newline at end of file
+}
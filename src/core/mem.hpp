@@ -1,8 +1,10 @@
 #ifndef MEM_GAYANES_HPP
 #define MEM_GAYANES_HPP
+#include <atomic>
 #include <memory>
 #include "types.hpp"
 #include "input_devices/device.hpp"
+#include "game_genie.hpp"
 
 class PPU_mem;
 class cpu6502;
@@ -10,14 +12,22 @@ struct nes_header;
 
 #define ADDR_SPACE_SIZE         65536
 #define STACK_PAGE_START        0x0100
+#define RAM_SIZE                0x0800
+#define PRG_RAM_SIZE            0x2000 // $6000-$7FFF
 // yay 16-bit addresses
 
 // ============== ROM HANDLING
 
-// 2 * 8 bytes per tile
-typedef UINT8 PATTERN_TABLE[4096];
+/* Where the PPU renderer reads the pattern tables : the mapper, or the code/data
+logger in between (see cdl.hpp) */
+class PatternReader
+{
+public:
+    virtual ~PatternReader(){};
+    virtual UINT8               read_pt(MEMADDR in_addr) = 0;
+};
 
-class ROMMemManager
+class ROMMemManager : public PatternReader
 {
 public:
     ROMMemManager(){};
@@ -28,28 +38,135 @@ public:
     virtual void                write_pt(MEMADDR in_addr, UINT8 val) = 0;
     virtual UINT8               read_pt(MEMADDR in_addr) = 0;
 
+    // needed by mappers which control the nametables miroring
+    virtual void                set_ppu_mem(PPU_mem *ppu_m) = 0;
+    // needed by mappers which raise IRQs
+    virtual void                set_cpu(cpu6502 *c) = 0;
+
+    /* Mappers counting scanlines on the rises of the PPU A12 line (MMC3) return 1 here.
+    The PPU then calls ppu_a12_rise() at the fetches where A12 can rise, which is once
+    per rendered scanline, instead of showing every pattern fetch to the mapper */
+    virtual BOOL                watches_ppu_a12() {return 0;};
+    virtual void                ppu_a12_rise() {};
+
+    /* Memory the CPU can fetch instructions from directly, for the page of a
+    ($6000-$FFFF) : returns base with base[x - lo] the byte at x, for
+    lo <= x < lo + len. len is 0 when there is none */
+    virtual const UINT8         *get_code_page(MEMADDR a, MEMADDR &lo, UINT32 &len) = 0;
+    // 8kb PRG ROM bank mapped at a, -1 below $8000 (for the profiler)
+    virtual int                 get_prg_bank(MEMADDR) {return -1;};
+    // 1kb CHR ROM bank mapped at a ($0000-$1FFF), -1 for CHR RAM
+    virtual int                 get_chr_bank(MEMADDR) {return -1;};
+
+    virtual UINT8               *get_prg_ram() = 0;
+    // counter of the PRG RAM writes (BatterySave::get_changes()), nullptr for none
+    virtual void                set_prg_ram_changes(std::atomic<UINT32> *changes) = 0;
+
+    // patched banks are used from now on (nullptr : no cheats)
+    virtual void                set_cheats(std::shared_ptr<CheatPatches> patches) = 0;
+
     virtual ROMMemManager       *save_state() = 0;
 };
 
+#define PRG_BANK_SIZE           0x2000
+#define CHR_BANK_SIZE           0x0400
+#define NR_PRG_SLOTS            4 // $8000-$FFFF, by 8kb
+#define NR_CHR_SLOTS            8 // $0000-$1FFF, by 1kb
 
+/*
+Mapper 0, and base of every other mapper.
+The CPU side $8000-$FFFF is seen through 4 pointers to 8kb PRG banks, and the
+PPU side $0000-$1FFF through 8 pointers to 1kb CHR banks (in CHR ROM, or in
+CHR RAM when the cartridge has none). Mappers only change those pointers when
+their registers are written, with map_prg_* and map_chr_*, so reads are a
+single indexing whatever the mapper.
+*/
 class ROMDefault : public ROMMemManager
 {
 protected:
     unsigned int  PRG_ROM_SIZE;
     UINT8         *PRG_ROM_DATA;
+    unsigned int  NR_PRG_BANKS; // 8kb banks
 
-    UINT32       PRG_ROM_RESOLUTION[2]; // array : number of 16kb chunk -> addr in PRG_ROM_DATA
+    unsigned int  CHR_SIZE;
+    UINT8         *CHR_DATA; // CHR ROM, or chr_ram
+    unsigned int  NR_CHR_BANKS; // 1kb banks
+    BOOL          chr_writable;
+    UINT8         chr_ram[0x2000];
 
-    PATTERN_TABLE pt[2];
+    UINT8         prg_ram[PRG_RAM_SIZE];
+    std::atomic<UINT32> *prg_ram_changes;
+    void          write_prg_ram(MEMADDR a, UINT8 val) {
+        // counted before the write, the battery save thread may be copying the RAM
+        if(prg_ram_changes) {
+            prg_ram_changes->store(prg_ram_changes->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+        prg_ram[a & 0x1FFF] = val;
+    };
+
+    UINT8         *prg_banks[NR_PRG_SLOTS];
+    unsigned int  prg_bank_index[NR_PRG_SLOTS];
+    UINT8         *chr_banks[NR_CHR_SLOTS];
+    unsigned int  chr_bank_index[NR_CHR_SLOTS];
+    // Game Genie, shared with the clones
+    std::shared_ptr<CheatPatches>
+                  cheats;
+
+    PPU_mem       *ppu_mem;
+    cpu6502       *cpu;
+    BOOL          controls_miroring;
+    UINT8         miroring; // screen_miroring value, when controls_miroring
+
+    void          init_banks(struct nes_data *nesdata);
+    // bank numbers wrap around the ROM size, as on the real boards
+    void          map_prg_8k(UINT8 slot, unsigned int bank);
+    void          map_prg_16k(UINT8 slot, unsigned int bank); // slot 0 : $8000, 1 : $C000
+    void          map_prg_32k(unsigned int bank);
+    void          map_chr_1k(UINT8 slot, unsigned int bank);
+    void          map_chr_4k(UINT8 slot, unsigned int bank); // slot 0 : $0000, 1 : $1000
+    void          map_chr_8k(unsigned int bank);
+    // sets the pointers again from the bank numbers, for clones
+    void          remap_banks();
+    void          set_miroring(UINT8 scrmir);
 
 public:
     ROMDefault(){};
     ROMDefault(struct nes_data *nes_data);
     virtual ~ROMDefault();
-    virtual UINT8               read(MEMADDR a);
+    // defined here so that the specialized cores can inline it
+    virtual UINT8               read(MEMADDR a) {
+        if(a < 0x8000) {
+            if(a >= 0x6000) return prg_ram[a & 0x1FFF];
+            return 0x00; // expansion area
+        }
+        // bits 13-14 : 8kb slot
+        return prg_banks[(a >> 13) & 0x03][a & 0x1FFF];
+    };
+    virtual const UINT8         *get_code_page(MEMADDR a, MEMADDR &lo, UINT32 &len) {
+        if(a >= 0x8000) {
+            lo = a & 0xE000;
+            len = PRG_BANK_SIZE;
+            return prg_banks[(a >> 13) & 0x03];
+        }
+        lo = 0x6000;
+        len = (a >= 0x6000)? PRG_RAM_SIZE : 0;
+        return prg_ram;
+    };
+    virtual int                 get_prg_bank(MEMADDR a) {
+        return (a >= 0x8000)? (int)prg_bank_index[(a >> 13) & 0x03] : -1;
+    };
+    virtual int                 get_chr_bank(MEMADDR a) {
+        return (chr_writable)? -1 : (int)chr_bank_index[(a >> 10) & 0x07];
+    };
     virtual void                write(MEMADDR a, UINT8 val);
     virtual void                write_pt(MEMADDR in_addr, UINT8 val);
     virtual UINT8               read_pt(MEMADDR in_addr);
+    virtual void                set_ppu_mem(PPU_mem *ppu_m);
+    virtual void                set_cpu(cpu6502 *c) {cpu = c;};
+    virtual UINT8               *get_prg_ram() {return prg_ram;};
+    virtual void                set_prg_ram_changes(std::atomic<UINT32> *changes) {prg_ram_changes = changes;};
+    virtual void                set_cheats(std::shared_ptr<CheatPatches> patches);
 
     virtual ROMMemManager       *save_state();
 };
@@ -57,15 +174,6 @@ public:
 // Abstract class of memory manager for the CPU
 class CPUMemoryManager
 {
-protected:
-
-    struct GameGenie {
-        MEMADDR addr;
-        UINT8   data;
-    };
-    BOOL                        game_genie_active;
-    struct GameGenie            game_genie; 
-
 public:
     CPUMemoryManager(){};
     virtual ~CPUMemoryManager(){};
@@ -78,14 +186,14 @@ public:
     virtual void        write_stack(ZPADDR offset, UINT8 val) = 0;
     virtual void        set_ppu_mem(PPU_mem *ppu_m){ppu_mem = ppu_m;};
     void                dump_stack(FILE *s);
-    virtual void        set_game_genie(std::string &genie_code) = 0;
-    virtual void        unset_game_genie() = 0;
     virtual void        write(MEMADDR a, UINT8 val) = 0;
     virtual UINT8       read(MEMADDR a) = 0;
+    // internal RAM, RAM_SIZE bytes
+    virtual const UINT8 *get_ram() = 0;
 
     virtual CPUMemoryManager
                         *save_state() = 0;
-}; 
+};
 
 // =========== REAL NES
 
@@ -97,28 +205,84 @@ class NESMemory : public CPUMemoryManager
 {
 protected:
 
-    UINT8                       memRAM[0x0800];
+    UINT8                       memRAM[RAM_SIZE];
     UINT8                       APUJoypads[0x17];    
 
     void                        check_ppu_sync(); 
+    // $2000-$401F : PPU, APU and joypads registers
+    UINT8                       read_io(MEMADDR a);
+    void                        write_io(MEMADDR a, UINT8 val);
 
 public:
     NESMemory(ROMMemManager *memrom) {
         memROM = memrom;
-        game_genie_active = 0;
         for(int i=0; i<0x0800; i++) memRAM[i] = 0;
     };
     virtual ~NESMemory(){};
-    virtual UINT8               read(MEMADDR a);
-    virtual void                write(MEMADDR a, UINT8 val);
-    virtual UINT8               read_stack(ZPADDR offset);
-    virtual void                write_stack(ZPADDR offset, UINT8 val);
-
-    virtual void        set_game_genie(std::string &genie_code);
-    virtual void        unset_game_genie();
+    // any mapper, through ROMMemManager
+    virtual UINT8               read(MEMADDR a) {
+        if(a < 0x2000) return memRAM[a & 0x07FF]; // main ram and its mirrors
+        if(a < 0x4020) return read_io(a);
+        return memROM->read(a);
+    };
+    virtual void                write(MEMADDR a, UINT8 val) {
+        if(a < 0x2000) memRAM[a & 0x07FF] = val;
+        else if(a < 0x4020) write_io(a, val);
+        else memROM->write(a, val);
+    };
+    virtual UINT8               read_stack(ZPADDR offset) {return memRAM[STACK_PAGE_START+(MEMADDR)offset];};
+    virtual void                write_stack(ZPADDR offset, UINT8 val) {memRAM[STACK_PAGE_START+(MEMADDR)offset] = val;};
+    virtual const UINT8         *get_ram() {return memRAM;};
+    // for the dynarec, which writes it directly
+    UINT8                       *get_ram_rw() {return memRAM;};
+    /* the next read of $2002 would return the same as the last one, and clear nothing
+    (as long as the PPU doesn't run) */
+    BOOL                        ppu_status_stable();
+    // see ROMMemManager::get_code_page, for the whole address space
+    const UINT8                 *get_code_page(MEMADDR a, MEMADDR &lo, UINT32 &len) {
+        if(a < 0x2000) {
+            lo = a & 0x1800; // mirror
+            len = RAM_SIZE;
+            return memRAM;
+        }
+        if(a < 0x4020) {
+            len = 0;
+            return nullptr;
+        }
+        return memROM->get_code_page(a, lo, len);
+    };
 
     virtual CPUMemoryManager
                         *save_state();
 
 };
+
+/*
+NES memory map for a given mapper class, used by the cores of core_resolve
+(mappers/mapper_resolve.hpp) : the calls to the mapper are not virtual, and
+RAM and PRG reads can be inlined up to the CPU instructions.
+ROM must be the exact class of memROM.
+*/
+template<class ROM>
+class NESMemoryT final : public NESMemory
+{
+public:
+    NESMemoryT(ROM *memrom) : NESMemory(memrom) {};
+    UINT8                       read(MEMADDR a) {
+        if(a < 0x2000) return memRAM[a & 0x07FF];
+        if(a < 0x4020) return read_io(a);
+        return static_cast<ROM *>(memROM)->ROM::read(a);
+    };
+    void                        write(MEMADDR a, UINT8 val) {
+        if(a < 0x2000) memRAM[a & 0x07FF] = val;
+        else if(a < 0x4020) write_io(a, val);
+        else static_cast<ROM *>(memROM)->ROM::write(a, val);
+    };
+    const UINT8                 *get_code_page(MEMADDR a, MEMADDR &lo, UINT32 &len) {
+        if(a < 0x4020) return NESMemory::get_code_page(a, lo, len);
+        return static_cast<ROM *>(memROM)->ROM::get_code_page(a, lo, len);
+    };
+
+    CPUMemoryManager            *save_state() {return new NESMemoryT(*this);};
+};
 #endif
\ No newline at end of file
@@ -61,17 +61,28 @@ struct nes_header read_nes_header(FILE *nesfile) {
     return header;
 }
 
+#define EXCEPTION_TRUNCATED(offset, size, image)  \
+    if((offset) + (size) > (image)->get_size())   \
+        throw FileReadingError("The nes file is truncated.")
+
 struct nes_data read_nes_data(FILE *nesfile, struct nes_header header) {
     struct nes_data nesdata;
     size_t size_read;
     
     nesdata.header = header;
-    EXCEPTION_SEEK(nesfile, 16, SEEK_SET);
+    nesdata.TRAINER = nullptr;
+    nesdata.INST_ROM = nullptr;
+    nesdata.PROM = nullptr;
+
+    // everything points directly into the file image, nothing is copied
+    nesdata.image = ROMImage::open(nesfile);
+    UINT8 *data = (UINT8*) nesdata.image->get_data();
+    size_t offset = 16;
 
     if(header.TRAINER) {
-        nesdata.TRAINER = (UINT8*) calloc(512, 1);
-        if(!nesdata.TRAINER) throw MemAllocFailed("mem alloc for TRAINER failed");
-        EXCEPTION_READ(nesdata.TRAINER, 1, 512, nesfile);
+        EXCEPTION_TRUNCATED(offset, 512, nesdata.image);
+        nesdata.TRAINER = data + offset;
+        offset += 512;
     }
 
     // PRG ROM
@@ -81,35 +92,33 @@ struct nes_data read_nes_data(FILE *nesfile, struct nes_header header) {
         throw IncorrectFileFormat("nb_PRG_ROM larger null.");
 
     size_read = 16384 * header.nb_PRG_ROM;
+    EXCEPTION_TRUNCATED(offset, size_read, nesdata.image);
     nesdata.PRG_ROM_size = size_read;
-    nesdata.PRG_ROM_data = (UINT8*) calloc(size_read, 1);
-    if(!nesdata.PRG_ROM_data) throw MemAllocFailed("mem alloc failed for PRG-ROM");
-
-    EXCEPTION_READ(nesdata.PRG_ROM_data, 1, size_read, nesfile);
+    nesdata.PRG_ROM_data = data + offset;
+    offset += size_read;
 
     // CHR ROM
 
     size_read = 8192 * header.nb_CHR_ROM;
+    EXCEPTION_TRUNCATED(offset, size_read, nesdata.image);
     nesdata.CHR_ROM_size = size_read;
-    nesdata.CHR_ROM_data = (UINT8*) calloc(size_read, 1);
-    if(!nesdata.CHR_ROM_data) throw MemAllocFailed("mem alloc failed for CHR-ROM");
-
-    EXCEPTION_READ(nesdata.CHR_ROM_data, 1, size_read, nesfile);
+    nesdata.CHR_ROM_data = data + offset;
+    offset += size_read;
 
     if(header.CONSOLE_TYPE == 2) {
         // PlayChoice
-        nesdata.INST_ROM = (UINT8*) calloc(1, 8192);
-        if(!nesdata.INST_ROM) throw MemAllocFailed("mem alloc failed for INST-ROM");
-        EXCEPTION_READ(nesdata.INST_ROM, 1, 8192, nesfile);
-
-        nesdata.PROM = (UINT8*) calloc(1, 32);
-        if(!nesdata.PROM) throw MemAllocFailed("mem alloc failed for PROM");
-        EXCEPTION_READ(nesdata.PROM, 1, 32, nesfile);
+        EXCEPTION_TRUNCATED(offset, 8192 + 32, nesdata.image);
+        nesdata.INST_ROM = data + offset;
+        nesdata.PROM = data + offset + 8192;
+        offset += 8192 + 32;
     }
 
     // finally, sometimes there is a title
     memset(nesdata.TITLE, '\0', 129);
-    fread(nesdata.TITLE, 1, 128, nesfile);
+    if(offset < nesdata.image->get_size()) {
+        size_t title_size = nesdata.image->get_size() - offset;
+        memcpy(nesdata.TITLE, data + offset, (title_size < 128)? title_size : 128);
+    }
     // we don't check for error as this is optional
 
     return nesdata;
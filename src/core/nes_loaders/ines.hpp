@@ -2,7 +2,9 @@
 #define GAYA_INES_HPP
 
 #include <stdio.h>
+#include <memory>
 #include "../types.hpp"
+#include "rom_image.hpp"
 
 /*
 NES loader structures
@@ -26,6 +28,9 @@ struct nes_header {
 
 struct nes_data {
     struct nes_header   header;
+    // the whole file, read-only : all the pointers below point into it
+    std::shared_ptr<ROMImage>
+                        image;
     UINT8               *TRAINER; //null if not present, as indicated in header
                                   //512 bytes otherwise
 
@@ -52,7 +57,8 @@ Can throw:
 struct nes_header read_nes_header(FILE *nesfile);
 
 /* Read the data of a nes file, in format FILE * opened in r mode,
-given the struct nes_header (as returned by read_nes_header) 
+given the struct nes_header (as returned by read_nes_header).
+The file is mapped in memory (see ROMImage), and can be closed afterwards.
 
 Can throw:
 - FileReadingError
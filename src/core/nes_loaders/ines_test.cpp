@@ -7,7 +7,7 @@
 Small program to test iNES loader
 donkey_kong.nes should be in the same dir
 
-Compile with `g++ -o ines_test ines_test.cpp ines.cpp`
+Compile with `g++ -o ines_test ines_test.cpp ines.cpp rom_image.cpp`
 */
 
 int main() {
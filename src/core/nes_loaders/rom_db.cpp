@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cstdio>
+#include "rom_db.hpp"
+
+// ============== CRC32
+
+static UINT32 crc_tables[8][256];
+
+static bool init_crc_tables() {
+    for(UINT32 i=0; i<256; i++) {
+        UINT32 c = i;
+        for(int k=0; k<8; k++) c = (c >> 1) ^ ((c & 1)? 0xEDB88320 : 0);
+        crc_tables[0][i] = c;
+    }
+    // table n : crc of a byte followed by n zeros
+    for(UINT32 i=0; i<256; i++) {
+        for(int t=1; t<8; t++) {
+            crc_tables[t][i] = (crc_tables[t-1][i] >> 8) ^ crc_tables[0][crc_tables[t-1][i] & 0xFF];
+        }
+    }
+    return true;
+}
+
+UINT32 crc32(const UINT8 *data, size_t len, UINT32 crc) {
+    static bool tables_ready = init_crc_tables();
+    (void) tables_ready;
+
+    crc = ~crc;
+    // 8 bytes per step, little endian words
+    while(len >= 8) {
+        UINT32 low = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) | ((UINT32)data[3] << 24));
+        crc = crc_tables[7][low & 0xFF] ^ crc_tables[6][(low >> 8) & 0xFF]
+            ^ crc_tables[5][(low >> 16) & 0xFF] ^ crc_tables[4][low >> 24]
+            ^ crc_tables[3][data[4]] ^ crc_tables[2][data[5]]
+            ^ crc_tables[1][data[6]] ^ crc_tables[0][data[7]];
+        data += 8; len -= 8;
+    }
+    while(len--) crc = (crc >> 8) ^ crc_tables[0][(crc ^ *data++) & 0xFF];
+    return ~crc;
+}
+
+// ============== SHA-1
+
+static inline UINT32 rotl32(UINT32 x, int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+SHA1::SHA1() : length(0), block_len(0) {
+    state[0] = 0x67452301; state[1] = 0xEFCDAB89; state[2] = 0x98BADCFE;
+    state[3] = 0x10325476; state[4] = 0xC3D2E1F0;
+}
+
+void SHA1::transform(const UINT8 *chunk) {
+    UINT32 w[80];
+    for(int i=0; i<16; i++) {
+        w[i] = ((UINT32)chunk[4*i] << 24) | (chunk[4*i+1] << 16) | (chunk[4*i+2] << 8) | chunk[4*i+3];
+    }
+    for(int i=16; i<80; i++) w[i] = rotl32(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+
+    UINT32 a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+#define SHA1_ROUND(f, k, i) { \
+        UINT32 tmp = rotl32(a, 5) + (f) + e + (k) + w[i]; \
+        e = d; d = c; c = rotl32(b, 30); b = a; a = tmp; }
+    for(int i=0; i<20; i++)  SHA1_ROUND((b & c) | (~b & d), 0x5A827999, i);
+    for(int i=20; i<40; i++) SHA1_ROUND(b ^ c ^ d, 0x6ED9EBA1, i);
+    for(int i=40; i<60; i++) SHA1_ROUND((b & c) | (b & d) | (c & d), 0x8F1BBCDC, i);
+    for(int i=60; i<80; i++) SHA1_ROUND(b ^ c ^ d, 0xCA62C1D6, i);
+#undef SHA1_ROUND
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+}
+
+void SHA1::update(const UINT8 *data, size_t len) {
+    length += len;
+    if(block_len) {
+        size_t n = std::min(len, 64 - block_len);
+        std::copy(data, data + n, block + block_len);
+        block_len += n; data += n; len -= n;
+        if(block_len < 64) return;
+        transform(block);
+        block_len = 0;
+    }
+    while(len >= 64) {
+        transform(data);
+        data += 64; len -= 64;
+    }
+    std::copy(data, data + len, block);
+    block_len = len;
+}
+
+void SHA1::final(UINT8 digest[20]) {
+    UINT64 bits = length * 8;
+    UINT8 pad = 0x80;
+    update(&pad, 1);
+    pad = 0;
+    while(block_len != 56) update(&pad, 1);
+    UINT8 len_be[8];
+    for(int i=0; i<8; i++) len_be[i] = (UINT8)(bits >> (56 - 8*i));
+    update(len_be, 8);
+    for(int i=0; i<20; i++) digest[i] = (UINT8)(state[i >> 2] >> (24 - 8*(i & 3)));
+}
+
+// ============== ROM IDENTIFICATION
+
+UINT32 rom_crc32(struct nes_data &nesdata) {
+    UINT32 crc = crc32(nesdata.PRG_ROM_data, nesdata.PRG_ROM_size);
+    return crc32(nesdata.CHR_ROM_data, nesdata.CHR_ROM_size, crc);
+}
+
+std::string rom_sha1(struct nes_data &nesdata) {
+    static const char hex[] = "0123456789abcdef";
+    SHA1 sha;
+    UINT8 digest[20];
+    sha.update(nesdata.PRG_ROM_data, nesdata.PRG_ROM_size);
+    sha.update(nesdata.CHR_ROM_data, nesdata.CHR_ROM_size);
+    sha.final(digest);
+    std::string res;
+    for(int i=0; i<20; i++) {
+        res += hex[digest[i] >> 4];
+        res += hex[digest[i] & 0x0F];
+    }
+    return res;
+}
+
+/*
+Known cartridges, sorted by crc32.
+Only dumps which were actually checked belong here : a wrong entry would break a
+game which loads fine with its own header.
+*/
+static const struct rom_db_entry rom_db[] = {
+    // crc32      mapper mir bat 4scr
+    {0x401349A8,  0,     0,  0,  0,   "Balloon Fight"},
+    {0x6F97C721,  0,     0,  0,  0,   "Donkey Kong"},
+    {0x94476A70,  2,     1,  0,  0,   "Mega Man"},
+    {0xA93527E2,  2,     1,  0,  0,   "Castlevania"},
+    {0xD445F698,  0,     1,  0,  0,   "Super Mario Bros."},
+    {0xE94E883D,  4,     0,  0,  0,   "Super Mario Bros. 2"},
+    {0xFB98D46E,  0,     0,  0,  0,   "Ice Climber"},
+};
+
+const struct rom_db_entry *rom_db_lookup(UINT32 crc) {
+    const struct rom_db_entry *end = rom_db + sizeof(rom_db) / sizeof(rom_db[0]);
+    const struct rom_db_entry *it = std::lower_bound(rom_db, end, crc,
+        [](const struct rom_db_entry &e, UINT32 c) {return e.crc32 < c;});
+    if(it == end || it->crc32 != crc) return nullptr;
+    return it;
+}
+
+int rom_db_correct_header(struct nes_data &nesdata, const struct rom_db_entry *entry) {
+    struct nes_header &h = nesdata.header;
+    int nr_changed = 0;
+    if(h.MAPPER_NB != entry->mapper) {
+        std::printf("Header correction : mapper %d -> %d\n", h.MAPPER_NB, entry->mapper);
+        h.MAPPER_NB = entry->mapper; nr_changed++;
+    }
+    if(h.SCREEN_MIRRORING != entry->mirroring) {
+        std::printf("Header correction : mirroring %d -> %d\n", h.SCREEN_MIRRORING, entry->mirroring);
+        h.SCREEN_MIRRORING = entry->mirroring; nr_changed++;
+    }
+    if(h.BB_PRG_RAM != entry->battery) {
+        std::printf("Header correction : battery %d -> %d\n", h.BB_PRG_RAM, entry->battery);
+        h.BB_PRG_RAM = entry->battery; nr_changed++;
+    }
+    if(h.FOUR_SCREENS != entry->four_screens) {
+        std::printf("Header correction : four screens %d -> %d\n", h.FOUR_SCREENS, entry->four_screens);
+        h.FOUR_SCREENS = entry->four_screens; nr_changed++;
+    }
+    return nr_changed;
+}
@@ -0,0 +1,56 @@
+#ifndef GAYA_ROM_DB_HPP
+#define GAYA_ROM_DB_HPP
+
+#include <string>
+#include "../types.hpp"
+#include "ines.hpp"
+
+/*
+Identification of a game from the content of its ROM (PRG followed by CHR, without
+the iNES header, so that a corrected header doesn't change it).
+
+The CRC32 is the usual IEEE one, as used by the NES ROM databases, and is computed
+at load to look the game up in a small compiled-in database of known cartridges,
+which corrects the header fields dumps often get wrong.
+The SHA-1 is only computed when asked for, to key save files and per-game data.
+*/
+
+// CRC32 (IEEE, reflected 0xEDB88320), slice-by-8. Can be chained with the previous crc
+UINT32 crc32(const UINT8 *data, size_t len, UINT32 crc = 0);
+
+class SHA1
+{
+public:
+    SHA1();
+    void                update(const UINT8 *data, size_t len);
+    void                final(UINT8 digest[20]);
+
+private:
+    UINT32              state[5];
+    UINT64              length; // in bytes
+    UINT8               block[64];
+    size_t              block_len;
+
+    void                transform(const UINT8 *chunk);
+};
+
+struct rom_db_entry {
+    UINT32      crc32;      // of PRG + CHR
+    UINT8       mapper;
+    BOOL        mirroring;  // as in nes_header : 0 horizontal, 1 vertical
+    BOOL        battery;
+    BOOL        four_screens;
+    const char  *name;
+};
+
+UINT32 rom_crc32(struct nes_data &nesdata);
+// 40 lowercase hex characters
+std::string rom_sha1(struct nes_data &nesdata);
+
+// nullptr for unknown games
+const struct rom_db_entry *rom_db_lookup(UINT32 crc);
+/* Overrides the header fields of nesdata which disagree with the database.
+Returns the number of fields changed */
+int rom_db_correct_header(struct nes_data &nesdata, const struct rom_db_entry *entry);
+
+#endif
@@ -0,0 +1,66 @@
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <map>
+#include <mutex>
+#include "rom_image.hpp"
+#include "../exceptions.hpp"
+
+// images currently alive, by (device, inode)
+static std::mutex registry_mutex;
+static std::map<std::pair<dev_t, ino_t>, std::weak_ptr<ROMImage>> registry;
+
+ROMImage::~ROMImage() {
+    if(mapped) munmap(data, size);
+    else free(data);
+}
+
+std::shared_ptr<ROMImage> ROMImage::open(FILE *f) {
+    struct stat st;
+    int fd = fileno(f);
+    if(fd < 0 || fstat(fd, &st) || !S_ISREG(st.st_mode) || !st.st_size) return read_file(f);
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto key = std::make_pair(st.st_dev, st.st_ino);
+    auto it = registry.find(key);
+    if(it != registry.end()) {
+        std::shared_ptr<ROMImage> image = it->second.lock();
+        // the file may have been replaced since
+        if(image && image->size == (size_t)st.st_size && image->mtime == st.st_mtime) return image;
+        registry.erase(it);
+    }
+
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(addr == MAP_FAILED) return read_file(f);
+
+    std::shared_ptr<ROMImage> image(new ROMImage());
+    image->data = (UINT8*) addr;
+    image->size = st.st_size;
+    image->mapped = true;
+    image->dev = st.st_dev;
+    image->ino = st.st_ino;
+    image->mtime = st.st_mtime;
+    registry[key] = image;
+    return image;
+}
+
+std::shared_ptr<ROMImage> ROMImage::read_file(FILE *f) {
+    std::shared_ptr<ROMImage> image(new ROMImage());
+    size_t capacity = 0x10000;
+    // the header was already read from it
+    if(fseek(f, 0, SEEK_SET)) throw FileReadingError("The nes file can't be read again from the start.");
+    image->data = (UINT8*) malloc(capacity);
+    if(!image->data) throw MemAllocFailed("mem alloc failed for ROM image");
+    size_t nr_read;
+    while((nr_read = fread(image->data + image->size, 1, capacity - image->size, f)) > 0) {
+        image->size += nr_read;
+        if(image->size == capacity) {
+            capacity *= 2;
+            UINT8 *bigger = (UINT8*) realloc(image->data, capacity);
+            if(!bigger) throw MemAllocFailed("mem alloc failed for ROM image");
+            image->data = bigger;
+        }
+    }
+    if(ferror(f)) throw FileReadingError("Error while reading the nes file.");
+    return image;
+}
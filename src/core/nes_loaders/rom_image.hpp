@@ -0,0 +1,47 @@
+#ifndef GAYA_ROM_IMAGE_HPP
+#define GAYA_ROM_IMAGE_HPP
+
+#include <stdio.h>
+#include <memory>
+#include <sys/types.h>
+#include "../types.hpp"
+
+/*
+Read-only image of a whole ROM file, which PRG and CHR banks point into.
+
+The file is memory mapped, and a file is only mapped once per process : opening
+it again (same device and inode) while an image of it is alive gives back the same
+image. Other processes mapping the same file share its pages in the page cache.
+When the file can't be mapped, it is read in memory instead (it still has to be
+seekable, as the header was read before).
+*/
+class ROMImage
+{
+public:
+    ~ROMImage();
+
+    /* Can throw:
+    - FileReadingError
+    - MemAllocFailed */
+    static std::shared_ptr<ROMImage> open(FILE *f);
+
+    const UINT8         *get_data() {return data;};
+    size_t              get_size() {return size;};
+    bool                is_mapped() {return mapped;};
+
+private:
+    ROMImage() : data(nullptr), size(0), mapped(false), dev(0), ino(0), mtime(0) {};
+
+    UINT8               *data;
+    size_t              size;
+    bool                mapped;
+
+    // identity of the file, for the registry
+    dev_t               dev;
+    ino_t               ino;
+    time_t              mtime;
+
+    static std::shared_ptr<ROMImage> read_file(FILE *f);
+};
+
+#endif
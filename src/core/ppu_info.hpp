@@ -5,7 +5,8 @@
 
 
 typedef enum {
-    MIRORING_HORIZONTAL, MIRORING_VERTICAL, MIRORING_SINGLE, MIRORING_FOUR
+    // MIRORING_SINGLE uses the lower physical nametable, MIRORING_SINGLE_UPPER the other one
+    MIRORING_HORIZONTAL, MIRORING_VERTICAL, MIRORING_SINGLE, MIRORING_FOUR, MIRORING_SINGLE_UPPER
 } screen_miroring;
 
 struct OAMentry {
@@ -146,6 +147,7 @@ private:
 
 
     UINT8               last_bits_written; // to be returned by PPUSTATUS
+    UINT8               last_status; // last value read from PPUSTATUS
 
 
     struct OAM          primary_oam;
@@ -166,7 +168,8 @@ public:
     struct PPU_state    *ppu_state;
     cpu6502             *cpu;
     ROMMemManager       *rom;
-
+    // rom, or the code/data logger (set_rom() puts rom back)
+    PatternReader       *bg_pt, *sprite_pt;
 
     void                increment_coarse_x_vram_addr();
     void                increment_y_vram_addr();
@@ -182,10 +185,18 @@ public:
 
     void                write_ppu_pt(MEMADDR a, UINT8 val){rom->write_pt(a, val);};
     UINT8               read_ppu_pt(MEMADDR a){return rom->read_pt(a);};
+    // fetches of the renderer, through the code/data logger while it runs
+    UINT8               read_bg_pt(MEMADDR a){return bg_pt->read_pt(a);};
+    UINT8               read_sprite_pt(MEMADDR a){return sprite_pt->read_pt(a);};
+    void                set_rom(ROMMemManager *r) {rom = r; bg_pt = r; sprite_pt = r;};
+    void                set_pattern_readers(PatternReader *bg, PatternReader *sprite) {bg_pt = bg; sprite_pt = sprite;};
 
     void    write_PPUCTRL(UINT8 ctrl);
     void    write_PPUMASK(UINT8 mask);
     UINT8   read_PPUSTATUS();
+    // what read_PPUSTATUS() would return now, without clearing anything
+    UINT8   peek_PPUSTATUS();
+    UINT8   get_last_status() {return last_status;};
     void    write_OAMADDR(UINT8 oamaddr);
     void    write_OAMDATA(UINT8 oamdata);
     UINT8   read_OAMDATA();
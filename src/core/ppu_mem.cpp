@@ -54,6 +54,7 @@ PPU_mem::PPU_mem(PPU_state *ppu_s) {
     */
 
     ppu_state = ppu_s;
+    set_rom(nullptr); // set by the emulation manager
     ppu_state->VRAM_ADDRESS = 0;
     ppu_state->internal_vram = 0;
     ppu_state->VRAM_INCREMENT = 1;
@@ -68,6 +69,7 @@ PPU_mem::PPU_mem(PPU_state *ppu_s) {
     ppu_state->SPRITE_OVERFLOW = 0;
     ppu_state->SPRITE_SIZE = 0;
     last_bits_written = 0;
+    last_status = 0;
 
     ppu_state->IN_VBLANK = 1;
     ppu_state->NMI_VBLANK = 0;
@@ -122,6 +124,7 @@ static void copy_oam(struct OAM &src, struct OAM &dst) {
 PPU_mem::PPU_mem(PPU_mem &p) {
     // ppu state will be handled else where
     ppu_state = nullptr;
+    set_rom(nullptr);
     // Nametables
     for(int nt=0; nt<4; nt++) {
         for(int i=0; i<1024; i++) {
@@ -133,6 +136,7 @@ PPU_mem::PPU_mem(PPU_mem &p) {
     }
     PPUDATA_read_buffer = p.PPUDATA_read_buffer;
     last_bits_written = p.last_bits_written;
+    last_status = p.last_status;
     // oam
     copy_oam(p.primary_oam, primary_oam);
     for(int i=0; i<8; i++) {
@@ -164,8 +168,8 @@ void PPU_mem::write_PPUCTRL(UINT8 ctrl) {
     // TODO : PPU master/slave ?
 
     if(ppu_state->IN_VBLANK && !ppu_state->NMI_VBLANK && has_nmi) {
-        // immediately triggers an NMI
-        cpu->enter_nmi();
+        // triggers an NMI right after this instruction
+        cpu->raise_nmi(cpu->get_cycles());
     }
 
     ppu_state->NMI_VBLANK = has_nmi;
@@ -183,7 +187,7 @@ void PPU_mem::write_PPUMASK(UINT8 mask) {
     last_bits_written = mask & 0x1F;
 }
 
-UINT8 PPU_mem::read_PPUSTATUS() {
+UINT8 PPU_mem::peek_PPUSTATUS() {
     UINT8 res = last_bits_written;
     /*
     Ok so Sprite overflow : TODO,
@@ -192,9 +196,15 @@ UINT8 PPU_mem::read_PPUSTATUS() {
    res |= (!!(ppu_state->IN_VBLANK)) << 7;
    res |= (!!(ppu_state->SPRITE0HIT)) << 6;
    res |= (!!(ppu_state->SPRITE_OVERFLOW)) << 5;
+   return res;
+}
+
+UINT8 PPU_mem::read_PPUSTATUS() {
+   UINT8 res = peek_PPUSTATUS();
 
    ppu_state->IN_VBLANK = 0;
    ppu_state->WRITE_TOGGLE = 0;
+   last_status = res;
 
     //std::printf("Returning %02X\n", res);
    return res;
@@ -435,6 +445,13 @@ void PPU_mem::set_screen_miroring(screen_miroring scrmir) {
         NT_correspondance[3] = 3;
         break;
 
+    case MIRORING_SINGLE_UPPER:
+        NT_correspondance[0] = 1;
+        NT_correspondance[1] = 1;
+        NT_correspondance[2] = 1;
+        NT_correspondance[3] = 1;
+        break;
+
     default:
         break;
     }
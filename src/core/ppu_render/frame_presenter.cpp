@@ -0,0 +1,71 @@
+#include "frame_presenter.hpp"
+#include "../exceptions.hpp"
+
+FramePresenter::FramePresenter(sdl_context *sdl_ctx) : sdl_ctx(sdl_ctx), texture(nullptr), latency_probe(nullptr),
+        back(0), front(1), last_published(2), middle(2), deferred(false)
+{
+    for(int i = 0; i < 3; i++) {
+        frames[i] = 0;
+        for(int p = 0; p < FRAME_WIDTH*FRAME_HEIGHT; p++) buffers[i][p] = 0xFF000000;
+    }
+    if(sdl_ctx && sdl_ctx->renderer) {
+        texture = SDL_CreateTexture(sdl_ctx->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                    FRAME_WIDTH, FRAME_HEIGHT);
+        if(!texture) {
+            throw MemAllocFailed("Allocation of sdl texture failed in frame presenter\n");
+        }
+    }
+}
+
+FramePresenter::~FramePresenter()
+{
+    if(texture) SDL_DestroyTexture(texture);
+}
+
+UINT32 FramePresenter::get_wake_event() {
+    static const UINT32 wake_event = SDL_RegisterEvents(1);
+    return wake_event;
+}
+
+void FramePresenter::publish(UINT32 frame) {
+    frames[back] = frame;
+    last_published = back;
+    UINT8 previous = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel);
+    back = previous & ~FRESH_BIT;
+    // never blocks. A frame still fresh was not presented yet, its event is still queued
+    if(deferred.load(std::memory_order_relaxed) && !(previous & FRESH_BIT)) {
+        SDL_Event ev;
+        SDL_zero(ev);
+        ev.type = get_wake_event();
+        SDL_PushEvent(&ev);
+    }
+}
+
+bool FramePresenter::present_latest() {
+    if(!(middle.load(std::memory_order_acquire) & FRESH_BIT)) return false;
+    front = middle.exchange(front, std::memory_order_acq_rel) & ~FRESH_BIT;
+
+    if(texture) {
+        SDL_UpdateTexture(texture, NULL, buffers[front], FRAME_WIDTH*sizeof(UINT32));
+        SDL_RenderCopy(sdl_ctx->renderer, texture, NULL, NULL);
+        SDL_RenderPresent(sdl_ctx->renderer);
+    }
+    if(latency_probe) latency_probe->frame_presented(frames[front]);
+    return true;
+}
+
+bool FramePresenter::present_deferred() {
+    std::lock_guard<std::mutex> lock(present_mutex);
+    if(!deferred.load()) return false;
+    return present_latest();
+}
+
+void FramePresenter::start_deferred() {
+    get_wake_event();
+    deferred = true;
+}
+
+void FramePresenter::stop_deferred() {
+    std::lock_guard<std::mutex> lock(present_mutex);
+    deferred = false;
+}
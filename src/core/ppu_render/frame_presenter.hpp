@@ -0,0 +1,74 @@
+#ifndef GAYA_FRAME_PRESENTER_HPP
+#define GAYA_FRAME_PRESENTER_HPP
+
+#include "../types.hpp"
+#include "draw_tile.hpp"
+#include "../latency_probe.hpp"
+
+#include <atomic>
+#include <mutex>
+
+#define FRAME_WIDTH  256
+#define FRAME_HEIGHT 240
+
+/*
+Hands the frames rendered by the PPU over to the display, through a triple buffer :
+the PPU draws in the back buffer, publish() swaps it with the middle one, and the
+presenting thread swaps the middle one with the front buffer when it is fresh.
+None of them ever waits for the other, and the display always shows the newest
+complete frame.
+SDL wants the renderer used by the thread which created it (the main one). With
+deferred presentation, the emulation runs on another thread, and publish() only
+wakes the main thread up with an SDL event of type get_wake_event(), on which it
+calls present_deferred().
+Pixels are stored as ARGB8888, one UINT32 per NES pixel (the scaling to the window
+is done by SDL_RenderCopy).
+*/
+class FramePresenter
+{
+public:
+    FramePresenter(sdl_context *sdl_ctx);
+    ~FramePresenter();
+
+    // buffer the PPU should currently draw into (changes after each publish())
+    UINT32                      *get_back_buffer() {return buffers[back];};
+    // back buffer is complete : hand it over to the display
+    void                        publish(UINT32 frame);
+    /* Last published frame. Only valid on the thread calling publish(), until
+    its next call */
+    const UINT32                *get_last_published() {return buffers[last_published];};
+
+    /* Once stopped, present_deferred() does nothing, and the frames are presented
+    by the thread calling publish() */
+    void                        start_deferred();
+    void                        stop_deferred();
+    bool                        is_deferred() {return deferred.load();};
+    static UINT32               get_wake_event();
+
+    /* Uploads and presents the newest published frame, if there is one which was not
+    shown yet. Called directly when the presentation is not deferred */
+    bool                        present_latest();
+    // same, on the wake event, by the thread owning the renderer
+    bool                        present_deferred();
+
+    void                        set_latency_probe(LatencyProbe *probe) {latency_probe = probe;};
+
+private:
+    static const UINT8          FRESH_BIT = 0x04;
+
+    sdl_context                 *sdl_ctx;
+    SDL_Texture                 *texture;
+    LatencyProbe                *latency_probe;
+
+    UINT32                      buffers[3][FRAME_WIDTH*FRAME_HEIGHT];
+    UINT32                      frames[3]; // frame number of each buffer
+    UINT8                       back, front, last_published;
+    // index of the middle buffer, with FRESH_BIT if it was published and not presented yet
+    std::atomic<UINT8>          middle;
+
+    std::atomic<bool>           deferred;
+    // held while presenting, so that stop_deferred() returns once the renderer is free
+    std::mutex                  present_mutex;
+};
+
+#endif
@@ -5,20 +5,22 @@
 #define BITSELECT16(val, pos) (((val) >> pos) & 0x0001)
 #define BITSELECT8(val, pos) (((val) >> pos) & 0x01)
 
-PPU_Render::PPU_Render(sdl_context *sdl_ctx, PPU_mem *ppu_mem, PPU_state *ppu_state, cpu6502 *cpu) : sdl_ctx(sdl_ctx), ppu_mem(ppu_mem), ppu_state(ppu_state),
-        cpu(cpu), in_tile(0), tile(0), debug_mode(PPU_DEBUG_MODE::NONE)
+PPU_Render::PPU_Render(sdl_context *sdl_ctx, PPU_mem *ppu_mem, PPU_state *ppu_state, cpu6502 *cpu, FramePresenter *presenter) : sdl_ctx(sdl_ctx), ppu_mem(ppu_mem), ppu_state(ppu_state),
+        cpu(cpu), in_tile(0), tile(0), debug_mode(PPU_DEBUG_MODE::NONE), frame_number(0), presenter(presenter)
 {
     ppu_state->ticks = 0;
     ppu_state->scanline = 261;
-    screen_surface = SDL_CreateRGBSurface(0, 256*sdl_ctx->block_size, 240*sdl_ctx->block_size, 32, 0, 0, 0, 0);
-    if(!screen_surface) {
-        throw MemAllocFailed("SDL surface allocation for PPU_Render failed\n");
+    frame_buffer = presenter->get_back_buffer();
+    a12_notify = ppu_mem->rom && ppu_mem->rom->watches_ppu_a12();
+
+    for(int c = 0; c < 64; c++) {
+        color3 col = color_from_uint8(c);
+        argb_palette[c] = 0xFF000000 | (col.r << 16) | (col.g << 8) | col.b;
     }
 }
 
 PPU_Render::~PPU_Render() 
 {
-    SDL_FreeSurface(screen_surface);
 }
 
 PPU_Render::save_state PPU_Render::ppu_render_save_state() {
@@ -48,7 +50,8 @@ void PPU_Render::ppu_execute_up_to(UINT32 nr_ticks) {
     }
 }
 
-void PPU_Render::ppu_begin_frame() {
+void PPU_Render::ppu_begin_frame(UINT32 frame) {
+    frame_number = frame;
     // step up to pre_render scanline
     ppu_state->ticks = 0;
     ppu_state->scanline = 261;
@@ -95,13 +98,7 @@ void PPU_Render::step_post_render() {
     switch (ppu_state->ticks) {
     case 0:
         // we display the screen
-        screen_texture = SDL_CreateTextureFromSurface(sdl_ctx->renderer, screen_surface);
-        if(!screen_texture) {
-            throw MemAllocFailed("Allocation of sdl texture failed in ppu render\n");
-        }
-        SDL_RenderCopy(sdl_ctx->renderer, screen_texture, NULL, NULL);
-        SDL_DestroyTexture(screen_texture);
-        SDL_RenderPresent(sdl_ctx->renderer);
+        publish_frame();
         break;
     
     default:
@@ -109,6 +106,13 @@ void PPU_Render::step_post_render() {
     }
 }
 
+void PPU_Render::publish_frame() {
+    presenter->publish(frame_number);
+    // when it is not deferred to the main thread, the frame is displayed right away
+    if(!presenter->is_deferred()) presenter->present_latest();
+    frame_buffer = presenter->get_back_buffer();
+}
+
 /*
 ***********************
         VBLANK
@@ -120,7 +124,8 @@ void PPU_Render::step_vblank() {
         case 1:
             if(ppu_state->scanline == 241) {
                 ppu_state->IN_VBLANK = 1;
-                if(ppu_state->NMI_VBLANK) cpu->enter_nmi();
+                // the CPU is usually ahead, and takes it at its next instruction
+                if(ppu_state->NMI_VBLANK) cpu->raise_nmi(ticks_frame / 3);
             }
             break;
         default:
@@ -135,6 +140,7 @@ void PPU_Render::step_vblank() {
 */
 
 void PPU_Render::step_pre_render() {
+    if(ppu_state->ticks == 260 || ppu_state->ticks == 324) a12_fetch_point();
     if(ppu_state->ticks == 320) {
         ppu_state->SEC_OAM_IDX = 0;
         ppu_state->NEXT_OAM_IDX = 0;
@@ -242,6 +248,7 @@ void PPU_Render::step_visible() {
 		ppu_state->VRAM_ADDRESS |= ppu_state->T_VRAM_ADDRESS & 0x041F;
 
     } else if(ppu_state->ticks <= 320) {
+        if(ppu_state->ticks == 260) a12_fetch_point();
         // sprite regs
         UINT8 sprite_idx = (ppu_state->ticks - 257) / 8;
         UINT8 tick_offset = (ppu_state->ticks - 257) % 8;
@@ -278,10 +285,26 @@ void PPU_Render::step_visible() {
             break;
         }
     } else if(ppu_state->ticks <= 336) {
+        if(ppu_state->ticks == 324) a12_fetch_point();
         step_two_first_tiles();
     }
 }
 
+void PPU_Render::a12_fetch_point() {
+    if(!a12_notify) return;
+    if(!ppu_state->SHOW_BACKGROUND && !ppu_state->SHOW_SPRITE) return;
+    /* A12 rises once per line : on the sprites fetches (tick 260) when they use $1000
+    (8x16 sprites are assumed to), or else on the next line first tiles fetches (tick 324)
+    when the background uses $1000. The short rises on nametable fetches are filtered
+    by the mapper anyway */
+    BOOL sprites_high = ppu_state->SPRITE_TABLE || ppu_state->SPRITE_SIZE;
+    if(ppu_state->ticks == 260) {
+        if(sprites_high) ppu_mem->rom->ppu_a12_rise();
+    } else if(!sprites_high && ppu_state->BACKGROUND_TABLE) {
+        ppu_mem->rom->ppu_a12_rise();
+    }
+}
+
 void PPU_Render::compute_fine_Y_sprite() {
     int max_rev = (ppu_state->SPRITE_SIZE)? 15 : 7;
     ppu_state->SPRITE_FINE_Y = (ppu_state->current_oame.attr & 0x80)? max_rev + ppu_state->current_oame.Y_off - ppu_state->scanline : ppu_state->scanline - ppu_state->current_oame.Y_off;
@@ -336,8 +359,7 @@ void PPU_Render::render_pixel() {
     update_sprite_regs();
 
     // display the pixel
-    color3 sdl_color = color_from_uint8(pixel_color);
-    set_surface_pixel(screen_surface, sdl_ctx->block_size, ppu_state->ticks - 1, ppu_state->scanline, SDL_MapRGB(sdl_ctx->format, sdl_color.r, sdl_color.g, sdl_color.b));
+    frame_buffer[ppu_state->scanline*FRAME_WIDTH + ppu_state->ticks - 1] = (pixel_color < 64)? argb_palette[pixel_color] : 0xFF000000;
 }
 
 
@@ -398,12 +420,12 @@ void PPU_Render::fetch_nt_byte() {
 
 void PPU_Render::fetch_low_pt_byte() {
     UINT16 fine_Y = (ppu_state->VRAM_ADDRESS & 0x7000) >> 12;
-    ppu_state->LOW_PT_BYTE = ppu_mem->read_ppu_pt(ppu_state->NT_BYTE + fine_Y + ((ppu_state->BACKGROUND_TABLE) << 12));
+    ppu_state->LOW_PT_BYTE = ppu_mem->read_bg_pt(ppu_state->NT_BYTE + fine_Y + ((ppu_state->BACKGROUND_TABLE) << 12));
 }
 
 void PPU_Render::fetch_high_pt_byte() {
     UINT16 fine_Y = (ppu_state->VRAM_ADDRESS & 0x7000) >> 12;
-    ppu_state->HIGH_PT_BYTE = ppu_mem->read_ppu_pt(ppu_state->NT_BYTE + 8 + fine_Y + ((ppu_state->BACKGROUND_TABLE) << 12));
+    ppu_state->HIGH_PT_BYTE = ppu_mem->read_bg_pt(ppu_state->NT_BYTE + 8 + fine_Y + ((ppu_state->BACKGROUND_TABLE) << 12));
 }
 
 void PPU_Render::fetch_attr_byte() {
@@ -454,9 +476,9 @@ UINT8 PPU_Render::sprite_fetch_pt(UINT8 tile_idx, UINT8 offset) {
             real_idx += 0x01; // look at the consecutive
             offset_y -= 8;
         }
-        return ppu_mem->read_ppu_mem((real_idx << 4) + offset + offset_y + (nr_table << 12));
+        return ppu_mem->read_sprite_pt((real_idx << 4) + offset + offset_y + (nr_table << 12));
     } else {
-        return ppu_mem->read_ppu_pt((tile_idx << 4) + offset + ppu_state->SPRITE_FINE_Y + ((ppu_state->SPRITE_TABLE) << 12));
+        return ppu_mem->read_sprite_pt((tile_idx << 4) + offset + ppu_state->SPRITE_FINE_Y + ((ppu_state->SPRITE_TABLE) << 12));
     }
 }
 
@@ -526,7 +548,6 @@ void PPU_Render::sprite_fetches(UINT8 sprite) {
 void PPU_Render::render() {
     /* essentially for debug, the real thing should be done with step() */
 
-    SDL_Texture *texture;
     UINT8 ppu_table_background = ppu_state->BACKGROUND_TABLE;
 
     ppu_state->SPRITE0HIT = 0;
@@ -598,10 +619,7 @@ void PPU_Render::render() {
     }
 
     ppu_state->IN_VBLANK = 1;
-    texture = SDL_CreateTextureFromSurface(sdl_ctx->renderer, screen_surface);
-    SDL_RenderCopy(sdl_ctx->renderer, texture, NULL, NULL);
-    SDL_DestroyTexture(texture);
-    SDL_RenderPresent(sdl_ctx->renderer);
+    publish_frame();
 }
 
 
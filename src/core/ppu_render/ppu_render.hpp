@@ -4,6 +4,7 @@
 #include "../types.hpp"
 #include "draw_tile.hpp"
 #include "../sdl_utils.hpp"
+#include "frame_presenter.hpp"
 
 #include <tuple>
 #include <map>
@@ -31,8 +32,16 @@ private:
 
     UINT16                                    tile, in_tile;
     UINT32                                    ticks_frame; // ticks since the beginning of the last frame
-    SDL_Surface                               *screen_surface;
-    SDL_Texture                               *screen_texture;
+    UINT32                                    frame_number;
+
+    FramePresenter                            *presenter;
+    UINT32                                    *frame_buffer; // back buffer of the presenter
+    UINT32                                    argb_palette[64];
+
+    void                                      publish_frame();
+
+    BOOL                                      a12_notify; // the mapper watches PPU A12
+    void                                      a12_fetch_point();
 
     void                                      step_pre_render();
     void                                      step_post_render();
@@ -80,7 +89,7 @@ public:
         UINT32 ticks;
     };
 
-    PPU_Render(sdl_context *sdl_ctx, PPU_mem *ppu_mem, PPU_state *ppu_state, cpu6502 *cpu);
+    PPU_Render(sdl_context *sdl_ctx, PPU_mem *ppu_mem, PPU_state *ppu_state, cpu6502 *cpu, FramePresenter *presenter);
     ~PPU_Render();
 
     void                                      draw_debug_tiles_grid(UINT8 half_size);
@@ -88,7 +97,7 @@ public:
     void                                      ppu_execute_ticks(UINT32 nr_ticks);
     // keep in mind that a frame begins at the start of post render scanline
     void                                      ppu_execute_up_to(UINT32 nr_ticks);
-    void                                      ppu_begin_frame();
+    void                                      ppu_begin_frame(UINT32 frame);
     save_state                                ppu_render_save_state();
     void                                      ppu_render_restore_state(save_state s);
 
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "profiler.hpp"
+
+Profiler::Profiler() : current(&root)
+{
+    root.loc = (UINT32)ROOT << 28;
+    root.self = 0;
+    std::memset(ram_cycles, 0, sizeof(ram_cycles));
+    frames.reserve(PROFILER_MAX_DEPTH);
+}
+
+Profiler::~Profiler()
+{
+}
+
+void Profiler::add_bank(int bank) {
+    if((unsigned int)bank >= rom_cycles.size()) {
+        rom_cycles.resize(bank + 1);
+        rom_lo.resize(bank + 1);
+    }
+    rom_cycles[bank].reset(new UINT64[PROFILER_BANK_SIZE]());
+}
+
+void Profiler::push_frame(UINT32 loc, UINT8 s) {
+    if(frames.size() >= PROFILER_MAX_DEPTH) return;
+    std::unique_ptr<call_node> &child = current->children[loc];
+    if(!child) {
+        child.reset(new call_node);
+        child->loc = loc;
+        child->self = 0;
+    }
+    current = child.get();
+    frames.push_back({current, s});
+}
+
+void Profiler::location_name(UINT32 loc, bool with_kind, char *out, size_t size) {
+    static const char *kinds[] = {"sub_", "nmi_", "irq_", ""};
+    LOCATION_KIND kind = (LOCATION_KIND)(loc >> 28);
+    unsigned int bank = (loc >> 16) & 0xFFF;
+    const char *prefix = (with_kind)? kinds[kind] : "";
+    if(kind == ROOT) snprintf(out, size, "main");
+    else if(bank) snprintf(out, size, "%s%02X:%04X", prefix, bank - 1, loc & 0xFFFF);
+    else snprintf(out, size, "%s%04X", prefix, loc & 0xFFFF);
+}
+
+/* A recursive routine is several nodes of a path : only the outermost one adds
+its subtree to the total */
+UINT64 Profiler::sum_routines(call_node *node, std::map<UINT32, int> &on_path,
+                              std::map<UINT32, routine_cycles> &routines) {
+    int &depth = on_path[node->loc];
+    depth++;
+    UINT64 sum = node->self;
+    for(auto &c : node->children) sum += sum_routines(c.second.get(), on_path, routines);
+    depth--;
+    routine_cycles &r = routines.insert({node->loc, {0, 0}}).first->second;
+    r.self += node->self;
+    if(!depth) r.total += sum;
+    return sum;
+}
+
+UINT64 Profiler::get_total_cycles() {
+    std::map<UINT32, int> on_path;
+    std::map<UINT32, routine_cycles> routines;
+    return sum_routines(&root, on_path, routines);
+}
+
+static void print_line(FILE *f, const char *name, UINT64 cycles, UINT64 total) {
+    std::fprintf(f, "  %-16s %14llu %6.2f%%\n", name, (unsigned long long)cycles, (total)? 100.0 * cycles / total : 0.0);
+}
+
+void Profiler::write_report(FILE *f, unsigned int max_lines) {
+    std::map<UINT32, int> on_path;
+    std::map<UINT32, routine_cycles> routines;
+    UINT64 total = sum_routines(&root, on_path, routines);
+    char name[32];
+    std::fprintf(f, "Profile of %llu CPU cycles\n", (unsigned long long)total);
+
+    // (cycles, location) of the instructions, and per bank
+    std::vector<std::pair<UINT64, UINT32>> instructions;
+    std::fprintf(f, "\n==== Banks\n");
+    for(unsigned int bank = 0; bank < rom_cycles.size(); bank++) {
+        if(!rom_cycles[bank]) continue;
+        UINT64 sum = 0;
+        for(unsigned int i = 0; i < PROFILER_BANK_SIZE; i++) {
+            UINT64 c = rom_cycles[bank][i];
+            if(!c) continue;
+            sum += c;
+            // at the address where the bank was last mapped
+            instructions.push_back({c, location(rom_lo[bank] | i, bank, ROUTINE)});
+        }
+        snprintf(name, sizeof(name), "PRG ROM %02X", bank);
+        print_line(f, name, sum, total);
+    }
+    UINT64 ram_sum = 0, prg_ram_sum = 0;
+    for(unsigned int a = 0; a < 0x8000; a++) {
+        if(!ram_cycles[a]) continue;
+        if(a >= 0x6000) prg_ram_sum += ram_cycles[a];
+        else ram_sum += ram_cycles[a];
+        instructions.push_back({ram_cycles[a], location(a, -1, ROUTINE)});
+    }
+    if(ram_sum) print_line(f, "RAM", ram_sum, total);
+    if(prg_ram_sum) print_line(f, "PRG RAM", prg_ram_sum, total);
+
+    size_t n = std::min((size_t)max_lines, instructions.size());
+    std::partial_sort(instructions.begin(), instructions.begin() + n, instructions.end(),
+                      [](const std::pair<UINT64, UINT32> &a, const std::pair<UINT64, UINT32> &b) {return a.first > b.first;});
+    std::fprintf(f, "\n==== Instructions\n");
+    for(size_t i = 0; i < n; i++) {
+        location_name(instructions[i].second, false, name, sizeof(name));
+        print_line(f, name, instructions[i].first, total);
+    }
+
+    std::vector<std::pair<routine_cycles, UINT32>> sorted;
+    for(auto &r : routines) sorted.push_back({r.second, r.first});
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::pair<routine_cycles, UINT32> &a, const std::pair<routine_cycles, UINT32> &b) {return a.first.self > b.first.self;});
+    std::fprintf(f, "\n==== Routines (self, then with the routines they call)\n");
+    for(size_t i = 0; i < sorted.size() && i < max_lines; i++) {
+        location_name(sorted[i].second, true, name, sizeof(name));
+        std::fprintf(f, "  %-16s %14llu %6.2f%% %14llu %6.2f%%\n", name, (unsigned long long)sorted[i].first.self,
+                     (total)? 100.0 * sorted[i].first.self / total : 0.0, (unsigned long long)sorted[i].first.total,
+                     (total)? 100.0 * sorted[i].first.total / total : 0.0);
+    }
+}
+
+void Profiler::fold(FILE *f, call_node *node, std::string &path) {
+    char name[32];
+    location_name(node->loc, true, name, sizeof(name));
+    size_t len = path.size();
+    if(len) path += ';';
+    path += name;
+    if(node->self) std::fprintf(f, "%s %llu\n", path.c_str(), (unsigned long long)node->self);
+    for(auto &c : node->children) fold(f, c.second.get(), path);
+    path.resize(len);
+}
+
+void Profiler::write_folded(FILE *f) {
+    std::string path;
+    fold(f, &root, path);
+}
@@ -0,0 +1,110 @@
+#ifndef GAYA_PROFILER_HPP
+#define GAYA_PROFILER_HPP
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+// deepest call stack followed, deeper calls are counted in their caller
+#define PROFILER_MAX_DEPTH      64
+// the PRG ROM banks as the mappers map them, by 8kb
+#define PROFILER_BANK_SIZE      0x2000
+
+/*
+Profile of the emulated program : the cycles of each instruction are counted at
+its address (in its PRG ROM bank for $8000-$FFFF, so that the same address in two
+banks are two instructions), in its bank, and in the routine running it.
+
+Routines are delimited by JSR and by the interrupts, and end when the stack pointer
+goes back above the return address (RTS, RTI, or a game dropping it from the stack),
+so there is no need to match the RTS with their JSR. Each call path is a node of a
+tree, the cycles counted in a node are the ones of its routine only (not of the ones
+it calls), which is what flamegraph.pl wants (see write_folded).
+
+The CPU calls instruction() and interrupt() (see cpu6502::execute_cycles_profiled),
+which only index arrays : the tree is only walked for the reports.
+*/
+class Profiler
+{
+public:
+    Profiler();
+    ~Profiler();
+
+    /* After an instruction at pc, in the PRG ROM bank (-1 below $8000), with what it
+    did to PC and S. The bank of a JSR target is needed to name the routine */
+    void                        instruction(MEMADDR pc, int bank, UINT8 op, UINT32 cycles, MEMADDR new_pc,
+                                            int new_bank, UINT8 new_s) {
+        UINT64 *counter = (bank >= 0)? rom_counter(bank, pc) : &ram_cycles[pc & 0x7FFF];
+        *counter += cycles;
+        current->self += cycles;
+        // returns, from this routine and maybe from a few more
+        while(!frames.empty() && new_s > frames.back().s) pop_frame();
+        if(op == 0x20) push_frame(location(new_pc, new_bank, ROUTINE), new_s);
+    };
+    // after the CPU entered an interrupt handler at pc (cycles : the ones of the entry)
+    void                        interrupt(MEMADDR pc, int bank, bool nmi, UINT32 cycles, UINT8 new_s) {
+        push_frame(location(pc, bank, (nmi)? NMI_HANDLER : IRQ_HANDLER), new_s);
+        current->self += cycles;
+    };
+
+    UINT64                      get_total_cycles();
+    // per bank, instruction and routine, the top max_lines of each
+    void                        write_report(FILE *f, unsigned int max_lines);
+    // one line per call path, "main;sub_0F:C000;sub_0F:C123 1234", for flamegraph.pl
+    void                        write_folded(FILE *f);
+
+private:
+    enum LOCATION_KIND {
+        ROUTINE = 0, NMI_HANDLER = 1, IRQ_HANDLER = 2, ROOT = 3
+    };
+    // kind in bits 28-31, bank + 1 in bits 16-27 (0 below $8000), then the address
+    static UINT32               location(MEMADDR a, int bank, LOCATION_KIND kind) {
+        return ((UINT32)kind << 28) | ((UINT32)((bank + 1) & 0xFFF) << 16) | a;
+    };
+    static void                 location_name(UINT32 loc, bool with_kind, char *out, size_t size);
+
+    struct call_node {
+        UINT32          loc;
+        UINT64          self;
+        std::map<UINT32, std::unique_ptr<call_node>>
+                        children;
+    };
+    struct frame {
+        call_node       *node;
+        UINT8           s; // S in the routine, returning puts it above
+    };
+    call_node                   root;
+    call_node                   *current;
+    std::vector<frame>          frames;
+
+    struct routine_cycles {
+        UINT64          self;
+        UINT64          total; // with the routines it called
+    };
+
+    // per bank : cycles for each byte of the bank, and where it was last mapped
+    std::vector<std::unique_ptr<UINT64[]>>
+                                rom_cycles;
+    std::vector<MEMADDR>        rom_lo;
+    UINT64                      ram_cycles[0x8000]; // RAM, and PRG RAM at $6000
+
+    UINT64                      *rom_counter(int bank, MEMADDR pc) {
+        if((unsigned int)bank >= rom_cycles.size() || !rom_cycles[bank]) add_bank(bank);
+        rom_lo[bank] = pc & ~(PROFILER_BANK_SIZE - 1);
+        return &rom_cycles[bank][pc & (PROFILER_BANK_SIZE - 1)];
+    };
+    void                        add_bank(int bank);
+    void                        push_frame(UINT32 loc, UINT8 s);
+    void                        pop_frame() {
+        frames.pop_back();
+        current = (frames.empty())? &root : frames.back().node;
+    };
+    static UINT64               sum_routines(call_node *node, std::map<UINT32, int> &on_path,
+                                             std::map<UINT32, routine_cycles> &routines);
+    void                        fold(FILE *f, call_node *node, std::string &path);
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include <cstring>
+#include "ram_search.hpp"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+RamSearch::RamSearch(const UINT8 *ram, const UINT8 *prg_ram) {
+    snapshot(ram, prg_ram);
+    std::memcpy(previous, current, RAM_SEARCH_SIZE);
+    for(unsigned int i=0; i<RAM_SEARCH_SIZE / 16; i++) candidates[i] = 0xFFFF;
+}
+
+void RamSearch::snapshot(const UINT8 *ram, const UINT8 *prg_ram) {
+    std::memcpy(current, ram, RAM_SIZE);
+    std::memcpy(current + RAM_SIZE, prg_ram, PRG_RAM_SIZE);
+}
+
+#ifdef __SSE2__
+// bit n set when byte n of cur and ref match op (unsigned)
+static inline UINT16 compare_16(RAM_SEARCH_OP op, __m128i cur, __m128i ref) {
+    __m128i eq = _mm_cmpeq_epi8(cur, ref);
+    // min(a, b) == a <=> a <= b
+    __m128i le = _mm_cmpeq_epi8(_mm_min_epu8(cur, ref), cur);
+    __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(cur, ref), cur);
+    UINT16 m;
+    switch (op)
+    {
+    case RAM_SEARCH_OP::EQUAL:          m = _mm_movemask_epi8(eq); break;
+    case RAM_SEARCH_OP::NOT_EQUAL:      m = ~_mm_movemask_epi8(eq); break;
+    case RAM_SEARCH_OP::LESS:           m = ~_mm_movemask_epi8(ge); break;
+    case RAM_SEARCH_OP::GREATER:        m = ~_mm_movemask_epi8(le); break;
+    case RAM_SEARCH_OP::LESS_EQUAL:     m = _mm_movemask_epi8(le); break;
+    default:                            m = _mm_movemask_epi8(ge); break;
+    }
+    return m;
+}
+#else
+static inline bool compare_byte(RAM_SEARCH_OP op, UINT8 cur, UINT8 ref) {
+    switch (op)
+    {
+    case RAM_SEARCH_OP::EQUAL:          return cur == ref;
+    case RAM_SEARCH_OP::NOT_EQUAL:      return cur != ref;
+    case RAM_SEARCH_OP::LESS:           return cur < ref;
+    case RAM_SEARCH_OP::GREATER:        return cur > ref;
+    case RAM_SEARCH_OP::LESS_EQUAL:     return cur <= ref;
+    default:                            return cur >= ref;
+    }
+}
+#endif
+
+unsigned int RamSearch::filter(RAM_SEARCH_OP op, bool against_previous, UINT8 value) {
+#ifdef __SSE2__
+    __m128i val = _mm_set1_epi8((char)value);
+    for(unsigned int i=0; i<RAM_SEARCH_SIZE / 16; i++) {
+        if(!candidates[i]) continue;
+        __m128i cur = _mm_loadu_si128((const __m128i *)(current + 16*i));
+        // wraps around like the 8-bit counters of the games
+        __m128i ref = (against_previous)? _mm_add_epi8(_mm_loadu_si128((const __m128i *)(previous + 16*i)), val) : val;
+        candidates[i] &= compare_16(op, cur, ref);
+    }
+#else
+    for(unsigned int i=0; i<RAM_SEARCH_SIZE / 16; i++) {
+        if(!candidates[i]) continue;
+        UINT16 m = 0;
+        for(unsigned int b=0; b<16; b++) {
+            UINT8 ref = (against_previous)? (UINT8)(previous[16*i + b] + value) : value;
+            if(compare_byte(op, current[16*i + b], ref)) m |= (1 << b);
+        }
+        candidates[i] &= m;
+    }
+#endif
+    std::memcpy(previous, current, RAM_SEARCH_SIZE);
+    return get_nr_candidates();
+}
+
+unsigned int RamSearch::get_nr_candidates() {
+    unsigned int n = 0;
+    for(unsigned int i=0; i<RAM_SEARCH_SIZE / 16; i++) n += __builtin_popcount(candidates[i]);
+    return n;
+}
+
+void RamSearch::print_candidates(FILE *f, unsigned int max) {
+    unsigned int shown = 0;
+    for(unsigned int i=0; i<RAM_SEARCH_SIZE / 16; i++) {
+        UINT16 m = candidates[i];
+        while(m) {
+            if(shown == max) {
+                fprintf(f, "... %u more\n", get_nr_candidates() - shown);
+                return;
+            }
+            unsigned int idx = 16*i + __builtin_ctz(m);
+            m &= m - 1;
+            fprintf(f, "0x%04X : %02X\n", get_addr(idx), current[idx]);
+            shown++;
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef GAYA_RAM_SEARCH_HPP
+#define GAYA_RAM_SEARCH_HPP
+
+#include <cstdio>
+#include "types.hpp"
+#include "mem.hpp"
+
+// internal RAM, then PRG RAM
+#define RAM_SEARCH_SIZE         (RAM_SIZE + PRG_RAM_SIZE)
+
+enum class RAM_SEARCH_OP {
+    EQUAL, NOT_EQUAL, LESS, GREATER, LESS_EQUAL, GREATER_EQUAL
+};
+
+/*
+Finds where a game keeps a value (lives, timer, position...) by narrowing down
+the candidate addresses between snapshots of its RAM : each filter keeps the
+bytes for which "current op reference" holds, the reference being either a
+constant, or the byte at the previous filter plus an offset (so "increased by 2"
+is EQUAL with the previous value + 2).
+The snapshot is taken at the end of each frame while a search is running, and
+the filters compare 16 bytes at a time (SSE2 when available) into a bitmap of
+candidates.
+*/
+class RamSearch
+{
+public:
+    RamSearch(const UINT8 *ram, const UINT8 *prg_ram);
+
+    // end of frame
+    void                        snapshot(const UINT8 *ram, const UINT8 *prg_ram);
+    /* Keeps the candidates matching the predicate, and makes the current snapshot
+    the previous one. Returns the number of remaining candidates */
+    unsigned int                filter(RAM_SEARCH_OP op, bool against_previous, UINT8 value);
+    unsigned int                get_nr_candidates();
+    // prints the address and the current value of the first candidates
+    void                        print_candidates(FILE *f, unsigned int max);
+
+    // CPU address of an index in the snapshots
+    static MEMADDR              get_addr(unsigned int idx) {return (idx < RAM_SIZE)? idx : 0x6000 + idx - RAM_SIZE;};
+
+private:
+    UINT8                       current[RAM_SEARCH_SIZE];
+    UINT8                       previous[RAM_SEARCH_SIZE];
+    UINT16                      candidates[RAM_SEARCH_SIZE / 16]; // bit n : byte 16*i + n
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "nes_loaders/ines.hpp"
+#include "nes_loaders/rom_db.hpp"
+#include "exceptions.hpp"
+
+/*
+Checks the header correction of the ROM database on known dumps : each one is
+loaded again with the usual header mistakes (wrong mapper, "DiskDude!" in the
+unused bytes, wrong mirroring, battery or four screens bits), which must all be
+put back as in the original header, with the same crc32.
+
+    ./rom_db_test ../../rom/mega_man.nes ../../rom/castlevania.nes ...
+
+The dumps must be in the database with a correct header. The exit status is 1 when
+a correction is wrong.
+
+Compile with `g++ -o rom_db_test rom_db_test.cpp nes_loaders/ines.cpp nes_loaders/rom_image.cpp nes_loaders/rom_db.cpp`
+*/
+
+struct corruption {
+    const char  *name;
+    int         offset;
+    const char  *bytes; // xored with the header when xor_bytes, copied otherwise
+    int         len;
+    bool        xor_bytes;
+};
+
+static const struct corruption corruptions[] = {
+    {"mapper",          6,  "\x10",      1, true},
+    {"DiskDude!",       7,  "DiskDude!", 9, false},
+    {"mirroring",       6,  "\x01",      1, true},
+    {"battery",         6,  "\x02",      1, true},
+    {"four screens",    6,  "\x08",      1, true},
+};
+
+static bool same_fields(const struct nes_header &a, const struct nes_header &b) {
+    return a.MAPPER_NB == b.MAPPER_NB && a.SCREEN_MIRRORING == b.SCREEN_MIRRORING &&
+           a.BB_PRG_RAM == b.BB_PRG_RAM && a.FOUR_SCREENS == b.FOUR_SCREENS;
+}
+
+// loads the dump from f, and corrects its header. -1 for an unknown crc
+static int load_corrected(FILE *f, struct nes_header *h, UINT32 *crc) {
+    struct nes_data data = read_nes_data(f, read_nes_header(f));
+    *crc = rom_crc32(data);
+    const struct rom_db_entry *entry = rom_db_lookup(*crc);
+    if(!entry) return -1;
+    int nr_changed = rom_db_correct_header(data, entry);
+    *h = data.header;
+    return nr_changed;
+}
+
+int main(int argc, char *argv[]) {
+    int nr_failed = 0;
+    for(int i = 1; i < argc; i++) {
+        FILE *f = fopen(argv[i], "rb");
+        if(!f) {
+            std::printf("%s : can't be opened\n", argv[i]);
+            return 1;
+        }
+        std::vector<UINT8> file;
+        UINT8 buf[4096];
+        size_t n;
+        while((n = fread(buf, 1, sizeof(buf), f)) > 0) file.insert(file.end(), buf, buf + n);
+
+        struct nes_header good;
+        UINT32 good_crc;
+        try
+        {
+            if(load_corrected(f, &good, &good_crc)) {
+                std::printf("%s : not in the database, or its header is not correct\n", argv[i]);
+                nr_failed++;
+                fclose(f);
+                continue;
+            }
+        }
+        catch(const std::exception &e)
+        {
+            std::printf("%s : %s\n", argv[i], e.what());
+            return 1;
+        }
+        fclose(f);
+
+        for(const struct corruption &c : corruptions) {
+            std::vector<UINT8> bad = file;
+            for(int k = 0; k < c.len; k++) {
+                if(c.xor_bytes) bad[c.offset + k] ^= (UINT8)c.bytes[k];
+                else bad[c.offset + k] = (UINT8)c.bytes[k];
+            }
+            FILE *t = tmpfile();
+            fwrite(bad.data(), 1, bad.size(), t);
+            fflush(t);
+
+            struct nes_header h;
+            UINT32 crc;
+            int nr_changed = load_corrected(t, &h, &crc);
+            fclose(t);
+            bool ok = crc == good_crc && nr_changed == 1 && same_fields(h, good);
+            std::printf("%s, %s : %s\n", argv[i], c.name, ok? "corrected" : "FAILED");
+            if(!ok) nr_failed++;
+        }
+    }
+    return nr_failed? 1 : 0;
+}
@@ -0,0 +1,41 @@
+#include <chrono>
+#include "trace.hpp"
+
+TraceWriter::TraceWriter(FILE *f) : output(f), ring(new trace_record[TRACE_RING_SIZE]), head(0), tail(0),
+        current_frame(0), running(true)
+{
+    fwrite(TRACE_FILE_MAGIC, 1, TRACE_FILE_MAGIC_SIZE, output);
+    thread = std::thread(&TraceWriter::thread_loop, this);
+}
+
+TraceWriter::~TraceWriter()
+{
+    running = false;
+    thread.join();
+    drain();
+    fflush(output);
+}
+
+UINT64 TraceWriter::drain() {
+    UINT64 t = tail.load(std::memory_order_relaxed);
+    UINT64 h = head.load(std::memory_order_acquire);
+    if(h == t) return 0;
+    // up to the end of the ring, then from its start
+    size_t first = t & (TRACE_RING_SIZE - 1);
+    size_t n = h - t;
+    size_t before_end = TRACE_RING_SIZE - first;
+    if(n <= before_end) fwrite(&ring[first], sizeof(trace_record), n, output);
+    else {
+        fwrite(&ring[first], sizeof(trace_record), before_end, output);
+        fwrite(&ring[0], sizeof(trace_record), n - before_end, output);
+    }
+    tail.store(h, std::memory_order_release);
+    return n;
+}
+
+void TraceWriter::thread_loop() {
+    while(running.load()) {
+        // a frame is around 10000 instructions, the ring holds a few of them
+        if(!drain()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
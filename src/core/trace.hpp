@@ -0,0 +1,73 @@
+#ifndef GAYA_TRACE_HPP
+#define GAYA_TRACE_HPP
+
+#include <cstdio>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include "types.hpp"
+
+// records in the ring buffer, a power of 2
+#define TRACE_RING_SIZE         (1 << 16)
+// start of the trace files, followed by the records
+#define TRACE_FILE_MAGIC        "GAYATRC1"
+#define TRACE_FILE_MAGIC_SIZE   8
+
+/*
+One instruction, with the registers before it is executed (as in the nestest logs).
+The files are these records as they are in memory, so they should be read on a
+host with the same endianness.
+*/
+struct trace_record {
+    UINT16      pc;
+    UINT8       opcode;
+    UINT8       operand[2]; // the bytes after the opcode (0 when the instruction is shorter)
+    UINT8       A, X, Y, S, P;
+    UINT16      frame;      // low bits of the frame number
+    UINT32      cycles;     // since the start of the frame
+};
+static_assert(sizeof(trace_record) == 16, "trace records are 16 bytes");
+
+/*
+Instruction trace of the whole emulation, to a file : the CPU appends the records
+to a ring buffer (see cpu6502::execute_cycles_traced), and a background thread
+writes them to the file. The CPU is the only writer and the thread the only reader
+of the ring, so they only share two counters and never lock. When the ring is
+full, the CPU waits for the thread rather than losing records.
+trace_dump converts the files to text.
+*/
+class TraceWriter
+{
+public:
+    // writes the header and starts the thread, f is not closed
+    TraceWriter(FILE *f);
+    // writes the remaining records
+    ~TraceWriter();
+
+    void                        set_frame(UINT32 frame) {current_frame = frame;};
+    UINT32                      get_frame() {return current_frame;};
+
+    void                        push(const trace_record &r) {
+        UINT64 h = head.load(std::memory_order_relaxed);
+        while(h - tail.load(std::memory_order_acquire) == TRACE_RING_SIZE) std::this_thread::yield();
+        ring[h & (TRACE_RING_SIZE - 1)] = r;
+        head.store(h + 1, std::memory_order_release);
+    };
+
+private:
+    FILE                        *output;
+    std::unique_ptr<trace_record[]>
+                                ring;
+    // records pushed, and written (only growing, the index in ring is modulo its size)
+    std::atomic<UINT64>         head, tail;
+    UINT32                      current_frame;
+
+    std::thread                 thread;
+    std::atomic<bool>           running;
+
+    void                        thread_loop();
+    // writes what was pushed so far, returns the number of records
+    UINT64                      drain();
+};
+
+#endif
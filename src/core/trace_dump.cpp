@@ -0,0 +1,100 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "trace.hpp"
+#include "cpu_opcodes.hpp"
+
+/*
+Converts an instruction trace written by emul_core -t to text, one line per
+instruction in the format of the nestest logs :
+
+C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 SP:FD PPU:261,  0 CYC:0
+
+    ./trace_dump trace.bin [first_frame [last_frame]] > trace.txt
+
+CYC counts the cycles from the start of the frame, and PPU is the scanline and the
+dot at this cycle (frames start on the pre-render line). The memory values nestest
+prints after the operands are not in the trace. A line "==== Frame N" starts each frame.
+
+Compile with `g++ -o trace_dump trace_dump.cpp cpu_opcodes.cpp`
+*/
+
+static void format_instruction(const trace_record &r, char *out, size_t size) {
+    const cpu_opcode_info &info = cpu_opcodes[r.opcode];
+    UINT8 lo = r.operand[0];
+    UINT16 abs = r.operand[0] | (r.operand[1] << 8);
+    switch (info.mode)
+    {
+    case ADDR_MODE::IMPLIED:     snprintf(out, size, "%s", info.name); break;
+    case ADDR_MODE::ACCUMULATOR: snprintf(out, size, "%s A", info.name); break;
+    case ADDR_MODE::IMMEDIATE:   snprintf(out, size, "%s #$%02X", info.name, lo); break;
+    case ADDR_MODE::ZERO_PAGE:   snprintf(out, size, "%s $%02X", info.name, lo); break;
+    case ADDR_MODE::ZERO_PAGE_X: snprintf(out, size, "%s $%02X,X", info.name, lo); break;
+    case ADDR_MODE::ZERO_PAGE_Y: snprintf(out, size, "%s $%02X,Y", info.name, lo); break;
+    case ADDR_MODE::ABSOLUTE:    snprintf(out, size, "%s $%04X", info.name, abs); break;
+    case ADDR_MODE::ABSOLUTE_X:  snprintf(out, size, "%s $%04X,X", info.name, abs); break;
+    case ADDR_MODE::ABSOLUTE_Y:  snprintf(out, size, "%s $%04X,Y", info.name, abs); break;
+    case ADDR_MODE::INDIRECT:    snprintf(out, size, "%s ($%04X)", info.name, abs); break;
+    case ADDR_MODE::X_INDIRECT:  snprintf(out, size, "%s ($%02X,X)", info.name, lo); break;
+    case ADDR_MODE::INDIRECT_Y:  snprintf(out, size, "%s ($%02X),Y", info.name, lo); break;
+    case ADDR_MODE::RELATIVE:
+        // the target
+        snprintf(out, size, "%s $%04X", info.name, (UINT16)(r.pc + 2 + (INT8)lo));
+        break;
+    }
+}
+
+static void print_record(const trace_record &r) {
+    UINT8 len = addr_mode_length(cpu_opcodes[r.opcode].mode);
+    char bytes[16], text[32];
+    if(len == 1) snprintf(bytes, sizeof(bytes), "%02X", r.opcode);
+    else if(len == 2) snprintf(bytes, sizeof(bytes), "%02X %02X", r.opcode, r.operand[0]);
+    else snprintf(bytes, sizeof(bytes), "%02X %02X %02X", r.opcode, r.operand[0], r.operand[1]);
+    format_instruction(r, text, sizeof(text));
+
+    UINT32 ticks = r.cycles * 3;
+    unsigned int scanline = (261 + ticks / 341) % 262;
+    unsigned int dot = ticks % 341;
+    // unofficial opcodes are marked with a star, as in nestest.log
+    std::printf("%04X  %-8s %c%-32sA:%02X X:%02X Y:%02X P:%02X SP:%02X PPU:%3u,%3u CYC:%u\n", r.pc, bytes,
+                cpu_opcodes[r.opcode].official ? ' ' : '*', text, r.A, r.X, r.Y, r.P, r.S, scanline, dot, r.cycles);
+}
+
+int main(int argc, char *argv[]) {
+    if(argc < 2 || argc > 4) {
+        std::printf("Usage : %s trace.bin [first_frame [last_frame]]\n", argv[0]);
+        return 2;
+    }
+    unsigned long first = (argc > 2)? strtoul(argv[2], NULL, 10) : 0;
+    unsigned long last = (argc > 3)? strtoul(argv[3], NULL, 10) : (unsigned long)-1;
+
+    FILE *f = fopen(argv[1], "rb");
+    if(!f) {
+        std::printf("Could not open %s\n", argv[1]);
+        return 2;
+    }
+    char magic[TRACE_FILE_MAGIC_SIZE];
+    if(fread(magic, 1, TRACE_FILE_MAGIC_SIZE, f) != TRACE_FILE_MAGIC_SIZE || memcmp(magic, TRACE_FILE_MAGIC, TRACE_FILE_MAGIC_SIZE)) {
+        std::printf("%s is not an instruction trace\n", argv[1]);
+        fclose(f);
+        return 2;
+    }
+
+    // records only have the low 16 bits of the frame number
+    unsigned long frame = 0;
+    bool started = false;
+    UINT16 prev_frame = 0;
+    trace_record r;
+    while(fread(&r, sizeof(r), 1, f) == 1) {
+        if(!started || r.frame != prev_frame) {
+            frame += (started)? (UINT16)(r.frame - prev_frame) : r.frame;
+            prev_frame = r.frame;
+            started = true;
+            if(frame > last) break;
+            if(frame >= first) std::printf("==== Frame %lu\n", frame);
+        }
+        if(frame >= first) print_record(r);
+    }
+    fclose(f);
+    return 0;
+}
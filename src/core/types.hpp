@@ -11,5 +11,6 @@ typedef uint16_t UINT16;
 typedef uint16_t MEMADDR;
 typedef int16_t  INT16;
 typedef uint32_t UINT32;
+typedef uint64_t UINT64;
 
 #endif
\ No newline at end of file